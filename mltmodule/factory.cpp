@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <framework/mlt.h>
+#include <limits.h>
+#include <stdio.h>
+
+extern "C" mlt_filter filter_lut3d_init(mlt_profile, mlt_service_type, const char*, char*);
+
+static mlt_properties metadata(mlt_service_type, const char*, void* data)
+{
+    char file[PATH_MAX];
+    snprintf(file, PATH_MAX, "%s/shotcut/%s", mlt_environment("MLT_DATA"), (const char*) data);
+    return mlt_properties_parse_yaml(file);
+}
+
+extern "C" MLT_REPOSITORY
+{
+    MLT_REGISTER(filter_type, "shotcut.lut3d", filter_lut3d_init);
+    MLT_REGISTER_METADATA(filter_type, "shotcut.lut3d", metadata, (void*) "filter_lut3d.yml");
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "lutregistry.h"
+#include <framework/mlt.h>
+
+// The lut3d filter of Shotcut. It takes the same av.file and av.interp
+// properties as avfilter.lut3d so that either can be edited the same way.
+
+static const char* kMemoProperty = "_memo";
+static const char* kFallbackProperty = "_fallback";
+
+namespace {
+
+// The table last used by a filter, to avoid a lookup on every frame.
+struct Memo
+{
+    QByteArray path;
+    LutRegistry::Pointer lut;
+};
+
+struct Job
+{
+    const LutRegistry::Lut* lut;
+    uint8_t* image;
+    int width;
+    int height;
+    int step;
+    LutRegistry::Interpolation interpolation;
+};
+
+int applySlice(int, int index, int jobs, void* cookie)
+{
+    Job* job = static_cast<Job*>(cookie);
+    int lines = (job->height + jobs - 1) / jobs;
+    int start = index * lines;
+    int end = qMin(job->height, start + lines);
+    if (end > start) {
+        LutRegistry::apply(*job->lut, job->image + start * job->width * job->step,
+                           (end - start) * job->width, job->step, job->interpolation);
+    }
+    return 0;
+}
+
+QByteArray frameProperty(mlt_filter filter)
+{
+    // A clip can have more than one LUT filter.
+    return QByteArray("shotcut.lut3d.") + QByteArray::number(quintptr(filter));
+}
+
+void deleteMemo(void* memo)
+{
+    delete static_cast<Memo*>(memo);
+}
+
+void deletePointer(void* pointer)
+{
+    delete static_cast<LutRegistry::Pointer*>(pointer);
+}
+
+int getImage(mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height, int)
+{
+    mlt_filter filter = (mlt_filter) mlt_frame_pop_service(frame);
+    LutRegistry::Pointer* lut = static_cast<LutRegistry::Pointer*>(
+        mlt_properties_get_data(MLT_FRAME_PROPERTIES(frame), frameProperty(filter).constData(), NULL));
+    if (*format != mlt_image_rgb24a)
+        *format = mlt_image_rgb24;
+    int error = mlt_frame_get_image(frame, image, format, width, height, 1);
+    if (!error && lut && *lut && *image && (*format == mlt_image_rgb24 || *format == mlt_image_rgb24a)) {
+        Job job = {lut->data(), *image, *width, *height, *format == mlt_image_rgb24a? 4 : 3,
+                   LutRegistry::interpolation(mlt_properties_get(MLT_FILTER_PROPERTIES(filter), "av.interp"))};
+        mlt_slices_run_normal(0, applySlice, &job);
+    }
+    return error;
+}
+
+// Files the registry does not parse go through FFmpeg's filter.
+mlt_frame fallback(mlt_filter filter, mlt_frame frame)
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_filter ffmpeg = (mlt_filter) mlt_properties_get_data(properties, kFallbackProperty, NULL);
+    if (!ffmpeg) {
+        ffmpeg = mlt_factory_filter(mlt_service_profile(MLT_FILTER_SERVICE(filter)), "avfilter.lut3d", NULL);
+        if (!ffmpeg)
+            return frame;
+        mlt_properties_set_data(properties, kFallbackProperty, ffmpeg, 0, (mlt_destructor) mlt_filter_close, NULL);
+    }
+    mlt_properties_pass_list(MLT_FILTER_PROPERTIES(ffmpeg), properties, "av.file av.interp");
+    return mlt_filter_process(ffmpeg, frame);
+}
+
+mlt_frame process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    const char* path = mlt_properties_get(properties, "av.file");
+    Memo* memo = static_cast<Memo*>(mlt_properties_get_data(properties, kMemoProperty, NULL));
+    if (!memo || memo->path != path) {
+        memo = new Memo;
+        memo->path = path;
+        memo->lut = LutRegistry::acquire(QString::fromUtf8(path));
+        mlt_properties_set_data(properties, kMemoProperty, memo, 0, deleteMemo, NULL);
+    }
+    if (!memo->lut)
+        return fallback(filter, frame);
+    mlt_properties_set_data(MLT_FRAME_PROPERTIES(frame), frameProperty(filter).constData(),
+                            new LutRegistry::Pointer(memo->lut), 0, deletePointer, NULL);
+    mlt_frame_push_service(frame, filter);
+    mlt_frame_push_get_image(frame, getImage);
+    return frame;
+}
+
+} // namespace
+
+extern "C" mlt_filter filter_lut3d_init(mlt_profile, mlt_service_type, const char*, char* arg)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (filter) {
+        filter->process = process;
+        if (arg)
+            mlt_properties_set(MLT_FILTER_PROPERTIES(filter), "av.file", arg);
+        mlt_properties_set(MLT_FILTER_PROPERTIES(filter), "av.interp", "tetrahedral");
+    }
+    return filter;
+}
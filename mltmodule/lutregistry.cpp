@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "lutregistry.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWeakPointer>
+#include <framework/mlt_log.h>
+#include <ctype.h>
+
+static const int kMaxLutSize = 256;
+// FFmpeg reads the values of .3dl files as 12-bit.
+static const float k3dlScale = 4096.0f;
+
+namespace {
+
+typedef LutRegistry::Lut Lut;
+
+struct FileEntry
+{
+    qint64 size;
+    QDateTime modified;
+    QByteArray hash;
+};
+
+struct Rgb
+{
+    float r, g, b;
+};
+
+QMutex registryMutex;
+QHash<QString, FileEntry> files;
+QHash<QByteArray, QWeakPointer<const Lut>> luts;
+
+Lut* makeLut(int size, const QVector<float>& values, const float* domainMin, const float* domainMax)
+{
+    Lut* lut = new Lut;
+    lut->size = size;
+    lut->table = values;
+    for (int c = 0; c < 3; ++c) {
+        // This is how FFmpeg 4 scales the input, which ignores the domain minimum.
+        float scale = qBound(0.f, float(1.0 / (domainMax[c] - domainMin[c])), 1.f);
+        float factor = scale / 255 * (size - 1);
+        for (int v = 0; v < 256; ++v)
+            lut->scaled[c][v] = v * factor;
+    }
+    return lut;
+}
+Lut* parseCube(const QByteArray& data)
+{
+    int size = 0;
+    float domainMin[3] = {0.0f, 0.0f, 0.0f};
+    float domainMax[3] = {1.0f, 1.0f, 1.0f};
+    QVector<float> values;
+    foreach (const QByteArray& text, data.split('\n')) {
+        QByteArray line = text.simplified();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        QList<QByteArray> fields = line.split(' ');
+        if (fields[0] == "LUT_3D_SIZE" && fields.size() == 2) {
+            size = fields[1].toInt();
+            if (size < 2 || size > kMaxLutSize)
+                return 0;
+            values.reserve(size * size * size * 3);
+        } else if ((fields[0] == "DOMAIN_MIN" || fields[0] == "DOMAIN_MAX") && fields.size() == 4) {
+            float* domain = fields[0] == "DOMAIN_MIN"? domainMin : domainMax;
+            for (int c = 0; c < 3; ++c)
+                domain[c] = fields[c + 1].toFloat();
+        } else if (fields[0] == "LUT_3D_INPUT_RANGE" && fields.size() == 3) {
+            for (int c = 0; c < 3; ++c) {
+                domainMin[c] = fields[1].toFloat();
+                domainMax[c] = fields[2].toFloat();
+            }
+        } else if (fields[0] == "LUT_1D_SIZE") {
+            // Leave LUTs with a shaper to FFmpeg.
+            return 0;
+        } else if (isalpha(fields[0][0])) {
+            // TITLE and other keywords that do not change the table
+            continue;
+        } else if (fields.size() == 3 && size > 0) {
+            for (int c = 0; c < 3; ++c) {
+                bool ok = false;
+                values << fields[c].toFloat(&ok);
+                if (!ok)
+                    return 0;
+            }
+        } else {
+            return 0;
+        }
+    }
+    if (size == 0 || values.size() != size * size * size * 3)
+        return 0;
+    for (int c = 0; c < 3; ++c) {
+        if (domainMax[c] <= domainMin[c])
+            return 0;
+    }
+    return makeLut(size, values, domainMin, domainMax);
+}
+
+Lut* parse3dl(const QByteArray& data)
+{
+    // The first line holds the input levels, one per lattice point, and
+    // blue changes fastest in the table that follows.
+    int size = 0;
+    QVector<float> lattice;
+    foreach (const QByteArray& text, data.split('\n')) {
+        QByteArray line = text.simplified();
+        if (line.isEmpty() || line.startsWith('#') || isalpha(line[0]))
+            continue;
+        QList<QByteArray> fields = line.split(' ');
+        if (size == 0) {
+            size = fields.size();
+            if (size < 2 || size > kMaxLutSize)
+                return 0;
+            lattice.reserve(size * size * size * 3);
+            continue;
+        }
+        if (fields.size() != 3)
+            return 0;
+        for (int c = 0; c < 3; ++c) {
+            bool ok = false;
+            lattice << fields[c].toInt(&ok) / k3dlScale;
+            if (!ok)
+                return 0;
+        }
+    }
+    if (size == 0 || lattice.size() != size * size * size * 3)
+        return 0;
+    QVector<float> values(lattice.size());
+    for (int r = 0; r < size; ++r) {
+        for (int g = 0; g < size; ++g) {
+            for (int b = 0; b < size; ++b) {
+                const float* from = lattice.constData() + ((r * size + g) * size + b) * 3;
+                float* to = values.data() + ((b * size + g) * size + r) * 3;
+                to[0] = from[0];
+                to[1] = from[1];
+                to[2] = from[2];
+            }
+        }
+    }
+    const float domainMin[3] = {0.0f, 0.0f, 0.0f};
+    const float domainMax[3] = {1.0f, 1.0f, 1.0f};
+    return makeLut(size, values, domainMin, domainMax);
+}
+
+inline float lerpf(float v0, float v1, float f)
+{
+    return v0 + (v1 - v0) * f;
+}
+
+inline Rgb lerp(const float* v0, const float* v1, float f)
+{
+    Rgb result = {lerpf(v0[0], v1[0], f), lerpf(v0[1], v1[1], f), lerpf(v0[2], v1[2], f)};
+    return result;
+}
+
+inline Rgb lerp(const Rgb& v0, const Rgb& v1, float f)
+{
+    Rgb result = {lerpf(v0.r, v1.r, f), lerpf(v0.g, v1.g, f), lerpf(v0.b, v1.b, f)};
+    return result;
+}
+
+inline uint8_t clip8(float value)
+{
+    // Truncate like FFmpeg's av_clip_uint8() of a float.
+    int i = int(value * 255.0f);
+    return uint8_t(i < 0? 0 : i > 255? 255 : i);
+}
+
+// The arithmetic follows FFmpeg's vf_lut3d.c so that the results match.
+inline void applyPixel(const Lut& lut, uint8_t* p, LutRegistry::Interpolation interpolation)
+{
+    const float sr = lut.scaled[0][p[0]];
+    const float sg = lut.scaled[1][p[1]];
+    const float sb = lut.scaled[2][p[2]];
+    const int n = lut.size;
+    const float* table = lut.table.constData();
+
+    if (interpolation == LutRegistry::Nearest) {
+        const float* c = table + ((int(sb + .5) * n + int(sg + .5)) * n + int(sr + .5)) * 3;
+        p[0] = clip8(c[0]);
+        p[1] = clip8(c[1]);
+        p[2] = clip8(c[2]);
+        return;
+    }
+
+    const int r = int(sr);
+    const int g = int(sg);
+    const int b = int(sb);
+    const float dr = sr - r;
+    const float dg = sg - g;
+    const float db = sb - b;
+    // Offsets to the next lattice point along each axis
+    const int nr = r < n - 1? 3 : 0;
+    const int ng = g < n - 1? 3 * n : 0;
+    const int nb = b < n - 1? 3 * n * n : 0;
+    const float* c000 = table + ((b * n + g) * n + r) * 3;
+    const float* c100 = c000 + nr;
+    const float* c010 = c000 + ng;
+    const float* c001 = c000 + nb;
+    const float* c110 = c000 + nr + ng;
+    const float* c101 = c000 + nr + nb;
+    const float* c011 = c000 + ng + nb;
+    const float* c111 = c000 + nr + ng + nb;
+    Rgb c;
+
+    if (interpolation == LutRegistry::Trilinear) {
+        const Rgb c00 = lerp(c000, c100, dr);
+        const Rgb c10 = lerp(c010, c110, dr);
+        const Rgb c01 = lerp(c001, c101, dr);
+        const Rgb c11 = lerp(c011, c111, dr);
+        const Rgb c0 = lerp(c00, c10, dg);
+        const Rgb c1 = lerp(c01, c11, dg);
+        c = lerp(c0, c1, db);
+    } else {
+        const float* a;
+        const float* d;
+        float w0, w1, w2, w3;
+        if (dr > dg) {
+            if (dg > db) {
+                a = c100; d = c110;
+                w0 = 1.f - dr; w1 = dr - dg; w2 = dg - db; w3 = db;
+            } else if (dr > db) {
+                a = c100; d = c101;
+                w0 = 1.f - dr; w1 = dr - db; w2 = db - dg; w3 = dg;
+            } else {
+                a = c001; d = c101;
+                w0 = 1.f - db; w1 = db - dr; w2 = dr - dg; w3 = dg;
+            }
+        } else {
+            if (db > dg) {
+                a = c001; d = c011;
+                w0 = 1.f - db; w1 = db - dg; w2 = dg - dr; w3 = dr;
+            } else if (db > dr) {
+                a = c010; d = c011;
+                w0 = 1.f - dg; w1 = dg - db; w2 = db - dr; w3 = dr;
+            } else {
+                a = c010; d = c110;
+                w0 = 1.f - dg; w1 = dg - dr; w2 = dr - db; w3 = db;
+            }
+        }
+        c.r = w0 * c000[0] + w1 * a[0] + w2 * d[0] + w3 * c111[0];
+        c.g = w0 * c000[1] + w1 * a[1] + w2 * d[1] + w3 * c111[1];
+        c.b = w0 * c000[2] + w1 * a[2] + w2 * d[2] + w3 * c111[2];
+    }
+    p[0] = clip8(c.r);
+    p[1] = clip8(c.g);
+    p[2] = clip8(c.b);
+}
+
+} // namespace
+
+LutRegistry::Pointer LutRegistry::acquire(const QString& path)
+{
+    QFileInfo info(path);
+    QString suffix = info.suffix().toLower();
+    if (!info.isFile() || (suffix != "cube" && suffix != "3dl"))
+        return Pointer();
+
+    QMutexLocker locker(&registryMutex);
+    if (files.contains(path)) {
+        const FileEntry& entry = files[path];
+        if (entry.size == info.size() && entry.modified == info.lastModified()) {
+            Pointer lut = luts.value(entry.hash).toStrongRef();
+            if (lut)
+                return lut;
+        }
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return Pointer();
+    QByteArray data = file.readAll();
+    FileEntry entry;
+    entry.size = info.size();
+    entry.modified = info.lastModified();
+    entry.hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    files.insert(path, entry);
+    Pointer lut = luts.value(entry.hash).toStrongRef();
+    if (lut)
+        return lut;
+
+    Lut* parsed = suffix == "cube"? parseCube(data) : parse3dl(data);
+    if (!parsed) {
+        mlt_log_info(NULL, "[shotcut.lut3d] leaving the LUT to FFmpeg: %s\n", path.toUtf8().constData());
+        return Pointer();
+    }
+    lut = Pointer(parsed);
+    // Forget the tables that no filter uses anymore.
+    for (auto i = luts.begin(); i != luts.end();) {
+        if (i.value().isNull())
+            i = luts.erase(i);
+        else
+            ++i;
+    }
+    luts.insert(entry.hash, lut);
+    mlt_log_verbose(NULL, "[shotcut.lut3d] loaded %s size %d, %d tables\n",
+                    path.toUtf8().constData(), parsed->size, luts.size());
+    return lut;
+}
+
+LutRegistry::Interpolation LutRegistry::interpolation(const char* name)
+{
+    if (!qstrcmp(name, "nearest"))
+        return Nearest;
+    if (!qstrcmp(name, "trilinear"))
+        return Trilinear;
+    return Tetrahedral;
+}
+
+void LutRegistry::apply(const Lut& lut, uint8_t* pixels, int count, int step, Interpolation interpolation)
+{
+    for (uint8_t* p = pixels; count > 0; --count, p += step)
+        applyPixel(lut, p, interpolation);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LUTREGISTRY_H
+#define LUTREGISTRY_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <stdint.h>
+
+/*!
+  \class LutRegistry
+  \brief Shares parsed 3D LUT files between all of the filters that use them.
+
+  FFmpeg's lut3d filter parses its file and keeps its own copy of the table,
+  so a LUT applied to hundreds of clips is loaded hundreds of times. The
+  shotcut.lut3d filter reads its table from this registry instead. Each
+  .cube or .3dl file is parsed once, keyed by path and also by content hash
+  so that copies of a LUT in different folders share one table. The table
+  is applied with the same single precision arithmetic as FFmpeg 4, so the
+  result matches avfilter.lut3d.
+*/
+
+class LutRegistry
+{
+public:
+    enum Interpolation {
+        Nearest,
+        Trilinear,
+        Tetrahedral
+    };
+
+    struct Lut {
+        int size;
+        QVector<float> table;  // RGB triplets, red changing fastest
+        float scaled[3][256];  // lattice coordinate of each 8-bit input
+        qint64 bytes() const { return sizeof(Lut) + table.size() * sizeof(float); }
+    };
+    typedef QSharedPointer<const Lut> Pointer;
+
+    //! Returns the table of a LUT file, or null if FFmpeg must handle it.
+    static Pointer acquire(const QString& path);
+    static Interpolation interpolation(const char* name);
+    //! Applies \a lut in place to \a count packed RGB pixels that are \a step bytes apart.
+    static void apply(const Lut& lut, uint8_t* pixels, int count, int step, Interpolation interpolation);
+};
+
+#endif // LUTREGISTRY_H
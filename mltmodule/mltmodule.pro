@@ -0,0 +1,50 @@
+# An MLT module with the services of Shotcut. Both Shotcut and melt load it
+# from the MLT repository, so the preview and export use the same code.
+include(../shotcut.pri)
+
+TEMPLATE = lib
+TARGET = mltshotcut
+CONFIG += plugin
+QT = core
+
+SOURCES += factory.cpp \
+    filter_lut3d.cpp \
+    lutregistry.cpp
+
+HEADERS += lutregistry.h
+
+OTHER_FILES += filter_lut3d.yml
+
+mac {
+    isEmpty(MLT_PREFIX) {
+        MLT_PREFIX = /opt/local
+    }
+    isEmpty(PREFIX) {
+        INCLUDEPATH += $$MLT_PREFIX/include/mlt
+        LIBS += -L$$MLT_PREFIX/lib -lmlt
+    } else {
+        INCLUDEPATH += $$PREFIX/Contents/Frameworks/include/mlt
+        LIBS += -L$$PREFIX/Contents/Frameworks -lmlt
+    }
+    target.path = $$PREFIX/Contents/PlugIns/mlt
+    metadata.path = $$PREFIX/Contents/Resources/mlt/shotcut
+}
+win32 {
+    isEmpty(MLT_PATH) {
+        MLT_PATH = ..\\..\\..
+    }
+    INCLUDEPATH += $$MLT_PATH\\include\\mlt
+    LIBS += -L$$MLT_PATH\\lib -lmlt
+    isEmpty(PREFIX):PREFIX = C:\\Projects\\Shotcut
+    target.path = $$PREFIX/lib/mlt
+    metadata.path = $$PREFIX/share/mlt/shotcut
+}
+unix:!mac {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += mlt-framework
+    isEmpty(PREFIX):PREFIX = /usr/local
+    target.path = $$PREFIX/lib/mlt
+    metadata.path = $$PREFIX/share/mlt/shotcut
+}
+metadata.files = filter_lut3d.yml
+INSTALLS += target metadata
@@ -6,10 +6,15 @@ include(shotcut.pri)
 }
 
 TEMPLATE = subdirs
-SUBDIRS = CuteLogger src translations
+SUBDIRS = CuteLogger mltmodule src translations
 cache()
 src.depends = CuteLogger
 
+CONFIG(tests) {
+    SUBDIRS += tests
+    tests.depends = CuteLogger
+}
+
 codespell.target = codespell
 codespell.commands = codespell -w -q 3 \
     -L shotcut,uint,seeked \
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "analysiscache.h"
+#include "settings.h"
+#include "util.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <MltProducer.h>
+
+AnalysisCache::AnalysisCache(const QString& folder, const QString& suffix, quint32 magic, qint32 version)
+    : m_folder(folder)
+    , m_suffix(suffix)
+    , m_magic(magic)
+    , m_version(version)
+{
+}
+
+QString AnalysisCache::path(Mlt::Producer& producer, int streamIndex) const
+{
+    // Caching under an empty name would mix up all files without a hash.
+    QString name = Util::getHash(producer);
+    if (name.isEmpty())
+        return QString();
+    if (streamIndex > 0)
+        name += QString("-%1").arg(streamIndex);
+    return path(name);
+}
+
+QString AnalysisCache::path(const QString& name) const
+{
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd(m_folder)) {
+        dir.mkpath(m_folder);
+        dir.cd(m_folder);
+    }
+    return dir.filePath(name + m_suffix);
+}
+
+bool AnalysisCache::read(const QString& path, const std::function<bool(QDataStream&)>& read) const
+{
+    if (path.isEmpty())
+        return false;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    quint32 magic;
+    qint32 version;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != m_magic || version != m_version)
+        return false;
+    return read(stream) && stream.status() == QDataStream::Ok;
+}
+
+bool AnalysisCache::write(const QString& path, const std::function<void(QDataStream&)>& write) const
+{
+    if (path.isEmpty())
+        return false;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream << m_magic << m_version;
+    write(stream);
+    return stream.status() == QDataStream::Ok;
+}
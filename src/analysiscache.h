@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include <QString>
+#include <functional>
+
+class QDataStream;
+namespace Mlt {
+    class Producer;
+}
+
+/*!
+  \class AnalysisCache
+  \brief Stores the results of one kind of media analysis on disk.
+
+  Each kind of analysis has its own folder in the application data folder,
+  a file suffix, and a magic number and version that start every file, so
+  changing a format only misses the cache. Files are keyed on the media
+  hash, and the stream index when it is not the first, so that they
+  survive moving or renaming the media.
+*/
+
+class AnalysisCache
+{
+public:
+    AnalysisCache(const QString& folder, const QString& suffix, quint32 magic, qint32 version);
+
+    //! Returns the file for a stream of \a producer, or empty if it has no hash.
+    QString path(Mlt::Producer& producer, int streamIndex) const;
+    QString path(const QString& name) const;
+    //! Checks the header of \a path and passes the rest of it to \a read.
+    bool read(const QString& path, const std::function<bool(QDataStream&)>& read) const;
+    bool write(const QString& path, const std::function<void(QDataStream&)>& write) const;
+
+private:
+    QString m_folder;
+    QString m_suffix;
+    quint32 m_magic;
+    qint32 m_version;
+};
+
+#endif // ANALYSISCACHE_H
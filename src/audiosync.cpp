@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audiosync.h"
+#include "mltcontroller.h"
+#include "shotcut_mlt_properties.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QVariantList>
+#include <QtConcurrent/QtConcurrentRun>
+#include <Logger.h>
+#include <complex>
+#include <cmath>
+
+static const double kMinConfidence = 0.1;
+
+namespace {
+
+typedef std::complex<double> Complex;
+
+int fftSize(int length)
+{
+    int size = 1;
+    while (size < length)
+        size <<= 1;
+    return size;
+}
+
+// In-place iterative radix-2 FFT.
+void fft(QVector<Complex>& buffer, bool inverse)
+{
+    const int n = buffer.size();
+    Complex* data = buffer.data();
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+    // Compute the twiddle factors once for the largest stage to avoid the
+    // error that accumulates when multiplying them incrementally.
+    QVector<Complex> twiddles(n / 2);
+    for (int k = 0; k < n / 2; ++k)
+        twiddles[k] = std::polar(1.0, (inverse? 2.0 : -2.0) * M_PI * k / n);
+    for (int length = 2; length <= n; length <<= 1) {
+        int half = length / 2;
+        int step = n / length;
+        for (int i = 0; i < n; i += length) {
+            for (int j = 0; j < half; ++j) {
+                Complex u = data[i + j];
+                Complex v = data[i + j + half] * twiddles[j * step];
+                data[i + j] = u + v;
+                data[i + j + half] = u - v;
+            }
+        }
+    }
+    if (inverse) {
+        for (int i = 0; i < n; ++i)
+            data[i] /= n;
+    }
+}
+
+// Rectified first difference of the envelope with the mean removed so that
+// clips recorded at different levels still correlate.
+QVector<double> onsets(const QVector<float>& envelope, double* energy)
+{
+    QVector<double> result(envelope.size(), 0.0);
+    double sum = 0.0;
+    for (int i = 1; i < envelope.size(); ++i) {
+        result[i] = qMax(0.0, double(envelope[i]) - envelope[i - 1]);
+        sum += result[i];
+    }
+    double mean = result.isEmpty()? 0.0 : sum / result.size();
+    *energy = 0.0;
+    for (int i = 0; i < result.size(); ++i) {
+        result[i] -= mean;
+        *energy += result[i] * result[i];
+    }
+    return result;
+}
+
+QVector<Complex> transform(const QVector<double>& signal, int size)
+{
+    QVector<Complex> result(size, Complex(0.0, 0.0));
+    for (int i = 0; i < signal.size(); ++i)
+        result[i] = Complex(signal[i], 0.0);
+    fft(result, false);
+    return result;
+}
+
+AudioSync::Result crossCorrelate(const QVector<Complex>& referenceSpectrum, double referenceEnergy,
+                                 int referenceLength, const QVector<float>& envelope)
+{
+    AudioSync::Result result = {0, 0.0};
+    double energy = 0.0;
+    QVector<double> signal = onsets(envelope, &energy);
+    int size = referenceSpectrum.size();
+    if (signal.isEmpty() || referenceLength + signal.size() > size || energy <= 0.0 || referenceEnergy <= 0.0)
+        return result;
+
+    // correlation[k] = sum(reference[i + k] * other[i]), negative lags wrap.
+    QVector<Complex> buffer = transform(signal, size);
+    for (int i = 0; i < size; ++i)
+        buffer[i] = referenceSpectrum[i] * std::conj(buffer[i]);
+    fft(buffer, true);
+
+    double best = -1.0;
+    for (int lag = 1 - signal.size(); lag < referenceLength; ++lag) {
+        double value = buffer[lag < 0? lag + size : lag].real();
+        if (value > best) {
+            best = value;
+            result.offset = lag;
+        }
+    }
+    result.confidence = qBound(0.0, best / std::sqrt(referenceEnergy * energy), 1.0);
+    return result;
+}
+
+} // namespace
+
+AudioSync::Clip AudioSync::makeClip(Mlt::Producer& producer, int in, int out)
+{
+    Clip clip = {producer, in, out, QVector<float>()};
+    // Copy the cached waveform now because the audio levels task may replace it.
+    QVariantList* levels = static_cast<QVariantList*>(producer.get_data(kAudioLevelsProperty));
+    if (levels && in >= 0 && out >= in && levels->size() >= 2 * (out + 1)) {
+        clip.levels.reserve(out - in + 1);
+        for (int i = in; i <= out; ++i)
+            clip.levels << (levels->at(2 * i).toFloat() + levels->at(2 * i + 1).toFloat()) / 2.0f;
+    }
+    return clip;
+}
+
+QVector<AudioSync::Result> AudioSync::synchronize(QList<Clip> clips)
+{
+    Result none = {0, 0.0};
+    QVector<Result> results(clips.size(), none);
+    if (clips.size() < 2)
+        return results;
+    results[0].confidence = 1.0;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), clips.size()));
+    QList<QFuture<QVector<float>>> envelopes;
+    foreach (const Clip& clip, clips)
+        envelopes << QtConcurrent::run(&pool, &AudioSync::envelope, clip);
+
+    // Transform the reference once and share it with every comparison.
+    QVector<float> reference = envelopes.first().result();
+    int longest = 0;
+    for (int i = 1; i < envelopes.size(); ++i)
+        longest = qMax(longest, envelopes[i].result().size());
+    double referenceEnergy = 0.0;
+    QVector<Complex> referenceSpectrum = transform(onsets(reference, &referenceEnergy),
+                                                   fftSize(reference.size() + longest));
+    LOG_DEBUG() << "correlating" << clips.size() - 1 << "clips using FFT size" << referenceSpectrum.size();
+
+    QList<QFuture<Result>> futures;
+    for (int i = 1; i < envelopes.size(); ++i) {
+        QVector<float> envelope = envelopes[i].result();
+        futures << QtConcurrent::run(&pool, [&, envelope]() {
+            return crossCorrelate(referenceSpectrum, referenceEnergy, reference.size(), envelope);
+        });
+    }
+    for (int i = 0; i < futures.size(); ++i) {
+        results[i + 1] = futures[i].result();
+        LOG_DEBUG() << "clip" << i + 1 << "offset" << results[i + 1].offset
+                    << "confidence" << results[i + 1].confidence;
+    }
+    return results;
+}
+
+QVector<float> AudioSync::envelope(Clip clip)
+{
+    if (!clip.levels.isEmpty() || clip.out < clip.in)
+        return clip.levels;
+
+    // Not cached, so compute the same levels as AudioLevelsTask for the range.
+    QVector<float> result;
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    QString service = clip.producer.get("mlt_service");
+    if (service == "avformat-novalidate")
+        service = "avformat";
+    else if (service.startsWith("xml"))
+        service = "xml-nogl";
+    Mlt::Producer producer(profile, service.toUtf8().constData(), clip.producer.get("resource"));
+    if (!producer.is_valid())
+        return result;
+    Mlt::Filter channels(profile, "audiochannels");
+    Mlt::Filter converter(profile, "audioconvert");
+    Mlt::Filter levels(profile, "audiolevel");
+    producer.attach(channels);
+    producer.attach(converter);
+    producer.attach(levels);
+    if (clip.producer.get("audio_index"))
+        producer.pass_property(clip.producer, "audio_index");
+    producer.set("video_index", -1);
+
+    result.reserve(clip.out - clip.in + 1);
+    producer.seek(clip.in);
+    for (int i = clip.in; i <= clip.out; ++i) {
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        float level = 0.0f;
+        if (frame && frame->is_valid() && !frame->get_int("test_audio")) {
+            mlt_audio_format format = mlt_audio_s16;
+            int frequency = 48000;
+            int channelCount = 2;
+            int samples = mlt_sample_calculator(float(profile.fps()), frequency, i);
+            frame->get_audio(format, frequency, channelCount, samples);
+            double left = qMin(frame->get_double("meta.media.audio_level.0") * 0.9, 1.0);
+            double right = qMin(frame->get_double("meta.media.audio_level.1") * 0.9, 1.0);
+            level = 256 * (left + right) / 2.0;
+        }
+        result << level;
+    }
+    return result;
+}
+
+AudioSync::Result AudioSync::correlate(const QVector<float>& reference, const QVector<float>& other)
+{
+    double energy = 0.0;
+    QVector<Complex> spectrum = transform(onsets(reference, &energy),
+                                          fftSize(reference.size() + other.size()));
+    return crossCorrelate(spectrum, energy, reference.size(), other);
+}
+
+bool AudioSync::isConfident(const Result& result)
+{
+    return result.confidence >= kMinConfidence;
+}
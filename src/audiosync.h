@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOSYNC_H
+#define AUDIOSYNC_H
+
+#include <QList>
+#include <QVector>
+#include <MltProducer.h>
+
+/*!
+  \class AudioSync
+  \brief Finds the offsets that line up the audio of several clips.
+
+  Each clip is reduced to a per-frame loudness envelope, which is taken
+  from the audio levels already computed for the timeline waveforms when
+  available. The envelopes are turned into onset curves and compared with
+  FFT cross-correlation, one clip per thread.
+*/
+
+class AudioSync
+{
+public:
+    struct Clip {
+        Mlt::Producer producer; // the parent producer, not a cut
+        int in;
+        int out;
+        QVector<float> levels; // per-frame audio levels, if cached
+    };
+
+    struct Result {
+        int offset;        // frames from the start of the reference clip
+        double confidence; // normalized correlation, 0 to 1
+    };
+
+    /*!
+      Returns a result for every clip relative to the first one, whose own
+      result is always zero.
+    */
+    static QVector<Result> synchronize(QList<Clip> clips);
+
+    // Call this on the main thread before synchronize().
+    static Clip makeClip(Mlt::Producer& producer, int in, int out);
+
+    static QVector<float> envelope(Clip clip);
+    static Result correlate(const QVector<float>& reference, const QVector<float>& other);
+    static bool isConfident(const Result& result);
+};
+
+#endif // AUDIOSYNC_H
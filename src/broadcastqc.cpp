@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "broadcastqc.h"
+#include "loudnessanalysis.h"
+#include "mltcontroller.h"
+#include <QFile>
+#include <QDataStream>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QTime>
+#include <QVariantMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtMath>
+#include <Logger.h>
+#include <cmath>
+#include <cstring>
+
+static const quint32 kStatsMagic = 0x53515343; // "SQSC"
+static const quint16 kStatsVersion = 2;
+static const int kMaxWorkers = 8;
+static const int kProgressIntervalMs = 250;
+static const double kPrerollSeconds = 3.0; // the short-term loudness window
+static const int kFrequency = 48000;
+static const int kChannels = 2;
+
+// EBU R 103: luma within -1% to 103%, RGB within -5% to 105%, and at most
+// 1% of the pixels of a frame may be outside.
+static const int kLumaLow = 14;
+static const int kLumaHigh = 241;
+static const int kChromaLow = 16;
+static const int kChromaHigh = 240;
+static const int kGamutLow = -13056;  // -5% of 255 * 1024
+static const int kGamutHigh = 274176; // 105% of 255 * 1024
+static const int kMaxOutOfRange = 10; // per mille
+static const qint16 kSilence = -1000;
+
+namespace {
+
+qint16 toTenths(double value)
+{
+    if (!std::isfinite(value))
+        return kSilence;
+    return qint16(qBound(-1000, qRound(value * 10.0), 1000));
+}
+
+quint16 perMille(int count, int total)
+{
+    return total > 0? quint16(qint64(count) * 1000 / total) : 0;
+}
+
+} // namespace
+
+BroadcastQc::BroadcastQc(const QString& xml, const Limits& limits)
+    : m_xml(xml)
+    , m_limits(limits)
+{
+}
+
+bool BroadcastQc::analyze(std::function<void(int)> progress, std::function<bool()> isCanceled)
+{
+    m_frames.clear();
+    m_error.clear();
+
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    Mlt::Producer producer(profile, "xml-string", m_xml.toUtf8().constData());
+    if (!producer.is_valid()) {
+        m_error = tr("Failed to load the media to analyze.");
+        return false;
+    }
+    int count = producer.get_playtime();
+    if (count <= 0) {
+        m_error = tr("There are no frames to analyze.");
+        return false;
+    }
+
+    // Each worker loads its own producer and analyzes a contiguous range of
+    // frames so that no decoder state is shared between threads.
+    int chunks = qMin(count, qBound(1, QThread::idealThreadCount(), kMaxWorkers));
+    LOG_DEBUG() << "analyzing" << count << "frames in" << chunks << "chunks";
+    QThreadPool pool;
+    pool.setMaxThreadCount(chunks);
+    QVector<QVector<FrameStats>> results(chunks);
+    QList<QFuture<bool>> futures;
+    QAtomicInt done(0);
+    for (int i = 0; i < chunks; ++i) {
+        int begin = qint64(count) * i / chunks;
+        int end = qint64(count) * (i + 1) / chunks;
+        QVector<FrameStats>* frames = &results[i];
+        futures << QtConcurrent::run(&pool, [=, &done]() {
+            return analyzeChunk(begin, end, frames, &done, isCanceled);
+        });
+    }
+
+    int previousPercent = -1;
+    bool ok = true;
+    foreach (QFuture<bool> future, futures) {
+        while (!future.isFinished()) {
+            QThread::msleep(kProgressIntervalMs);
+            int percent = done.load() * 100 / count;
+            if (percent != previousPercent) {
+                progress(percent);
+                previousPercent = percent;
+            }
+        }
+        ok = future.result() && ok;
+    }
+    if (isCanceled())
+        return false;
+    if (!ok) {
+        m_error = tr("Failed to analyze all of the frames.");
+        return false;
+    }
+    m_frames.reserve(count);
+    foreach (const QVector<FrameStats>& frames, results)
+        m_frames += frames;
+    return true;
+}
+
+bool BroadcastQc::analyzeChunk(int begin, int end, QVector<FrameStats>* frames,
+                               QAtomicInt* done, std::function<bool()> isCanceled) const
+{
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    Mlt::Producer producer(profile, "xml-string", m_xml.toUtf8().constData());
+    Mlt::Filter meter(profile, "loudness_meter");
+    if (!producer.is_valid() || !meter.is_valid())
+        return false;
+    meter.set("calc_program", 0);
+    meter.set("calc_shortterm", 1);
+    meter.set("calc_momentary", 1);
+    meter.set("calc_range", 0);
+    meter.set("calc_peak", 0);
+    meter.set("calc_true_peak", 1);
+
+    // Start early enough to fill the short-term loudness window.
+    int preroll = qMin(begin, qCeil(kPrerollSeconds * profile.fps()));
+    producer.seek(begin - preroll);
+    frames->reserve(end - begin);
+    for (int position = begin - preroll; position < end; ++position) {
+        if (isCanceled())
+            return false;
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        if (!frame || !frame->is_valid())
+            return false;
+
+        mlt_audio_format audioFormat = mlt_audio_f32le;
+        int frequency = kFrequency;
+        int channels = kChannels;
+        int samples = mlt_sample_calculator(float(profile.fps()), frequency, position);
+        meter.process(*frame);
+        frame->get_audio(audioFormat, frequency, channels, samples);
+        if (position < begin)
+            continue;
+
+        FrameStats stats;
+        memset(&stats, 0, sizeof(stats));
+        stats.position = position;
+        stats.momentary = toTenths(meter.get_double("momentary"));
+        stats.shortTerm = toTenths(meter.get_double("shortterm"));
+        stats.truePeak = toTenths(meter.get_double("true_peak"));
+
+        mlt_image_format imageFormat = mlt_image_yuv420p;
+        int width = profile.width();
+        int height = profile.height();
+        frame->set("consumer_deinterlace", 1);
+        frame->set("rescale.interp", "bilinear");
+        const uint8_t* image = frame->get_image(imageFormat, width, height);
+        if (image && imageFormat == mlt_image_yuv420p)
+            analyzeImage(image, width, height, profile.colorspace(), stats);
+
+        frames->append(stats);
+        done->ref();
+    }
+    return true;
+}
+
+void BroadcastQc::analyzeImage(const uint8_t* image, int width, int height,
+                               int colorspace, FrameStats& stats)
+{
+    // YCbCr to RGB in 10-bit fixed point.
+    const int lumaScale = 1192;
+    const int crToR = colorspace == 601? 1634 : 1836;
+    const int cbToG = colorspace == 601? 401 : 218;
+    const int crToG = colorspace == 601? 832 : 546;
+    const int cbToB = colorspace == 601? 2066 : 2163;
+    const int chromaWidth = width / 2;
+    const int chromaHeight = height / 2;
+    const uint8_t* yPlane = image;
+    const uint8_t* uPlane = yPlane + width * height;
+    const uint8_t* vPlane = uPlane + chromaWidth * chromaHeight;
+    int lumaMin = 255;
+    int lumaMax = 0;
+    int64_t lumaSum = 0;
+    int lumaOut = 0;
+    int gamutOut = 0;
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* py = yPlane + y * width;
+        const uint8_t* pu = uPlane + qMin(y / 2, chromaHeight - 1) * chromaWidth;
+        const uint8_t* pv = vPlane + qMin(y / 2, chromaHeight - 1) * chromaWidth;
+        for (int x = 0; x < width; ++x) {
+            int luma = py[x];
+            int cx = qMin(x / 2, chromaWidth - 1);
+            int cb = pu[cx] - 128;
+            int cr = pv[cx] - 128;
+            lumaMin = qMin(lumaMin, luma);
+            lumaMax = qMax(lumaMax, luma);
+            lumaSum += luma;
+            if (luma < kLumaLow || luma > kLumaHigh)
+                ++lumaOut;
+            int l = lumaScale * (luma - 16);
+            int r = l + crToR * cr;
+            int g = l - cbToG * cb - crToG * cr;
+            int b = l + cbToB * cb;
+            if (r < kGamutLow || r > kGamutHigh || g < kGamutLow || g > kGamutHigh
+                    || b < kGamutLow || b > kGamutHigh)
+                ++gamutOut;
+        }
+    }
+
+    int chromaOut = 0;
+    int saturation = 0;
+    for (int i = 0; i < chromaWidth * chromaHeight; ++i) {
+        int cb = uPlane[i];
+        int cr = vPlane[i];
+        if (cb < kChromaLow || cb > kChromaHigh || cr < kChromaLow || cr > kChromaHigh)
+            ++chromaOut;
+        saturation = qMax(saturation, (cb - 128) * (cb - 128) + (cr - 128) * (cr - 128));
+    }
+
+    int pixels = width * height;
+    stats.lumaMin = quint8(lumaMin);
+    stats.lumaMax = quint8(lumaMax);
+    stats.lumaMean = pixels > 0? quint8(lumaSum / pixels) : 0;
+    stats.chromaMax = quint8(qMin(255, qRound(std::sqrt(double(saturation)))));
+    stats.lumaOut = perMille(lumaOut, pixels);
+    stats.chromaOut = perMille(chromaOut, chromaWidth * chromaHeight);
+    stats.gamutOut = perMille(gamutOut, pixels);
+}
+
+bool BroadcastQc::writeStats(const QString& path, int frameRateNum, int frameRateDen) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << kStatsMagic << kStatsVersion << qint32(frameRateNum) << qint32(frameRateDen)
+           << qint32(m_frames.size());
+    foreach (const FrameStats& s, m_frames) {
+        stream << s.position << s.lumaMin << s.lumaMax << s.lumaMean << s.chromaMax
+               << s.lumaOut << s.chromaOut << s.gamutOut << s.momentary << s.shortTerm << s.truePeak;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+QVector<BroadcastQc::FrameStats> BroadcastQc::readStats(const QString& path, double* fps)
+{
+    QVector<FrameStats> frames;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return frames;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint32 frameRateNum = 0, frameRateDen = 0, count = 0;
+    stream >> magic >> version >> frameRateNum >> frameRateDen >> count;
+    if (magic != kStatsMagic || version != kStatsVersion || count < 0) {
+        LOG_WARNING() << "invalid QC statistics file" << path;
+        return frames;
+    }
+    if (fps)
+        *fps = frameRateDen > 0? double(frameRateNum) / frameRateDen : 0.0;
+    frames.reserve(count);
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        FrameStats s;
+        stream >> s.position >> s.lumaMin >> s.lumaMax >> s.lumaMean >> s.chromaMax
+               >> s.lumaOut >> s.chromaOut >> s.gamutOut >> s.momentary >> s.shortTerm >> s.truePeak;
+        if (stream.status() == QDataStream::Ok)
+            frames.append(s);
+    }
+    return frames;
+}
+
+bool BroadcastQc::writeReport(const QString& path, double fps) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    auto timecode = [=](int position) {
+        return QTime::fromMSecsSinceStartOfDay(qRound(position * 1000.0 / fps)).toString("HH:mm:ss.zzz");
+    };
+    QVector<Region> list = regions(m_frames, m_limits);
+    int flagged = 0;
+    qint16 peak = kSilence;
+    qint16 shortTerm = kSilence;
+    foreach (const FrameStats& s, m_frames) {
+        if (violations(s, m_limits))
+            ++flagged;
+        peak = qMax(peak, s.truePeak);
+        shortTerm = qMax(shortTerm, s.shortTerm);
+    }
+    double program = programLoudness(m_frames);
+    stream << tr("Frames analyzed: %1\n").arg(m_frames.size());
+    stream << tr("Frames outside broadcast limits: %1\n").arg(flagged);
+    stream << tr("Maximum true peak: %1 dBTP (limit %2 dBTP)\n")
+              .arg(peak / 10.0, 0, 'f', 1).arg(m_limits.truePeak, 0, 'f', 1);
+    stream << tr("Maximum short-term loudness: %1 LUFS (limit %2 LUFS)\n")
+              .arg(shortTerm / 10.0, 0, 'f', 1).arg(m_limits.shortTerm, 0, 'f', 1);
+    if (std::isfinite(program)) {
+        stream << tr("Program loudness: %1 LUFS (target %2 +/- %3 LU)\n")
+                  .arg(program, 0, 'f', 1).arg(m_limits.programLoudness, 0, 'f', 1)
+                  .arg(m_limits.programTolerance, 0, 'f', 1);
+        if (qAbs(program - m_limits.programLoudness) > m_limits.programTolerance)
+            stream << tr("The program loudness is outside the target.\n");
+    }
+    stream << "\n";
+    foreach (const Region& r, list) {
+        stream << QString("%1 - %2  %3\n").arg(timecode(r.start)).arg(timecode(r.end))
+                  .arg(violationNames(r.violations));
+    }
+    return stream.status() == QTextStream::Ok;
+}
+
+BroadcastQc::Limits BroadcastQc::defaultLimits()
+{
+    Limits limits = {-1.0, -18.0, -23.0, 0.5};
+    return limits;
+}
+
+int BroadcastQc::violations(const FrameStats& stats, const Limits& limits)
+{
+    int result = NoViolation;
+    if (stats.lumaOut > kMaxOutOfRange)
+        result |= LumaViolation;
+    if (stats.chromaOut > kMaxOutOfRange)
+        result |= ChromaViolation;
+    if (stats.gamutOut > kMaxOutOfRange)
+        result |= GamutViolation;
+    if (stats.truePeak > toTenths(limits.truePeak))
+        result |= AudioViolation;
+    if (stats.shortTerm > toTenths(limits.shortTerm))
+        result |= LoudnessViolation;
+    return result;
+}
+
+QVector<BroadcastQc::Region> BroadcastQc::regions(const QVector<FrameStats>& frames, const Limits& limits)
+{
+    QVector<Region> result;
+    foreach (const FrameStats& s, frames) {
+        int v = violations(s, limits);
+        if (v == NoViolation)
+            continue;
+        if (!result.isEmpty() && result.last().end + 1 == s.position) {
+            result.last().end = s.position;
+            result.last().violations |= v;
+        } else {
+            Region r = {s.position, s.position, v};
+            result.append(r);
+        }
+    }
+    return result;
+}
+
+double BroadcastQc::programLoudness(const QVector<FrameStats>& frames)
+{
+    // Each frame holds the loudness of the 400 ms block that ends there.
+    LoudnessAnalysis::Histogram histogram;
+    foreach (const FrameStats& s, frames) {
+        if (s.momentary > kSilence)
+            histogram.addBlock(std::pow(10.0, (s.momentary / 10.0 + 0.691) / 10.0));
+    }
+    return histogram.integrated();
+}
+
+QVariantList BroadcastQc::regionsForJS(const QVector<Region>& regions)
+{
+    QVariantList result;
+    foreach (const Region& r, regions) {
+        QVariantMap map;
+        map["start"] = r.start;
+        map["end"] = r.end;
+        map["violations"] = r.violations;
+        map["video"] = bool(r.violations & (LumaViolation | ChromaViolation | GamutViolation));
+        map["text"] = violationNames(r.violations);
+        result << map;
+    }
+    return result;
+}
+
+QString BroadcastQc::violationNames(int violations)
+{
+    QStringList names;
+    if (violations & LumaViolation)
+        names << tr("Luma");
+    if (violations & ChromaViolation)
+        names << tr("Chroma");
+    if (violations & GamutViolation)
+        names << tr("RGB gamut");
+    if (violations & AudioViolation)
+        names << tr("True peak");
+    if (violations & LoudnessViolation)
+        names << tr("Loudness");
+    return names.join(", ");
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BROADCASTQC_H
+#define BROADCASTQC_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+#include <QVariantList>
+#include <QAtomicInt>
+#include <functional>
+#include <stdint.h>
+
+/*!
+  \class BroadcastQc
+  \brief Checks every frame of a clip or timeline against broadcast limits.
+
+  This runs the luma (waveform and histogram), chroma (vectorscope) and RGB
+  gamut checks of the video scopes plus a loudness meter over a whole
+  producer. The frame range is split into contiguous chunks that are
+  analyzed in parallel, each with its own producer. The video limits
+  follow EBU R 103. The audio limits are configurable and default to
+  EBU R 128: -23 LUFS program loudness, at most -1 dBTP true peak and, as
+  for short-form content, at most -18 LUFS short-term loudness.
+*/
+
+class BroadcastQc
+{
+    Q_DECLARE_TR_FUNCTIONS(BroadcastQc)
+
+public:
+    enum Violation {
+        NoViolation = 0,
+        LumaViolation = 1,
+        ChromaViolation = 2,
+        GamutViolation = 4,
+        AudioViolation = 8,    // true peak
+        LoudnessViolation = 16 // short-term loudness
+    };
+
+    struct Limits {
+        double truePeak;         // dBTP
+        double shortTerm;        // LUFS
+        double programLoudness;  // LUFS
+        double programTolerance; // LU
+    };
+
+    // Pixel counts are stored in per mille to keep the statistics file small.
+    struct FrameStats {
+        qint32 position;
+        quint8 lumaMin;
+        quint8 lumaMax;
+        quint8 lumaMean;
+        quint8 chromaMax;
+        quint16 lumaOut;
+        quint16 chromaOut;
+        quint16 gamutOut;
+        qint16 momentary; // LUFS * 10
+        qint16 shortTerm; // LUFS * 10
+        qint16 truePeak;  // dBTP * 10
+    };
+
+    struct Region {
+        int start;
+        int end;
+        int violations;
+    };
+
+    explicit BroadcastQc(const QString& xml, const Limits& limits = defaultLimits());
+
+    /*!
+      Analyzes every frame and returns true when all frames were analyzed.
+      \a progress receives a percentage, and \a isCanceled is polled between
+      frames.
+    */
+    bool analyze(std::function<void(int)> progress, std::function<bool()> isCanceled);
+
+    const QVector<FrameStats>& frames() const { return m_frames; }
+    QString errorString() const { return m_error; }
+    bool writeStats(const QString& path, int frameRateNum, int frameRateDen) const;
+    bool writeReport(const QString& path, double fps) const;
+
+    static QVector<FrameStats> readStats(const QString& path, double* fps = nullptr);
+    static Limits defaultLimits();
+    static int violations(const FrameStats& stats, const Limits& limits);
+    static QVector<Region> regions(const QVector<FrameStats>& frames, const Limits& limits);
+    //! Returns the gated program loudness in LUFS from the momentary loudness of every frame.
+    static double programLoudness(const QVector<FrameStats>& frames);
+    static QVariantList regionsForJS(const QVector<Region>& regions);
+    static QString violationNames(int violations);
+    static void analyzeImage(const uint8_t* image, int width, int height,
+                             int colorspace, FrameStats& stats);
+
+private:
+    bool analyzeChunk(int begin, int end, QVector<FrameStats>* frames,
+                      QAtomicInt* done, std::function<bool()> isCanceled) const;
+
+    QString m_xml;
+    Limits m_limits;
+    QVector<FrameStats> m_frames;
+    QString m_error;
+};
+
+#endif // BROADCASTQC_H
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "colorfusion.h"
+#include "mltcontroller.h"
+#include "shotcut_mlt_properties.h"
+#include "util.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <MltFilter.h>
+#include <MltFrame.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+#include <Logger.h>
+
+static const char* kFusedObjectName = "fusedColor";
+static const char* kLutFolder = "luts";
+static const int kLutSize = 33;
+// Colors are drawn as blocks so that 4:2:2 conversions between the
+// filters do not blend neighboring colors.
+static const int kCellWidth = 4;
+static const int kCellHeight = 2;
+static const int kLatticeColumns = 192;
+// Lattice points are about 8 code values apart, and the error of
+// interpolating between them peaks mid-cell where a curve such as a gamma
+// or levels adjustment bends the most. For the curves these filters make,
+// that stays within 3 codes, and the 4:2:2 conversions between the
+// original filters add up to one more. A larger error means a filter did
+// not behave as a function of the color alone, so the fusion is refused.
+static const int kMaxError = 4;
+static const double kMaxMeanError = 0.5;
+
+namespace {
+
+// Services whose output pixel depends only on the same input pixel.
+const QSet<QString> fusableServices = QSet<QString>()
+    << "brightness" << "lift_gamma_gain" << "sepia" << "invert" << "tcolor"
+    << "frei0r.saturat0r" << "frei0r.levels" << "frei0r.colgate" << "frei0r.coloradj_RGB"
+    << "avfilter.hue" << "avfilter.lut3d" << "shotcut.lut3d";
+
+// Brightness is also used for opacity and fades, which change alpha.
+const QSet<QString> fusableObjectNames = QSet<QString>()
+    << QString() << "contrast" << kFusedObjectName;
+
+class Random
+{
+public:
+    Random() : m_state(0x9E3779B9) {}
+    int next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state & 0xff;
+    }
+private:
+    quint32 m_state;
+};
+
+int latticeLevel(int i)
+{
+    return qRound(i * 255.0 / (kLutSize - 1));
+}
+
+void fillCell(QImage& image, int cell, int columns, QRgb color)
+{
+    int x0 = (cell % columns) * kCellWidth;
+    int y0 = (cell / columns) * kCellHeight;
+    for (int y = y0; y < y0 + kCellHeight; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = x0; x < x0 + kCellWidth; ++x)
+            line[x] = color;
+    }
+}
+
+QImage latticeImage()
+{
+    int cells = kLutSize * kLutSize * kLutSize;
+    int rows = (cells + kLatticeColumns - 1) / kLatticeColumns;
+    QImage image(kLatticeColumns * kCellWidth, rows * kCellHeight, QImage::Format_RGB32);
+    image.fill(Qt::black);
+    // Red changes fastest as in the .cube format.
+    for (int i = 0; i < cells; ++i) {
+        fillCell(image, i, kLatticeColumns, qRgb(latticeLevel(i % kLutSize),
+                                                 latticeLevel(i / kLutSize % kLutSize),
+                                                 latticeLevel(i / kLutSize / kLutSize)));
+    }
+    return image;
+}
+
+QImage testImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    Random random;
+    int columns = width / kCellWidth;
+    int cells = columns * (height / kCellHeight);
+    for (int i = 0; i < cells; ++i) {
+        int r = random.next();
+        int g = random.next();
+        int b = random.next();
+        fillCell(image, i, columns, qRgb(r, g, b));
+    }
+    return image;
+}
+
+Mlt::Filter* copyFilter(Mlt::Profile& profile, Mlt::Filter& filter)
+{
+    Mlt::Filter* copy = new Mlt::Filter(profile, filter.get("mlt_service"));
+    if (copy->is_valid()) {
+        for (int i = 0; i < filter.count(); ++i) {
+            const char* name = filter.get_name(i);
+            const char* value = filter.get(i);
+            if (name && value && name[0] != '_' && qstrcmp(name, "in") && qstrcmp(name, "out")
+                    && qstrncmp(name, "mlt_", 4))
+                copy->set(name, value);
+        }
+    }
+    return copy;
+}
+
+// Renders an image file through copies of the filters and returns its
+// RGB pixels or an empty array.
+QByteArray render(Mlt::Profile& profile, const QString& path, const QList<Mlt::Filter*>& filters)
+{
+    QByteArray result;
+    Mlt::Producer producer(profile, path.toUtf8().constData());
+    if (!producer.is_valid())
+        return result;
+    QList<Mlt::Filter*> copies;
+    foreach (Mlt::Filter* filter, filters) {
+        Mlt::Filter* copy = copyFilter(profile, *filter);
+        if (copy->is_valid())
+            producer.attach(*copy);
+        copies << copy;
+    }
+    QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+    mlt_image_format format = mlt_image_rgb24;
+    int width = profile.width();
+    int height = profile.height();
+    const uint8_t* image = frame? frame->get_image(format, width, height) : 0;
+    if (image && format == mlt_image_rgb24 && width == profile.width() && height == profile.height())
+        result = QByteArray(reinterpret_cast<const char*>(image), width * height * 3);
+    frame.reset();
+    foreach (Mlt::Filter* copy, copies) {
+        producer.detach(*copy);
+        delete copy;
+    }
+    return result;
+}
+
+void setProfileSize(Mlt::Profile& profile, int width, int height)
+{
+    profile.set_width(width);
+    profile.set_height(height);
+    profile.set_sample_aspect(1, 1);
+    profile.set_display_aspect(width, height);
+    profile.set_progressive(1);
+}
+
+bool writeCube(const QString& path, const QByteArray& rgb, int imageWidth)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    stream << "TITLE \"Shotcut fused color\"\n";
+    stream << "LUT_3D_SIZE " << kLutSize << "\n";
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(rgb.constData());
+    int cells = kLutSize * kLutSize * kLutSize;
+    for (int i = 0; i < cells; ++i) {
+        // Average the block to cancel chroma rounding at its edges.
+        int x0 = (i % kLatticeColumns) * kCellWidth;
+        int y0 = (i / kLatticeColumns) * kCellHeight;
+        double sum[3] = {0.0, 0.0, 0.0};
+        for (int y = y0; y < y0 + kCellHeight; ++y) {
+            const uint8_t* p = pixels + (y * imageWidth + x0) * 3;
+            for (int x = 0; x < kCellWidth * 3; ++x)
+                sum[x % 3] += p[x];
+        }
+        for (int c = 0; c < 3; ++c) {
+            stream << QString::number(sum[c] / (kCellWidth * kCellHeight * 255.0), 'f', 6)
+                   << (c < 2? " " : "\n");
+        }
+    }
+    stream.flush();
+    return file.error() == QFileDevice::NoError;
+}
+
+QJsonObject filterToJson(Mlt::Filter& filter)
+{
+    QJsonObject object;
+    for (int i = 0; i < filter.count(); ++i) {
+        const char* name = filter.get_name(i);
+        const char* value = filter.get(i);
+        if (name && value && name[0] != '_' && qstrcmp(name, "mlt_type"))
+            object.insert(QString::fromUtf8(name), QString::fromUtf8(value));
+    }
+    return object;
+}
+
+} // namespace
+
+bool ColorFusion::isFusable(Mlt::Producer& producer, Mlt::Filter& filter)
+{
+    if (!filter.is_valid() || filter.get_int("_loader") || filter.get_int("disable"))
+        return false;
+    if (!fusableServices.contains(filter.get("mlt_service"))
+            || !fusableObjectNames.contains(QString::fromUtf8(filter.get(kShotcutFilterProperty))))
+        return false;
+    // Levels can draw a histogram over the image.
+    if (!qstrcmp(filter.get("mlt_service"), "frei0r.levels") && filter.get_double("6") > 0.0)
+        return false;
+    if (QString::fromLatin1(filter.get("mlt_service")).endsWith(".lut3d") && !QFile::exists(filter.get("av.file")))
+        return false;
+    for (int i = 0; i < filter.count(); ++i) {
+        const char* name = filter.get_name(i);
+        if (name && name[0] != '_' && Util::isKeyframed(filter.get(i)))
+            return false;
+    }
+    // A filter that does not cover the whole clip is not the same everywhere.
+    if (filter.get_in() > 0 || filter.get_out() > 0) {
+        int in = producer.get(kFilterInProperty)? producer.get_int(kFilterInProperty) : producer.get_in();
+        int out = producer.get(kFilterOutProperty)? producer.get_int(kFilterOutProperty) : producer.get_out();
+        if (filter.get_in() > in || filter.get_out() < out)
+            return false;
+    }
+    return true;
+}
+
+QList<ColorFusion::Run> ColorFusion::findRuns(Mlt::Producer& producer)
+{
+    QList<Run> runs;
+    Run run;
+    int count = producer.filter_count();
+    for (int i = 0; i <= count; ++i) {
+        QScopedPointer<Mlt::Filter> filter(i < count? producer.filter(i) : 0);
+        if (filter && filter->is_valid() && filter->get_int("_loader"))
+            continue;
+        if (filter && isFusable(producer, *filter)) {
+            run << i;
+        } else {
+            if (run.size() > 1)
+                runs << run;
+            run.clear();
+        }
+    }
+    return runs;
+}
+
+bool ColorFusion::isFused(Mlt::Filter& filter)
+{
+    return filter.is_valid() && filter.get(kFusedFiltersProperty);
+}
+
+QString ColorFusion::lutFolder(const QString& projectFileName)
+{
+    return QFileInfo(projectFileName).dir().filePath(kLutFolder);
+}
+
+Mlt::Filter* ColorFusion::fuse(Mlt::Producer& producer, const Run& run, const QString& folder,
+                               QString* errorString)
+{
+    QList<Mlt::Filter*> filters;
+    QJsonArray json;
+    foreach (int index, run) {
+        Mlt::Filter* filter = producer.filter(index);
+        if (!filter || !isFusable(producer, *filter)) {
+            delete filter;
+            qDeleteAll(filters);
+            if (errorString)
+                *errorString = tr("The filters changed before they could be combined.");
+            return 0;
+        }
+        filters << filter;
+        json << filterToJson(*filter);
+    }
+    QByteArray jsonData = QJsonDocument(json).toJson(QJsonDocument::Compact);
+
+    QDir dir(folder);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qDeleteAll(filters);
+        if (errorString)
+            *errorString = tr("Failed to create the folder %1").arg(QDir::toNativeSeparators(folder));
+        return 0;
+    }
+    QString cubePath = dir.filePath(QString("fused-%1.cube")
+        .arg(QString(QCryptographicHash::hash(jsonData, QCryptographicHash::Md5).toHex())));
+
+    QTemporaryDir tmp;
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    bool ok = tmp.isValid();
+    QString error = tr("Failed to render the filters.");
+
+    if (ok && !QFile::exists(cubePath)) {
+        QImage lattice = latticeImage();
+        QString latticePath = tmp.filePath("lattice.png");
+        setProfileSize(profile, lattice.width(), lattice.height());
+        QByteArray rgb;
+        ok = lattice.save(latticePath);
+        if (ok)
+            rgb = render(profile, latticePath, filters);
+        ok = !rgb.isEmpty() && writeCube(cubePath, rgb, lattice.width());
+        if (!ok)
+            QFile::remove(cubePath);
+    }
+
+    Mlt::Filter lut(profile, Util::lut3dService().toLatin1().constData());
+    if (ok) {
+        lut.set("av.file", cubePath.toUtf8().constData());
+        lut.set("av.interp", "tetrahedral");
+        ok = lut.is_valid();
+    }
+
+    // Compare the LUT with the filters on colors it did not sample.
+    if (ok) {
+        QImage test = testImage(512, 256);
+        QString testPath = tmp.filePath("test.png");
+        setProfileSize(profile, test.width(), test.height());
+        ok = test.save(testPath);
+        QByteArray expected = ok? render(profile, testPath, filters) : QByteArray();
+        QByteArray actual = ok? render(profile, testPath, QList<Mlt::Filter*>() << &lut) : QByteArray();
+        ok = !expected.isEmpty() && expected.size() == actual.size();
+        if (ok) {
+            int maxError = 0;
+            qint64 sum = 0;
+            for (int i = 0; i < expected.size(); ++i) {
+                int d = qAbs(int(uint8_t(expected[i])) - int(uint8_t(actual[i])));
+                maxError = qMax(maxError, d);
+                sum += d;
+            }
+            double meanError = double(sum) / expected.size();
+            LOG_INFO() << "fused" << filters.size() << "filters, max error" << maxError << "mean error" << meanError;
+            if (maxError > kMaxError || meanError > kMaxMeanError) {
+                ok = false;
+                error = tr("The combined filters differ too much from the originals.");
+                QFile::remove(cubePath);
+            }
+        }
+    }
+
+    Mlt::Filter* result = 0;
+    if (ok) {
+        result = new Mlt::Filter(MLT.profile(), Util::lut3dService().toLatin1().constData());
+        result->set(kShotcutFilterProperty, kFusedObjectName);
+        result->set("av.file", cubePath.toUtf8().constData());
+        result->set("av.interp", "tetrahedral");
+        result->set(kFusedFiltersProperty, jsonData.constData());
+        result->set_in_and_out(filters.first()->get_in(), filters.first()->get_out());
+    } else if (errorString) {
+        *errorString = error;
+    }
+    qDeleteAll(filters);
+    return result;
+}
+
+QList<Mlt::Filter*> ColorFusion::unfuse(Mlt::Filter& filter)
+{
+    QList<Mlt::Filter*> result;
+    QJsonDocument doc = QJsonDocument::fromJson(QByteArray(filter.get(kFusedFiltersProperty)));
+    foreach (const QJsonValue& value, doc.array()) {
+        QJsonObject object = value.toObject();
+        Mlt::Filter* original = new Mlt::Filter(MLT.profile(),
+                                                object.value("mlt_service").toString().toUtf8().constData());
+        if (!original->is_valid()) {
+            delete original;
+            qDeleteAll(result);
+            return QList<Mlt::Filter*>();
+        }
+        foreach (const QString& name, object.keys()) {
+            if (name != "mlt_service" && name != "in" && name != "out")
+                original->set(name.toUtf8().constData(), object.value(name).toString().toUtf8().constData());
+        }
+        original->set_in_and_out(object.value("in").toString().toInt(), object.value("out").toString().toInt());
+        result << original;
+    }
+    return result;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COLORFUSION_H
+#define COLORFUSION_H
+
+#include <QCoreApplication>
+#include <QList>
+#include <QString>
+
+namespace Mlt {
+    class Filter;
+    class Producer;
+}
+
+/*!
+  \class ColorFusion
+  \brief Collapses stacked per-pixel color filters into one 3D LUT.
+
+  Filters such as Brightness, Contrast, Saturation, Levels and Sepia each
+  make a full pass over the image with a conversion in between. When
+  several of them are adjacent on a clip and none of them is animated,
+  their combined effect is a function of the input color alone. This
+  renders a lattice of colors through copies of the filters, writes the
+  outputs as a .cube file in a luts folder next to the project, and
+  replaces the run with one LUT (3D) filter, which shares parsed tables
+  with the other LUT filters. The project refers to
+  the file like any other resource, so it moves and packages with the
+  project. The fused LUT is checked against the original filters on a
+  test image before it is used. The original filters are kept as JSON on
+  the fused filter so that they can be restored.
+*/
+
+class ColorFusion
+{
+    Q_DECLARE_TR_FUNCTIONS(ColorFusion)
+
+public:
+    typedef QList<int> Run; // adjacent MLT filter indices
+
+    static bool isFusable(Mlt::Producer& producer, Mlt::Filter& filter);
+    static QList<Run> findRuns(Mlt::Producer& producer);
+    static bool isFused(Mlt::Filter& filter);
+    //! Returns the folder for the tables of the project saved at \a projectFileName.
+    static QString lutFolder(const QString& projectFileName);
+
+    /*!
+      Returns a new lut3d filter equivalent to the filters of the run with
+      its table written to \a folder, or null with errorString set when the
+      LUT does not match them closely enough. The caller owns the result
+      and attaches it.
+    */
+    static Mlt::Filter* fuse(Mlt::Producer& producer, const Run& run, const QString& folder,
+                             QString* errorString = 0);
+
+    // Returns new filters rebuilt from a fused filter. The caller owns them.
+    static QList<Mlt::Filter*> unfuse(Mlt::Filter& filter);
+};
+
+#endif // COLORFUSION_H
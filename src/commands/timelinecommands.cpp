@@ -166,6 +166,42 @@ void OverwriteCommand::undo()
     m_undoHelper.undoChanges();
 }
 
+PasteCommand::PasteCommand(MultitrackModel &model, int trackIndex, int position,
+    const QList<TimelineClipboard::Item>& items, QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , m_model(model)
+    , m_trackIndex(trackIndex)
+    , m_position(position)
+    , m_items(items)
+    , m_undoHelper(m_model)
+{
+    setText(QObject::tr("Paste %1 timeline clips").arg(items.size()));
+}
+
+void PasteCommand::redo()
+{
+    LOG_DEBUG() << "trackIndex" << m_trackIndex << "position" << m_position << "clips" << m_items.size();
+    // Record the state once for the whole batch rather than once per clip.
+    m_undoHelper.recordBeforeState();
+    foreach (const TimelineClipboard::Item& item, m_items) {
+        int trackIndex = m_trackIndex + item.trackOffset;
+        if (trackIndex >= m_model.trackList().size())
+            continue;
+        Mlt::Producer clip = TimelineClipboard::materialize(item);
+        if (!clip.is_valid())
+            continue;
+        ProxyManager::generateIfNotExists(clip);
+        m_model.overwrite(trackIndex, clip, m_position + item.position, false);
+    }
+    m_undoHelper.recordAfterState();
+}
+
+void PasteCommand::undo()
+{
+    LOG_DEBUG() << "trackIndex" << m_trackIndex << "position" << m_position;
+    m_undoHelper.undoChanges();
+}
+
 LiftCommand::LiftCommand(MultitrackModel &model, int trackIndex,
     int clipIndex, QUndoCommand *parent)
     : QUndoCommand(parent)
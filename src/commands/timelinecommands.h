@@ -21,6 +21,7 @@
 #include "models/multitrackmodel.h"
 #include "docks/timelinedock.h"
 #include "undohelper.h"
+#include "timelineclipboard.h"
 #include <QUndoCommand>
 #include <QString>
 #include <QObject>
@@ -87,6 +88,21 @@ private:
     bool m_seek;
 };
 
+class PasteCommand : public QUndoCommand
+{
+public:
+    PasteCommand(MultitrackModel& model, int trackIndex, int position,
+                 const QList<TimelineClipboard::Item>& items, QUndoCommand * parent = 0);
+    void redo();
+    void undo();
+private:
+    MultitrackModel& m_model;
+    int m_trackIndex;
+    int m_position;
+    QList<TimelineClipboard::Item> m_items;
+    UndoHelper m_undoHelper;
+};
+
 class LiftCommand : public QUndoCommand
 {
 public:
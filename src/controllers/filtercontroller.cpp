@@ -27,6 +27,7 @@
 #include "qmltypes/qmlmetadata.h"
 #include "qmltypes/qmlutilities.h"
 #include "qmltypes/qmlfilter.h"
+#include "util.h"
 
 FilterController::FilterController(QObject* parent) : QObject(parent),
  m_mltFilter(0),
@@ -56,6 +57,8 @@ void FilterController::loadFilterMetadata() {
             QQmlComponent component(QmlUtilities::sharedEngine(), subdir.absoluteFilePath(fileName));
             QmlMetadata *meta = qobject_cast<QmlMetadata*>(component.create());
             if (meta) {
+                if (meta->mlt_service() == "shotcut.lut3d")
+                    meta->set_mlt_service(Util::lut3dService());
                 // Check if mlt_service is available.
                 if (mltFilters->get_data(meta->mlt_service().toLatin1().constData())) {
                     LOG_DEBUG() << "added filter" << meta->name();
@@ -86,8 +89,6 @@ void FilterController::loadFilterMetadata() {
 
 QmlMetadata *FilterController::metadataForService(Mlt::Service *service)
 {
-    QmlMetadata* meta = 0;
-    int rowCount = m_metadataModel.rowCount();
     QString uniqueId = service->get(kShotcutFilterProperty);
 
     // Fallback to mlt_service for legacy filters
@@ -95,15 +96,7 @@ QmlMetadata *FilterController::metadataForService(Mlt::Service *service)
         uniqueId = service->get("mlt_service");
     }
 
-    for (int i = 0; i < rowCount; i++) {
-        QmlMetadata* tmpMeta = m_metadataModel.get(i);
-        if (tmpMeta->uniqueId() == uniqueId) {
-            meta = tmpMeta;
-            break;
-        }
-    }
-
-    return meta;
+    return m_metadataIndex.value(uniqueId);
 }
 
 void FilterController::timerEvent(QTimerEvent* event)
@@ -240,4 +233,7 @@ void FilterController::onProducerChanged()
 void FilterController::addMetadata(QmlMetadata* meta)
 {
     m_metadataModel.add(meta);
+    // Keep the first one like a search of the metadata model would.
+    if (!m_metadataIndex.contains(meta->uniqueId()))
+        m_metadataIndex.insert(meta->uniqueId(), meta);
 }
@@ -21,6 +21,7 @@
 #include <QObject>
 #include <QScopedPointer>
 #include <QFuture>
+#include <QHash>
 #include "models/metadatamodel.h"
 #include "models/attachedfiltersmodel.h"
 #include "qmltypes/qmlmetadata.h"
@@ -76,6 +77,7 @@ private:
     QScopedPointer<QmlFilter> m_currentFilter;
     Mlt::Filter* m_mltFilter;
     MetadataModel m_metadataModel;
+    QHash<QString, QmlMetadata*> m_metadataIndex; // keyed by QmlMetadata::uniqueId()
     AttachedFiltersModel m_attachedModel;
     int m_currentFilterIndex;
 };
@@ -34,6 +34,7 @@
 
 ScopeController::ScopeController(QMainWindow* mainWindow, QMenu* menu)
   : QObject(mainWindow)
+  , m_videoScopesShown(0)
 {
     LOG_DEBUG() << "begin";
     QMenu* scopeMenu = menu->addMenu(tr("Scopes"));
@@ -42,22 +43,31 @@ ScopeController::ScopeController(QMainWindow* mainWindow, QMenu* menu)
     createScopeDock<AudioSpectrumScopeWidget>(mainWindow, scopeMenu);
     createScopeDock<AudioWaveformScopeWidget>(mainWindow, scopeMenu);
     if (!Settings.playerGPU()) {
-        createScopeDock<VideoHistogramScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoRgbParadeScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoRgbWaveformScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoVectorScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoZoomScopeWidget>(mainWindow, scopeMenu);
+        createScopeDock<VideoHistogramScopeWidget>(mainWindow, scopeMenu, true);
+        createScopeDock<VideoRgbParadeScopeWidget>(mainWindow, scopeMenu, true);
+        createScopeDock<VideoRgbWaveformScopeWidget>(mainWindow, scopeMenu, true);
+        createScopeDock<VideoVectorScopeWidget>(mainWindow, scopeMenu, true);
+        createScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu, true);
+        createScopeDock<VideoZoomScopeWidget>(mainWindow, scopeMenu, true);
     }
     LOG_DEBUG() << "end";
 }
 
-template<typename ScopeTYPE> void ScopeController::createScopeDock(QMainWindow* mainWindow, QMenu* menu)
+template<typename ScopeTYPE> void ScopeController::createScopeDock(QMainWindow* mainWindow, QMenu* menu, bool isVideo)
 {
     ScopeWidget* scopeWidget = new ScopeTYPE();
     ScopeDock* scopeDock = new ScopeDock(this, scopeWidget);
     scopeDock->hide();
     menu->addAction(scopeDock->toggleViewAction());
     mainWindow->addDockWidget(Qt::RightDockWidgetArea, scopeDock);
+    if (isVideo)
+        connect(scopeDock->toggleViewAction(), SIGNAL(toggled(bool)), SLOT(onVideoScopeToggled(bool)));
+}
+
+void ScopeController::onVideoScopeToggled(bool checked)
+{
+    m_videoScopesShown += checked? 1 : -1;
+    if (m_videoScopesShown == (checked? 1 : 0))
+        emit videoScopesShownChanged(checked);
 }
 
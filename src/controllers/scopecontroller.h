@@ -36,9 +36,15 @@ public:
 
 signals:
     void newFrame(const SharedFrame& frame);
+    void videoScopesShownChanged(bool shown);
+
+private slots:
+    void onVideoScopeToggled(bool checked);
 
 private:
-    template<typename ScopeTYPE> void createScopeDock(QMainWindow* mainWindow, QMenu* menu);
+    template<typename ScopeTYPE> void createScopeDock(QMainWindow* mainWindow, QMenu* menu, bool isVideo = false);
+
+    int m_videoScopesShown;
 
 };
 
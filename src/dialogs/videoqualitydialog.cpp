@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videoqualitydialog.h"
+#include "widgets/videoqualitygraph.h"
+#include "dialogs/textviewerdialog.h"
+#include <QVBoxLayout>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QListWidget>
+#include <QLabel>
+#include <QFile>
+#include <QTime>
+
+static const int WORST_SEGMENT_COUNT = 10;
+
+VideoQualityDialog::VideoQualityDialog(const QString& csvPath, const QString& reportPath,
+                                       double fps, QWidget* parent)
+    : QDialog(parent)
+    , m_reportPath(reportPath)
+    , m_fps(fps > 0.0? fps : 25.0)
+{
+    setWindowTitle(tr("Video Quality Measurement"));
+    setSizeGripEnabled(true);
+    resize(700, 450);
+
+    QVector<VideoQualityMeter::FrameResult> results = VideoQualityMeter::readCsv(csvPath);
+    m_segments = VideoQualityMeter::worstSegments(results, qRound(m_fps), WORST_SEGMENT_COUNT);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    m_summaryLabel = new QLabel(this);
+    layout->addWidget(m_summaryLabel);
+    m_graph = new VideoQualityGraph(this);
+    m_graph->setResults(results);
+    m_graph->setSegments(m_segments);
+    layout->addWidget(m_graph, 2);
+    layout->addWidget(new QLabel(tr("Worst segments"), this));
+    m_segmentsList = new QListWidget(this);
+    layout->addWidget(m_segmentsList, 1);
+    connect(m_segmentsList, SIGNAL(currentRowChanged(int)), SLOT(onSegmentRowChanged(int)));
+
+    if (!results.isEmpty()) {
+        double psnr = 0.0;
+        double ssim = 0.0;
+        foreach (const VideoQualityMeter::FrameResult& r, results) {
+            psnr += r.psnr[VideoQualityMeter::PlaneY];
+            ssim += r.ssim[VideoQualityMeter::PlaneY];
+        }
+        m_summaryLabel->setText(tr("%1 frames, average Y PSNR %2 dB, average Y SSIM %3")
+                                .arg(results.size())
+                                .arg(psnr / results.size(), 0, 'f', 2)
+                                .arg(ssim / results.size(), 0, 'f', 4));
+    } else {
+        m_summaryLabel->setText(tr("The results could not be read from %1").arg(csvPath));
+    }
+    foreach (const VideoQualityMeter::Segment& s, m_segments) {
+        m_segmentsList->addItem(tr("%1 - %2    Y SSIM %3    Y PSNR %4 dB")
+                                .arg(timecode(s.start)).arg(timecode(s.end))
+                                .arg(s.ssim, 0, 'f', 4).arg(s.psnr, 0, 'f', 2));
+    }
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton* button = buttons->addButton(tr("View Report"), QDialogButtonBox::ActionRole);
+    button->setEnabled(QFile::exists(m_reportPath));
+    connect(button, SIGNAL(clicked()), SLOT(onViewReportClicked()));
+    connect(buttons, SIGNAL(rejected()), SLOT(reject()));
+    layout->addWidget(buttons);
+}
+
+void VideoQualityDialog::onSegmentRowChanged(int row)
+{
+    m_graph->setHighlightedSegment(row);
+}
+
+void VideoQualityDialog::onViewReportClicked()
+{
+    TextViewerDialog dialog(this);
+    dialog.setWindowTitle(tr("Video Quality Report"));
+    QFile f(m_reportPath);
+    f.open(QIODevice::ReadOnly);
+    QString s(f.readAll());
+    f.close();
+    dialog.setText(s);
+    dialog.exec();
+}
+
+QString VideoQualityDialog::timecode(int position) const
+{
+    return QTime::fromMSecsSinceStartOfDay(qRound(position * 1000.0 / m_fps)).toString("HH:mm:ss.zzz");
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOQUALITYDIALOG_H
+#define VIDEOQUALITYDIALOG_H
+
+#include <QDialog>
+#include "videoqualitymeter.h"
+
+class VideoQualityGraph;
+class QListWidget;
+class QLabel;
+
+class VideoQualityDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    VideoQualityDialog(const QString& csvPath, const QString& reportPath,
+                       double fps, QWidget* parent = 0);
+
+private slots:
+    void onSegmentRowChanged(int row);
+    void onViewReportClicked();
+
+private:
+    QString timecode(int position) const;
+
+    QString m_reportPath;
+    double m_fps;
+    VideoQualityGraph* m_graph;
+    QListWidget* m_segmentsList;
+    QLabel* m_summaryLabel;
+    QVector<VideoQualityMeter::Segment> m_segments;
+};
+
+#endif // VIDEOQUALITYDIALOG_H
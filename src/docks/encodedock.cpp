@@ -24,6 +24,7 @@
 #include "settings.h"
 #include "qmltypes/qmlapplication.h"
 #include "jobs/encodejob.h"
+#include "jobs/encodetunejob.h"
 #include "shotcut_mlt_properties.h"
 #include "util.h"
 #include "dialogs/listselectiondialog.h"
@@ -45,8 +46,10 @@
 static const int kOpenCaptureFileDelayMs = 1500;
 static const qint64 kFreeSpaceThesholdGB = 25LL * 1024 * 1024 * 1024;
 static const int kCustomPresetFileNameRole = Qt::UserRole + 1;
+static const double kTuneDurationSeconds = 5.0;
 
 static double getBufferSize(Mlt::Properties& preset, const char* property);
+static double getBitrate(const QString& value);
 
 EncodeDock::EncodeDock(QWidget *parent) :
     QDockWidget(parent),
@@ -81,6 +84,23 @@ EncodeDock::EncodeDock(QWidget *parent) :
     m_presetsModel.setSourceModel(new QStandardItemModel(this));
     m_presetsModel.setFilterCaseSensitivity(Qt::CaseInsensitive);
     ui->presetsTree->setModel(&m_presetsModel);
+    ui->hwencodeCheckBox->setChecked(Settings.encodeUseHardware() && !Settings.encodeHardware().isEmpty());
+
+    LOG_DEBUG() << "end";
+}
+
+EncodeDock::~EncodeDock()
+{
+    if (m_immediateJob)
+        m_immediateJob->stop();
+    delete ui;
+    delete m_presets;
+    delete m_profiles;
+}
+
+void EncodeDock::initialize()
+{
+    LOG_DEBUG() << "begin";
     loadPresets();
 
     // populate the combos
@@ -119,22 +139,11 @@ EncodeDock::EncodeDock(QWidget *parent) :
     ui->videoCodecCombo->model()->sort(0);
     ui->videoCodecCombo->insertItem(0, tr("Default for format"));
 
-    ui->hwencodeCheckBox->setChecked(Settings.encodeUseHardware() && !Settings.encodeHardware().isEmpty());
-
     on_resetButton_clicked();
 
     LOG_DEBUG() << "end";
 }
 
-EncodeDock::~EncodeDock()
-{
-    if (m_immediateJob)
-        m_immediateJob->stop();
-    delete ui;
-    delete m_presets;
-    delete m_profiles;
-}
-
 void EncodeDock::loadPresetFromProperties(Mlt::Properties& preset)
 {
     int audioQuality = -1;
@@ -1315,6 +1324,21 @@ static double getBufferSize(Mlt::Properties& preset, const char* property)
     return double(qRound(size / 1024 / 8 * 100)) / 100;
 }
 
+static double getBitrate(const QString& value)
+{
+    // Bit rates are given as a number with an optional k or M suffix.
+    QString s = value.trimmed();
+    double multiplier = 1.0;
+    if (s.endsWith('k', Qt::CaseInsensitive)) {
+        multiplier = 1000.0;
+        s.chop(1);
+    } else if (s.endsWith('M')) {
+        multiplier = 1000000.0;
+        s.chop(1);
+    }
+    return s.toDouble() * multiplier;
+}
+
 void EncodeDock::on_presetsTree_clicked(const QModelIndex &index)
 {
     if (!index.parent().isValid())
@@ -1993,6 +2017,114 @@ void EncodeDock::on_parallelCheckbox_clicked(bool checked)
     Settings.setEncodeParallelProcessing(checked);
 }
 
+void EncodeDock::on_tuneButton_clicked()
+{
+    Mlt::Producer* service = fromProducer();
+    const QString& vcodec = ui->videoCodecCombo->currentText();
+    if (!service || !MLT.isSeekable(service) || ui->disableVideoCheckbox->isChecked() || vcodec.isEmpty()) {
+        MAIN.showStatusMessage(tr("Choose a video codec and a source to export before tuning."));
+        return;
+    }
+    if (Settings.playerGPU()) {
+        MAIN.showStatusMessage(tr("Tuning is not available with GPU effects."));
+        return;
+    }
+
+    if (EncodeTuneJob::candidates(vcodec).size() < 2) {
+        QMessageBox dialog(QMessageBox::Information, tr("Tune Encoder"),
+                           tr("%1 has no speed settings to compare, so tuning can only measure its speed.\n\n"
+                              "Do you want to measure it anyway?").arg(vcodec),
+                           QMessageBox::No | QMessageBox::Yes, this);
+        dialog.setWindowModality(QmlApplication::dialogModality());
+        dialog.setDefaultButton(QMessageBox::No);
+        if (dialog.exec() != QMessageBox::Yes)
+            return;
+    }
+
+    // Offer the saved result of an earlier run.
+    QStringList saved = Settings.encodeTuning(vcodec);
+    if (!saved.isEmpty()) {
+        QMessageBox dialog(QMessageBox::Question, tr("Tune Encoder"),
+                           tr("These settings were found to be the fastest for %1:\n\n%2\n\n"
+                              "Do you want to use them or measure again?")
+                           .arg(vcodec).arg(saved.join("\n")),
+                           QMessageBox::Cancel, this);
+        QPushButton* applyButton = dialog.addButton(tr("Use"), QMessageBox::AcceptRole);
+        QPushButton* tuneButton = dialog.addButton(tr("Measure Again"), QMessageBox::ActionRole);
+        dialog.setWindowModality(QmlApplication::dialogModality());
+        dialog.setDefaultButton(applyButton);
+        dialog.exec();
+        if (dialog.clickedButton() == applyButton)
+            onEncodeTuned(vcodec, saved);
+        if (dialog.clickedButton() != tuneButton)
+            return;
+    }
+
+    // Encode a few seconds from the middle, which is more representative
+    // than the start of most projects.
+    int length = service->get_playtime();
+    int frames = qMin(length, qRound(MLT.profile().fps() * kTuneDurationSeconds));
+    if (frames < 1)
+        return;
+    int in = (length - frames) / 2;
+
+    QMap<QString, QString> properties;
+    QScopedPointer<Mlt::Properties> p(collectProperties(-1));
+    if (p && p->is_valid()) {
+        for (int i = 0; i < p->count(); i++)
+            if (p->get_name(i) && strcmp(p->get_name(i), ""))
+                properties.insert(p->get_name(i), QString::fromUtf8(p->get(i)));
+    }
+    if (!properties.contains("vcodec"))
+        properties.insert("vcodec", vcodec);
+    // Audio only adds noise to the measurements.
+    properties.remove("acodec");
+    properties.insert("an", "1");
+    properties.insert("audio_off", "1");
+    double targetBitrate = 0.0;
+    if (ui->videoRateControlCombo->currentIndex() != RateControlQuality)
+        targetBitrate = getBitrate(ui->videoBitrateCombo->currentText());
+
+    QScopedPointer<QTemporaryFile> tmp(Util::writableTemporaryFile());
+    tmp->open();
+    tmp->close();
+    auto isProxy = ui->previewScaleCheckBox->isChecked() && Settings.proxyEnabled();
+    MLT.saveXML(tmp->fileName(), service, false /* without relative paths */, false /* without verify */, isProxy);
+    QFile f(tmp->fileName());
+    f.open(QIODevice::ReadOnly);
+    QString xml = QString::fromUtf8(f.readAll());
+    f.close();
+
+    QString name = MAIN.fileName().isEmpty()? tr("Untitled") : MAIN.fileName();
+    QString extension = m_extension.isEmpty()? QString("mkv") : m_extension;
+    EncodeTuneJob* job = new EncodeTuneJob(name, xml, properties, extension, in, in + frames - 1, targetBitrate);
+    connect(job, SIGNAL(tuned(QString,QStringList)), this, SLOT(onEncodeTuned(QString,QStringList)));
+    JOBS.add(job);
+}
+
+void EncodeDock::onEncodeTuned(const QString& codec, const QStringList& settings)
+{
+    if (codec != ui->videoCodecCombo->currentText()) {
+        MAIN.showStatusMessage(tr("Choose the %1 video codec to use its tuned settings.").arg(codec));
+        return;
+    }
+    // Replace the settings in Other, but the threads have their own control.
+    QString presetProperty = EncodeTuneJob::presetProperty(codec) + "=";
+    QStringList other;
+    foreach (const QString& line, ui->advancedTextEdit->toPlainText().split("\n")) {
+        if (!line.startsWith(presetProperty) && !line.startsWith("threads=") && !line.startsWith("slices="))
+            other << line;
+    }
+    foreach (const QString& setting, settings) {
+        if (setting.startsWith("threads="))
+            ui->videoCodecThreadsSpinner->setValue(setting.mid(8).toInt());
+        else
+            other << setting;
+    }
+    ui->advancedTextEdit->setPlainText(other.join("\n"));
+    MAIN.showStatusMessage(tr("Applied %1").arg(settings.join(" ")));
+}
+
 bool EncodeDock::detectHardwareEncoders()
 {
     MAIN.showStatusMessage(tr("Detecting hardware encoders..."));
@@ -50,6 +50,9 @@ public:
     explicit EncodeDock(QWidget *parent = 0);
     ~EncodeDock();
 
+    // Loads the presets and the available formats and codecs, which is
+    // deferred until the dock is first shown or the application is idle.
+    void initialize();
     void loadPresetFromProperties(Mlt::Properties&);
     bool isExportInProgress() const;
 
@@ -125,6 +128,10 @@ private slots:
 
     void on_parallelCheckbox_clicked(bool checked);
 
+    void on_tuneButton_clicked();
+
+    void onEncodeTuned(const QString& codec, const QStringList& settings);
+
 private:
     enum {
         RateControlAverage = 0,
@@ -27,6 +27,8 @@
 #include <QIcon>
 #include <Logger.h>
 #include "qmltypes/qmlfilter.h"
+#include "qmltypes/qmlmetadata.h"
+#include "qmltypes/filterpanelpool.h"
 #include "qmltypes/qmlutilities.h"
 #include "qmltypes/qmlview.h"
 #include "models/metadatamodel.h"
@@ -35,7 +37,9 @@
 
 FiltersDock::FiltersDock(MetadataModel* metadataModel, AttachedFiltersModel* attachedModel, QWidget *parent) :
     QDockWidget(tr("Filters"), parent),
-    m_qview(QmlUtilities::sharedEngine(), this)
+    m_qview(QmlUtilities::sharedEngine(), this),
+    m_attachedModel(attachedModel),
+    m_isInitialized(false)
 {
     LOG_DEBUG() << "begin";
     setObjectName("FiltersDock");
@@ -56,6 +60,9 @@ FiltersDock::FiltersDock(MetadataModel* metadataModel, AttachedFiltersModel* att
     m_qview.rootContext()->setContextProperty("metadatamodel", metadataModel);
     m_qview.rootContext()->setContextProperty("attachedfiltersmodel", attachedModel);
     m_qview.rootContext()->setContextProperty("producer", &m_producer);
+    m_panelPool = new FilterPanelPool(m_qview.rootContext(), &m_producer, this);
+    m_qview.rootContext()->setContextProperty("panelPool", m_panelPool);
+    connect(attachedModel, SIGNAL(modelReset()), SLOT(onAttachedModelReset()));
     connect(&m_producer, SIGNAL(seeked(int)), SIGNAL(seeked(int)));
     connect(this, SIGNAL(producerInChanged(int)), &m_producer, SIGNAL(inChanged(int)));
     connect(this, SIGNAL(producerOutChanged(int)), &m_producer, SIGNAL(outChanged(int)));
@@ -133,14 +140,25 @@ void FiltersDock::openFilterMenu() const
     QMetaObject::invokeMethod(m_qview.rootObject(), "openFilterMenu");
 }
 
+void FiltersDock::initialize()
+{
+    m_isInitialized = true;
+    // Otherwise the view loads when the scene graph is initialized.
+    if (m_qview.quickWindow()->isSceneGraphInitialized())
+        resetQview();
+}
+
 void FiltersDock::resetQview()
 {
+    if (!m_isInitialized)
+        return;
     LOG_DEBUG() << "begin";
     if (m_qview.status() != QQuickWidget::Null) {
         QObject* root = m_qview.rootObject();
         QObject::disconnect(root, SIGNAL(currentFilterRequested(int)),
                             this, SIGNAL(currentFilterRequested(int)));
 
+        m_panelPool->clear();
         m_qview.setSource(QUrl(""));
     }
 
@@ -162,3 +180,13 @@ void FiltersDock::resetQview()
         SIGNAL(currentFilterRequested(int)));
     emit currentFilterRequested(-1);
 }
+
+void FiltersDock::onAttachedModelReset()
+{
+    // Compile the panels of the new clip's filters before they are selected.
+    for (int i = 0; i < m_attachedModel->rowCount(); i++) {
+        QmlMetadata* meta = m_attachedModel->getMetadata(i);
+        if (meta)
+            m_panelPool->preload(meta->qmlFilePath());
+    }
+}
@@ -30,6 +30,7 @@ class QmlFilter;
 class QmlMetadata;
 class MetadataModel;
 class AttachedFiltersModel;
+class FilterPanelPool;
 
 class FiltersDock : public QDockWidget
 {
@@ -39,6 +40,9 @@ public:
     explicit FiltersDock(MetadataModel* metadataModel, AttachedFiltersModel* attachedModel, QWidget *parent = 0);
 
     QmlProducer* qmlProducer() { return &m_producer; }
+    // Allows loading the QML view, which the main window defers until the
+    // window has painted or the dock is shown afterwards.
+    void initialize();
 
 signals:
     void currentFilterRequested(int attachedIndex);
@@ -59,10 +63,14 @@ protected:
 
 private slots:
     void resetQview();
+    void onAttachedModelReset();
 
 private:
     QQuickWidget m_qview;
     QmlProducer m_producer;
+    AttachedFiltersModel* m_attachedModel;
+    FilterPanelPool* m_panelPool;
+    bool m_isInitialized;
 };
 
 #endif // FILTERSDOCK_H
@@ -101,12 +101,12 @@ void JobsDock::on_treeView_customContextMenuRequested(const QPoint &pos)
     QMenu menu(this);
     AbstractJob* job = index.isValid()? JOBS.jobFromIndex(index) : nullptr;
     if (job) {
-        if (job->ran() && job->state() == QProcess::NotRunning && job->exitStatus() == QProcess::NormalExit) {
+        if (job->ran() && job->jobState() == QProcess::NotRunning && job->exitStatus() == QProcess::NormalExit) {
             menu.addActions(job->successActions());
         }
         if (job->stopped() || (JOBS.isPaused() && !job->ran()))
             menu.addAction(ui->actionRun);
-        if (job->state() == QProcess::Running)
+        if (job->jobState() == QProcess::Running)
             menu.addAction(ui->actionStopJob);
         else
             menu.addAction(ui->actionRemove);
@@ -115,7 +115,7 @@ void JobsDock::on_treeView_customContextMenuRequested(const QPoint &pos)
         menu.addActions(job->standardActions());
     }
     for (auto job : JOBS.jobs()) {
-        if (job->ran() && job->state() != QProcess::Running) {
+        if (job->ran() && job->jobState() != QProcess::Running) {
             menu.addAction(ui->actionRemoveFinished);
             break;
         }
@@ -168,7 +168,7 @@ void JobsDock::on_menuButton_clicked()
 void JobsDock::on_treeView_doubleClicked(const QModelIndex &index)
 {
     AbstractJob* job = JOBS.jobFromIndex(index);
-    if (job && job->ran() && job->state() == QProcess::NotRunning && job->exitStatus() == QProcess::NormalExit) {
+    if (job && job->ran() && job->jobState() == QProcess::NotRunning && job->exitStatus() == QProcess::NormalExit) {
         foreach (QAction* action, job->successActions()) {
             if (action->text() == "Open") {
                 action->trigger();
@@ -41,6 +41,7 @@ KeyframesDock::KeyframesDock(QmlProducer* qmlProducer, QWidget *parent)
     : QDockWidget(tr("Keyframes"), parent)
     , m_qview(QmlUtilities::sharedEngine(), this)
     , m_qmlProducer(qmlProducer)
+    , m_isInitialized(false)
 {
     LOG_DEBUG() << "begin";
     setObjectName("KeyframesDock");
@@ -140,8 +141,18 @@ int KeyframesDock::currentParameter() const
     return m_qview.rootObject()->property("currentTrack").toInt();
 }
 
+void KeyframesDock::initialize()
+{
+    m_isInitialized = true;
+    // Otherwise the view loads when the scene graph is initialized.
+    if (m_qview.quickWindow()->isSceneGraphInitialized())
+        load();
+}
+
 void KeyframesDock::load(bool force)
 {
+    if (!m_isInitialized)
+        return;
     LOG_DEBUG() << "begin";
 
     if (m_qview.source().isEmpty() || force) {
@@ -41,6 +41,9 @@ public:
     explicit KeyframesDock(QmlProducer* qmlProducer, QWidget *parent = 0);
 
     KeyframesModel& model() { return m_model; }
+    // Allows loading the QML view, which the main window defers until the
+    // window has painted or the dock is shown afterwards.
+    void initialize();
     Q_INVOKABLE int seekPrevious();
     Q_INVOKABLE int seekNext();
     int currentParameter() const;
@@ -72,6 +75,7 @@ private:
     QmlFilter m_emptyQmlFilter;
     KeyframesModel m_model;
     QmlProducer* m_qmlProducer;
+    bool m_isInitialized;
 };
 
 #endif // KEYFRAMESDOCK_H
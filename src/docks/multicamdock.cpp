@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "multicamdock.h"
+#include "mainwindow.h"
+#include "mltcontroller.h"
+#include "multicamdecoder.h"
+#include "proxymanager.h"
+#include "shotcut_mlt_properties.h"
+#include "sharedframe.h"
+#include "docks/timelinedock.h"
+#include "models/multitrackmodel.h"
+#include "commands/timelinecommands.h"
+#include "widgets/multicamwidget.h"
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QToolButton>
+#include <QUndoStack>
+#include <Logger.h>
+#include <cmath>
+
+static const int kMaxAngles = 9;
+static const int kMaxAngleWidth = 640;
+static const int kMinAngleWidth = 160;
+static const int kMaxLowres = 3;
+static const int kUpdateDelayMs = 500;
+
+static QString originalResource(Mlt::Producer* producer)
+{
+    if (producer->get(kOriginalResourceProperty))
+        return QString::fromUtf8(producer->get(kOriginalResourceProperty));
+    return QString::fromUtf8(producer->get("resource"));
+}
+
+MulticamDock::MulticamDock(QWidget *parent)
+    : QDockWidget(tr("Multicam"), parent)
+    , m_programTrack(-1)
+    , m_trackCount(0)
+    , m_angleWidth(kMaxAngleWidth)
+{
+    LOG_DEBUG() << "begin";
+    setObjectName("MulticamDock");
+    QIcon icon = QIcon::fromTheme("camera-video", QIcon(":/icons/oxygen/32x32/devices/video-television.png"));
+    setWindowIcon(icon);
+    toggleViewAction()->setIcon(windowIcon());
+#ifdef Q_OS_MAC
+    setFeatures(DockWidgetClosable | DockWidgetMovable);
+#endif
+
+    QWidget* container = new QWidget(this);
+    QVBoxLayout* vlayout = new QVBoxLayout(container);
+    vlayout->setContentsMargins(0, 0, 0, 0);
+    vlayout->setSpacing(2);
+    QHBoxLayout* hlayout = new QHBoxLayout;
+    hlayout->setContentsMargins(4, 2, 4, 0);
+    m_label = new QLabel(container);
+    hlayout->addWidget(m_label, 1);
+    QToolButton* button = new QToolButton(container);
+    button->setIcon(QIcon::fromTheme("view-refresh", QIcon(":/icons/oxygen/32x32/actions/view-refresh.png")));
+    button->setToolTip(tr("Use the current track as the program and the other video tracks as angles"));
+    button->setAutoRaise(true);
+    connect(button, SIGNAL(clicked()), SLOT(refresh()));
+    hlayout->addWidget(button);
+    vlayout->addLayout(hlayout);
+    m_widget = new MulticamWidget(container);
+    m_widget->setToolTip(tr("Click an angle or press 1-9 to cut to it at the playhead"));
+    vlayout->addWidget(m_widget, 1);
+    QDockWidget::setWidget(container);
+
+    connect(m_widget, SIGNAL(angleClicked(int)), SLOT(cutToAngle(int)));
+    connect(this, SIGNAL(visibilityChanged(bool)), SLOT(onVisibilityChanged(bool)));
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(kUpdateDelayMs);
+    connect(&m_updateTimer, SIGNAL(timeout()), SLOT(updateAngles()));
+    LOG_DEBUG() << "end";
+}
+
+MulticamDock::~MulticamDock()
+{
+    stopDecoders();
+}
+
+void MulticamDock::refresh()
+{
+    stopDecoders();
+    m_angleTracks.clear();
+    TimelineDock* timeline = MAIN.timelineDock();
+    MultitrackModel* model = timeline->model();
+    m_programTrack = timeline->currentTrack();
+    const TrackList& tracks = model->trackList();
+    m_trackCount = tracks.size();
+    if (m_programTrack < 0 || m_programTrack >= tracks.size()
+            || tracks[m_programTrack].type != VideoTrackType) {
+        m_programTrack = -1;
+        m_label->setText(tr("Select a video track to receive the cuts and click refresh."));
+        m_widget->setAngles(QStringList());
+        return;
+    }
+
+    QStringList names;
+    for (int i = 0; i < tracks.size() && m_angleTracks.size() < kMaxAngles; ++i) {
+        if (i != m_programTrack && tracks[i].type == VideoTrackType) {
+            m_angleTracks << i;
+            names << model->index(i).data(MultitrackModel::NameRole).toString();
+        }
+    }
+    m_label->setText(tr("Program: %1")
+                     .arg(model->index(m_programTrack).data(MultitrackModel::NameRole).toString()));
+    m_widget->setAngles(names);
+    if (m_angleTracks.isEmpty())
+        return;
+
+    // One decoder per angle, each scaled to the size of its grid cell.
+    int columns = int(std::ceil(std::sqrt(double(m_angleTracks.size()))));
+    m_angleWidth = qBound(kMinAngleWidth, m_widget->width() * devicePixelRatio() / columns, kMaxAngleWidth);
+    for (int i = 0; i < m_angleTracks.size(); ++i)
+        m_decoders << startDecoder(i, angleXml(m_angleTracks[i], m_angleWidth));
+    m_widget->setActiveAngle(activeAngle(timeline->position()));
+    LOG_DEBUG() << "multicam angles" << m_angleTracks.size() << "width" << m_angleWidth;
+}
+
+MulticamDecoder* MulticamDock::startDecoder(int index, const QString& xml)
+{
+    MulticamDecoder* decoder = new MulticamDecoder(index, xml, m_angleWidth, this);
+    connect(decoder, SIGNAL(frameReady(int, const QImage&)), m_widget, SLOT(setImage(int, const QImage&)));
+    decoder->start(QThread::LowPriority);
+    decoder->requestPosition(MAIN.timelineDock()->position());
+    return decoder;
+}
+
+void MulticamDock::onTimelineModified()
+{
+    if (!m_decoders.isEmpty())
+        m_updateTimer.start();
+}
+
+// Reloads only the angles whose clips changed since their decoders started.
+void MulticamDock::updateAngles()
+{
+    if (m_decoders.isEmpty())
+        return;
+    MultitrackModel* model = MAIN.timelineDock()->model();
+    if (model->trackList().size() != m_trackCount) {
+        // The track indexes moved, so pick the angles again.
+        refresh();
+        return;
+    }
+    for (int i = 0; i < m_decoders.size(); ++i) {
+        QString xml = angleXml(m_angleTracks[i], m_angleWidth);
+        if (xml == m_decoders[i]->xml())
+            continue;
+        LOG_DEBUG() << "reloading multicam angle" << i;
+        delete m_decoders[i];
+        m_decoders[i] = startDecoder(i, xml);
+    }
+}
+
+void MulticamDock::clear()
+{
+    m_updateTimer.stop();
+    stopDecoders();
+    m_angleTracks.clear();
+    m_programTrack = -1;
+    m_label->clear();
+    m_widget->setAngles(QStringList());
+}
+
+void MulticamDock::stopDecoders()
+{
+    foreach (MulticamDecoder* decoder, m_decoders)
+        decoder->stop();
+    qDeleteAll(m_decoders);
+    m_decoders.clear();
+}
+
+// Copies an angle track into a standalone playlist, substituting proxies
+// wherever they exist so that the grid decodes the lightest media available.
+// Other video is decoded at a reduced resolution where its codec allows it.
+QString MulticamDock::angleXml(int trackIndex, int width) const
+{
+    MultitrackModel* model = MAIN.timelineDock()->model();
+    int mltIndex = model->trackList().at(trackIndex).mlt_index;
+    QScopedPointer<Mlt::Producer> track(model->tractor()->track(mltIndex));
+    if (!track)
+        return QString();
+    Mlt::Playlist source(*track);
+    Mlt::Playlist playlist(MLT.profile());
+    for (int i = 0; i < source.count(); ++i) {
+        QScopedPointer<Mlt::ClipInfo> info(source.clip_info(i));
+        if (!info)
+            continue;
+        if (!info->producer || !info->producer->is_valid() || info->producer->is_blank()) {
+            playlist.blank(info->frame_count - 1);
+            continue;
+        }
+        Mlt::Producer clip(MLT.profile(), "xml-string", MLT.XML(info->producer).toUtf8().constData());
+        if (!clip.get_int(kIsProxyProperty) && ProxyManager::fileExists(clip)) {
+            ProxyManager::useProxy(clip);
+        } else if (!clip.get_int(kIsProxyProperty)
+                   && QString::fromLatin1(clip.get("mlt_service")).startsWith("avformat")) {
+            // These are passed to the decoder, which ignores a lowres that
+            // its codec does not support.
+            int lowres = 0;
+            int mediaWidth = clip.get_int("meta.media.width");
+            while (lowres < kMaxLowres && (mediaWidth >> (lowres + 1)) >= width)
+                ++lowres;
+            if (lowres > 0)
+                clip.set("lowres", lowres);
+            clip.set("skip_loop_filter", "all");
+        }
+        playlist.append(clip, info->frame_in, info->frame_out);
+    }
+    return MLT.XML(&playlist);
+}
+
+int MulticamDock::activeAngle(int position) const
+{
+    TimelineDock* timeline = MAIN.timelineDock();
+    int clipIndex = timeline->clipIndexAtPosition(m_programTrack, position);
+    QScopedPointer<Mlt::ClipInfo> program(timeline->getClipInfo(m_programTrack, clipIndex));
+    if (!program || !program->producer || program->producer->is_blank())
+        return -1;
+    QString resource = originalResource(program->producer);
+    int programIn = program->frame_in + position - program->start;
+    for (int i = 0; i < m_angleTracks.size(); ++i) {
+        int angleIndex = timeline->clipIndexAtPosition(m_angleTracks[i], position);
+        QScopedPointer<Mlt::ClipInfo> angle(timeline->getClipInfo(m_angleTracks[i], angleIndex));
+        if (angle && angle->producer && !angle->producer->is_blank()
+                && angle->frame_in + position - angle->start == programIn
+                && originalResource(angle->producer) == resource)
+            return i;
+    }
+    return -1;
+}
+
+void MulticamDock::cutToAngle(int index)
+{
+    if (index < 0 || index >= m_angleTracks.size() || m_programTrack < 0)
+        return;
+    TimelineDock* timeline = MAIN.timelineDock();
+    MultitrackModel* model = timeline->model();
+    if (m_programTrack >= model->trackList().size()) {
+        clear();
+        return;
+    }
+    if (timeline->isTrackLocked(m_programTrack)) {
+        MAIN.showStatusMessage(tr("The program track is locked"));
+        return;
+    }
+    int angleTrack = m_angleTracks[index];
+    int position = timeline->position();
+
+    // Replace from the playhead to the end of the program clip under it, or
+    // to the end of the angle when the program track is empty there.
+    int end = -1;
+    int programIndex = timeline->clipIndexAtPosition(m_programTrack, position);
+    QScopedPointer<Mlt::ClipInfo> program(timeline->getClipInfo(m_programTrack, programIndex));
+    if (program && program->producer && !program->producer->is_blank())
+        end = program->start + program->frame_count;
+    if (end < 0) {
+        QScopedPointer<Mlt::Producer> track(model->tractor()->track(model->trackList().at(angleTrack).mlt_index));
+        if (track)
+            end = Mlt::Playlist(*track).get_playtime();
+    }
+    if (end <= position)
+        return;
+
+    QList<QString> clips;
+    QList<int> starts;
+    int count = model->rowCount(model->index(angleTrack));
+    for (int i = timeline->clipIndexAtPosition(angleTrack, position); i >= 0 && i < count; ++i) {
+        QScopedPointer<Mlt::ClipInfo> info(timeline->getClipInfo(angleTrack, i));
+        if (!info || info->start >= end)
+            break;
+        if (!info->producer || !info->producer->is_valid() || info->producer->is_blank())
+            continue;
+        int start = qMax(info->start, position);
+        int length = qMin(info->start + info->frame_count, end) - start;
+        if (length <= 0)
+            continue;
+        Mlt::Producer clip(MLT.profile(), "xml-string", MLT.XML(info->producer).toUtf8().constData());
+        int in = info->frame_in + start - info->start;
+        clip.set_in_and_out(in, in + length - 1);
+        clips << MLT.XML(&clip);
+        starts << start;
+    }
+    if (clips.isEmpty()) {
+        MAIN.showStatusMessage(tr("Angle %1 has no clip at the playhead").arg(index + 1));
+        return;
+    }
+    MAIN.undoStack()->beginMacro(tr("Multicam cut to %1")
+        .arg(model->index(angleTrack).data(MultitrackModel::NameRole).toString()));
+    for (int i = 0; i < clips.size(); ++i)
+        MAIN.undoStack()->push(new Timeline::OverwriteCommand(*model, m_programTrack, starts[i], clips[i], false));
+    MAIN.undoStack()->endMacro();
+    m_widget->setActiveAngle(index);
+}
+
+void MulticamDock::onShowFrame(const SharedFrame& frame)
+{
+    if (!isVisible() || !MLT.isMultitrack() || m_decoders.isEmpty())
+        return;
+    int position = frame.get_position();
+    foreach (MulticamDecoder* decoder, m_decoders)
+        decoder->requestPosition(position);
+    m_widget->setActiveAngle(activeAngle(position));
+}
+
+void MulticamDock::onVisibilityChanged(bool visible)
+{
+    if (visible && m_decoders.isEmpty() && MLT.isMultitrack())
+        refresh();
+    else if (!visible)
+        stopDecoders();
+}
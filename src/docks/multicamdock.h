@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MULTICAMDOCK_H
+#define MULTICAMDOCK_H
+
+#include <QDockWidget>
+#include <QList>
+#include <QTimer>
+#include <QVector>
+
+class MulticamDecoder;
+class MulticamWidget;
+class SharedFrame;
+class QLabel;
+
+class MulticamDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MulticamDock(QWidget *parent = 0);
+    ~MulticamDock();
+
+public slots:
+    void refresh();
+    void clear();
+    void cutToAngle(int index);
+    void onShowFrame(const SharedFrame& frame);
+
+private slots:
+    void onVisibilityChanged(bool visible);
+    void onTimelineModified();
+    void updateAngles();
+
+private:
+    QString angleXml(int trackIndex, int width) const;
+    int activeAngle(int position) const;
+    void stopDecoders();
+    MulticamDecoder* startDecoder(int index, const QString& xml);
+
+    MulticamWidget* m_widget;
+    QLabel* m_label;
+    QList<MulticamDecoder*> m_decoders;
+    QVector<int> m_angleTracks;
+    int m_programTrack;
+    int m_trackCount;
+    int m_angleWidth;
+    QTimer m_updateTimer;
+};
+
+#endif // MULTICAMDOCK_H
@@ -30,6 +30,7 @@
 #include "util.h"
 #include "commands/playlistcommands.h"
 #include "proxymanager.h"
+#include "audiosync.h"
 #include <Logger.h>
 
 #include <QMenu>
@@ -321,6 +322,8 @@ void PlaylistDock::on_menuButton_clicked()
         menu.addAction(ui->actionUpdate);
         menu.addAction(ui->actionUpdateThumbnails);
         menu.addAction(ui->actionSetFileDate);
+        if (m_view->selectionModel()->selectedRows().size() > 1)
+            menu.addAction(ui->actionSyncByAudio);
         menu.addSeparator();
     }
     menu.addAction(ui->actionRemoveAll);
@@ -499,6 +502,50 @@ void PlaylistDock::on_actionSetFileDate_triggered()
     }
 }
 
+void PlaylistDock::on_actionSyncByAudio_triggered()
+{
+    if (!m_model.playlist()) return;
+    QList<int> rows;
+    QList<AudioSync::Clip> clips;
+    foreach (auto index, m_view->selectionModel()->selectedIndexes()) {
+        if (index.column() || rows.contains(index.row())) continue;
+        QScopedPointer<Mlt::ClipInfo> info(m_model.playlist()->clip_info(index.row()));
+        if (info && info->producer && info->producer->is_valid()) {
+            rows << index.row();
+            clips << AudioSync::makeClip(*info->producer, info->frame_in, info->frame_out);
+        }
+    }
+    if (clips.size() < 2) return;
+
+    LongUiTask longTask(tr("Synchronize by Audio"));
+    QVector<AudioSync::Result> results = longTask.runAsync<QVector<AudioSync::Result>>(
+                tr("Analyzing audio"), &AudioSync::synchronize, clips);
+
+    // Trim the in points so that every clip starts with the one that starts latest.
+    int latest = 0;
+    foreach (const AudioSync::Result& result, results) {
+        if (AudioSync::isConfident(result))
+            latest = qMax(latest, result.offset);
+    }
+    int skipped = 0;
+    QList<QPair<int, int>> trims; // row and new in point
+    for (int i = 0; i < rows.size(); ++i) {
+        int in = clips[i].in + latest - results[i].offset;
+        if (!AudioSync::isConfident(results[i]) || in > clips[i].out)
+            ++skipped;
+        else if (in != clips[i].in)
+            trims << qMakePair(rows[i], in);
+    }
+    if (!trims.isEmpty()) {
+        MAIN.undoStack()->beginMacro(tr("Synchronize %1 playlist items").arg(rows.size()));
+        foreach (auto trim, trims)
+            MAIN.undoStack()->push(new Playlist::TrimClipInCommand(m_model, trim.first, trim.second));
+        MAIN.undoStack()->endMacro();
+    }
+    if (skipped)
+        MAIN.showStatusMessage(tr("%1 of %2 clips could not be synchronized").arg(skipped).arg(rows.size()));
+}
+
 void PlaylistDock::setUpdateButtonEnabled(bool modified)
 {
     ui->updateButton->setEnabled(modified);
@@ -559,6 +606,8 @@ void PlaylistDock::viewCustomContextMenuRequested(const QPoint &pos)
         menu.addAction(ui->actionUpdate);
         menu.addAction(ui->actionUpdateThumbnails);
         menu.addAction(ui->actionSetFileDate);
+        if (m_view->selectionModel()->selectedRows().size() > 1)
+            menu.addAction(ui->actionSyncByAudio);
         menu.exec(mapToGlobal(pos));
     }
 }
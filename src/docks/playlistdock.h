@@ -89,6 +89,8 @@ private slots:
 
     void on_actionSetFileDate_triggered();
 
+    void on_actionSyncByAudio_triggered();
+
     void onPlaylistCreated();
 
     void onPlaylistLoaded();
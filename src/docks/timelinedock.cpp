@@ -24,19 +24,37 @@
 #include "commands/timelinecommands.h"
 #include "qmltypes/qmlutilities.h"
 #include "qmltypes/qmlview.h"
+#include "qmltypes/qmlapplication.h"
 #include "shotcut_mlt_properties.h"
 #include "settings.h"
 #include "util.h"
 #include "proxymanager.h"
 #include "dialogs/longuitask.h"
+#include "jobqueue.h"
+#include "jobs/qcjob.h"
+#include "jobs/loudnessjob.h"
+#include "loudnessanalysis.h"
+#include "audiosync.h"
 
 #include <QAction>
+#include <QMessageBox>
+#include <QTime>
 #include <QtQml>
 #include <QtQuick>
 #include <Logger.h>
 
 static QString kNonSeekableWarning = QObject::tr("You cannot add a non-seekable source.");
 
+// Whether a clip plays no audio, like the services without waveforms.
+static bool isSilent(Mlt::Producer& producer)
+{
+    QString service = QString::fromLatin1(producer.get("mlt_service"));
+    return service == "pixbuf" || service == "qimage" || service == "webvfx"
+        || service == "color" || service == "colour" || service == "qtext"
+        || service == "kdenlivetitle" || service.startsWith("frei0r")
+        || (producer.get("audio_index") && producer.get_int("audio_index") < 0);
+}
+
 TimelineDock::TimelineDock(QWidget *parent) :
     QDockWidget(parent),
     ui(new Ui::TimelineDock),
@@ -45,7 +63,8 @@ TimelineDock::TimelineDock(QWidget *parent) :
     m_ignoreNextPositionChange(false),
     m_trimDelta(0),
     m_transitionDelta(0),
-    m_blockSetSelection(false)
+    m_blockSetSelection(false),
+    m_isInitialized(false)
 {
     LOG_DEBUG() << "begin";
     m_selection.selectedTrack = -1;
@@ -70,6 +89,11 @@ TimelineDock::TimelineDock(QWidget *parent) :
     m_quickView.setAttribute(Qt::WA_AcceptTouchEvents);
 
     connect(&m_model, SIGNAL(modified()), this, SLOT(clearSelectionIfInvalid()));
+    // Any edit can change the pictures that were checked.
+    connect(&m_model, SIGNAL(modified()), this, SLOT(clearQcRegions()));
+    connect(&m_model, SIGNAL(loaded()), this, SLOT(clearQcRegions()));
+    connect(&m_model, SIGNAL(created()), this, SLOT(clearQcRegions()));
+    connect(&m_model, SIGNAL(closed()), this, SLOT(clearQcRegions()));
     connect(&m_model, &MultitrackModel::inserted, this, &TimelineDock::onInserted, Qt::QueuedConnection);
     connect(&m_model, &MultitrackModel::overWritten, this, &TimelineDock::onOverWritten, Qt::QueuedConnection);
     connect(&m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(onRowsInserted(QModelIndex,int,int)));
@@ -390,7 +414,7 @@ void TimelineDock::trimClipAtPlayhead(TrimLocation location, bool ripple)
 
 bool TimelineDock::isRipple() const
 {
-    return m_quickView.rootObject()->property("ripple").toBool();
+    return m_quickView.rootObject() && m_quickView.rootObject()->property("ripple").toBool();
 }
 
 void TimelineDock::copyToSource()
@@ -414,6 +438,193 @@ void TimelineDock::openProperties()
     MAIN.onPropertiesDockTriggered(true);
 }
 
+void TimelineDock::analyzeBroadcastSafety()
+{
+    if (model()->tractor() && model()->tractor()->is_valid()) {
+        QString name = MAIN.fileName().isEmpty()? tr("Timeline") : MAIN.fileName();
+        JOBS.add(new QcJob(name, MLT.XML(model()->tractor()), true,
+                           MLT.profile().frame_rate_num(), MLT.profile().frame_rate_den()));
+        emit showStatusMessage(tr("Analyzing the timeline for broadcast safety..."));
+    }
+}
+
+void TimelineDock::measureLoudness()
+{
+    if (!m_model.tractor() || !m_model.tractor()->is_valid())
+        return;
+    int in = 0;
+    int out = m_model.tractor()->get_length() - 1;
+    if (MLT.isMultitrack() && MLT.producer()) {
+        in = MLT.producer()->get_in();
+        out = qMin(out, MLT.producer()->get_out());
+    }
+
+    QList<LoudnessAnalysis::Clip> clips;
+    QList<LoudnessAnalysis::Request> requests;
+    QSet<QString> requested;
+    int unmeasured = 0;
+    // Filters on a track or the master apply to the mix, so the cached
+    // clips cannot be combined; render the range instead.
+    bool isRendered = LoudnessAnalysis::hasAudioFilters(*m_model.tractor());
+    for (int trackIndex = 0; trackIndex < m_model.trackList().size() && !isRendered; ++trackIndex) {
+        QScopedPointer<Mlt::Producer> track(m_model.tractor()->track(m_model.trackList().at(trackIndex).mlt_index));
+        if (!track || track->get_int("hide") & 2)
+            continue;
+        isRendered = LoudnessAnalysis::hasAudioFilters(*track);
+        // Only media files have a cached source analysis. Audio from a speed
+        // change, a nested project or a generator is measured in the mix.
+        Mlt::Playlist playlist(*track);
+        for (int clipIndex = 0; clipIndex < playlist.count() && !isRendered; ++clipIndex) {
+            QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(clipIndex));
+            if (!info || !info->producer || !info->producer->is_valid() || info->producer->is_blank()
+                    || info->start > out || info->start + info->frame_count <= in)
+                continue;
+            isRendered = !QString::fromLatin1(info->producer->get("mlt_service")).startsWith("avformat")
+                    && !isSilent(*info->producer);
+            if (isRendered)
+                LOG_INFO() << "measuring the mix for clip" << clipIndex << "of track" << trackIndex
+                           << info->producer->get("mlt_service");
+        }
+    }
+    if (isRendered) {
+        LoudnessAnalysis::Request request = LoudnessAnalysis::programRequest(*m_model.tractor(), in, out);
+        if (request.cachePath.isEmpty()) {
+            emit showStatusMessage(tr("Failed to save the timeline for measuring loudness"));
+            return;
+        }
+        LoudnessAnalysis::Clip clip = {request.cachePath, in, 0, out - in + 1};
+        clips << clip;
+        if (!LoudnessAnalysis::isCached(request.cachePath))
+            requests << request;
+    }
+    for (int trackIndex = 0; trackIndex < m_model.trackList().size() && !isRendered; ++trackIndex) {
+        int mltIndex = m_model.trackList().at(trackIndex).mlt_index;
+        QScopedPointer<Mlt::Producer> track(m_model.tractor()->track(mltIndex));
+        if (!track || track->get_int("hide") & 2)
+            continue;
+        Mlt::Playlist playlist(*track);
+        for (int clipIndex = 0; clipIndex < playlist.count(); ++clipIndex) {
+            QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(clipIndex));
+            if (!info || !info->producer || !info->producer->is_valid() || info->producer->is_blank()
+                    || info->start > out || info->start + info->frame_count <= in)
+                continue;
+            Mlt::Producer& producer = *info->producer;
+            if (isSilent(producer))
+                continue;
+            bool isFiltered = LoudnessAnalysis::hasAudioFilters(producer);
+            LoudnessAnalysis::Request request = isFiltered? LoudnessAnalysis::clipRequest(*info)
+                                                          : LoudnessAnalysis::sourceRequest(producer);
+            if (request.cachePath.isEmpty()) {
+                ++unmeasured;
+                continue;
+            }
+            // A filtered clip is analyzed from its in point.
+            LoudnessAnalysis::Clip clip = {request.cachePath, info->start,
+                                           isFiltered? 0 : info->frame_in, info->frame_count};
+            clips << clip;
+            if (!requested.contains(clip.cachePath) && !LoudnessAnalysis::isCached(clip.cachePath)) {
+                requests << request;
+                requested << clip.cachePath;
+            }
+        }
+    }
+
+    if (!requests.isEmpty()) {
+        // Only sources that were never analyzed need to be decoded.
+        QString name = MAIN.fileName().isEmpty()? tr("Timeline") : MAIN.fileName();
+        JOBS.add(new LoudnessJob(name, requests));
+        emit showStatusMessage(tr("Analyzing the loudness of %1 sources...").arg(requests.size()));
+        return;
+    }
+    QTime time;
+    time.start();
+    LoudnessAnalysis::Result result = LoudnessAnalysis::measure(clips, in, out, MLT.profile().fps());
+    LOG_INFO() << "measured loudness of" << clips.size() << "clips in" << time.elapsed() << "ms";
+    QString text = LoudnessAnalysis::toString(result);
+    if (unmeasured > 0)
+        text += "\n\n" + tr("%n clip(s) were not measured because their files are missing.", nullptr, unmeasured);
+    QMessageBox dialog(QMessageBox::Information, tr("Program Loudness"), text, QMessageBox::Ok, &MAIN);
+    dialog.setDefaultButton(QMessageBox::Ok);
+    dialog.setEscapeButton(QMessageBox::Ok);
+    dialog.setWindowModality(QmlApplication::dialogModality());
+    dialog.exec();
+}
+
+void TimelineDock::syncSelectionByAudio()
+{
+    QList<QPoint> clips = selection();
+    if (clips.size() < 2) {
+        emit showStatusMessage(tr("Select at least two clips to synchronize."));
+        return;
+    }
+    // The first clip selected is the reference that does not move.
+    QList<AudioSync::Clip> syncClips;
+    QList<int> starts;
+    foreach (const QPoint& clip, clips) {
+        if (isTrackLocked(clip.y())) {
+            pulseLockButtonOnTrack(clip.y());
+            return;
+        }
+        QScopedPointer<Mlt::ClipInfo> info(getClipInfo(clip.y(), clip.x()));
+        if (!info || !info->producer || !info->cut || isBlank(clip.y(), clip.x()))
+            return;
+        syncClips << AudioSync::makeClip(*info->producer, info->frame_in, info->frame_out);
+        starts << info->start;
+    }
+
+    LongUiTask longTask(tr("Synchronize by Audio"));
+    QVector<AudioSync::Result> results = longTask.runAsync<QVector<AudioSync::Result>>(
+                tr("Analyzing audio"), &AudioSync::synchronize, syncClips);
+
+    QList<int> positions;
+    int skipped = 0;
+    int shift = 0;
+    for (int i = 0; i < clips.size(); ++i) {
+        if (AudioSync::isConfident(results[i])) {
+            positions << starts.first() + results[i].offset;
+        } else {
+            positions << starts[i];
+            ++skipped;
+        }
+        shift = qMin(shift, positions.last());
+    }
+    auto command = new Timeline::MoveClipCommand(m_model, 0, false);
+    for (int i = 0; i < clips.size(); ++i) {
+        // A clip cannot start before zero, so move the others later instead.
+        int position = positions[i] - shift;
+        if (position != starts[i]) {
+            QScopedPointer<Mlt::ClipInfo> info(getClipInfo(clips[i].y(), clips[i].x()));
+            info->cut->set(kPlaylistStartProperty, position);
+            command->selection().insert(info->start, *info->cut);
+        }
+    }
+    if (skipped)
+        emit showStatusMessage(tr("%1 of %2 clips could not be synchronized").arg(skipped).arg(clips.size()));
+    if (command->selection().isEmpty()) {
+        delete command;
+        return;
+    }
+    setSelection();
+    TimelineSelectionBlocker blocker(*this);
+    MAIN.undoStack()->push(command);
+}
+
+void TimelineDock::setQcRegions(const QVariantList& regions)
+{
+    m_qcRegions = regions;
+    emit qcRegionsChanged();
+    if (regions.isEmpty())
+        emit showStatusMessage(tr("No frames are outside broadcast limits."));
+}
+
+void TimelineDock::clearQcRegions()
+{
+    if (!m_qcRegions.isEmpty()) {
+        m_qcRegions.clear();
+        emit qcRegionsChanged();
+    }
+}
+
 void TimelineDock::emitSelectedChanged(const QVector<int> &roles)
 {
     if (selection().isEmpty())
@@ -608,10 +819,13 @@ void TimelineDock::removeSelection(bool withCopy)
 
     // Cut
     if (withCopy) {
-        auto clip = selection().first();
-        copyClip(clip.y(), clip.x());
-        remove(clip.y(), clip.x());
-        return;
+        if (selection().size() == 1) {
+            auto clip = selection().first();
+            copyClip(clip.y(), clip.x());
+            remove(clip.y(), clip.x());
+            return;
+        }
+        copySelection();
     }
 
     // Ripple delete
@@ -694,10 +908,54 @@ void TimelineDock::copyClip(int trackIndex, int clipIndex)
         p.seek(info->frame_in);
         p.set_in_and_out(info->frame_in, info->frame_out);
         MLT.setSavedProducer(&p);
+        m_clipboard.clear();
         emit clipCopied();
     }
 }
 
+void TimelineDock::copySelection()
+{
+    if (selection().size() <= 1) {
+        if (selection().isEmpty())
+            copyClip(-1, -1);
+        else
+            copyClip(selection().first().y(), selection().first().x());
+        return;
+    }
+
+    int n = m_clipboard.copy(m_model, selection());
+    LOG_DEBUG() << "copied" << n << "clips on" << m_clipboard.trackCount() << "tracks";
+    emit showStatusMessage(tr("Copied %1 clips from the timeline").arg(n));
+}
+
+void TimelineDock::pasteClipboard(int trackIndex, int position)
+{
+    if (m_clipboard.isEmpty()) {
+        insert(trackIndex, position);
+        return;
+    }
+    if (trackIndex < 0)
+        trackIndex = currentTrack();
+    if (trackIndex < 0 || trackIndex >= m_model.trackList().size())
+        return;
+    if (position < 0)
+        position = m_position;
+
+    QList<TimelineClipboard::Item> items;
+    int skipped = 0;
+    foreach (const TimelineClipboard::Item& item, m_clipboard.items()) {
+        int target = trackIndex + item.trackOffset;
+        if (target < m_model.trackList().size() && !isTrackLocked(target))
+            items << item;
+        else
+            ++skipped;
+    }
+    if (!items.isEmpty())
+        MAIN.undoStack()->push(new Timeline::PasteCommand(m_model, trackIndex, position, items));
+    if (skipped > 0)
+        emit showStatusMessage(tr("%1 clips were not pasted because their tracks are missing or locked").arg(skipped));
+}
+
 void TimelineDock::emitSelectedFromSelection()
 {
     if (!m_model.trackList().count()) {
@@ -1016,6 +1274,9 @@ bool TimelineDock::trimClipIn(int trackIndex, int clipIndex, int oldClipIndex, i
         m_trimCommand.reset(new Timeline::TrimClipInCommand(m_model, trackIndex, oldClipIndex, m_trimDelta, ripple, false));
         if (m_updateCommand && m_updateCommand->trackIndex() == trackIndex && m_updateCommand->clipIndex() == clipIndex)
             m_updateCommand->setPosition(trackIndex, clipIndex, m_updateCommand->position() + delta);
+        QScopedPointer<Mlt::ClipInfo> trimmed(getClipInfo(trackIndex, clipIndex));
+        if (trimmed)
+            emit trimPositionChanged(trackIndex, trimmed->start);
     }
     else return false;
 
@@ -1064,6 +1325,9 @@ bool TimelineDock::trimClipOut(int trackIndex, int clipIndex, int delta, bool ri
         m_trimCommand.reset(new Timeline::TrimClipOutCommand(m_model, trackIndex, clipIndex, m_trimDelta, ripple, false));
         if (m_updateCommand && m_updateCommand->trackIndex() == trackIndex && m_updateCommand->clipIndex() == clipIndex)
             m_updateCommand->setPosition(trackIndex, clipIndex,-1);
+        QScopedPointer<Mlt::ClipInfo> trimmed(getClipInfo(trackIndex, clipIndex));
+        if (trimmed)
+            emit trimPositionChanged(trackIndex, trimmed->start + trimmed->frame_count);
     }
     else return false;
 
@@ -1375,8 +1639,17 @@ void TimelineDock::keyReleaseEvent(QKeyEvent* event)
         MAIN.keyReleaseEvent(event);
 }
 
+void TimelineDock::initialize()
+{
+    m_isInitialized = true;
+    if (isVisible())
+        load();
+}
+
 void TimelineDock::load(bool force)
 {
+    if (!m_isInitialized)
+        return;
     if (m_quickView.source().isEmpty() || force) {
         QDir sourcePath = QmlUtilities::qmlDir();
         sourcePath.cd("views");
@@ -1388,9 +1661,9 @@ void TimelineDock::load(bool force)
         connect(m_quickView.rootObject(), SIGNAL(clipClicked()),
                 this, SIGNAL(clipClicked()));
         if (force && Settings.timelineShowWaveforms())
-            m_model.reload();
+            m_model.refresh();
     } else if (Settings.timelineShowWaveforms()) {
-        m_model.reload();
+        m_model.refresh();
     }
 }
 
@@ -23,6 +23,7 @@
 #include <QApplication>
 #include "models/multitrackmodel.h"
 #include "sharedframe.h"
+#include "timelineclipboard.h"
 
 namespace Ui {
 class TimelineDock;
@@ -39,11 +40,16 @@ class TimelineDock : public QDockWidget
     Q_PROPERTY(int position READ position WRITE setPosition NOTIFY positionChanged)
     Q_PROPERTY(int currentTrack READ currentTrack WRITE setCurrentTrack NOTIFY currentTrackChanged)
     Q_PROPERTY(QVariantList selection READ selectionForJS WRITE setSelectionFromJS NOTIFY selectionChanged)
+    Q_PROPERTY(QVariantList qcRegions READ qcRegions NOTIFY qcRegionsChanged)
 
 public:
     explicit TimelineDock(QWidget *parent = 0);
     ~TimelineDock();
 
+    // Allows loading the QML view, which the main window defers until the
+    // window has painted or the dock is shown afterwards.
+    void initialize();
+
     enum TrimLocation {
         TrimInPoint,
         TrimOutPoint
@@ -82,6 +88,14 @@ public:
     Q_INVOKABLE bool isFloating() const { return QDockWidget::isFloating(); }
     Q_INVOKABLE void copyToSource();
     Q_INVOKABLE static void openProperties();
+    Q_INVOKABLE void analyzeBroadcastSafety();
+    Q_INVOKABLE void syncSelectionByAudio();
+    Q_INVOKABLE void measureLoudness();
+    Q_INVOKABLE void copySelection();
+    Q_INVOKABLE void pasteClipboard(int trackIndex = -1, int position = -1);
+    bool hasClipboard() const { return !m_clipboard.isEmpty(); }
+    QVariantList qcRegions() const { return m_qcRegions; }
+    void setQcRegions(const QVariantList& regions);
     void emitSelectedChanged(const QVector<int> &roles);
     void replaceClipsWithHash(const QString& hash, Mlt::Producer& producer);
 
@@ -104,6 +118,8 @@ signals:
     void filteredClicked();
     void durationChanged();
     void transitionAdded(int trackIndex, int clipIndex, int position, bool ripple);
+    void qcRegionsChanged();
+    void trimPositionChanged(int trackIndex, int position);
 
 public slots:
     void addAudioTrack();
@@ -152,6 +168,7 @@ public slots:
     bool blockSelection(bool block);
     void onProducerModified();
     void replace(int trackIndex, int clipIndex, const QString& xml = QString());
+    void clearQcRegions();
 
 protected:
     void dragEnterEvent(QDragEnterEvent* event);
@@ -184,6 +201,9 @@ private:
     int m_trimDelta;
     int m_transitionDelta;
     bool m_blockSetSelection;
+    bool m_isInitialized;
+    QVariantList m_qcRegions;
+    TimelineClipboard m_clipboard;
 
 private slots:
     void load(bool force = false);
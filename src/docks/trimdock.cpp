@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trimdock.h"
+#include "mainwindow.h"
+#include "mltcontroller.h"
+#include "seekindex.h"
+#include "trimprefetcher.h"
+#include "docks/timelinedock.h"
+#include "widgets/trimmonitorwidget.h"
+#include <QScopedPointer>
+#include <Logger.h>
+
+static const int kMaxSideWidth = 640;
+static const int kMinSideWidth = 160;
+
+TrimDock::TrimDock(QWidget *parent)
+    : QDockWidget(tr("Trim Monitor"), parent)
+{
+    LOG_DEBUG() << "begin";
+    setObjectName("TrimDock");
+    QIcon icon = QIcon::fromTheme("split", QIcon(":/icons/oxygen/32x32/actions/split.png"));
+    setWindowIcon(icon);
+    toggleViewAction()->setIcon(windowIcon());
+#ifdef Q_OS_MAC
+    setFeatures(DockWidgetClosable | DockWidgetMovable);
+#endif
+    for (int i = TrimMonitorWidget::OutgoingSide; i <= TrimMonitorWidget::IncomingSide; ++i) {
+        m_prefetchers[i] = 0;
+        m_producers[i] = 0;
+        m_frames[i] = -1;
+    }
+    m_widget = new TrimMonitorWidget(this);
+    QDockWidget::setWidget(m_widget);
+    connect(this, SIGNAL(visibilityChanged(bool)), SLOT(onVisibilityChanged(bool)));
+    LOG_DEBUG() << "end";
+}
+
+TrimDock::~TrimDock()
+{
+    stopPrefetcher(TrimMonitorWidget::OutgoingSide);
+    stopPrefetcher(TrimMonitorWidget::IncomingSide);
+}
+
+void TrimDock::setEditPoint(int trackIndex, int position)
+{
+    if (!isVisible())
+        return;
+    TimelineDock* timeline = MAIN.timelineDock();
+    QScopedPointer<Mlt::ClipInfo> outgoing;
+    if (position > 0)
+        outgoing.reset(timeline->getClipInfo(trackIndex, timeline->clipIndexAtPosition(trackIndex, position - 1)));
+    showSide(TrimMonitorWidget::OutgoingSide, outgoing.data(), outgoing? position - 1 - outgoing->start : 0);
+    QScopedPointer<Mlt::ClipInfo> incoming(timeline->getClipInfo(trackIndex, timeline->clipIndexAtPosition(trackIndex, position)));
+    showSide(TrimMonitorWidget::IncomingSide, incoming.data(), incoming? position - incoming->start : 0);
+}
+
+void TrimDock::clear()
+{
+    stopPrefetcher(TrimMonitorWidget::OutgoingSide);
+    stopPrefetcher(TrimMonitorWidget::IncomingSide);
+    m_widget->clear();
+}
+
+void TrimDock::showSide(int side, Mlt::ClipInfo* info, int offset)
+{
+    if (!info || !info->producer || !info->producer->is_valid() || info->producer->is_blank()
+            || offset < 0 || offset >= info->frame_count) {
+        stopPrefetcher(side);
+        m_widget->setLabel(side, QString());
+        return;
+    }
+    int frame = info->frame_in + offset;
+    void* producer = info->producer->get_producer();
+    if (!m_prefetchers[side] || m_producers[side] != producer) {
+        stopPrefetcher(side);
+        Mlt::Producer parent(info->producer->parent());
+        SeekIndex::request(parent);
+        int width = qBound(kMinSideWidth, m_widget->width() * devicePixelRatio() / 2, kMaxSideWidth);
+        m_prefetchers[side] = new TrimPrefetcher(side, MLT.XML(info->producer), width, this);
+        connect(m_prefetchers[side], SIGNAL(frameReady(int, int, const QImage&)),
+                SLOT(onFrameReady(int, int, const QImage&)));
+        m_prefetchers[side]->start(QThread::LowPriority);
+        m_producers[side] = producer;
+    }
+    m_frames[side] = frame;
+    QString time = QString::fromLatin1(info->producer->frames_to_time(frame));
+    m_widget->setLabel(side, (side == TrimMonitorWidget::OutgoingSide)? tr("Out %1").arg(time) : tr("In %1").arg(time));
+    // Show a prefetched frame right away.
+    QImage image = m_prefetchers[side]->image(frame);
+    if (!image.isNull())
+        m_widget->setImage(side, image);
+    m_prefetchers[side]->requestFrame(frame);
+}
+
+void TrimDock::stopPrefetcher(int side)
+{
+    // The destructor waits for the thread to finish.
+    delete m_prefetchers[side];
+    m_prefetchers[side] = 0;
+    m_producers[side] = 0;
+    m_frames[side] = -1;
+}
+
+void TrimDock::onFrameReady(int side, int frame, const QImage& image)
+{
+    if (side >= TrimMonitorWidget::OutgoingSide && side <= TrimMonitorWidget::IncomingSide
+            && sender() == m_prefetchers[side] && frame == m_frames[side])
+        m_widget->setImage(side, image);
+}
+
+void TrimDock::onVisibilityChanged(bool visible)
+{
+    if (!visible)
+        clear();
+}
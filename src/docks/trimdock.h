@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRIMDOCK_H
+#define TRIMDOCK_H
+
+#include <QDockWidget>
+
+class TrimPrefetcher;
+class TrimMonitorWidget;
+namespace Mlt {
+    class ClipInfo;
+}
+
+class TrimDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TrimDock(QWidget *parent = 0);
+    ~TrimDock();
+
+public slots:
+    void setEditPoint(int trackIndex, int position);
+    void clear();
+
+private slots:
+    void onFrameReady(int side, int frame, const QImage& image);
+    void onVisibilityChanged(bool visible);
+
+private:
+    void showSide(int side, Mlt::ClipInfo* info, int offset);
+    void stopPrefetcher(int side);
+
+    TrimMonitorWidget* m_widget;
+    TrimPrefetcher* m_prefetchers[2];
+    void* m_producers[2]; // identifies the clip each prefetcher decodes
+    int m_frames[2];
+};
+
+#endif // TRIMDOCK_H
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "fielddetection.h"
+#include "analysiscache.h"
+#include "mltcontroller.h"
+#include "proxymanager.h"
+#include <QDataStream>
+#include <QVector>
+#include <MltProfile.h>
+#include <MltProducer.h>
+#include <MltFrame.h>
+#include <Logger.h>
+#include <algorithm>
+
+static const AnalysisCache kCache("fields", ".fields", 0x4649454C /* "FIEL" */, 1);
+static const int kRunCount = 8;
+static const int kRunLength = 25;
+static const int kCombThreshold = 12;
+static const int kNoiseFloorDivisor = 500;
+static const int kMinVotes = 8;
+
+FieldDetection::Request FieldDetection::request(Mlt::Producer& producer)
+{
+    Request request;
+    // Analyze the original media; proxies are always progressive.
+    request.service = "avformat";
+    request.resource = ProxyManager::resource(producer);
+    request.videoIndex = producer.get("video_index")? producer.get_int("video_index") : 0;
+    request.cachePath = kCache.path(producer, request.videoIndex);
+    return request;
+}
+
+int FieldDetection::combCount(const uint8_t* top, const uint8_t* bottom, int width, int height)
+{
+    // A bottom field line is combed where it is brighter or darker than both
+    // of its neighbors in the top field. Every other column is enough.
+    int count = 0;
+    for (int y = 1; y + 1 < height; y += 2) {
+        const uint8_t* above = top + (y - 1) * width;
+        const uint8_t* below = top + (y + 1) * width;
+        const uint8_t* line = bottom + y * width;
+        for (int x = 0; x < width; x += 2) {
+            int d1 = line[x] - above[x];
+            int d2 = line[x] - below[x];
+            if ((d1 > kCombThreshold && d2 > kCombThreshold) || (d1 < -kCombThreshold && d2 < -kCombThreshold))
+                ++count;
+        }
+    }
+    return count;
+}
+
+FieldDetection::Scan FieldDetection::vote(int own, int topWithPreviousBottom, int previousTopWithBottom, int noiseFloor)
+{
+    // Without motion every weave looks the same.
+    if (qMax(topWithPreviousBottom, previousTopWithBottom) < noiseFloor)
+        return Unknown;
+    // Progressive frames only comb when mixed with another frame.
+    if (own * 2 < qMin(topWithPreviousBottom, previousTopWithBottom))
+        return Progressive;
+    // The previous bottom field is next to the top field only in TFF video.
+    if (topWithPreviousBottom * 3 < previousTopWithBottom * 2)
+        return TopFieldFirst;
+    if (previousTopWithBottom * 3 < topWithPreviousBottom * 2)
+        return BottomFieldFirst;
+    return Unknown;
+}
+
+FieldDetection::Result FieldDetection::analyze(const Request& request,
+                                               const std::function<void(int)>& progress,
+                                               const std::function<bool()>& isCanceled)
+{
+    Result result = {Unknown, 0, 0, 0, 0};
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    // Open the media without the normalizing filters so that nothing scales
+    // or deinterlaces the fields.
+    Mlt::Producer producer(profile, request.service.toUtf8().constData(), request.resource.toUtf8().constData());
+    if (!producer.is_valid())
+        return result;
+    producer.set("video_index", request.videoIndex);
+    producer.set("audio_index", -1);
+    int width = producer.get_int("meta.media.width");
+    int height = producer.get_int("meta.media.height");
+    int length = producer.get_length();
+    if (width <= 0 || height < 4 || length < 2)
+        return result;
+
+    // Sample runs of consecutive frames spread over the clip.
+    int runLength = qMin(kRunLength, length);
+    int runs = qBound(1, length / runLength, kRunCount);
+    int noiseFloor = qMax(1, (width / 2) * (height / 2) / kNoiseFloorDivisor);
+    QVector<uint8_t> previous;
+    QVector<uint8_t> current(width * height);
+    for (int run = 0; run < runs; ++run) {
+        int start = (runs > 1)? qint64(length - runLength) * run / (runs - 1) : 0;
+        producer.seek(start);
+        previous.clear();
+        for (int i = 0; i < runLength; ++i) {
+            if (isCanceled())
+                return result;
+            progress(100 * (run * runLength + i) / (runs * runLength));
+            QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+            if (!frame || !frame->is_valid())
+                continue;
+            mlt_image_format format = mlt_image_yuv422;
+            int w = width;
+            int h = height;
+            const uint8_t* image = frame->get_image(format, w, h);
+            if (!image || w != width || h != height)
+                continue;
+            for (int k = 0; k < width * height; ++k)
+                current[k] = image[2 * k];
+            if (!previous.isEmpty()) {
+                int own = combCount(current.constData(), current.constData(), width, height);
+                int a = combCount(current.constData(), previous.constData(), width, height);
+                int b = combCount(previous.constData(), current.constData(), width, height);
+                switch (vote(own, a, b, noiseFloor)) {
+                case Progressive:
+                    ++result.progressive;
+                    break;
+                case TopFieldFirst:
+                    ++result.topFieldFirst;
+                    break;
+                case BottomFieldFirst:
+                    ++result.bottomFieldFirst;
+                    break;
+                default:
+                    ++result.undetermined;
+                    break;
+                }
+            } else {
+                previous.resize(width * height);
+            }
+            std::swap(previous, current);
+        }
+    }
+
+    int interlaced = result.topFieldFirst + result.bottomFieldFirst;
+    if (result.progressive + interlaced >= kMinVotes) {
+        if (result.progressive > interlaced)
+            result.scan = Progressive;
+        else if (result.topFieldFirst >= result.bottomFieldFirst)
+            result.scan = TopFieldFirst;
+        else
+            result.scan = BottomFieldFirst;
+    }
+    LOG_DEBUG() << request.resource << toString(result);
+    return result;
+}
+
+// A result without enough motion is still worth caching; only a file that
+// could not be decoded is not.
+bool FieldDetection::isValid(const Result& result)
+{
+    return result.progressive + result.topFieldFirst + result.bottomFieldFirst + result.undetermined > 0;
+}
+
+bool FieldDetection::load(const QString& cachePath, Result& result)
+{
+    return kCache.read(cachePath, [&](QDataStream& stream) {
+        qint32 scan;
+        stream >> scan >> result.progressive >> result.topFieldFirst
+               >> result.bottomFieldFirst >> result.undetermined;
+        result.scan = Scan(scan);
+        return true;
+    });
+}
+
+bool FieldDetection::save(const QString& cachePath, const Result& result)
+{
+    return kCache.write(cachePath, [&](QDataStream& stream) {
+        stream << qint32(result.scan) << result.progressive << result.topFieldFirst
+               << result.bottomFieldFirst << result.undetermined;
+    });
+}
+
+QString FieldDetection::jobLabel(const QString& name)
+{
+    return tr("Detect scan mode of %1").arg(name);
+}
+
+bool FieldDetection::differs(Mlt::Producer& producer, const Result& result)
+{
+    if (result.scan == Unknown)
+        return false;
+    int progressive = producer.get("force_progressive")? producer.get_int("force_progressive")
+                                                       : producer.get_int("meta.media.progressive");
+    if (progressive != (result.scan == Progressive))
+        return true;
+    if (result.scan == Progressive)
+        return false;
+    int tff = producer.get("force_tff")? producer.get_int("force_tff")
+                                       : producer.get_int("meta.media.top_field_first");
+    return tff != (result.scan == TopFieldFirst);
+}
+
+bool FieldDetection::apply(Mlt::Producer& producer, const Result& result, bool overrideUser)
+{
+    if (!differs(producer, result))
+        return false;
+    if (!overrideUser && (producer.get("force_progressive") || producer.get("force_tff")))
+        return false;
+    bool changed = false;
+    // Set these force_ properties as a string so they can be removed by setting them NULL.
+    int progressive = producer.get("force_progressive")? producer.get_int("force_progressive")
+                                                       : producer.get_int("meta.media.progressive");
+    int isProgressive = (result.scan == Progressive)? 1 : 0;
+    if (progressive != isProgressive) {
+        producer.set("force_progressive", QString::number(isProgressive).toLatin1().constData());
+        changed = true;
+    }
+    if (!isProgressive) {
+        int tff = producer.get("force_tff")? producer.get_int("force_tff")
+                                           : producer.get_int("meta.media.top_field_first");
+        int isTff = (result.scan == TopFieldFirst)? 1 : 0;
+        if (tff != isTff) {
+            producer.set("force_tff", QString::number(isTff).toLatin1().constData());
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+QString FieldDetection::toString(const Result& result)
+{
+    int votes = result.progressive + result.topFieldFirst + result.bottomFieldFirst;
+    int frames = votes + result.undetermined;
+    switch (result.scan) {
+    case Progressive:
+        return tr("Progressive (%1 of %2 frames)").arg(result.progressive).arg(frames);
+    case TopFieldFirst:
+        return tr("Interlaced, top field first (%1 of %2 frames)").arg(result.topFieldFirst).arg(frames);
+    case BottomFieldFirst:
+        return tr("Interlaced, bottom field first (%1 of %2 frames)").arg(result.bottomFieldFirst).arg(frames);
+    default:
+        return tr("Unknown, not enough motion in %1 frames").arg(frames);
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FIELDDETECTION_H
+#define FIELDDETECTION_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <functional>
+#include <stdint.h>
+
+namespace Mlt {
+    class Producer;
+}
+
+/*!
+  \class FieldDetection
+  \brief Detects whether video is really progressive and its field order.
+
+  Container flags are often wrong, which either deinterlaces progressive
+  video for nothing or shows interlaced video combed. This looks at the
+  pictures instead. For runs of consecutive frames, each frame is woven
+  three ways: its own two fields, its top field with the previous bottom
+  field, and the previous top field with its bottom field. Fields close in
+  time comb the least in motion, so the least combed weave votes for
+  progressive, top field first or bottom field first. Frames without
+  enough motion do not vote. The result is cached per file in the
+  application data folder, unless the file has no hash, and applied to
+  clips as the force_progressive and force_tff producer properties that
+  the preview and export honor.
+*/
+
+class FieldDetection
+{
+    Q_DECLARE_TR_FUNCTIONS(FieldDetection)
+
+public:
+    enum Scan {
+        Unknown = 0,
+        Progressive,
+        TopFieldFirst,
+        BottomFieldFirst
+    };
+
+    struct Result {
+        Scan scan;
+        int progressive;  // frames voting for each scan mode
+        int topFieldFirst;
+        int bottomFieldFirst;
+        int undetermined; // static or ambiguous frames
+    };
+
+    struct Request {
+        QString service;
+        QString resource;
+        int videoIndex;
+        QString cachePath;
+    };
+
+    static Request request(Mlt::Producer& producer);
+    static Result analyze(const Request& request,
+                          const std::function<void(int)>& progress,
+                          const std::function<bool()>& isCanceled);
+    static bool isValid(const Result& result);
+    static bool load(const QString& cachePath, Result& result);
+    static bool save(const QString& cachePath, const Result& result);
+    static QString jobLabel(const QString& name);
+
+    //! Returns whether applying \a result would change the scan mode of \a producer.
+    static bool differs(Mlt::Producer& producer, const Result& result);
+    /*!
+      Sets the force properties of \a producer that differ from its metadata.
+      Properties already set by the user are kept unless \a overrideUser.
+      Returns whether the producer changed.
+    */
+    static bool apply(Mlt::Producer& producer, const Result& result, bool overrideUser);
+    static QString toString(const Result& result);
+
+    // Counts the combed pixels when weaving the given fields of two frames.
+    static int combCount(const uint8_t* top, const uint8_t* bottom, int width, int height);
+    static Scan vote(int own, int topWithPreviousBottom, int previousTopWithBottom, int noiseFloor);
+};
+
+#endif // FIELDDETECTION_H
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frametiming.h"
+#include "analysiscache.h"
+#include "mltcontroller.h"
+#include "proxymanager.h"
+#include <QDataStream>
+#include <QFileInfo>
+#include <QProcess>
+#include <MltPlaylist.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+#include <MltTractor.h>
+#include <Logger.h>
+#include <algorithm>
+#include <cmath>
+
+static const AnalysisCache kCache("timing", ".timing", 0x54494D45 /* "TIME" */, 2);
+// Rounding to the container time base moves timestamps a little.
+static const double kConstantTolerance = 0.05; // of a frame
+static const double kRateTolerance = 0.005;
+static const int kStandardRates[][2] = {
+    {24000, 1001}, {24, 1}, {25, 1}, {30000, 1001}, {30, 1}, {48, 1}, {50, 1},
+    {60000, 1001}, {60, 1}, {90, 1}, {100, 1}, {120000, 1001}, {120, 1}, {240, 1}
+};
+
+FrameTiming::Request FrameTiming::request(Mlt::Producer& producer)
+{
+    Request request;
+    // Analyze the original media; proxies are encoded at a constant rate.
+    request.resource = ProxyManager::resource(producer);
+    request.videoIndex = producer.get("video_index")? producer.get_int("video_index") : 0;
+    request.duration = producer.get_length() / MLT.profile().fps();
+    request.cachePath = kCache.path(producer, request.videoIndex);
+    return request;
+}
+
+FrameTiming::Result FrameTiming::analyze(const Request& request,
+                                         const std::function<void(int)>& progress,
+                                         const std::function<bool()>& isCanceled)
+{
+    Result result = {Unknown, 0, 0, 1, 0.0, 0.0, 0, 0, QVector<qint32>()};
+    QProcess process;
+    QFileInfo ffprobePath(qApp->applicationDirPath(), "ffprobe");
+    QStringList args;
+    args << "-v" << "error" << "-select_streams" << QString::number(request.videoIndex)
+         << "-show_entries" << "packet=pts_time" << "-of" << "csv=print_section=0"
+         << request.resource;
+    process.start(ffprobePath.absoluteFilePath(), args);
+    if (!process.waitForStarted())
+        return result;
+
+    // Packets are listed in decoding order.
+    QVector<double> timestamps;
+    double first = -1.0;
+    bool isRunning = true;
+    while (isRunning) {
+        isRunning = process.state() != QProcess::NotRunning && !process.waitForFinished(100);
+        if (isCanceled()) {
+            process.kill();
+            process.waitForFinished();
+            return result;
+        }
+        while (process.canReadLine()) {
+            bool ok = false;
+            double time = process.readLine().trimmed().toDouble(&ok);
+            if (!ok)
+                continue;
+            timestamps << time;
+            if (first < 0.0)
+                first = time;
+            if (request.duration > 0.0)
+                progress(qBound(0, int(100 * (time - first) / request.duration), 99));
+        }
+    }
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        LOG_WARNING() << "ffprobe failed for" << request.resource << process.readAllStandardError();
+        return result;
+    }
+    std::sort(timestamps.begin(), timestamps.end());
+    result = classify(timestamps);
+    LOG_DEBUG() << request.resource << toString(result);
+    return result;
+}
+
+FrameTiming::Result FrameTiming::classify(const QVector<double>& timestamps)
+{
+    Result result = {Unknown, timestamps.size(), 0, 1, 0.0, 0.0, 0, 0, QVector<qint32>()};
+    if (timestamps.size() < 3)
+        return result;
+
+    // The median frame duration ignores the occasional long or short frame.
+    QVector<double> durations;
+    durations.reserve(timestamps.size() - 1);
+    for (int i = 1; i < timestamps.size(); ++i)
+        durations << timestamps[i] - timestamps[i - 1];
+    std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+    double duration = durations[durations.size() / 2];
+    if (duration <= 0.0)
+        return result;
+
+    double fps = 1.0 / duration;
+    result.rateNum = qRound(fps * 1000.0);
+    result.rateDen = 1000;
+    for (const auto& rate : kStandardRates) {
+        if (qAbs(fps - double(rate[0]) / rate[1]) < fps * kRateTolerance) {
+            result.rateNum = rate[0];
+            result.rateDen = rate[1];
+            break;
+        }
+    }
+    fps = double(result.rateNum) / result.rateDen;
+
+    // Map every frame to its slot on the constant rate grid.
+    QVector<qint32> frameSlots;
+    frameSlots.reserve(timestamps.size());
+    double sum = 0.0;
+    int previous = -1;
+    for (int i = 0; i < timestamps.size(); ++i) {
+        double time = (timestamps[i] - timestamps[0]) * fps;
+        int slot = qRound(time);
+        double distance = qAbs(time - slot) / fps * 1000.0;
+        sum += distance * distance;
+        result.maxJitter = qMax(result.maxJitter, distance);
+        if (slot == previous)
+            ++result.duplicates;
+        else if (previous >= 0 && slot > previous + 1)
+            result.gaps += slot - previous - 1;
+        frameSlots << slot;
+        previous = slot;
+    }
+    result.jitter = std::sqrt(sum / timestamps.size());
+
+    if (result.duplicates || result.gaps) {
+        result.timing = Variable;
+        // A one to one map is implied by the other timings.
+        result.frameSlots = frameSlots;
+    } else if (result.maxJitter * fps / 1000.0 > kConstantTolerance) {
+        result.timing = Jittered;
+    } else {
+        result.timing = Constant;
+    }
+    return result;
+}
+
+QVector<int> FrameTiming::gridMap(const QVector<qint32>& frameSlots)
+{
+    QVector<int> map;
+    if (frameSlots.isEmpty())
+        return map;
+    map.reserve(frameSlots.last() + 1);
+    int frame = 0;
+    int shown = frameSlots.first();
+    for (int slot = 0; slot <= frameSlots.last(); ++slot) {
+        // Frames after the first in a slot are never shown.
+        while (frame < frameSlots.size() && frameSlots[frame] <= slot)
+            shown = frameSlots[frame++];
+        map << shown;
+    }
+    return map;
+}
+
+bool FrameTiming::load(const QString& cachePath, Result& result)
+{
+    return kCache.read(cachePath, [&](QDataStream& stream) {
+        qint32 timing;
+        stream >> timing >> result.frames >> result.rateNum >> result.rateDen >> result.jitter
+               >> result.maxJitter >> result.duplicates >> result.gaps >> result.frameSlots;
+        result.timing = Timing(timing);
+        return result.rateDen > 0;
+    });
+}
+
+bool FrameTiming::save(const QString& cachePath, const Result& result)
+{
+    return kCache.write(cachePath, [&](QDataStream& stream) {
+        stream << qint32(result.timing) << result.frames << result.rateNum << result.rateDen
+               << result.jitter << result.maxJitter << result.duplicates << result.gaps
+               << result.frameSlots;
+    });
+}
+
+QString FrameTiming::jobLabel(const QString& name)
+{
+    return tr("Analyze frame rate of %1").arg(name);
+}
+
+bool FrameTiming::differs(Mlt::Producer& producer, const Result& result)
+{
+    if (result.timing != Constant && result.timing != Jittered)
+        return false;
+    return producer.get_int("meta.media.frame_rate_num") != result.rateNum
+        || producer.get_int("meta.media.frame_rate_den") != result.rateDen
+        || producer.get_int("meta.media.variable_frame_rate");
+}
+
+bool FrameTiming::apply(Mlt::Producer& producer, const Result& result)
+{
+    if (!differs(producer, result))
+        return false;
+    // avformat converts positions to source frames and timestamps with the
+    // source rate in the media metadata, and the project keeps it.
+    producer.set("meta.media.frame_rate_num", result.rateNum);
+    producer.set("meta.media.frame_rate_den", result.rateDen);
+    producer.set("meta.media.variable_frame_rate", 0);
+    return true;
+}
+
+bool FrameTiming::conform(Mlt::Producer& producer, const Result& result, const QString& fileName)
+{
+    if (result.timing != Variable || result.frameSlots.isEmpty())
+        return false;
+    Mlt::Profile& profile = MLT.profile();
+    QByteArray resource = ProxyManager::resource(producer).toUtf8();
+    Mlt::Producer video(profile, "avformat", resource.constData());
+    Mlt::Producer audio(profile, "avformat", resource.constData());
+    if (!video.is_valid() || !audio.is_valid())
+        return false;
+    // On the nominal rate a position in the source lands on the frame in
+    // that slot of the map, or the next one when the slot is empty.
+    video.set("video_index", producer.get_int("video_index"));
+    video.set("audio_index", -1);
+    video.set("meta.media.frame_rate_num", result.rateNum);
+    video.set("meta.media.frame_rate_den", result.rateDen);
+    video.set("meta.media.variable_frame_rate", 0);
+    audio.set("video_index", -1);
+    audio.set("audio_index", producer.get_int("audio_index"));
+
+    // Cut the video into runs of consecutive positions and step back over
+    // each empty slot to repeat the frame before it.
+    QVector<int> map = gridMap(result.frameSlots);
+    double slotsPerFrame = double(result.rateNum) / result.rateDen / profile.fps();
+    int length = qMax(1, int(map.size() / slotsPerFrame));
+    Mlt::Playlist videoTrack(profile);
+    int in = -1;
+    int out = -1;
+    for (int i = 0; i < length; ++i) {
+        int slot = qMin(int(i * slotsPerFrame + 1e-6), map.size() - 1);
+        int position = i - qRound((slot - map[slot]) / slotsPerFrame);
+        if (in < 0 || position != out + 1) {
+            if (in >= 0)
+                videoTrack.append(video, in, out);
+            in = position;
+        }
+        out = position;
+    }
+    videoTrack.append(video, in, out);
+    videoTrack.set("hide", 2);
+
+    Mlt::Playlist audioTrack(profile);
+    audioTrack.append(audio, 0, length - 1);
+    audioTrack.set("hide", 1);
+
+    Mlt::Tractor tractor(profile);
+    tractor.set_track(videoTrack, 0);
+    tractor.set_track(audioTrack, 1);
+    return MLT.saveXML(fileName, &tractor, false, false);
+}
+
+QString FrameTiming::toString(const Result& result)
+{
+    QString rate = QString("%L1").arg(double(result.rateNum) / result.rateDen, 0, 'f', 3);
+    switch (result.timing) {
+    case Constant:
+        return tr("Constant frame rate, %1 fps (%2 frames)").arg(rate).arg(result.frames);
+    case Jittered:
+        return tr("Constant frame rate %1 fps with timestamp jitter of %2 ms (up to %3 ms)")
+            .arg(rate).arg(result.jitter, 0, 'f', 2).arg(result.maxJitter, 0, 'f', 2);
+    case Variable:
+        return tr("Variable frame rate around %1 fps: %2 repeated and %3 missing frames")
+            .arg(rate).arg(result.duplicates).arg(result.gaps);
+    default:
+        return tr("Unknown frame rate, too few frames");
+    }
+}
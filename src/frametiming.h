@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FRAMETIMING_H
+#define FRAMETIMING_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+namespace Mlt {
+    class Producer;
+}
+
+/*!
+  \class FrameTiming
+  \brief Finds whether video is really variable frame rate and conforms it.
+
+  Phones and screen recorders write timestamps that wander around a
+  constant rate, and containers then report an average rate that is not
+  the real one, so the producer maps frames to the wrong times and the
+  preview drifts from the export. This reads the presentation timestamps
+  of every video packet with ffprobe, picks the nominal rate from the
+  typical frame duration, and builds a constant frame rate timestamp map
+  that places every frame in its slot on that grid.
+
+  When no two frames share a slot and no slot is left empty, the map is
+  one to one and the media is only jittered: the producer is conformed by
+  giving it the nominal rate as its source rate. Otherwise conform() writes
+  a clip that follows the map, repeating a frame into each empty slot and
+  dropping frames that share a slot, so neither needs a re-encode. The
+  result is cached per file in the application data folder.
+*/
+
+class FrameTiming
+{
+    Q_DECLARE_TR_FUNCTIONS(FrameTiming)
+
+public:
+    enum Timing {
+        Unknown = 0,
+        Constant,
+        Jittered,
+        Variable
+    };
+
+    struct Result {
+        Timing timing;
+        int frames;
+        int rateNum;       // nominal frame rate
+        int rateDen;
+        double jitter;     // RMS distance from the grid in milliseconds
+        double maxJitter;  // largest distance from the grid in milliseconds
+        int duplicates;    // frames that share a slot with the previous one
+        int gaps;          // empty slots between frames
+        QVector<qint32> frameSlots; // the timestamp map, only kept when Variable
+    };
+
+    struct Request {
+        QString resource;
+        int videoIndex;
+        double duration; // seconds, for progress
+        QString cachePath;
+    };
+
+    static Request request(Mlt::Producer& producer);
+    static Result analyze(const Request& request,
+                          const std::function<void(int)>& progress,
+                          const std::function<bool()>& isCanceled);
+
+    // Classifies sorted presentation timestamps in seconds.
+    static Result classify(const QVector<double>& timestamps);
+    /*!
+      Returns the slot of the frame to show in each slot of the grid, given
+      the slot of each frame: the slot itself when a frame starts in it, or
+      else the last slot before it that has one.
+    */
+    static QVector<int> gridMap(const QVector<qint32>& frameSlots);
+    static bool isValid(const Result& result) { return result.timing != Unknown; }
+    static bool load(const QString& cachePath, Result& result);
+    static bool save(const QString& cachePath, const Result& result);
+    static QString jobLabel(const QString& name);
+
+    //! Returns whether apply() would change \a producer.
+    static bool differs(Mlt::Producer& producer, const Result& result);
+    /*!
+      Sets the source frame rate of \a producer to the nominal rate when the
+      timestamp map is one to one. Returns whether the producer changed.
+    */
+    static bool apply(Mlt::Producer& producer, const Result& result);
+    /*!
+      Writes to \a fileName a clip that shows the video of \a producer on the
+      grid of a Variable \a result by following its timestamp map, in the
+      current profile, with the audio left as it is. Returns whether the clip
+      was written.
+    */
+    static bool conform(Mlt::Producer& producer, const Result& result, const QString& fileName);
+    static QString toString(const Result& result);
+};
+
+#endif // FRAMETIMING_H
@@ -32,6 +32,8 @@
 #include "qmltypes/qmlutilities.h"
 #include "qmltypes/qmlfilter.h"
 #include "mainwindow.h"
+#include "previewregion.h"
+#include "util.h"
 
 #define USE_GL_SYNC // Use glFinish() if not defined.
 
@@ -41,6 +43,9 @@
 #define check_error(fn) { int err = fn->glGetError(); if (err != GL_NO_ERROR) { LOG_ERROR() << "GL error"  << hex << err << dec << "at" << __FILE__ << ":" << __LINE__; } }
 #endif
 
+// Render the whole frame when most of it is visible anyway.
+static const double kMaxRegionSize = 0.9;
+
 #ifndef GL_TIMEOUT_IGNORED
 #define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
 #endif
@@ -70,6 +75,9 @@ GLWidget::GLWidget(QObject *parent)
     , m_shareContext(0)
     , m_snapToGrid(true)
     , m_scrubAudio(false)
+    , m_regionFilter(0)
+    , m_isRegionSuspended(false)
+    , m_isFullFrameNeeded(false)
 {
     LOG_DEBUG() << "begin";
     m_texture[0] = m_texture[1] = m_texture[2] = 0;
@@ -104,6 +112,7 @@ GLWidget::~GLWidget()
 {
     LOG_DEBUG() << "begin";
     stop();
+    delete m_regionFilter;
     delete m_glslManager;
     delete m_threadStartEvent;
     delete m_threadStopEvent;
@@ -218,6 +227,8 @@ void GLWidget::resizeGL(int width, int height)
     y = (height - h) / 2.0;
     m_rect.setRect(x, y, w, h);
     emit rectChanged();
+    if (updateRegion())
+        refreshConsumer();
 }
 
 void GLWidget::resizeEvent(QResizeEvent* event)
@@ -383,6 +394,14 @@ void GLWidget::paintGL()
         return;
     }
 
+    // The image may show only the visible part of the frame.
+    QRectF region;
+    if (!m_glslManager) {
+        m_mutex.lock();
+        region = PreviewRegion::frameRegion(m_sharedFrame);
+        m_mutex.unlock();
+    }
+
     // Bind textures.
     for (int i = 0; i < 3; ++i) {
         if (m_texture[i]) {
@@ -425,10 +444,20 @@ void GLWidget::paintGL()
     QVector<QVector2D> vertices;
     width = m_rect.width() * devicePixelRatio();
     height = m_rect.height() * devicePixelRatio();
-    vertices << QVector2D(-width/2.0f, -height/2.0f);
-    vertices << QVector2D(-width/2.0f, height/2.0f);
-    vertices << QVector2D(width/2.0f, -height/2.0f);
-    vertices << QVector2D(width/2.0f, height/2.0f);
+    float left = -width/2.0f;
+    float top = height/2.0f;
+    float right = width/2.0f;
+    float bottom = -height/2.0f;
+    if (!region.isNull()) {
+        left = -width/2.0f + region.left() * width;
+        top = height/2.0f - region.top() * height;
+        right = left + region.width() * width;
+        bottom = top - region.height() * height;
+    }
+    vertices << QVector2D(left, bottom);
+    vertices << QVector2D(left, top);
+    vertices << QVector2D(right, bottom);
+    vertices << QVector2D(right, top);
     m_shader->enableAttributeArray(m_vertexLocation);
     check_error(f);
     m_shader->setAttributeArray(m_vertexLocation, vertices.constData());
@@ -634,6 +663,8 @@ int GLWidget::reconfigure(bool isMulti)
     // use SDL for audio, OpenGL for video
     QString serviceName = property("mlt_service").toString();
     if (!m_consumer || !m_consumer->is_valid()) {
+        delete m_regionFilter;
+        m_regionFilter = 0;
         if (serviceName.isEmpty()) {
             m_consumer.reset(new Mlt::FilteredConsumer(previewProfile(), "sdl2_audio"));
             if (m_consumer->is_valid())
@@ -656,6 +687,15 @@ int GLWidget::reconfigure(bool isMulti)
         m_threadCreateEvent = m_consumer->listen("consumer-thread-create", this, (mlt_listener) onThreadCreate);
         delete m_threadJoinEvent;
         m_threadJoinEvent = m_consumer->listen("consumer-thread-join", this, (mlt_listener) onThreadJoin);
+
+#if LIBMLT_VERSION_INT >= MLT_VERSION_PREVIEW_SCALE
+        // Render only the visible part of a zoomed clip.
+        if (m_consumer->is_valid() && !isMulti && !m_glslManager) {
+            m_regionFilter = PreviewRegion::createFilter(previewProfile());
+            if (m_regionFilter)
+                m_consumer->attach(*m_regionFilter);
+        }
+#endif
     }
     if (m_consumer->is_valid()) {
         // Connect the producer to the consumer - tell it to "run" later
@@ -715,6 +755,8 @@ int GLWidget::reconfigure(bool isMulti)
 
 void GLWidget::refreshConsumer(bool scrubAudio)
 {
+    // The clip filters may have changed.
+    updateRegion();
     m_refreshTimer.start();
     m_scrubAudio = scrubAudio;
 }
@@ -752,6 +794,98 @@ void GLWidget::requestImage() const
     m_frameRenderer->requestImage();
 }
 
+void GLWidget::setPreviewScale(int scale)
+{
+    Controller::setPreviewScale(scale);
+    updateRegion();
+}
+
+bool GLWidget::isReducedResolution() const
+{
+    if (!m_consumer || !m_consumer->is_valid())
+        return false;
+    return m_consumer->get_int("width") != MLT.profile().width()
+        || m_consumer->get_int("height") != MLT.profile().height();
+}
+
+// Exporting a frame needs the whole frame at full resolution.
+void GLWidget::setRegionSuspended(bool suspended)
+{
+    m_isRegionSuspended = suspended;
+    updateRegion();
+}
+
+// The video scopes analyze the displayed frames, so they need all of the
+// picture while any of them is shown.
+void GLWidget::setFullFrameNeeded(bool needed)
+{
+    m_isFullFrameNeeded = needed;
+    if (updateRegion())
+        refreshConsumer();
+}
+
+// Returns the part of the frame shown in the widget in fractions of the
+// frame, expanded to the aspect ratio of the profile.
+QRectF GLWidget::visibleRegion() const
+{
+    double frameWidth = MLT.profile().width() * m_zoom;
+    double frameHeight = MLT.profile().height() * m_zoom;
+    if (frameWidth <= 0.0 || frameHeight <= 0.0)
+        return QRectF();
+    QRectF region(m_offset.x() / frameWidth, m_offset.y() / frameHeight,
+                  width() / frameWidth, height() / frameHeight);
+    region &= QRectF(0.0, 0.0, 1.0, 1.0);
+    double size = qMax(region.width(), region.height());
+    if (region.isEmpty() || size >= kMaxRegionSize)
+        return QRectF();
+    QPointF center = region.center();
+    region.setSize(QSizeF(size, size));
+    region.moveCenter(center);
+    region.moveLeft(qBound(0.0, region.left(), 1.0 - size));
+    region.moveTop(qBound(0.0, region.top(), 1.0 - size));
+    return region;
+}
+
+// Sets the consumer to render the visible region at the resolution at which
+// it is shown and returns whether anything changed.
+bool GLWidget::updateRegion()
+{
+#if LIBMLT_VERSION_INT >= MLT_VERSION_PREVIEW_SCALE
+    if (!m_regionFilter || !m_consumer || !m_consumer->is_valid() || !m_producer)
+        return false;
+    int width = previewProfile().width();
+    int height = previewProfile().height();
+    QRectF region;
+    bool isSuspended = m_isRegionSuspended || m_isFullFrameNeeded;
+    if (!isSuspended && m_zoom > 0.0f && m_zoom < 1.0f) {
+        // Do not render more pixels than are shown.
+        int shown = Util::coerceMultiple(qCeil(MLT.profile().height() * m_zoom * devicePixelRatio()));
+        if (shown < height) {
+            width = Util::coerceMultiple(width * shown / height);
+            height = shown;
+        }
+    } else if (!isSuspended && m_zoom > 1.0f && isClip() && PreviewRegion::isSupported(*m_producer)) {
+        region = visibleRegion();
+        if (!region.isNull()) {
+            width = Util::coerceMultiple(qCeil(width * region.width()));
+            height = Util::coerceMultiple(qCeil(height * region.height()));
+        }
+    }
+    PreviewRegion::setRegion(*m_regionFilter, region);
+    bool isChanged = region != m_region || width != m_consumer->get_int("width")
+        || height != m_consumer->get_int("height");
+    if (isChanged) {
+        LOG_DEBUG() << "zoom" << m_zoom << "region" << region << width << "x" << height;
+        m_region = region;
+        m_consumer->set("width", width);
+        m_consumer->set("height", height);
+    }
+    return isChanged;
+#else
+    return false;
+#endif
+}
+
 void GLWidget::onFrameDisplayed(const SharedFrame &frame)
 {
     m_mutex.lock();
@@ -778,6 +912,8 @@ void GLWidget::setZoom(float zoom)
 {
     m_zoom = zoom;
     emit zoomChanged();
+    if (updateRegion())
+        refreshConsumer();
     quickWindow()->update();
 }
 
@@ -785,6 +921,8 @@ void GLWidget::setOffsetX(int x)
 {
     m_offset.setX(x);
     emit offsetChanged();
+    if (updateRegion())
+        refreshConsumer();
     quickWindow()->update();
 }
 
@@ -792,6 +930,8 @@ void GLWidget::setOffsetY(int y)
 {
     m_offset.setY(y);
     emit offsetChanged();
+    if (updateRegion())
+        refreshConsumer();
     quickWindow()->update();
 }
 
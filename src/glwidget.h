@@ -90,6 +90,9 @@ public:
     QImage image() const;
     void requestImage() const;
     bool snapToGrid() const { return m_snapToGrid; }
+    void setPreviewScale(int scale);
+    bool isReducedResolution() const;
+    void setRegionSuspended(bool suspended);
 
 public slots:
     void onFrameDisplayed(const SharedFrame& frame);
@@ -100,6 +103,7 @@ public slots:
     void setBlankScene();
     void setCurrentFilter(QmlFilter* filter, QmlMetadata* meta);
     void setSnapToGrid(bool snap);
+    void setFullFrameNeeded(bool needed);
 
 signals:
     void frameDisplayed(const SharedFrame& frame);
@@ -147,7 +151,13 @@ private:
     bool m_snapToGrid;
     QTimer m_refreshTimer;
     bool m_scrubAudio;
+    Filter* m_regionFilter;
+    bool m_isRegionSuspended;
+    bool m_isFullFrameNeeded;
+    QRectF m_region;
 
+    QRectF visibleRegion() const;
+    bool updateRegion();
     static void on_frame_show(mlt_consumer, void* self, mlt_frame frame);
 
 private slots:
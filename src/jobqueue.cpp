@@ -38,7 +38,7 @@ void JobQueue::cleanup()
 {
     QMutexLocker locker(&m_mutex);
     foreach (AbstractJob* job, m_jobs) {
-        if (job->state() == QProcess::Running) {
+        if (job->jobState() == QProcess::Running) {
             job->stop();
             break;
         }
@@ -126,7 +126,7 @@ void JobQueue::startNextJob()
     if (!m_jobs.isEmpty()) {
         foreach(AbstractJob* job, m_jobs) {
             // if there is already a job started or running, then exit
-            if (job->ran() && job->state() != QProcess::NotRunning)
+            if (job->ran() && job->jobState() != QProcess::NotRunning)
                 break;
             // otherwise, start first non-started job and exit
             if (!job->ran()) {
@@ -161,7 +161,7 @@ bool JobQueue::isPaused() const
 bool JobQueue::hasIncomplete() const
 {
     foreach (AbstractJob* job, m_jobs) {
-        if (!job->ran() || job->state() == QProcess::Running)
+        if (!job->ran() || job->jobState() == QProcess::Running)
             return true;
     }
     return false;
@@ -185,7 +185,7 @@ void JobQueue::removeFinished()
     QMutexLocker locker(&m_mutex);
     auto row = 0;
     foreach (AbstractJob* job, m_jobs) {
-        if (job->ran() && job->state() != QProcess::Running) {
+        if (job->ran() && job->jobState() != QProcess::Running) {
             removeRow(row);
             m_jobs.removeOne(job);
             delete job;
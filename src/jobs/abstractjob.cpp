@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2019 Meltytech, LLC
+ * Copyright (c) 2012-2020 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -17,26 +17,99 @@
 
 #include "abstractjob.h"
 #include "postjobaction.h"
+#include "playbackgovernor.h"
 #include <QApplication>
+#include <QThreadPool>
 #include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
 #include <Logger.h>
 #ifdef Q_OS_WIN
 #include <windows.h>
+#else
+#include <errno.h>
+#include <sys/resource.h>
 #endif
+#ifdef Q_OS_LINUX
+#include <QDir>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+static const int kThrottledNice = 19;
+#endif
+#ifdef Q_OS_LINUX
+static const int kIoprioWhoProcess = 1;
+static const int kIoprioClassShift = 13;
+static const int kIoprioClassIdle = 3;
+#endif
+
+namespace {
+
+// In-process jobs run in their own pool so that they do not take the
+// threads of the global pool, which the player limits during playback.
+QThreadPool& inProcessPool()
+{
+    static QThreadPool* pool = 0;
+    if (!pool)
+        pool = new QThreadPool(qApp);
+    return *pool;
+}
+
+#ifdef Q_OS_LINUX
+QList<int> taskIds(qint64 processId)
+{
+    QList<int> ids;
+    foreach (const QString& tid, QDir(QString("/proc/%1/task").arg(processId)).entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        ids << tid.toInt();
+    if (ids.isEmpty())
+        ids << int(processId);
+    return ids;
+}
+
+// Linux only lets a task leave SCHED_IDLE when it may also lower its nice
+// value to the current one, which usually needs privileges.
+bool canLeaveIdle(int id)
+{
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, id_t(id));
+    if (errno != 0)
+        return false;
+    struct rlimit limit;
+    return geteuid() == 0
+        || (getrlimit(RLIMIT_NICE, &limit) == 0 && rlim_t(20 - nice) <= limit.rlim_cur);
+}
+#endif
+
+} // namespace
 
 AbstractJob::AbstractJob(const QString& name)
     : QProcess(0)
     , m_item(0)
     , m_ran(false)
     , m_killed(false)
+    , m_inProcessState(QProcess::NotRunning)
     , m_label(name)
     , m_startingPercent(0)
+    , m_isThrottled(false)
+#if !defined(Q_OS_WIN) && !defined(Q_OS_LINUX) && !defined(Q_OS_MAC)
+    , m_savedNice(0)
+#endif
 {
     setObjectName(name);
     connect(this, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onFinished(int, QProcess::ExitStatus)));
     connect(this, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
     connect(this, SIGNAL(started()), this, SLOT(onStarted()));
     connect(this, SIGNAL(progressUpdated(QStandardItem*, int)), SLOT(onProgressUpdated(QStandardItem*, int)));
+    connect(&m_inProcessWatcher, SIGNAL(finished()), SLOT(onInProcessFinished()));
+}
+
+AbstractJob::~AbstractJob()
+{
+    if (m_inProcessWatcher.isRunning()) {
+        m_killed = true;
+        m_inProcessWatcher.waitForFinished();
+    }
 }
 
 void AbstractJob::start()
@@ -68,13 +141,22 @@ bool AbstractJob::stopped() const
     return m_killed;
 }
 
+QProcess::ProcessState AbstractJob::jobState() const
+{
+    if (m_inProcessState != QProcess::NotRunning)
+        return m_inProcessState;
+    return state();
+}
+
 void AbstractJob::appendToLog(const QString& s)
 {
+    QMutexLocker locker(&m_logMutex);
     m_log.append(s);
 }
 
 QString AbstractJob::log() const
 {
+    QMutexLocker locker(&m_logMutex);
     return m_log;
 }
 
@@ -106,25 +188,44 @@ void AbstractJob::stop()
     m_killed = true;
 }
 
+void AbstractJob::startInProcess(const std::function<int()>& work)
+{
+    m_inProcessState = QProcess::Running;
+    m_inProcessWatcher.setFuture(QtConcurrent::run(&inProcessPool(), work));
+}
+
+bool AbstractJob::isCanceled() const
+{
+    PlaybackGovernor::yieldIfThrottled();
+    return stopped();
+}
+
+void AbstractJob::onInProcessFinished()
+{
+    m_inProcessState = QProcess::NotRunning;
+    onFinished(m_inProcessWatcher.result(), QProcess::NormalExit);
+}
+
 void AbstractJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    m_log.append(readAll());
+    if (isOpen())
+        appendToLog(readAll());
     const QTime& time = QTime::fromMSecsSinceStartOfDay(m_totalTime.elapsed());
     if (exitStatus == QProcess::NormalExit && exitCode == 0 && !m_killed) {
         if (m_postJobAction) {
             m_postJobAction->doAction();
         }
         LOG_INFO() << "job succeeeded";
-        m_log.append(QString("Completed successfully in %1\n").arg(time.toString()));
+        appendToLog(QString("Completed successfully in %1\n").arg(time.toString()));
         emit progressUpdated(m_item, 100);
         emit finished(this, true);
     } else if (m_killed) {
         LOG_INFO() << "job stopped";
-        m_log.append(QString("Stopped by user at %1\n").arg(time.toString()));
+        appendToLog(QString("Stopped by user at %1\n").arg(time.toString()));
         emit finished(this, false);
     } else {
         LOG_INFO() << "job failed with" << exitCode;
-        m_log.append(QString("Failed with exit code %1\n").arg(exitCode));
+        appendToLog(QString("Failed with exit code %1\n").arg(exitCode));
         emit finished(this, false);
     }
 }
@@ -149,6 +250,83 @@ void AbstractJob::onStarted()
         CloseHandle(processHandle);
     }
 #endif
+    m_isThrottled = false;
+    if (PlaybackGovernor::isThrottled())
+        setThrottled(true);
+}
+
+void AbstractJob::setThrottled(bool throttled)
+{
+    qint64 processId = QProcess::processId();
+    if (processId <= 0 || throttled == m_isThrottled)
+        return;
+    m_isThrottled = throttled;
+#if defined(Q_OS_WIN)
+    HANDLE processHandle = OpenProcess(PROCESS_SET_INFORMATION, FALSE, processId);
+    if (processHandle) {
+        SetPriorityClass(processHandle, throttled? IDLE_PRIORITY_CLASS : BELOW_NORMAL_PRIORITY_CLASS);
+        CloseHandle(processHandle);
+    }
+#elif defined(Q_OS_LINUX)
+    // Priorities belong to each thread on Linux. Lowering the nice value
+    // again needs privileges, so the child is moved to the idle scheduling
+    // class when it may leave it and otherwise pinned to one CPU. Both keep
+    // its nice value, and threads it starts inherit them.
+    if (throttled) {
+        m_savedPriorities.clear();
+        foreach (int id, taskIds(processId)) {
+            TaskPriority saved;
+            saved.ioPriority = qMax(0, int(syscall(SYS_ioprio_get, kIoprioWhoProcess, id)));
+            saved.isIdle = false;
+            saved.isPinned = false;
+            if (canLeaveIdle(id)) {
+                struct sched_param param = {0};
+                saved.isIdle = sched_setscheduler(id, SCHED_IDLE, &param) == 0;
+            }
+            if (!saved.isIdle && sched_getaffinity(id, sizeof(saved.affinity), &saved.affinity) == 0) {
+                int cpu = CPU_SETSIZE - 1;
+                while (cpu > 0 && !CPU_ISSET(cpu, &saved.affinity))
+                    --cpu;
+                cpu_set_t one;
+                CPU_ZERO(&one);
+                CPU_SET(cpu, &one);
+                saved.isPinned = sched_setaffinity(id, sizeof(one), &one) == 0;
+            }
+            syscall(SYS_ioprio_set, kIoprioWhoProcess, id, kIoprioClassIdle << kIoprioClassShift);
+            m_savedPriorities[id] = saved;
+        }
+    } else if (m_savedPriorities.contains(int(processId))) {
+        // Threads started while throttled take the priorities of the main one.
+        const TaskPriority main = m_savedPriorities[int(processId)];
+        foreach (int id, taskIds(processId)) {
+            const TaskPriority saved = m_savedPriorities.value(id, main);
+            struct sched_param param = {0};
+            if (saved.isIdle && sched_setscheduler(id, SCHED_OTHER, &param) != 0)
+                LOG_WARNING() << "failed to restore the scheduling of job" << objectName();
+            if (saved.isPinned)
+                sched_setaffinity(id, sizeof(saved.affinity), &saved.affinity);
+            syscall(SYS_ioprio_set, kIoprioWhoProcess, id, saved.ioPriority);
+        }
+        m_savedPriorities.clear();
+    }
+#elif defined(Q_OS_MAC)
+    // The background state lowers the CPU and I/O priorities and is undone
+    // without privileges.
+    setpriority(PRIO_DARWIN_PROCESS, id_t(processId), throttled? PRIO_DARWIN_BG : 0);
+#else
+    // Restoring the nice value that the child had may need privileges.
+    if (throttled) {
+        errno = 0;
+        m_savedNice = getpriority(PRIO_PROCESS, id_t(processId));
+        if (errno == 0)
+            setpriority(PRIO_PROCESS, id_t(processId), kThrottledNice);
+        else
+            m_isThrottled = false;
+    } else if (setpriority(PRIO_PROCESS, id_t(processId), m_savedNice) != 0) {
+        LOG_WARNING() << "job" << objectName() << "stays at nice" << kThrottledNice;
+    }
+#endif
+    LOG_DEBUG() << (throttled? "throttled" : "restored") << "job" << objectName();
 }
 
 void AbstractJob::onProgressUpdated(QStandardItem*, int percent)
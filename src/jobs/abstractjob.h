@@ -23,6 +23,14 @@
 #include <QModelIndex>
 #include <QList>
 #include <QTime>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#ifdef Q_OS_LINUX
+#include <QHash>
+#include <sched.h>
+#endif
 
 class QAction;
 class QStandardItem;
@@ -32,12 +40,14 @@ class AbstractJob : public QProcess
     Q_OBJECT
 public:
     explicit AbstractJob(const QString& name);
-    virtual ~AbstractJob() {}
+    virtual ~AbstractJob();
 
     void setStandardItem(QStandardItem* item);
     QStandardItem* standardItem();
     bool ran() const;
     bool stopped() const;
+    // Use this instead of state(), which is NotRunning for in-process jobs.
+    QProcess::ProcessState jobState() const;
     void appendToLog(const QString&);
     QString log() const;
     QString label() const { return m_label; }
@@ -47,6 +57,7 @@ public:
     QTime estimateRemaining(int percent);
     QTime time() const { return m_totalTime; }
     void setPostJobAction(PostJobAction* action);
+    void setThrottled(bool throttled);
 
 public slots:
     virtual void start();
@@ -57,6 +68,20 @@ signals:
     void finished(AbstractJob* job, bool isSuccess, QString failureTime = QString());
 
 protected:
+    /*!
+      Runs \a work on a worker thread instead of launching a child process.
+      jobState() reports the job as running until \a work returns its exit
+      code, which is then handled by onFinished() as usual. \a work may only
+      call appendToLog() and stopped() and emit progressUpdated().
+    */
+    void startInProcess(const std::function<int()>& work);
+    /*!
+      Returns whether the job was stopped. In-process work calls this
+      between units of work instead of stopped() so that it also slows
+      down while the player is playing.
+    */
+    bool isCanceled() const;
+
     QList<QAction*> m_standardActions;
     QList<QAction*> m_successActions;
     QStandardItem*  m_item;
@@ -68,16 +93,33 @@ protected slots:
 
 private slots:
     void onProgressUpdated(QStandardItem*, int percent);
+    void onInProcessFinished();
 
 private:
     bool m_ran;
-    bool m_killed;
+    std::atomic<bool> m_killed;
+    QProcess::ProcessState m_inProcessState;
+    mutable QMutex m_logMutex;
     QString m_log;
     QString m_label;
     QTime m_estimateTime;
     int m_startingPercent;
     QTime m_totalTime;
     QScopedPointer<PostJobAction> m_postJobAction;
+    QFutureWatcher<int> m_inProcessWatcher;
+    bool m_isThrottled;
+#ifdef Q_OS_LINUX
+    // The priorities of the threads of the child from before it was throttled.
+    struct TaskPriority {
+        int ioPriority;
+        bool isIdle;
+        bool isPinned;
+        cpu_set_t affinity;
+    };
+    QHash<int, TaskPriority> m_savedPriorities;
+#elif !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
+    int m_savedNice;
+#endif
 };
 
 #endif // ABSTRACTJOB_H
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANALYSISJOB_H
+#define ANALYSISJOB_H
+
+#include "abstractjob.h"
+#include "util.h"
+
+/*!
+  \class AnalysisJob
+  \brief Runs a media analysis as a job and caches its result.
+
+  \a Analysis provides the Request and Result types and static analyze(),
+  isValid(), save(), toString() and jobLabel() functions. The job has no
+  meta-object of its own, so use dynamic_cast on it.
+*/
+
+template <class Analysis>
+class AnalysisJob : public AbstractJob
+{
+public:
+    typedef typename Analysis::Request Request;
+    typedef typename Analysis::Result Result;
+
+    AnalysisJob(const QString& name, const Request& request)
+        : AbstractJob(name)
+        , m_request(request)
+        , m_result()
+    {
+        setLabel(Analysis::jobLabel(Util::baseName(name)));
+    }
+
+    Request request() const { return m_request; }
+    Result result() const { return m_result; }
+
+    void start()
+    {
+        AbstractJob::start();
+        startInProcess([this]() {
+            m_result = Analysis::analyze(m_request, [this](int percent) {
+                emit progressUpdated(m_item, percent);
+            }, [this]() {
+                return isCanceled();
+            });
+            if (stopped())
+                return 1;
+            appendToLog(Analysis::toString(m_result) + "\n");
+            if (!Analysis::isValid(m_result))
+                return 1;
+            // Without a cache path the result is only handed to the caller.
+            if (!m_request.cachePath.isEmpty() && !Analysis::save(m_request.cachePath, m_result)) {
+                appendToLog(QObject::tr("Failed to write %1\n").arg(m_request.cachePath));
+                return 1;
+            }
+            return 0;
+        });
+    }
+
+private:
+    Request m_request;
+    Result m_result;
+};
+
+#endif // ANALYSISJOB_H
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2019 Meltytech, LLC
+ * Copyright (c) 2012-2020 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -65,44 +65,9 @@ void EncodeJob::onVideoQualityTriggered()
         if (Util::warnIfNotWritable(reportPath, &MAIN, caption, true /* remove */))
             return;
 
-        // Get temp filename for the new XML.
-        QScopedPointer<QTemporaryFile> tmp(Util::writableTemporaryFile(reportPath));
-        tmp->open();
-        tmp->close();
-
-        // Generate the XML for the comparison.
-        Mlt::Tractor tractor(MLT.profile());
-        Mlt::Producer original(MLT.profile(), xmlPath().toUtf8().constData());
-        Mlt::Producer encoded(MLT.profile(), objectName().toUtf8().constData());
-        Mlt::Transition vqm(MLT.profile(), "vqm");
-        if (original.is_valid() && encoded.is_valid() && vqm.is_valid()) {
-            tractor.set_track(original, 0);
-            tractor.set_track(encoded, 1);
-            tractor.plant_transition(vqm);
-            vqm.set("render", 0);
-            MLT.saveXML(tmp->fileName(), &tractor, false /* without relative paths */, false /* do not verify */ );
-
-            // Add consumer element to XML.
-            QFile f1(tmp->fileName());
-            f1.open(QIODevice::ReadOnly);
-            QDomDocument dom(tmp->fileName());
-            dom.setContent(&f1);
-            f1.close();
-
-            QDomElement consumerNode = dom.createElement("consumer");
-            QDomNodeList profiles = dom.elementsByTagName("profile");
-            if (profiles.isEmpty())
-                dom.documentElement().insertAfter(consumerNode, dom.documentElement());
-            else
-                dom.documentElement().insertAfter(consumerNode, profiles.at(profiles.length() - 1));
-            consumerNode.setAttribute("mlt_service", "null");
-            consumerNode.setAttribute("real_time", -1);
-            consumerNode.setAttribute("terminate_on_pause", 1);
-
-            // Create job and add it to the queue.
-            JOBS.add(new VideoQualityJob(objectName(), dom.toString(2), reportPath,
-                     MLT.profile().frame_rate_num(), MLT.profile().frame_rate_den()));
-        }
+        // The job keeps its own copy of this job's XML as the reference.
+        JOBS.add(new VideoQualityJob(objectName(), xml(), reportPath,
+                 MLT.profile().frame_rate_num(), MLT.profile().frame_rate_den()));
     }
 }
 
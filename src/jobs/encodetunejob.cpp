@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "encodetunejob.h"
+#include "mainwindow.h"
+#include "mltcontroller.h"
+#include "settings.h"
+#include "util.h"
+#include "videoqualitymeter.h"
+#include <QAction>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <MltConsumer.h>
+#include <MltPlaylist.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+#include <Logger.h>
+#include <cmath>
+
+static const double kBitrateTolerance = 0.15;
+// SSIM differences below about 0.5 dB are hard to see, so the faster
+// setting wins within this margin of the best quality.
+static const double kQualityTolerance = 0.5;
+static const int kMaxSlices = 8;
+
+static bool isHardware(const QString& codec)
+{
+    return codec.contains("nvenc") || codec.endsWith("_amf") || codec.endsWith("_qsv")
+            || codec.endsWith("_vaapi") || codec.endsWith("_videotoolbox");
+}
+
+EncodeTuneJob::EncodeTuneJob(const QString& name, const QString& xml, const QMap<QString, QString>& properties,
+                             const QString& extension, int in, int out, double targetBitrate)
+    : AbstractJob(name)
+    , m_xml(xml)
+    , m_properties(properties)
+    , m_extension(extension)
+    , m_codec(properties.value("vcodec"))
+    , m_in(in)
+    , m_out(out)
+    , m_targetBitrate(targetBitrate)
+    , m_best(-1)
+{
+    // Only the settings being tuned may vary between the test encodes.
+    m_properties.remove("target");
+    m_properties.remove("pass");
+    m_properties.remove("passlogfile");
+    m_properties.remove(presetProperty(m_codec));
+    m_properties.remove("threads");
+    m_properties.remove("slices");
+    m_properties.insert("real_time", "-1");
+    m_candidates = candidates(m_codec);
+
+    QAction* action = new QAction(tr("Apply To Export"), this);
+    action->setToolTip(tr("Use the fastest settings found in Export"));
+    connect(action, SIGNAL(triggered()), this, SLOT(onApplyTriggered()));
+    m_successActions << action;
+
+    setLabel(tr("Tune %1 for %2").arg(m_codec).arg(Util::baseName(name)));
+}
+
+QList<EncodeTuneJob::Candidate> EncodeTuneJob::candidates(const QString& codec)
+{
+    QList<Candidate> result;
+    QStringList presets;
+    QList<int> slices;
+    int ideal = QThread::idealThreadCount();
+    int maxSlices = qBound(2, ideal, kMaxSlices);
+    if (codec == "libx264" || codec == "libx265") {
+        presets << "ultrafast" << "superfast" << "veryfast" << "faster" << "fast" << "medium";
+        foreach (const QString& preset, presets) {
+            // Zero lets the encoder choose, which often oversubscribes the CPU.
+            result << Candidate {preset, 0, 0};
+            if (ideal > 2)
+                result << Candidate {preset, ideal / 2, 0};
+            // libx265 does not take the slice count from FFmpeg.
+            if (codec == "libx264")
+                result << Candidate {preset, 0, maxSlices};
+        }
+    } else if (isHardware(codec)) {
+        // Hardware encoders do not use the threads, but most have presets.
+        if (codec.contains("nvenc"))
+            presets << "fast" << "medium" << "slow";
+        else if (codec.endsWith("_qsv"))
+            presets << "veryfast" << "faster" << "fast" << "medium" << "slow";
+        else if (codec.endsWith("_amf"))
+            presets << "speed" << "balanced" << "quality";
+        if (codec.endsWith("_vaapi"))
+            slices << 1 << 2 << 4;
+        foreach (const QString& preset, presets)
+            result << Candidate {preset, 0, 0};
+        foreach (int n, slices)
+            result << Candidate {QString(), 0, n};
+        if (result.isEmpty())
+            result << Candidate {QString(), 0, 0};
+    } else {
+        result << Candidate {QString(), ideal, 0};
+        // Codecs that thread by slices, such as MPEG-2, need them to scale.
+        result << Candidate {QString(), ideal, maxSlices};
+        if (ideal > 2)
+            result << Candidate {QString(), ideal / 2, 0};
+        result << Candidate {QString(), 1, 0};
+    }
+    return result;
+}
+
+QString EncodeTuneJob::presetProperty(const QString& codec)
+{
+    return codec.endsWith("_amf")? "quality" : "preset";
+}
+
+QStringList EncodeTuneJob::recommendation() const
+{
+    QStringList result;
+    if (m_best >= 0) {
+        const Candidate& best = m_results[m_best].candidate;
+        if (!best.preset.isEmpty())
+            result << QString("%1=%2").arg(presetProperty(m_codec)).arg(best.preset);
+        if (!isHardware(m_codec))
+            result << QString("threads=%1").arg(best.threads);
+        if (best.slices > 0)
+            result << QString("slices=%1").arg(best.slices);
+    }
+    return result;
+}
+
+void EncodeTuneJob::start()
+{
+    AbstractJob::start();
+    startInProcess([this]() {
+        QTemporaryDir dir;
+        if (!dir.isValid()) {
+            appendToLog(tr("Failed to create a temporary folder.\n"));
+            return 1;
+        }
+        m_results.clear();
+        m_best = -1;
+        if (m_candidates.size() < 2)
+            appendToLog(tr("%1 has no speed settings to compare, so only its speed is measured.\n").arg(m_codec));
+        QString reference = dir.filePath("reference.mlt");
+        if (!writeReference(reference))
+            return 1;
+        for (int index = 0; index < m_candidates.size(); ++index) {
+            const Candidate& candidate = m_candidates[index];
+            QString target = dir.filePath(QString("tune-%1.%2").arg(index).arg(m_extension));
+            Result result;
+            if (!encode(target, candidate, index, &result) || !score(reference, target, &result))
+                return 1;
+            QFile::remove(target);
+            m_results << result;
+            LOG_DEBUG() << m_codec << candidate.preset << "threads" << candidate.threads
+                        << "slices" << candidate.slices << "fps" << result.fps
+                        << "bytes" << result.bytes << "ssim" << result.ssim;
+        }
+        chooseBest();
+
+        appendToLog(QString("%1 %2 %3 %4 %5 %6 %7\n").arg(tr("Preset"), -10).arg(tr("Threads"), 8)
+                    .arg(tr("Slices"), 7).arg(tr("Frames/sec"), 11).arg(tr("Size (KiB)"), 11)
+                    .arg(tr("Bitrate (kb/s)"), 15).arg(tr("SSIM (dB)"), 10));
+        for (int i = 0; i < m_results.size(); ++i) {
+            const Result& r = m_results[i];
+            appendToLog(QString("%1 %2 %3 %4 %5 %6 %7%8\n")
+                        .arg(r.candidate.preset.isEmpty()? QString("-") : r.candidate.preset, -10)
+                        .arg(r.candidate.threads, 8).arg(r.candidate.slices, 7).arg(r.fps, 11, 'f', 2)
+                        .arg(r.bytes / 1024, 11).arg(r.bitrate / 1000.0, 15, 'f', 0)
+                        .arg(r.ssim, 10, 'f', 2)
+                        .arg(i == m_best? QString(" *") : QString()));
+        }
+        if (m_best < 0) {
+            appendToLog(tr("No settings produced a usable result.\n"));
+            return 1;
+        }
+        return 0;
+    });
+}
+
+// Saves the segment being encoded so that each result can be compared to it.
+bool EncodeTuneJob::writeReference(const QString& path)
+{
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    Mlt::Producer producer(profile, "xml-string", m_xml.toUtf8().constData());
+    if (!producer.is_valid()) {
+        appendToLog(tr("Failed to load the media to encode.\n"));
+        return false;
+    }
+    Mlt::Playlist playlist(profile);
+    playlist.append(producer, m_in, m_out);
+    Mlt::Consumer consumer(profile, "xml", path.toUtf8().constData());
+    consumer.set("no_meta", 1);
+    consumer.connect(playlist);
+    consumer.start();
+    if (!QFile::exists(path)) {
+        appendToLog(tr("Failed to write %1\n").arg(path));
+        return false;
+    }
+    return true;
+}
+
+bool EncodeTuneJob::encode(const QString& target, const Candidate& candidate, int index, Result* result)
+{
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    Mlt::Producer producer(profile, "xml-string", m_xml.toUtf8().constData());
+    if (!producer.is_valid()) {
+        appendToLog(tr("Failed to load the media to encode.\n"));
+        return false;
+    }
+    producer.set_in_and_out(m_in, m_out);
+    Mlt::Consumer consumer(profile, "avformat", target.toUtf8().constData());
+    if (!consumer.is_valid()) {
+        appendToLog(tr("Failed to create the encoder.\n"));
+        return false;
+    }
+    QMapIterator<QString, QString> i(m_properties);
+    while (i.hasNext()) {
+        i.next();
+        consumer.set(i.key().toUtf8().constData(), i.value().toUtf8().constData());
+    }
+    if (!candidate.preset.isEmpty())
+        consumer.set(presetProperty(m_codec).toLatin1().constData(), candidate.preset.toLatin1().constData());
+    consumer.set("threads", candidate.threads);
+    if (candidate.slices > 0)
+        consumer.set("slices", candidate.slices);
+    consumer.set("terminate_on_pause", 1);
+    consumer.connect(producer);
+
+    int frames = m_out - m_in + 1;
+    int total = m_candidates.size() * frames;
+    QElapsedTimer timer;
+    timer.start();
+    producer.seek(0);
+    consumer.start();
+    while (!consumer.is_stopped()) {
+        if (stopped()) {
+            consumer.stop();
+            return false;
+        }
+        emit progressUpdated(m_item, 100 * (index * frames + producer.position()) / total);
+        QThread::msleep(100);
+    }
+    qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+    consumer.stop();
+
+    result->candidate = candidate;
+    result->fps = frames * 1000.0 / elapsed;
+    result->bytes = QFileInfo(target).size();
+    result->bitrate = result->bytes * 8.0 * profile.fps() / frames;
+    result->ssim = 0.0;
+    if (result->bytes <= 0) {
+        appendToLog(tr("Encoding with preset %1, %2 threads and %3 slices failed.\n")
+                    .arg(candidate.preset).arg(candidate.threads).arg(candidate.slices));
+        return false;
+    }
+    return true;
+}
+
+bool EncodeTuneJob::score(const QString& reference, const QString& target, Result* result)
+{
+    VideoQualityMeter meter(reference, target);
+    if (!meter.measure([](int) {}, [this]() { return isCanceled(); })) {
+        if (!meter.errorString().isEmpty())
+            appendToLog(meter.errorString() + "\n");
+        return false;
+    }
+    if (meter.results().isEmpty())
+        return false;
+    double sum = 0.0;
+    foreach (const VideoQualityMeter::FrameResult& frame, meter.results())
+        sum += frame.ssim[VideoQualityMeter::PlaneY];
+    double ssim = qMin(sum / meter.results().size(), 0.9999999999);
+    result->ssim = -10.0 * std::log10(1.0 - ssim);
+    return true;
+}
+
+void EncodeTuneJob::chooseBest()
+{
+    // Faster presets lose quality at the same rate control setting, so only
+    // those close to the best measured quality compete on speed.
+    QList<int> eligible;
+    double bestSsim = -HUGE_VAL;
+    for (int i = 0; i < m_results.size(); ++i) {
+        const Result& r = m_results[i];
+        if (m_targetBitrate > 0.0 && std::fabs(r.bitrate - m_targetBitrate) > kBitrateTolerance * m_targetBitrate)
+            continue;
+        eligible << i;
+        bestSsim = qMax(bestSsim, r.ssim);
+    }
+    foreach (int i, eligible) {
+        const Result& r = m_results[i];
+        if (r.ssim >= bestSsim - kQualityTolerance && (m_best < 0 || r.fps > m_results[m_best].fps))
+            m_best = i;
+    }
+    // A short segment may not reach the target bit rate; use the closest.
+    if (m_best < 0 && m_targetBitrate > 0.0) {
+        for (int i = 0; i < m_results.size(); ++i) {
+            if (m_best < 0 || std::fabs(m_results[i].bitrate - m_targetBitrate)
+                    < std::fabs(m_results[m_best].bitrate - m_targetBitrate))
+                m_best = i;
+        }
+    }
+}
+
+void EncodeTuneJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    AbstractJob::onFinished(exitCode, exitStatus);
+    if (exitStatus == QProcess::NormalExit && exitCode == 0 && !stopped() && m_best >= 0) {
+        Settings.setEncodeTuning(m_codec, recommendation());
+        MAIN.showStatusMessage(tr("Fastest settings for %1: %2 (%3 frames/sec)")
+                               .arg(m_codec).arg(recommendation().join(" "))
+                               .arg(m_results[m_best].fps, 0, 'f', 1));
+    }
+}
+
+void EncodeTuneJob::onApplyTriggered()
+{
+    emit tuned(m_codec, recommendation());
+}
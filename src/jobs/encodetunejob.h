@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ENCODETUNEJOB_H
+#define ENCODETUNEJOB_H
+
+#include "abstractjob.h"
+#include <QList>
+#include <QMap>
+#include <QStringList>
+
+/*!
+  \class EncodeTuneJob
+  \brief Finds the fastest encoder settings for this machine.
+
+  A short segment of the export source is encoded once for every candidate
+  preset, thread count and slice count with the export settings otherwise
+  unchanged, and each result is scored against the source with the video
+  quality meter. Among the candidates that meet the target bit rate, those
+  within a small SSIM margin of the best quality are ranked by speed and
+  the fastest one is saved for the codec.
+*/
+
+class EncodeTuneJob : public AbstractJob
+{
+    Q_OBJECT
+public:
+    struct Candidate {
+        QString preset; // empty to keep the codec default
+        int threads;    // 0 lets the codec choose
+        int slices;     // 0 keeps the codec default
+    };
+
+    struct Result {
+        Candidate candidate;
+        double fps;
+        qint64 bytes;
+        double bitrate; // bits per second
+        double ssim;    // mean luma SSIM in dB
+    };
+
+    //! Returns the settings worth measuring for \a codec; one means nothing to tune.
+    static QList<Candidate> candidates(const QString& codec);
+    //! Returns the consumer property that selects the speed preset.
+    static QString presetProperty(const QString& codec);
+
+    /*!
+      Encodes frames \a in through \a out of the producer in \a xml using the
+      consumer \a properties. A \a targetBitrate of zero selects quality mode.
+    */
+    EncodeTuneJob(const QString& name, const QString& xml, const QMap<QString, QString>& properties,
+                  const QString& extension, int in, int out, double targetBitrate);
+    QString codec() const { return m_codec; }
+    QStringList recommendation() const;
+
+public slots:
+    void start();
+
+signals:
+    void tuned(const QString& codec, const QStringList& settings);
+
+protected slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private slots:
+    void onApplyTriggered();
+
+private:
+    bool writeReference(const QString& path);
+    bool encode(const QString& target, const Candidate& candidate, int index, Result* result);
+    bool score(const QString& reference, const QString& target, Result* result);
+    void chooseBest();
+
+    QString m_xml;
+    QMap<QString, QString> m_properties;
+    QString m_extension;
+    QString m_codec;
+    int m_in;
+    int m_out;
+    double m_targetBitrate;
+    QList<Candidate> m_candidates;
+    QList<Result> m_results;
+    int m_best;
+};
+
+#endif // ENCODETUNEJOB_H
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frameexportjob.h"
+#include "mltcontroller.h"
+#include "seekindex.h"
+#include "util.h"
+#include <QAction>
+#include <QFileInfo>
+#include <QImage>
+#include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtMath>
+#include <MltProfile.h>
+#include <MltProducer.h>
+#include <MltFrame.h>
+#include <Logger.h>
+#include <algorithm>
+
+static const int kMaxWorkers = 4;
+
+FrameExportJob::FrameExportJob(const QString& name, const QString& xml, const QList<int>& positions, const QString& path)
+    : AbstractJob(name)
+    , m_xml(xml)
+    , m_positions(positions)
+    , m_path(path)
+{
+    std::sort(m_positions.begin(), m_positions.end());
+    m_positions.erase(std::unique(m_positions.begin(), m_positions.end()), m_positions.end());
+
+    QAction* action = new QAction(tr("Show In Folder"), this);
+    connect(action, SIGNAL(triggered()), this, SLOT(onShowFolderTriggered()));
+    m_successActions << action;
+
+    setLabel(tr("Export %1 frames of %2").arg(m_positions.size()).arg(Util::baseName(name)));
+}
+
+QString FrameExportJob::fileName(int position) const
+{
+    // Pad the frame numbers so that the files sort in position order.
+    QFileInfo fi(m_path);
+    int width = m_positions.isEmpty()? 1 : QString::number(m_positions.last()).size();
+    return QString("%1/%2-%3.%4").arg(fi.path()).arg(fi.completeBaseName())
+            .arg(position, width, 10, QChar('0')).arg(fi.suffix());
+}
+
+void FrameExportJob::start()
+{
+    AbstractJob::start();
+    startInProcess([this]() {
+        int count = m_positions.size();
+        if (count == 0)
+            return 1;
+        int chunks = qMin(count, qBound(1, QThread::idealThreadCount(), kMaxWorkers));
+        LOG_DEBUG() << "exporting" << count << "frames in" << chunks << "chunks";
+        QThreadPool pool;
+        pool.setMaxThreadCount(chunks);
+        QList<QFuture<QString>> futures;
+        QAtomicInt done(0);
+        for (int i = 0; i < chunks; ++i) {
+            int begin = qint64(count) * i / chunks;
+            int end = qint64(count) * (i + 1) / chunks;
+            futures << QtConcurrent::run(&pool, [=, &done]() {
+                return exportFrames(begin, end, &done);
+            });
+        }
+        while (!pool.waitForDone(500))
+            emit progressUpdated(m_item, 100 * done.load() / count);
+
+        // Log the errors here because the workers must not share the log.
+        bool ok = true;
+        foreach (QFuture<QString> future, futures) {
+            if (!future.result().isEmpty()) {
+                appendToLog(future.result());
+                ok = false;
+            }
+        }
+        return (!ok || stopped())? 1 : 0;
+    });
+}
+
+QString FrameExportJob::exportFrames(int begin, int end, QAtomicInt* done)
+{
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    Mlt::Producer producer(profile, "xml-string", m_xml.toUtf8().constData());
+    if (!producer.is_valid())
+        return tr("Failed to load the media to export.\n");
+    // The positions are source frames like those of the player.
+    producer.set("ignore_points", 1);
+    // Frames of a run that share a group of pictures decode forward.
+    SeekIndex::attach(producer);
+    int width = profile.width();
+    int height = profile.height();
+    double dar = profile.dar();
+
+    for (int i = begin; i < end && !isCanceled(); ++i) {
+        int position = m_positions[i];
+        producer.seek(position);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        if (!frame || !frame->is_valid())
+            return tr("Failed to render frame %1\n").arg(position);
+        frame->set("rescale.interp", "bicubic");
+        frame->set("consumer_deinterlace", 1);
+        mlt_image_format format = mlt_image_rgb24;
+        int w = width;
+        int h = height;
+        const uchar* data = frame->get_image(format, w, h);
+        if (!data || w <= 0 || h <= 0)
+            return tr("Failed to render frame %1\n").arg(position);
+        QImage image(data, w, h, 3 * w, QImage::Format_RGB888);
+        // Convert to square pixels if needed.
+        qreal aspectRatio = (qreal) w / h;
+        if (qFloor(aspectRatio * 1000) != qFloor(dar * 1000)) {
+            image = image.scaled(qRound(h * dar), h, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        QString fileName = this->fileName(position);
+        if (!image.save(fileName, Q_NULLPTR, (QFileInfo(fileName).suffix() == "webp")? 80 : -1))
+            return tr("Failed to write %1\n").arg(fileName);
+        done->ref();
+    }
+    return QString();
+}
+
+void FrameExportJob::onShowFolderTriggered()
+{
+    Util::showInFolder(m_positions.isEmpty()? m_path : fileName(m_positions.first()));
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FRAMEEXPORTJOB_H
+#define FRAMEEXPORTJOB_H
+
+#include "abstractjob.h"
+#include <QAtomicInt>
+#include <QList>
+
+/*!
+  \class FrameExportJob
+  \brief Saves full resolution images of a list of frames.
+
+  The frames are rendered from a private copy of the producer instead of
+  the player, so the player's preview scale and position are untouched.
+  The sorted positions are split into contiguous runs and each run is
+  rendered in position order by its own producer on a separate thread.
+*/
+
+class FrameExportJob : public AbstractJob
+{
+    Q_OBJECT
+public:
+    /*!
+      Exports the frames at \a positions of the producer in \a xml to files
+      named after \a path with the frame number appended to the base name.
+    */
+    FrameExportJob(const QString& name, const QString& xml, const QList<int>& positions, const QString& path);
+    QString fileName(int position) const;
+
+public slots:
+    void start();
+
+private slots:
+    void onShowFolderTriggered();
+
+private:
+    QString exportFrames(int begin, int end, QAtomicInt* done);
+
+    QString m_xml;
+    QList<int> m_positions;
+    QString m_path;
+};
+
+#endif // FRAMEEXPORTJOB_H
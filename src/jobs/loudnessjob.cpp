@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "loudnessjob.h"
+#include "mainwindow.h"
+#include "docks/timelinedock.h"
+#include "util.h"
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QScopedArrayPointer>
+#include <Logger.h>
+
+LoudnessJob::LoudnessJob(const QString& name, const QList<LoudnessAnalysis::Request>& requests)
+    : AbstractJob(name)
+    , m_requests(requests)
+{
+    setLabel(tr("Measure loudness %1").arg(Util::baseName(name)));
+}
+
+void LoudnessJob::start()
+{
+    AbstractJob::start();
+    startInProcess([this]() {
+        // Analyze the sources in parallel, one per thread.
+        int n = m_requests.size();
+        QScopedArrayPointer<QAtomicInt> percents(new QAtomicInt[n]);
+        QThreadPool pool;
+        pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), n));
+        QList<QFuture<bool>> futures;
+        for (int i = 0; i < n; ++i) {
+            LoudnessAnalysis::Request request = m_requests[i];
+            QAtomicInt* percent = &percents[i];
+            futures << QtConcurrent::run(&pool, [this, request, percent]() {
+                return LoudnessAnalysis::analyze(request, [percent](int value) {
+                    percent->store(value);
+                }, [this]() {
+                    return isCanceled();
+                });
+            });
+        }
+        while (!pool.waitForDone(500)) {
+            int total = 0;
+            for (int i = 0; i < n; ++i)
+                total += percents[i].load();
+            emit progressUpdated(m_item, total / qMax(1, n));
+        }
+        int failures = 0;
+        for (int i = 0; i < n; ++i) {
+            if (!futures[i].result()) {
+                if (m_requests[i].service == "xml-string")
+                    appendToLog(tr("Failed to analyze %1\n").arg(QFileInfo(m_requests[i].cachePath).fileName()));
+                else
+                    appendToLog(tr("Failed to analyze %1\n").arg(m_requests[i].resource));
+                ++failures;
+            }
+        }
+        return (failures || stopped())? 1 : 0;
+    });
+}
+
+void LoudnessJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    AbstractJob::onFinished(exitCode, exitStatus);
+    if (exitStatus == QProcess::NormalExit && exitCode == 0 && !stopped())
+        MAIN.timelineDock()->measureLoudness();
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LOUDNESSJOB_H
+#define LOUDNESSJOB_H
+
+#include "abstractjob.h"
+#include "loudnessanalysis.h"
+
+class LoudnessJob : public AbstractJob
+{
+    Q_OBJECT
+public:
+    LoudnessJob(const QString& name, const QList<LoudnessAnalysis::Request>& requests);
+
+public slots:
+    void start();
+
+protected slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    QList<LoudnessAnalysis::Request> m_requests;
+};
+
+#endif // LOUDNESSJOB_H
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "packagejob.h"
+#include "projectpackager.h"
+#include "util.h"
+#include <QAction>
+#include <QDir>
+#include <QFileInfo>
+#include <Logger.h>
+
+PackageJob::PackageJob(const QString& name, const QString& xml, const QString& folder, bool trim)
+    : AbstractJob(name)
+    , m_xml(xml)
+    , m_folder(folder)
+    , m_isTrimEnabled(trim)
+{
+    QAction* action = new QAction(tr("Show In Folder"), this);
+    connect(action, SIGNAL(triggered()), this, SLOT(onShowFolderTriggered()));
+    m_successActions << action;
+
+    setLabel(tr("Collect %1").arg(Util::baseName(name)));
+}
+
+QString PackageJob::projectPath() const
+{
+    return QDir(m_folder).filePath(QFileInfo(objectName()).completeBaseName() + ".mlt");
+}
+
+void PackageJob::start()
+{
+    AbstractJob::start();
+    startInProcess([this]() {
+        ProjectPackager packager(m_xml, m_folder, QFileInfo(objectName()).completeBaseName(), m_isTrimEnabled);
+        auto canceled = [this]() {
+            return isCanceled();
+        };
+        bool ok = packager.analyze(canceled) && packager.collect([this](int percent) {
+            emit progressUpdated(m_item, percent);
+        }, canceled) && packager.writeProject();
+        if (!ok) {
+            if (!packager.errorString().isEmpty())
+                appendToLog(packager.errorString() + "\n");
+            return 1;
+        }
+        appendToLog(packager.report());
+        LOG_INFO() << "collected the project to" << packager.projectPath();
+        return 0;
+    });
+}
+
+void PackageJob::onShowFolderTriggered()
+{
+    Util::showInFolder(projectPath());
+}
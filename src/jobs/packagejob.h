@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PACKAGEJOB_H
+#define PACKAGEJOB_H
+
+#include "abstractjob.h"
+
+class PackageJob : public AbstractJob
+{
+    Q_OBJECT
+public:
+    PackageJob(const QString& name, const QString& xml, const QString& folder, bool trim);
+    QString projectPath() const;
+
+public slots:
+    void start();
+
+private slots:
+    void onShowFolderTriggered();
+
+private:
+    QString m_xml;
+    QString m_folder;
+    bool m_isTrimEnabled;
+};
+
+#endif // PACKAGEJOB_H
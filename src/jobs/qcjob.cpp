@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qcjob.h"
+#include "mainwindow.h"
+#include "docks/timelinedock.h"
+#include "dialogs/textviewerdialog.h"
+#include "settings.h"
+#include "util.h"
+#include <QAction>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <Logger.h>
+
+QcJob::QcJob(const QString& name, const QString& xml, bool isTimeline,
+             int frameRateNum, int frameRateDen)
+    : AbstractJob(name)
+    , m_xml(xml)
+    , m_isTimeline(isTimeline)
+    , m_frameRateNum(frameRateNum)
+    , m_frameRateDen(frameRateDen)
+    , m_isTimelineModified(false)
+{
+    m_limits.truePeak = Settings.qcMaxTruePeak();
+    m_limits.shortTerm = Settings.qcMaxShortTermLoudness();
+    m_limits.programLoudness = Settings.qcProgramLoudness();
+    m_limits.programTolerance = Settings.qcProgramTolerance();
+
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd("qc")) {
+        dir.mkdir("qc");
+        dir.cd("qc");
+    }
+    m_statsPath = dir.filePath(QString("%1-%2.qc").arg(QFileInfo(name).completeBaseName())
+                               .arg(QDateTime::currentDateTime().toString("yyyyMMddHHmmss")));
+
+    QAction* action;
+    if (m_isTimeline) {
+        action = new QAction(tr("Show On Timeline"), this);
+        action->setToolTip(tr("Mark the frames outside broadcast limits on the timeline"));
+        connect(action, SIGNAL(triggered()), this, SLOT(onShowOnTimelineTriggered()));
+        m_successActions << action;
+        connect(MAIN.timelineDock()->model(), SIGNAL(modified()), this, SLOT(onTimelineModified()));
+        connect(MAIN.timelineDock()->model(), SIGNAL(closed()), this, SLOT(onTimelineModified()));
+    }
+    action = new QAction(tr("View Report"), this);
+    connect(action, SIGNAL(triggered()), this, SLOT(onViewReportTriggered()));
+    m_successActions << action;
+
+    action = new QAction(tr("Show In Folder"), this);
+    connect(action, SIGNAL(triggered()), this, SLOT(onShowFolderTriggered()));
+    m_successActions << action;
+
+    setLabel(tr("Broadcast QC %1").arg(Util::baseName(name)));
+}
+
+QString QcJob::reportPath() const
+{
+    QFileInfo fi(m_statsPath);
+    return fi.path() + "/" + fi.completeBaseName() + ".txt";
+}
+
+void QcJob::start()
+{
+    AbstractJob::start();
+    startInProcess([this]() {
+        BroadcastQc qc(m_xml, m_limits);
+        bool ok = qc.analyze([this](int percent) {
+            emit progressUpdated(m_item, percent);
+        }, [this]() {
+            return isCanceled();
+        });
+        if (!ok) {
+            if (!qc.errorString().isEmpty())
+                appendToLog(qc.errorString() + "\n");
+            return 1;
+        }
+        double fps = m_frameRateDen > 0? double(m_frameRateNum) / m_frameRateDen : MLT.profile().fps();
+        if (!qc.writeStats(m_statsPath, m_frameRateNum, m_frameRateDen)
+                || !qc.writeReport(reportPath(), fps)) {
+            appendToLog(tr("Failed to write %1\n").arg(m_statsPath));
+            return 1;
+        }
+        LOG_INFO() << "analyzed" << qc.frames().size() << "frames to" << m_statsPath;
+        return 0;
+    });
+}
+
+void QcJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    AbstractJob::onFinished(exitCode, exitStatus);
+    if (m_isTimeline && exitStatus == QProcess::NormalExit && exitCode == 0 && !stopped())
+        onShowOnTimelineTriggered();
+}
+
+void QcJob::onShowOnTimelineTriggered()
+{
+    // The frames no longer match after an edit.
+    if (m_isTimelineModified) {
+        MAIN.showStatusMessage(tr("The timeline changed since it was checked. Run Broadcast QC again."));
+        return;
+    }
+    QVector<BroadcastQc::FrameStats> frames = BroadcastQc::readStats(m_statsPath);
+    MAIN.timelineDock()->setQcRegions(BroadcastQc::regionsForJS(BroadcastQc::regions(frames, m_limits)));
+}
+
+void QcJob::onTimelineModified()
+{
+    m_isTimelineModified = true;
+}
+
+void QcJob::onViewReportTriggered()
+{
+    TextViewerDialog dialog(&MAIN);
+    dialog.setWindowTitle(tr("Broadcast QC Report"));
+    QFile f(reportPath());
+    f.open(QIODevice::ReadOnly);
+    QString s(f.readAll());
+    f.close();
+    dialog.setText(s);
+    dialog.exec();
+}
+
+void QcJob::onShowFolderTriggered()
+{
+    Util::showInFolder(m_statsPath);
+}
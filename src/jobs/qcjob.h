@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QCJOB_H
+#define QCJOB_H
+
+#include "abstractjob.h"
+#include "broadcastqc.h"
+
+class QcJob : public AbstractJob
+{
+    Q_OBJECT
+public:
+    QcJob(const QString& name, const QString& xml, bool isTimeline,
+          int frameRateNum, int frameRateDen);
+    QString statsPath() const { return m_statsPath; }
+    QString reportPath() const;
+
+public slots:
+    void start();
+
+protected slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private slots:
+    void onShowOnTimelineTriggered();
+    void onViewReportTriggered();
+    void onShowFolderTriggered();
+    void onTimelineModified();
+
+private:
+    QString m_xml;
+    QString m_statsPath;
+    bool m_isTimeline;
+    int m_frameRateNum;
+    int m_frameRateDen;
+    bool m_isTimelineModified;
+    BroadcastQc::Limits m_limits;
+};
+
+#endif // QCJOB_H
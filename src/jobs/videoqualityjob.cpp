@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2017 Meltytech, LLC
+ * Copyright (c) 2012-2020 Meltytech, LLC
  * Author: Dan Dennedy <dan@dennedy.org>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -19,26 +19,22 @@
 #include "videoqualityjob.h"
 #include <QAction>
 #include <QFile>
-#include <QDomDocument>
-#include <QTextStream>
 #include <QFileInfo>
 #include <QUrl>
 #include <QDesktopServices>
 #include "mainwindow.h"
-#include "dialogs/textviewerdialog.h"
+#include "dialogs/videoqualitydialog.h"
+#include "videoqualitymeter.h"
 #include "util.h"
+#include <Logger.h>
 
-VideoQualityJob::VideoQualityJob(const QString& name, const QString& xml,
+VideoQualityJob::VideoQualityJob(const QString& name, const QString& referenceXml,
                                  const QString& reportPath, int frameRateNum, int frameRateDen)
-    : MeltJob(name, xml, frameRateNum, frameRateDen)
+    : MeltJob(name, referenceXml, frameRateNum, frameRateDen)
     , m_reportPath(reportPath)
+    , m_fps(frameRateDen > 0? double(frameRateNum) / frameRateDen : 0.0)
 {
-    QAction* action = new QAction(tr("Open"), this);
-    action->setToolTip(tr("Open original and encoded side-by-side in the Shotcut player"));
-    connect(action, SIGNAL(triggered()), this, SLOT(onOpenTiggered()));
-    m_successActions << action;
-
-    action = new QAction(tr("View Report"), this);
+    QAction* action = new QAction(tr("View Report"), this);
     connect(action, SIGNAL(triggered()), this, SLOT(onViewReportTriggered()));
     m_successActions << action;
 
@@ -47,49 +43,42 @@ VideoQualityJob::VideoQualityJob(const QString& name, const QString& xml,
     m_successActions << action;
 
     setLabel(tr("Measure %1").arg(objectName()));
-    setStandardOutputFile(reportPath);
 }
 
-void VideoQualityJob::onOpenTiggered()
+QString VideoQualityJob::csvPath() const
 {
-    // Parse the XML.
-    QFile file(xmlPath());
-    file.open(QIODevice::ReadOnly);
-    QDomDocument dom(xmlPath());
-    dom.setContent(&file);
-    file.close();
-
-    // Locate the VQM transition.
-    QDomNodeList transitions = dom.elementsByTagName("transition");
-    for (int i = 0; i < transitions.length(); i++ ) {
-        QDomElement property = transitions.at(i).firstChildElement("property");
-        while (!property.isNull()) {
-            // Change the render property to 1.
-            if (property.attribute("name") == "render") {
-                property.firstChild().setNodeValue("1");
-
-                // Save the new XML.
-                file.open(QIODevice::WriteOnly);
-                QTextStream textStream(&file);
-                dom.save(textStream, 2);
-                file.close();
+    QFileInfo fi(m_reportPath);
+    return fi.path() + "/" + fi.completeBaseName() + ".csv";
+}
 
-                MAIN.open(xmlPath().toUtf8().constData());
-                break;
-            }
-            property = property.nextSiblingElement("property");
+void VideoQualityJob::start()
+{
+    // Measure in-process instead of running the vqm transition in melt.
+    AbstractJob::start();
+    startInProcess([this]() {
+        VideoQualityMeter meter(xmlPath(), objectName());
+        bool ok = meter.measure([this](int percent) {
+            emit progressUpdated(m_item, percent);
+        }, [this]() {
+            return isCanceled();
+        });
+        if (!ok) {
+            if (!meter.errorString().isEmpty())
+                appendToLog(meter.errorString() + "\n");
+            return 1;
+        }
+        double fps = m_fps > 0.0? m_fps : MLT.profile().fps();
+        if (!meter.writeReport(m_reportPath, fps) || !meter.writeCsv(csvPath(), fps)) {
+            appendToLog(tr("Failed to write the report %1\n").arg(m_reportPath));
+            return 1;
         }
-    }
+        LOG_INFO() << "measured" << meter.results().size() << "frames to" << csvPath();
+        return 0;
+    });
 }
 
 void VideoQualityJob::onViewReportTriggered()
 {
-    TextViewerDialog dialog(&MAIN);
-    dialog.setWindowTitle(tr("Video Quality Measurement"));
-    QFile f(m_reportPath);
-    f.open(QIODevice::ReadOnly);
-    QString s(f.readAll());
-    f.close();
-    dialog.setText(s);
+    VideoQualityDialog dialog(csvPath(), m_reportPath, m_fps, &MAIN);
     dialog.exec();
 }
@@ -24,15 +24,19 @@ class VideoQualityJob : public MeltJob
 {
     Q_OBJECT
 public:
-    VideoQualityJob(const QString& name, const QString& xml,
+    VideoQualityJob(const QString& name, const QString& referenceXml,
                     const QString& reportPath, int frameRateNum, int frameRateDen);
+    QString csvPath() const;
+
+public slots:
+    void start();
 
 private slots:
-    void onOpenTiggered();
     void onViewReportTriggered();
 
 private:
     QString m_reportPath;
+    double m_fps;
 };
 
 #endif // VIDEOQUALITYJOB_H
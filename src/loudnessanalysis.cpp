@@ -0,0 +1,536 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "loudnessanalysis.h"
+#include "analysiscache.h"
+#include "mltcontroller.h"
+#include "mainwindow.h"
+#include "controllers/filtercontroller.h"
+#include "qmltypes/qmlmetadata.h"
+#include "shotcut_mlt_properties.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+#include <MltProfile.h>
+#include <MltProducer.h>
+#include <MltPlaylist.h>
+#include <MltTractor.h>
+#include <MltFilter.h>
+#include <MltFrame.h>
+#include <Logger.h>
+#include <cmath>
+
+static const AnalysisCache kCache("loudness", ".loud", 0x4C4F5544 /* "LOUD" */, 1);
+static const double kMinLoudness = -70.0;
+static const double kMaxLoudness = 5.0;
+static const double kBinWidth = 0.1;
+static const int kMomentarySegments = 4;  // 400 ms
+static const int kShortTermSegments = 30; // 3 s
+static const int kMinChunkSegments = 6000;
+
+static QHash<QString, LoudnessAnalysis::Source> sourceCache;
+static QMutex sourceCacheMutex;
+
+namespace {
+
+// Biquad in transposed direct form II.
+struct Biquad
+{
+    double b0, b1, b2, a1, a2;
+    double z1, z2;
+
+    double process(double x)
+    {
+        double y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+};
+
+// The two stages of the BS.1770 K-weighting filter for any sample rate.
+void kWeighting(double rate, Biquad& shelf, Biquad& highpass)
+{
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / rate);
+    double vh = std::pow(10.0, gain / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    shelf = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+             2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0, 0.0, 0.0};
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    highpass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0, 0.0, 0.0};
+}
+
+// 4x oversampling peak detector with a windowed sinc interpolator.
+class TruePeak
+{
+public:
+    enum { Phases = 4, Taps = 12 };
+
+    TruePeak()
+        : m_index(0)
+    {
+        for (int i = 0; i < Taps; ++i)
+            m_history[i] = 0.0f;
+        for (int phase = 0; phase < Phases; ++phase) {
+            for (int tap = 0; tap < Taps; ++tap) {
+                double x = tap - Taps / 2 + 1 - double(phase) / Phases;
+                double sinc = x == 0.0? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+                double window = 0.5 + 0.5 * std::cos(M_PI * x / (Taps / 2));
+                m_coefficients[phase][tap] = float(sinc * window);
+            }
+        }
+    }
+
+    float process(float sample)
+    {
+        m_history[m_index] = sample;
+        m_index = (m_index + 1) % Taps;
+        float peak = 0.0f;
+        for (int phase = 0; phase < Phases; ++phase) {
+            float sum = 0.0f;
+            for (int tap = 0; tap < Taps; ++tap)
+                sum += m_coefficients[phase][tap] * m_history[(m_index + tap) % Taps];
+            peak = qMax(peak, std::fabs(sum));
+        }
+        return peak;
+    }
+
+private:
+    float m_coefficients[Phases][Taps];
+    float m_history[Taps];
+    int m_index;
+};
+
+double binLoudness(int bin)
+{
+    return kMinLoudness + (bin + 0.5) * kBinWidth;
+}
+
+double binPower(int bin)
+{
+    return std::pow(10.0, (binLoudness(bin) + 0.691) / 10.0);
+}
+
+struct Histograms
+{
+    LoudnessAnalysis::Histogram momentary;
+    LoudnessAnalysis::Histogram shortTerm;
+};
+
+// Counts the gating blocks that end in segments [first, last).
+Histograms countBlocks(const QVector<double>& cumulative, int first, int last)
+{
+    Histograms result;
+    for (int end = first; end < last; ++end) {
+        if (end >= kMomentarySegments)
+            result.momentary.addBlock((cumulative[end] - cumulative[end - kMomentarySegments]) / kMomentarySegments);
+        if (end >= kShortTermSegments)
+            result.shortTerm.addBlock((cumulative[end] - cumulative[end - kShortTermSegments]) / kShortTermSegments);
+    }
+    return result;
+}
+
+} // namespace
+
+LoudnessAnalysis::Histogram::Histogram()
+    : m_bins(qRound((kMaxLoudness - kMinLoudness) / kBinWidth), 0)
+{
+}
+
+void LoudnessAnalysis::Histogram::addBlock(double power)
+{
+    double value = loudness(power);
+    // The absolute gate.
+    if (value < kMinLoudness)
+        return;
+    int bin = qBound(0, int((value - kMinLoudness) / kBinWidth), m_bins.size() - 1);
+    ++m_bins[bin];
+}
+
+void LoudnessAnalysis::Histogram::merge(const Histogram& other)
+{
+    for (int i = 0; i < m_bins.size(); ++i)
+        m_bins[i] += other.m_bins[i];
+}
+
+int LoudnessAnalysis::Histogram::blockCount() const
+{
+    int count = 0;
+    foreach (quint32 n, m_bins)
+        count += n;
+    return count;
+}
+
+double LoudnessAnalysis::Histogram::integrated() const
+{
+    double sum = 0.0;
+    quint64 count = 0;
+    for (int i = 0; i < m_bins.size(); ++i) {
+        sum += m_bins[i] * binPower(i);
+        count += m_bins[i];
+    }
+    if (count == 0)
+        return -HUGE_VAL;
+    // The relative gate is 10 LU below the absolute-gated loudness.
+    double gate = loudness(sum / count) - 10.0;
+    sum = 0.0;
+    count = 0;
+    for (int i = 0; i < m_bins.size(); ++i) {
+        if (binLoudness(i) >= gate) {
+            sum += m_bins[i] * binPower(i);
+            count += m_bins[i];
+        }
+    }
+    return count? loudness(sum / count) : -HUGE_VAL;
+}
+
+double LoudnessAnalysis::Histogram::range() const
+{
+    double sum = 0.0;
+    quint64 count = 0;
+    for (int i = 0; i < m_bins.size(); ++i) {
+        sum += m_bins[i] * binPower(i);
+        count += m_bins[i];
+    }
+    if (count == 0)
+        return 0.0;
+    // EBU Tech 3342: relative gate 20 LU below, then the 10th to 95th percentile.
+    double gate = loudness(sum / count) - 20.0;
+    int first = 0;
+    while (first < m_bins.size() && binLoudness(first) < gate)
+        ++first;
+    count = 0;
+    for (int i = first; i < m_bins.size(); ++i)
+        count += m_bins[i];
+    if (count == 0)
+        return 0.0;
+    quint64 low = quint64(std::ceil(0.10 * count));
+    quint64 high = quint64(std::ceil(0.95 * count));
+    quint64 seen = 0;
+    double lowLoudness = binLoudness(first);
+    double highLoudness = lowLoudness;
+    bool foundLow = false;
+    for (int i = first; i < m_bins.size(); ++i) {
+        seen += m_bins[i];
+        if (!foundLow && seen >= low) {
+            lowLoudness = binLoudness(i);
+            foundLow = true;
+        }
+        if (seen >= high) {
+            highLoudness = binLoudness(i);
+            break;
+        }
+    }
+    return highLoudness - lowLoudness;
+}
+
+double LoudnessAnalysis::loudness(double power)
+{
+    return power > 0.0? -0.691 + 10.0 * std::log10(power) : -HUGE_VAL;
+}
+
+// Returns the settings of the enabled audio filters, which are what the
+// loudness depends on; video filters do not matter.
+QString LoudnessAnalysis::audioFilters(Mlt::Service& service)
+{
+    QString result;
+    for (int i = 0; i < service.filter_count(); ++i) {
+        QScopedPointer<Mlt::Filter> filter(service.filter(i));
+        if (!filter || !filter->is_valid() || filter->get_int("disable"))
+            continue;
+        QmlMetadata* meta = MAIN.filterController()->metadataForService(filter.data());
+        if (!meta || !meta->isAudio())
+            continue;
+        for (int j = 0; j < filter->count(); ++j) {
+            QString name = filter->get_name(j);
+            if (!name.startsWith('_'))
+                result += name + '=' + QString::fromUtf8(filter->get(j)) + '\n';
+        }
+    }
+    return result;
+}
+
+bool LoudnessAnalysis::hasAudioFilters(Mlt::Service& service)
+{
+    return !audioFilters(service).isEmpty();
+}
+
+// Analyzes the original file rather than a proxy, so the cache is keyed on
+// the file actually decoded.
+LoudnessAnalysis::Request LoudnessAnalysis::sourceRequest(Mlt::Producer& producer)
+{
+    QString resource = QString::fromUtf8(producer.get("resource"));
+    if (producer.get_int(kIsProxyProperty) && producer.get(kOriginalResourceProperty))
+        resource = QString::fromUtf8(producer.get(kOriginalResourceProperty));
+    int audioIndex = producer.get_int("audio_index");
+    Request request = {"avformat", resource, audioIndex, -1, -1, QString()};
+    request.cachePath = kCache.path(producer, audioIndex);
+    return request;
+}
+
+// Analyzes a clip through its own filters, for its in and out only.
+LoudnessAnalysis::Request LoudnessAnalysis::clipRequest(Mlt::ClipInfo& info)
+{
+    Mlt::Producer& producer = *info.producer;
+    Request request = sourceRequest(producer);
+    QString xml = MLT.XML(&producer);
+    if (producer.get_int(kIsProxyProperty) && producer.get(kOriginalResourceProperty)) {
+        QDomDocument dom;
+        dom.setContent(xml);
+        QDomNodeList properties = dom.documentElement().firstChildElement("producer").elementsByTagName("property");
+        for (int i = 0; i < properties.size(); ++i) {
+            QDomElement property = properties.at(i).toElement();
+            if (property.attribute("name") == "resource" && property.parentNode().nodeName() == "producer") {
+                property.firstChild().setNodeValue(request.resource);
+                break;
+            }
+        }
+        xml = dom.toString(0);
+    }
+    if (!request.cachePath.isEmpty()) {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(QFileInfo(request.cachePath).completeBaseName().toUtf8());
+        hash.addData(audioFilters(producer).toUtf8());
+        hash.addData(QString("%1 %2").arg(info.frame_in).arg(info.frame_out).toLatin1());
+        request.cachePath = kCache.path(QString::fromLatin1(hash.result().toHex()));
+    }
+    request.service = "xml-string";
+    request.resource = xml;
+    request.audioIndex = -1;
+    request.in = info.frame_in;
+    request.out = info.frame_out;
+    return request;
+}
+
+// Renders the range with everything applied, as an export would.
+LoudnessAnalysis::Request LoudnessAnalysis::programRequest(Mlt::Tractor& tractor, int in, int out)
+{
+    Request request = {"xml-string", QString(), -1, in, out, QString()};
+    // Saving to a file replaces proxies with their original files.
+    QDir dir(QDir::temp());
+    QString fileName = dir.filePath(QString("shotcut-loudness-%1.mlt").arg(QCoreApplication::applicationPid()));
+    QFile file(fileName);
+    if (MLT.saveXML(fileName, &tractor, false, false) && file.open(QIODevice::ReadOnly)) {
+        request.resource = QString::fromUtf8(file.readAll());
+        file.close();
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(request.resource.toUtf8());
+        hash.addData(QString("%1 %2").arg(in).arg(out).toLatin1());
+        request.cachePath = kCache.path(QString::fromLatin1(hash.result().toHex()));
+    }
+    file.remove();
+    return request;
+}
+
+bool LoudnessAnalysis::isCached(const QString& cachePath)
+{
+    {
+        QMutexLocker locker(&sourceCacheMutex);
+        if (sourceCache.contains(cachePath))
+            return true;
+    }
+    return QFile::exists(cachePath);
+}
+
+bool LoudnessAnalysis::load(const QString& path, Source& source)
+{
+    QMutexLocker locker(&sourceCacheMutex);
+    if (sourceCache.contains(path)) {
+        source = sourceCache.value(path);
+        return true;
+    }
+    bool ok = kCache.read(path, [&](QDataStream& stream) {
+        stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        stream >> source.power >> source.peak;
+        return source.power.size() == source.peak.size();
+    });
+    if (!ok)
+        return false;
+    sourceCache.insert(path, source);
+    return true;
+}
+
+bool LoudnessAnalysis::save(const QString& path, const Source& source)
+{
+    bool ok = kCache.write(path, [&](QDataStream& stream) {
+        stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        stream << source.power << source.peak;
+    });
+    if (!ok)
+        return false;
+    QMutexLocker locker(&sourceCacheMutex);
+    sourceCache.insert(path, source);
+    return true;
+}
+
+bool LoudnessAnalysis::analyze(const Request& request,
+                               const std::function<void(int)>& progress,
+                               const std::function<bool()>& isCanceled)
+{
+    Source source;
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    Mlt::Producer producer(profile, request.service.toUtf8().constData(), request.resource.toUtf8().constData());
+    if (!producer.is_valid()) {
+        // Do not cache anything so that it is tried again once fixed.
+        LOG_WARNING() << "failed to open" << request.service << (request.service == "xml-string"? QString() : request.resource);
+        return false;
+    }
+    Mlt::Filter channels(profile, "audiochannels");
+    Mlt::Filter converter(profile, "audioconvert");
+    producer.attach(channels);
+    producer.attach(converter);
+    if (request.audioIndex >= 0)
+        producer.set("audio_index", request.audioIndex);
+    producer.set("video_index", -1);
+    if (request.in >= 0 && request.out >= request.in)
+        producer.set_in_and_out(request.in, request.out);
+    int first = qMax(0, request.in);
+
+    Biquad shelf[2], highpass[2];
+    TruePeak truePeak[2];
+    double squares[2] = {0.0, 0.0};
+    float peak = 0.0f;
+    int segmentLength = 0;
+    int count = 0;
+    int n = producer.get_playtime();
+    for (int i = 0; i < n; ++i) {
+        if (isCanceled())
+            return false;
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        if (!frame || !frame->is_valid())
+            continue;
+        mlt_audio_format format = mlt_audio_f32le;
+        int frequency = 48000;
+        int channelCount = 2;
+        int samples = mlt_sample_calculator(float(profile.fps()), frequency, first + i);
+        const float* data = static_cast<const float*>(frame->get_audio(format, frequency, channelCount, samples));
+        if (segmentLength == 0) {
+            // Design the filters for the rate the producer actually returns.
+            segmentLength = qMax(1, frequency / SegmentsPerSecond);
+            for (int c = 0; c < 2; ++c)
+                kWeighting(frequency, shelf[c], highpass[c]);
+        }
+        for (int s = 0; s < samples; ++s) {
+            for (int c = 0; c < 2; ++c) {
+                float x = (data && frame->get_int("test_audio") == 0 && c < channelCount)
+                        ? data[s * channelCount + c] : 0.0f;
+                double y = highpass[c].process(shelf[c].process(x));
+                squares[c] += y * y;
+                peak = qMax(peak, truePeak[c].process(x));
+            }
+            if (++count == segmentLength) {
+                source.power << float((squares[0] + squares[1]) / segmentLength);
+                source.peak << peak;
+                squares[0] = squares[1] = 0.0;
+                peak = 0.0f;
+                count = 0;
+            }
+        }
+        if (i % 100 == 0 && n > 0)
+            progress(i * 100 / n);
+    }
+    LOG_DEBUG() << request.cachePath << "segments" << source.power.size();
+    if (request.cachePath.isEmpty())
+        return false;
+    return save(request.cachePath, source);
+}
+
+LoudnessAnalysis::Result LoudnessAnalysis::measure(const QList<Clip>& clips, int in, int out, double fps)
+{
+    Result result = {-HUGE_VAL, 0.0, -HUGE_VAL, 0.0};
+    if (out < in || fps <= 0.0)
+        return result;
+    result.seconds = (out - in + 1) / fps;
+    int segments = qMax(1, int(std::ceil(result.seconds * SegmentsPerSecond)));
+    QVector<double> power(segments, 0.0);
+    float peak = 0.0f;
+
+    // Place the segments of every clip; overlapping tracks add their power.
+    foreach (const Clip& clip, clips) {
+        Source source;
+        if (!load(clip.cachePath, source) || source.power.isEmpty())
+            continue;
+        double clipStart = (clip.start - in) / fps;
+        double clipEnd = (clip.start + clip.length - in) / fps;
+        int first = qMax(0, int(std::floor(clipStart * SegmentsPerSecond)));
+        int last = qMin(segments, int(std::ceil(clipEnd * SegmentsPerSecond)));
+        for (int k = first; k < last; ++k) {
+            double sourceTime = clip.in / fps + double(k) / SegmentsPerSecond - clipStart;
+            int s = int(sourceTime * SegmentsPerSecond);
+            if (s >= 0 && s < source.power.size()) {
+                power[k] += source.power[s];
+                peak = qMax(peak, source.peak[s]);
+            }
+        }
+    }
+    QVector<double> cumulative(segments + 1, 0.0);
+    for (int k = 0; k < segments; ++k)
+        cumulative[k + 1] = cumulative[k] + power[k];
+
+    // Count the blocks in parallel chunks and merge their histograms.
+    int chunks = qBound(1, segments / kMinChunkSegments, QThread::idealThreadCount());
+    Histograms total;
+    if (chunks > 1) {
+        QList<QFuture<Histograms>> futures;
+        for (int i = 0; i < chunks; ++i) {
+            int first = 1 + qint64(segments) * i / chunks;
+            int last = 1 + qint64(segments) * (i + 1) / chunks;
+            futures << QtConcurrent::run([&cumulative, first, last]() {
+                return countBlocks(cumulative, first, last);
+            });
+        }
+        foreach (QFuture<Histograms> future, futures) {
+            Histograms h = future.result();
+            total.momentary.merge(h.momentary);
+            total.shortTerm.merge(h.shortTerm);
+        }
+    } else {
+        total = countBlocks(cumulative, 1, segments + 1);
+    }
+    result.integrated = total.momentary.integrated();
+    result.range = total.shortTerm.range();
+    result.truePeak = peak > 0.0f? 20.0 * std::log10(peak) : -HUGE_VAL;
+    return result;
+}
+
+QString LoudnessAnalysis::toString(const Result& result)
+{
+    QString integrated = std::isfinite(result.integrated)? QString::number(result.integrated, 'f', 1) : "-inf";
+    QString peak = std::isfinite(result.truePeak)? QString::number(result.truePeak, 'f', 1) : "-inf";
+    return tr("Integrated loudness: %1 LUFS\nLoudness range: %2 LU\nTrue peak: %3 dBTP\nDuration: %4 s")
+            .arg(integrated).arg(result.range, 0, 'f', 1).arg(peak).arg(result.seconds, 0, 'f', 1);
+}
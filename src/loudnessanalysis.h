@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LOUDNESSANALYSIS_H
+#define LOUDNESSANALYSIS_H
+
+#include <QCoreApplication>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+namespace Mlt {
+    class ClipInfo;
+    class Producer;
+    class Service;
+    class Tractor;
+}
+
+/*!
+  \class LoudnessAnalysis
+  \brief Measures program loudness from per-source analysis cached on disk.
+
+  Each audio source is decoded once into 100 ms segments of K-weighted
+  power and true peak, following ITU-R BS.1770, and the result is stored
+  in the application data folder. Edits never require decoding again
+  because a timeline range is measured by placing the cached segments of
+  its clips, summing the power of overlapping tracks, and filling EBU R 128
+  gating block histograms. Histograms merge by adding bins, so the blocks
+  are counted in parallel chunks.
+
+  A clip with audio filters is analyzed through its filters over its own
+  in and out instead, keyed on the filter settings. When a track or the
+  master has audio filters, or a clip plays audio that is not from a media
+  file, the whole range is rendered and analyzed.
+*/
+
+class LoudnessAnalysis
+{
+    Q_DECLARE_TR_FUNCTIONS(LoudnessAnalysis)
+
+public:
+    enum { SegmentsPerSecond = 10 };
+
+    struct Source {
+        QVector<float> power; // K-weighted mean square summed over channels
+        QVector<float> peak;  // linear true peak
+    };
+
+    // Gating block loudness in 0.1 LU bins from -70 to +5 LUFS.
+    class Histogram
+    {
+    public:
+        Histogram();
+        void addBlock(double power);
+        void merge(const Histogram& other);
+        int blockCount() const;
+        double integrated() const;
+        double range() const;
+    private:
+        QVector<quint32> m_bins;
+    };
+
+    struct Request {
+        QString service;
+        QString resource;  // a file name or the XML for xml-string
+        int audioIndex;    // -1 to keep the producer's
+        int in;            // -1 for the whole source
+        int out;
+        QString cachePath; // empty if the source cannot be identified
+    };
+
+    struct Clip {
+        QString cachePath;
+        int start;  // timeline frame
+        int in;     // source frame
+        int length; // frames
+    };
+
+    struct Result {
+        double integrated; // LUFS
+        double range;      // LU
+        double truePeak;   // dBTP
+        double seconds;
+    };
+
+    static Request sourceRequest(Mlt::Producer& producer);
+    static Request clipRequest(Mlt::ClipInfo& info);
+    static Request programRequest(Mlt::Tractor& tractor, int in, int out);
+    static bool hasAudioFilters(Mlt::Service& service);
+    static bool isCached(const QString& cachePath);
+    static bool analyze(const Request& request,
+                        const std::function<void(int)>& progress,
+                        const std::function<bool()>& isCanceled);
+    static Result measure(const QList<Clip>& clips, int in, int out, double fps);
+    static double loudness(double power);
+    static QString toString(const Result& result);
+
+private:
+    static QString audioFilters(Mlt::Service& service);
+    static bool load(const QString& path, Source& source);
+    static bool save(const QString& path, const Source& source);
+};
+
+#endif // LOUDNESSANALYSIS_H
@@ -19,6 +19,7 @@
 #include <QtGlobal>
 #include "mainwindow.h"
 #include "settings.h"
+#include "startuptrace.h"
 #include <Logger.h>
 #include <FileAppender.h>
 #include <ConsoleAppender.h>
@@ -295,6 +296,7 @@ protected:
 
 int main(int argc, char **argv)
 {
+    StartupTrace::start();
 #if defined(Q_OS_WIN) && defined(QT_DEBUG)
     ExcHndlInit();
 #endif
@@ -72,6 +72,9 @@
 #include "widgets/timelinepropertieswidget.h"
 #include "dialogs/unlinkedfilesdialog.h"
 #include "docks/keyframesdock.h"
+#include "docks/multicamdock.h"
+#include "docks/trimdock.h"
+#include "playbackgovernor.h"
 #include "util.h"
 #include "models/keyframesmodel.h"
 #include "dialogs/listselectiondialog.h"
@@ -80,6 +83,11 @@
 #include "dialogs/longuitask.h"
 #include "dialogs/systemsyncdialog.h"
 #include "proxymanager.h"
+#include "jobs/frameexportjob.h"
+#include "jobs/packagejob.h"
+#include "rendercache.h"
+#include "seekindex.h"
+#include "startuptrace.h"
 
 #include <QtWidgets>
 #include <Logger.h>
@@ -165,10 +173,16 @@ MainWindow::MainWindow()
     connect(&m_autosaveTimer, SIGNAL(timeout()), this, SLOT(onAutosaveTimeout()));
 
     // Initialize all QML types
-    QmlUtilities::registerCommonTypes();
+    {
+        StartupTrace::Scope trace("QML types");
+        QmlUtilities::registerCommonTypes();
+    }
 
     // Create the UI.
-    ui->setupUi(this);
+    {
+        StartupTrace::Scope trace("main window");
+        ui->setupUi(this);
+    }
 #ifdef Q_OS_MAC
     // Qt 5 on OS X supports the standard Full Screen window widget.
     ui->mainToolBar->removeAction(ui->actionFullscreen);
@@ -213,11 +227,20 @@ MainWindow::MainWindow()
     connect(m_undoStack, SIGNAL(canRedoChanged(bool)), ui->actionRedo, SLOT(setEnabled(bool)));
 
     // Add the player widget.
-    m_player = new Player;
+    {
+        StartupTrace::Scope trace("player");
+        m_player = new Player;
+    }
     MLT.videoWidget()->installEventFilter(this);
     ui->centralWidget->layout()->addWidget(m_player);
     connect(this, SIGNAL(producerOpened()), m_player, SLOT(onProducerOpened()));
     connect(m_player, SIGNAL(showStatusMessage(QString)), this, SLOT(showStatusMessage(QString)));
+    PlaybackGovernor& governor = PlaybackGovernor::singleton(this);
+    connect(m_player, SIGNAL(played(double)), &governor, SLOT(onPlayed(double)));
+    connect(m_player, SIGNAL(paused()), &governor, SLOT(onPaused()));
+    connect(m_player, SIGNAL(stopped()), &governor, SLOT(onPaused()));
+    connect(MLT.videoWidget(), SIGNAL(frameDisplayed(const SharedFrame&)), &governor, SLOT(onFrameDisplayed(const SharedFrame&)));
+    connect(&governor, SIGNAL(showStatusMessage(QString)), this, SLOT(showStatusMessage(QString)));
     connect(m_player, SIGNAL(inChanged(int)), this, SLOT(onCutModified()));
     connect(m_player, SIGNAL(outChanged(int)), this, SLOT(onCutModified()));
     connect(m_player, SIGNAL(tabIndexChanged(int)), SLOT(onPlayerTabIndexChanged(int)));
@@ -237,7 +260,10 @@ MainWindow::MainWindow()
         delete ui->actionUpgrade;
 
     // Add the docks.
-    m_scopeController = new ScopeController(this, ui->menuView);
+    {
+        StartupTrace::Scope trace("scopes");
+        m_scopeController = new ScopeController(this, ui->menuView);
+    }
     QDockWidget* audioMeterDock = findChild<QDockWidget*>("AudioPeakMeterDock");
     if (audioMeterDock) {
         audioMeterDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_1));
@@ -259,7 +285,10 @@ MainWindow::MainWindow()
     connect(m_propertiesDock->toggleViewAction(), SIGNAL(triggered(bool)), this, SLOT(onPropertiesDockTriggered(bool)));
     connect(ui->actionProperties, SIGNAL(triggered()), this, SLOT(onPropertiesDockTriggered()));
 
-    m_recentDock = new RecentDock(this);
+    {
+        StartupTrace::Scope trace("Recent dock");
+        m_recentDock = new RecentDock(this);
+    }
     m_recentDock->hide();
     addDockWidget(Qt::RightDockWidgetArea, m_recentDock);
     m_recentDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_3));
@@ -270,7 +299,10 @@ MainWindow::MainWindow()
     connect(this, SIGNAL(openFailed(QString)), m_recentDock, SLOT(remove(QString)));
     connect(m_recentDock, &RecentDock::deleted, m_player->projectWidget(), &NewProjectFolder::updateRecentProjects);
 
-    m_playlistDock = new PlaylistDock(this);
+    {
+        StartupTrace::Scope trace("Playlist dock");
+        m_playlistDock = new PlaylistDock(this);
+    }
     m_playlistDock->hide();
     addDockWidget(Qt::LeftDockWidgetArea, m_playlistDock);
     m_playlistDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_4));
@@ -288,16 +320,25 @@ MainWindow::MainWindow()
     connect(m_playlistDock->model(), SIGNAL(modified()), this, SLOT(updateAutoSave()));
     connect(m_playlistDock->model(), SIGNAL(loaded()), this, SLOT(onPlaylistLoaded()));
     connect(this, SIGNAL(producerOpened()), m_playlistDock, SLOT(onProducerOpened()));
-    if (!Settings.playerGPU())
+    if (!Settings.playerGPU()) {
         connect(m_playlistDock->model(), SIGNAL(loaded()), this, SLOT(updateThumbnails()));
+        connect(m_playlistDock->model(), SIGNAL(loaded()), this, SLOT(attachHiddenFilters()));
+        connect(m_playlistDock->model(), SIGNAL(modified()), this, SLOT(attachHiddenFilters()));
+    }
     connect(m_player, &Player::inChanged, m_playlistDock, &PlaylistDock::onInChanged);
     connect(m_player, &Player::outChanged, m_playlistDock, &PlaylistDock::onOutChanged);
     connect(m_playlistDock->model(), &PlaylistModel::inChanged, this, &MainWindow::onPlaylistInChanged);
     connect(m_playlistDock->model(), &PlaylistModel::outChanged, this, &MainWindow::onPlaylistOutChanged);
 
-    m_timelineDock = new TimelineDock(this);
+    {
+        StartupTrace::Scope trace("Timeline dock");
+        m_timelineDock = new TimelineDock(this);
+    }
     m_timelineDock->hide();
     addDockWidget(Qt::BottomDockWidgetArea, m_timelineDock);
+    deferInitialization(m_timelineDock, "Timeline view", [this]() {
+        m_timelineDock->initialize();
+    });
     m_timelineDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_5));
     ui->menuView->addAction(m_timelineDock->toggleViewAction());
     connect(m_timelineDock->toggleViewAction(), SIGNAL(triggered(bool)), this, SLOT(onTimelineDockTriggered(bool)));
@@ -312,6 +353,10 @@ MainWindow::MainWindow()
     connect(m_timelineDock->model(), SIGNAL(modified()), SLOT(onMultitrackModified()));
     connect(m_timelineDock->model(), SIGNAL(modified()), SLOT(updateAutoSave()));
     connect(m_timelineDock->model(), SIGNAL(durationChanged()), SLOT(onMultitrackDurationChanged()));
+    if (!Settings.playerGPU()) {
+        connect(m_timelineDock->model(), SIGNAL(loaded()), SLOT(attachHiddenFilters()));
+        connect(m_timelineDock->model(), SIGNAL(modified()), SLOT(attachHiddenFilters()));
+    }
     connect(m_timelineDock, SIGNAL(clipOpened(Mlt::Producer*)), SLOT(openCut(Mlt::Producer*)));
     connect(m_timelineDock->model(), &MultitrackModel::seeked, this, &MainWindow::seekTimeline);
     connect(m_timelineDock->model(), SIGNAL(scaleFactorChanged()), m_player, SLOT(pause()));
@@ -324,11 +369,17 @@ MainWindow::MainWindow()
     connect(m_player, SIGNAL(previousSought()), m_timelineDock, SLOT(seekPreviousEdit()));
     connect(m_player, SIGNAL(nextSought()), m_timelineDock, SLOT(seekNextEdit()));
 
-    m_filterController = new FilterController(this);
-    m_filtersDock = new FiltersDock(m_filterController->metadataModel(), m_filterController->attachedModel(), this);
+    {
+        StartupTrace::Scope trace("Filters dock");
+        m_filterController = new FilterController(this);
+        m_filtersDock = new FiltersDock(m_filterController->metadataModel(), m_filterController->attachedModel(), this);
+    }
     m_filtersDock->setMinimumSize(400, 300);
     m_filtersDock->hide();
     addDockWidget(Qt::LeftDockWidgetArea, m_filtersDock);
+    deferInitialization(m_filtersDock, "Filters view", [this]() {
+        m_filtersDock->initialize();
+    });
     m_filtersDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_6));
     ui->menuView->addAction(m_filtersDock->toggleViewAction());
     connect(m_filtersDock, SIGNAL(currentFilterRequested(int)), m_filterController, SLOT(setCurrentFilter(int)), Qt::QueuedConnection);
@@ -360,9 +411,15 @@ MainWindow::MainWindow()
     connect(m_timelineDock->model(), SIGNAL(filterInChanged(int, Mlt::Filter*)), m_filterController, SLOT(onFilterInChanged(int, Mlt::Filter*)));
     connect(m_timelineDock->model(), SIGNAL(filterOutChanged(int, Mlt::Filter*)), m_filterController, SLOT(onFilterOutChanged(int, Mlt::Filter*)));
 
-    m_keyframesDock = new KeyframesDock(m_filtersDock->qmlProducer(), this);
+    {
+        StartupTrace::Scope trace("Keyframes dock");
+        m_keyframesDock = new KeyframesDock(m_filtersDock->qmlProducer(), this);
+    }
     m_keyframesDock->hide();
     addDockWidget(Qt::BottomDockWidgetArea, m_keyframesDock);
+    deferInitialization(m_keyframesDock, "Keyframes view", [this]() {
+        m_keyframesDock->initialize();
+    });
     m_keyframesDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_7));
     ui->menuView->addAction(m_keyframesDock->toggleViewAction());
     connect(m_keyframesDock->toggleViewAction(), SIGNAL(triggered(bool)), this, SLOT(onKeyframesDockTriggered(bool)));
@@ -389,7 +446,10 @@ MainWindow::MainWindow()
     ui->actionUndo->setDisabled(true);
     ui->actionRedo->setDisabled(true);
 
-    m_encodeDock = new EncodeDock(this);
+    {
+        StartupTrace::Scope trace("Export dock");
+        m_encodeDock = new EncodeDock(this);
+    }
     m_encodeDock->hide();
     addDockWidget(Qt::LeftDockWidgetArea, m_encodeDock);
     m_encodeDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_9));
@@ -415,8 +475,14 @@ MainWindow::MainWindow()
     connect(m_playlistDock->model(), SIGNAL(modified()), m_encodeDock, SLOT(onProducerOpened()));
     connect(m_timelineDock, SIGNAL(clipCopied()), m_encodeDock, SLOT(onProducerOpened()));
     m_encodeDock->onProfileChanged();
+    deferInitialization(m_encodeDock, "Export presets and codecs", [this]() {
+        m_encodeDock->initialize();
+    });
 
-    m_jobsDock = new JobsDock(this);
+    {
+        StartupTrace::Scope trace("Jobs dock");
+        m_jobsDock = new JobsDock(this);
+    }
     m_jobsDock->hide();
     addDockWidget(Qt::RightDockWidgetArea, m_jobsDock);
     m_jobsDock->toggleViewAction()->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_0));
@@ -425,6 +491,31 @@ MainWindow::MainWindow()
     connect(m_jobsDock->toggleViewAction(), SIGNAL(triggered(bool)), this, SLOT(onJobsDockTriggered(bool)));
     connect(ui->actionJobs, SIGNAL(triggered()), this, SLOT(onJobsDockTriggered()));
 
+    {
+        StartupTrace::Scope trace("Multicam dock");
+        m_multicamDock = new MulticamDock(this);
+    }
+    m_multicamDock->hide();
+    addDockWidget(Qt::RightDockWidgetArea, m_multicamDock);
+    ui->menuView->addAction(m_multicamDock->toggleViewAction());
+    connect(MLT.videoWidget(), SIGNAL(frameDisplayed(const SharedFrame&)), m_multicamDock, SLOT(onShowFrame(const SharedFrame&)));
+    connect(m_timelineDock->model(), SIGNAL(created()), m_multicamDock, SLOT(clear()));
+    connect(m_timelineDock->model(), SIGNAL(loaded()), m_multicamDock, SLOT(clear()));
+    connect(m_timelineDock->model(), SIGNAL(closed()), m_multicamDock, SLOT(clear()));
+    connect(m_timelineDock->model(), SIGNAL(modified()), m_multicamDock, SLOT(onTimelineModified()));
+
+    {
+        StartupTrace::Scope trace("Trim Monitor dock");
+        m_trimDock = new TrimDock(this);
+    }
+    m_trimDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, m_trimDock);
+    ui->menuView->addAction(m_trimDock->toggleViewAction());
+    connect(m_timelineDock, SIGNAL(trimPositionChanged(int, int)), m_trimDock, SLOT(setEditPoint(int, int)));
+    connect(m_timelineDock->model(), SIGNAL(created()), m_trimDock, SLOT(clear()));
+    connect(m_timelineDock->model(), SIGNAL(loaded()), m_trimDock, SLOT(clear()));
+    connect(m_timelineDock->model(), SIGNAL(closed()), m_trimDock, SLOT(clear()));
+
     tabifyDockWidget(m_propertiesDock, m_playlistDock);
     tabifyDockWidget(m_playlistDock, m_filtersDock);
     tabifyDockWidget(m_filtersDock, m_encodeDock);
@@ -447,9 +538,14 @@ MainWindow::MainWindow()
     connect(videoWidget, SIGNAL(gpuNotSupported()), this, SLOT(onGpuNotSupported()));
     connect(videoWidget->quickWindow(), SIGNAL(sceneGraphInitialized()), SLOT(onSceneGraphInitialized()), Qt::QueuedConnection);
     connect(videoWidget, SIGNAL(frameDisplayed(const SharedFrame&)), m_scopeController, SIGNAL(newFrame(const SharedFrame&)));
+    connect(m_scopeController, SIGNAL(videoScopesShownChanged(bool)), videoWidget, SLOT(setFullFrameNeeded(bool)));
     connect(m_filterController, SIGNAL(currentFilterChanged(QmlFilter*, QmlMetadata*, int)), videoWidget, SLOT(setCurrentFilter(QmlFilter*, QmlMetadata*)));
 
-    readWindowSettings();
+    {
+        // Restoring the layout shows docks, whose views load after the first paint.
+        StartupTrace::Scope trace("window layout");
+        readWindowSettings();
+    }
     setCorner(Qt::TopLeftCorner, Qt::LeftDockWidgetArea);
     setCorner(Qt::TopRightCorner, Qt::RightDockWidgetArea);
     setCorner(Qt::BottomLeftCorner, Qt::BottomDockWidgetArea);
@@ -1444,6 +1540,7 @@ void MainWindow::readPlayerSettings()
     LOG_DEBUG() << "begin";
     ui->actionRealtime->setChecked(Settings.playerRealtime());
     ui->actionProgressive->setChecked(Settings.playerProgressive());
+    ui->actionThrottleBackground->setChecked(Settings.playerThrottleBackground());
     ui->actionScrubAudio->setChecked(Settings.playerScrubAudio());
     if (ui->actionJack)
         ui->actionJack->setChecked(Settings.playerJACK());
@@ -1746,12 +1843,7 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
         } else if (isMultitrackValid()) {
             m_timelineDock->show();
             m_timelineDock->raise();
-            if (m_timelineDock->selection().isEmpty()) {
-                m_timelineDock->copyClip(-1, -1);
-            } else {
-                auto& selected = m_timelineDock->selection().first();
-                m_timelineDock->copyClip(selected.y(), selected.x());
-            }
+            m_timelineDock->copySelection();
         }
         break;
     case Qt::Key_D:
@@ -2317,6 +2409,8 @@ void MainWindow::removeCustomProfiles(const QStringList &profiles, QDir& dir, QM
 
 bool MainWindow::eventFilter(QObject* target, QEvent* event)
 {
+    if (event->type() == QEvent::Expose && target == windowHandle() && !StartupTrace::isFirstPaintDone())
+        QTimer::singleShot(0, this, SLOT(onFirstPaint()));
     if (event->type() == QEvent::DragEnter && target == MLT.videoWidget()) {
         dragEnterEvent(static_cast<QDragEnterEvent*>(event));
         return true;
@@ -2389,6 +2483,7 @@ void MainWindow::closeEvent(QCloseEvent* event)
         if (!m_htmlEditor || m_htmlEditor->close()) {
             LOG_DEBUG() << "begin";
             JOBS.cleanup();
+            SeekIndex::cancelAll();
             writeSettings();
             if (m_exitCode == EXIT_SUCCESS) {
                 MLT.stop();
@@ -2488,6 +2583,8 @@ void MainWindow::onProducerOpened(bool withReopen)
         m_player->enableTab(Player::SourceTabIndex);
         m_player->switchToTab(Player::SourceTabIndex);
         Util::getHash(*MLT.producer());
+        SeekIndex::request(*MLT.producer());
+        SeekIndex::attach(*MLT.producer());
         ui->actionPaste->setEnabled(true);
     }
     QMutexLocker locker(&m_autosaveMutex);
@@ -2745,6 +2842,7 @@ void MainWindow::onMultitrackClosed()
 {
     setAudioChannels(Settings.playerAudioChannels());
     closeProducer();
+    RenderCache::clear();
     setProfile(Settings.playerProfile());
     setCurrentFile("");
     setWindowModified(false);
@@ -2803,6 +2901,19 @@ void MainWindow::onMultitrackDurationChanged()
         m_player->onDurationChanged();
 }
 
+void MainWindow::attachHiddenFilters()
+{
+    // New clips are found by walking the clips again, which is cheap.
+    if (playlist()) {
+        RenderCache::attach(*playlist());
+        SeekIndex::attach(*playlist());
+    }
+    if (isMultitrackValid()) {
+        RenderCache::attach(*multitrack());
+        SeekIndex::attach(*multitrack());
+    }
+}
+
 void MainWindow::onCutModified()
 {
     if (!playlist() && !multitrack()) {
@@ -3209,6 +3320,11 @@ void MainWindow::on_actionRealtime_triggered(bool checked)
 
 }
 
+void MainWindow::on_actionThrottleBackground_triggered(bool checked)
+{
+    Settings.setPlayerThrottleBackground(checked);
+}
+
 void MainWindow::on_actionProgressive_triggered(bool checked)
 {
     MLT.videoWidget()->setProperty("progressive", checked);
@@ -3841,14 +3957,14 @@ void MainWindow::on_actionCopy_triggered()
     m_timelineDock->show();
     m_timelineDock->raise();
     if (!m_timelineDock->selection().isEmpty())
-        m_timelineDock->copyClip(m_timelineDock->selection().first().y(), m_timelineDock->selection().first().x());
+        m_timelineDock->copySelection();
 }
 
 void MainWindow::on_actionPaste_triggered()
 {
     m_timelineDock->show();
     m_timelineDock->raise();
-    m_timelineDock->insert(-1);
+    m_timelineDock->pasteClipboard(-1);
 }
 
 void MainWindow::onClipCopied()
@@ -3917,9 +4033,10 @@ void MainWindow::on_actionExportEDL_triggered()
 
 void MainWindow::on_actionExportFrame_triggered()
 {
-    if (Settings.playerGPU() || Settings.playerPreviewScale()) {
-        Mlt::GLWidget* glw = qobject_cast<Mlt::GLWidget*>(MLT.videoWidget());
+    Mlt::GLWidget* glw = qobject_cast<Mlt::GLWidget*>(MLT.videoWidget());
+    if (Settings.playerGPU() || Settings.playerPreviewScale() || glw->isReducedResolution()) {
         connect(glw, SIGNAL(imageReady()), SLOT(onGLWidgetImageReady()));
+        glw->setRegionSuspended(true);
         MLT.setPreviewScale(0);
         glw->requestImage();
         MLT.refreshConsumer();
@@ -3932,10 +4049,9 @@ void MainWindow::onGLWidgetImageReady()
 {
     Mlt::GLWidget* glw = qobject_cast<Mlt::GLWidget*>(MLT.videoWidget());
     QImage image = glw->image();
-    if (Settings.playerGPU() || Settings.playerPreviewScale()) {
-        disconnect(glw, SIGNAL(imageReady()), this, 0);
-        MLT.setPreviewScale(Settings.playerPreviewScale());
-    }
+    disconnect(glw, SIGNAL(imageReady()), this, 0);
+    glw->setRegionSuspended(false);
+    MLT.setPreviewScale(Settings.playerPreviewScale());
     if (!image.isNull()) {
         QString path = Settings.savePath();
         QString caption = tr("Export Frame");
@@ -3963,6 +4079,127 @@ void MainWindow::onGLWidgetImageReady()
     }
 }
 
+void MainWindow::on_actionExportFrames_triggered()
+{
+    if (!MLT.producer() || !MLT.producer()->is_valid())
+        return;
+    if (Settings.playerGPU()) {
+        showStatusMessage(tr("Export Frames is not available with GPU effects."));
+        return;
+    }
+    QString caption = tr("Export Frames");
+
+    // Offer the clip starts of the playlist or the current timeline track.
+    QList<int> markers;
+    if (MLT.isPlaylist() && playlist()) {
+        for (int i = 0; i < playlist()->count(); i++)
+            markers << playlist()->clip_start(i);
+    } else if (MLT.isMultitrack()) {
+        int trackIndex = m_timelineDock->currentTrack();
+        for (int i = 0; i < m_timelineDock->clipCount(trackIndex); i++) {
+            QScopedPointer<Mlt::ClipInfo> info(m_timelineDock->getClipInfo(trackIndex, i));
+            if (info && info->producer && !info->producer->is_blank())
+                markers << info->start;
+        }
+    }
+    QStringList choices;
+    if (!markers.isEmpty())
+        choices << tr("At the start of each clip");
+    choices << tr("At a regular interval");
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, caption, tr("Export a frame"), choices, 0, false, &ok);
+    if (!ok)
+        return;
+    QList<int> positions;
+    if (!markers.isEmpty() && choice == choices.first()) {
+        positions = markers;
+    } else {
+        double seconds = QInputDialog::getDouble(this, caption, tr("Seconds between frames"),
+                                                 10.0, 0.1, 86400.0, 1, &ok);
+        if (!ok)
+            return;
+        int step = qMax(1, qRound(seconds * MLT.profile().fps()));
+        for (int i = MLT.producer()->get_in(); i <= MLT.producer()->get_out(); i += step)
+            positions << i;
+    }
+
+    QString path = Settings.savePath();
+    QString nameFilter = tr("PNG (*.png);;BMP (*.bmp);;JPEG (*.jpg *.jpeg);;PPM (*.ppm);;TIFF (*.tif *.tiff);;WebP (*.webp);;All Files (*)");
+    QString saveFileName = QFileDialog::getSaveFileName(this, caption, path, nameFilter);
+    if (saveFileName.isEmpty())
+        return;
+    QFileInfo fi(saveFileName);
+    if (fi.suffix().isEmpty())
+        saveFileName += ".png";
+    if (Util::warnIfNotWritable(saveFileName, this, caption))
+        return;
+    Settings.setSavePath(fi.path());
+
+    // Render from the original media rather than any proxies.
+    QScopedPointer<QTemporaryFile> tmp(Util::writableTemporaryFile(saveFileName));
+    tmp->open();
+    tmp->close();
+    MLT.saveXML(tmp->fileName(), nullptr, false /* without relative paths */, false /* without verify */, false /* without proxy */);
+    QFile f(tmp->fileName());
+    f.open(QIODevice::ReadOnly);
+    QString xml = QString::fromUtf8(f.readAll());
+    f.close();
+
+    QString name = m_currentFile.isEmpty()? Util::producerTitle(*MLT.producer()) : m_currentFile;
+    JOBS.add(new FrameExportJob(name, xml, positions, saveFileName));
+}
+
+void MainWindow::on_actionCollectProject_triggered()
+{
+    if (!MLT.producer())
+        return;
+    QString caption = tr("Collect Project");
+    QString folder = QFileDialog::getExistingDirectory(this, caption, Settings.savePath());
+    if (folder.isEmpty())
+        return;
+    QString name = m_currentFile.isEmpty()? tr("Untitled") : m_currentFile;
+    QString projectPath = QDir(folder).filePath(QFileInfo(name).completeBaseName() + ".mlt");
+    if (QFileInfo(projectPath) == QFileInfo(m_currentFile)) {
+        QMessageBox::warning(this, caption, tr("Choose a folder other than the one with the project."));
+        return;
+    }
+    if (Util::warnIfNotWritable(projectPath, this, caption, true))
+        return;
+
+    QMessageBox dialog(QMessageBox::Question,
+       caption,
+       tr("Do you want to trim long videos to the parts that the project uses?\n\n"
+          "This keeps about a second of handles around each use and needs the "
+          "keyframe index that Shotcut builds when a clip is opened. Other files "
+          "are linked or copied whole."),
+       QMessageBox::No |
+       QMessageBox::Yes |
+       QMessageBox::Cancel,
+       this);
+    dialog.setWindowModality(QmlApplication::dialogModality());
+    dialog.setDefaultButton(QMessageBox::No);
+    dialog.setEscapeButton(QMessageBox::Cancel);
+    int r = dialog.exec();
+    if (r == QMessageBox::Cancel)
+        return;
+
+    // Save with absolute paths and without proxies.
+    QScopedPointer<QTemporaryFile> tmp(Util::writableTemporaryFile(m_currentFile, "shotcut-XXXXXX.mlt"));
+    tmp->open();
+    tmp->close();
+    if (!saveXML(tmp->fileName(), false /* without relative paths */)) {
+        showStatusMessage(tr("Unable to collect the project."));
+        return;
+    }
+    QFile f(tmp->fileName());
+    f.open(QIODevice::ReadOnly);
+    QString xml = QString::fromUtf8(f.readAll());
+    f.close();
+
+    JOBS.add(new PackageJob(name, xml, folder, r == QMessageBox::Yes));
+    Settings.setSavePath(folder);
+}
+
 void MainWindow::on_actionAppDataSet_triggered()
 {
     QMessageBox dialog(QMessageBox::Information,
@@ -4217,6 +4454,57 @@ void MainWindow::on_actionClearRecentOnExit_toggled(bool arg1)
         Settings.setRecent(QStringList());
 }
 
+// Runs the initialization of a dock that is not needed to show the main
+// window after the first paint: right away for docks that are showing, then
+// for the others when the dock is first shown or the application is idle,
+// whichever comes first.
+void MainWindow::deferInitialization(QDockWidget* dock, const QString& name, const std::function<void()>& initialize)
+{
+    DeferredDock deferred = {dock, name, initialize};
+    m_deferredDocks << deferred;
+    connect(dock, &QDockWidget::visibilityChanged, this, [this, dock](bool visible) {
+        // Restoring the layout shows docks before the window paints.
+        if (visible && StartupTrace::isFirstPaintDone())
+            initializeDeferred(dock);
+    });
+}
+
+void MainWindow::initializeDeferred(QDockWidget* dock)
+{
+    for (int i = 0; i < m_deferredDocks.size(); ++i) {
+        if (m_deferredDocks[i].dock == dock) {
+            DeferredDock deferred = m_deferredDocks.takeAt(i);
+            StartupTrace::Scope trace(deferred.name);
+            deferred.initialize();
+            return;
+        }
+    }
+}
+
+void MainWindow::onFirstPaint()
+{
+    // Posted from the expose event, which paints the window before this runs.
+    if (StartupTrace::firstPaint())
+        QTimer::singleShot(0, this, SLOT(initializeNextDeferred()));
+}
+
+void MainWindow::initializeNextDeferred()
+{
+    // One at a time to keep the user interface responsive in between.
+    if (!m_deferredDocks.isEmpty()) {
+        QDockWidget* dock = m_deferredDocks.first().dock;
+        for (const auto& deferred : m_deferredDocks) {
+            if (deferred.dock->isVisible()) {
+                dock = deferred.dock;
+                break;
+            }
+        }
+        initializeDeferred(dock);
+        if (!m_deferredDocks.isEmpty())
+            QTimer::singleShot(0, this, SLOT(initializeNextDeferred()));
+    }
+}
+
 void MainWindow::onSceneGraphInitialized()
 {
     if (Settings.playerGPU() && Settings.playerWarnGPU()) {
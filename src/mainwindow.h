@@ -25,6 +25,7 @@
 #include <QNetworkAccessManager>
 #include <QScopedPointer>
 #include <QSharedPointer>
+#include <functional>
 #include "mltcontroller.h"
 #include "mltxmlchecker.h"
 
@@ -48,6 +49,8 @@ class TimelineDock;
 class AutoSaveFile;
 class QNetworkReply;
 class KeyframesDock;
+class MulticamDock;
+class TrimDock;
 
 class MainWindow : public QMainWindow
 {
@@ -63,6 +66,7 @@ public:
     bool saveXML(const QString& filename, bool withRelativePaths = true);
     static void changeTheme(const QString& theme);
     PlaylistDock* playlistDock() const { return m_playlistDock; }
+    TimelineDock* timelineDock() const { return m_timelineDock; }
     FilterController* filterController() const { return m_filterController; }
     HtmlEditor* htmlEditor() const { return m_htmlEditor.data(); }
     Mlt::Playlist* playlist() const;
@@ -129,6 +133,14 @@ private:
     void setAudioChannels(int channels);
     void showSaveError();
     void setPreviewScale(int scale);
+    void deferInitialization(QDockWidget* dock, const QString& name, const std::function<void()>& initialize);
+    void initializeDeferred(QDockWidget* dock);
+
+    struct DeferredDock {
+        QDockWidget* dock;
+        QString name;
+        std::function<void()> initialize;
+    };
 
     Ui::MainWindow* ui;
     Player* m_player;
@@ -165,6 +177,9 @@ private:
     QNetworkAccessManager m_network;
     QString m_upgradeUrl;
     KeyframesDock* m_keyframesDock;
+    MulticamDock* m_multicamDock;
+    TrimDock* m_trimDock;
+    QList<DeferredDock> m_deferredDocks;
 
 #ifdef WITH_LIBLEAP
     LeapListener m_leapListener;
@@ -224,6 +239,7 @@ private slots:
     void onMultitrackClosed();
     void onMultitrackModified();
     void onMultitrackDurationChanged();
+    void attachHiddenFilters();
     void onCutModified();
     void onProducerModified();
     void onFilterModelChanged();
@@ -235,6 +251,7 @@ private slots:
     void on_actionForum_triggered();
     void on_actionEnter_Full_Screen_triggered();
     void on_actionRealtime_triggered(bool checked);
+    void on_actionThrottleBackground_triggered(bool checked);
     void on_actionProgressive_triggered(bool checked);
     void on_actionChannels1_triggered(bool checked);
     void on_actionChannels2_triggered(bool checked);
@@ -292,6 +309,8 @@ private slots:
     void on_actionExportEDL_triggered();
     void on_actionExportFrame_triggered();
     void onGLWidgetImageReady();
+    void on_actionExportFrames_triggered();
+    void on_actionCollectProject_triggered();
     void on_actionAppDataSet_triggered();
     void on_actionAppDataShow_triggered();
     void on_actionNew_triggered();
@@ -309,6 +328,8 @@ private slots:
     void onOpenOtherTriggered();
     void on_actionClearRecentOnExit_toggled(bool arg1);
     void onSceneGraphInitialized();
+    void onFirstPaint();
+    void initializeNextDeferred();
     void on_actionShowTextUnderIcons_toggled(bool b);
     void on_actionShowSmallIcons_toggled(bool b);
     void onPlaylistInChanged(int in);
@@ -1256,6 +1256,19 @@ void Controller::updatePreviewProfile()
     m_previewProfile.set_explicit(true);
 }
 
+void Controller::copyProfile(Mlt::Profile& destination)
+{
+    // Used by background analyses that must not alter the project profile.
+    destination.set_width(m_profile.width());
+    destination.set_height(m_profile.height());
+    destination.set_sample_aspect(m_profile.sample_aspect_num(), m_profile.sample_aspect_den());
+    destination.set_display_aspect(m_profile.display_aspect_num(), m_profile.display_aspect_den());
+    destination.set_frame_rate(m_profile.frame_rate_num(), m_profile.frame_rate_den());
+    destination.set_progressive(m_profile.progressive());
+    destination.set_colorspace(m_profile.colorspace());
+    destination.set_explicit(1);
+}
+
 void Controller::purgeMemoryPool()
 {
     ::mlt_pool_purge();
@@ -166,8 +166,9 @@ public:
     static void resetLocale();
     static int filterIn(Mlt::Playlist&playlist, int clipIndex);
     static int filterOut(Mlt::Playlist&playlist, int clipIndex);
-    void setPreviewScale(int scale);
+    virtual void setPreviewScale(int scale);
     void updatePreviewProfile();
+    void copyProfile(Mlt::Profile& destination);
     static void purgeMemoryPool();
     static bool fullRange(Mlt::Producer& producer);
 
@@ -16,12 +16,14 @@
  */
 
 #include "attachedfiltersmodel.h"
+#include "colorfusion.h"
 #include "mltcontroller.h"
 #include "mainwindow.h"
 #include "controllers/filtercontroller.h"
 #include "qmltypes/qmlmetadata.h"
 #include "shotcut_mlt_properties.h"
 #include "util.h"
+#include <QApplication>
 #include <QTimer>
 #include <Logger.h>
 
@@ -237,6 +239,7 @@ bool AttachedFiltersModel::moveRows(const QModelIndex & sourceParent, int source
             }
             m_mltIndexMap.insert(destinationRow, mltDstIndex);
             m_metaList.move(sourceRow, destinationRow);
+            m_filterList.move(sourceRow, destinationRow);
             endMoveRows();
             emit changed();
             return true;
@@ -259,7 +262,7 @@ void AttachedFiltersModel::add(QmlMetadata* meta)
 
     int insertIndex = -1;
     int mltIndex = -1;
-    Mlt::Filter* filter = new Mlt::Filter(MLT.profile(), meta->mlt_service().toUtf8().constData());
+    QSharedPointer<Mlt::Filter> filter(new Mlt::Filter(MLT.profile(), meta->mlt_service().toUtf8().constData()));
     if (filter->is_valid()) {
         if (!meta->objectName().isEmpty())
             filter->set(kShotcutFilterProperty, meta->objectName().toUtf8().constData());
@@ -301,12 +304,12 @@ void AttachedFiltersModel::add(QmlMetadata* meta)
         }
         m_mltIndexMap.insert(insertIndex, mltIndex);
         m_metaList.insert(insertIndex, meta);
+        m_filterList.insert(insertIndex, filter);
         endInsertRows();
         emit addedOrRemoved(m_producer.data());
         emit changed();
     }
     else LOG_WARNING() << "Failed to load filter" << meta->mlt_service();
-    delete filter;
 }
 
 void AttachedFiltersModel::remove(int row)
@@ -330,6 +333,7 @@ void AttachedFiltersModel::remove(int row)
         }
     }
     m_metaList.removeAt(row);
+    m_filterList.removeAt(row);
     endRemoveRows();
     emit addedOrRemoved(m_producer.data());
     emit changed();
@@ -352,6 +356,97 @@ bool AttachedFiltersModel::move(int fromRow, int toRow)
     return moveRows(parent, fromRow, 1, parent, toRow);
 }
 
+void AttachedFiltersModel::fuseColorFilters()
+{
+    if (!m_producer || !m_producer->is_valid())
+        return;
+    QList<ColorFusion::Run> runs = ColorFusion::findRuns(*m_producer);
+    if (runs.isEmpty()) {
+        MAIN.showStatusMessage(tr("There are no adjacent color filters to combine"));
+        return;
+    }
+
+    // The table is a project resource, so it needs a project folder.
+    if (MAIN.fileName().isEmpty()) {
+        MAIN.showStatusMessage(tr("Save the project before combining color filters"));
+        return;
+    }
+    QString folder = ColorFusion::lutFolder(MAIN.fileName());
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    if (MLT.isSeekable())
+        MLT.pause();
+    int count = 0;
+    QString error;
+    // Work from the end so that the indices of the earlier runs stay valid.
+    for (int i = runs.size() - 1; i >= 0; i--) {
+        const ColorFusion::Run& run = runs[i];
+        QScopedPointer<Mlt::Filter> fused(ColorFusion::fuse(*m_producer, run, folder, &error));
+        if (!fused)
+            continue;
+        QStringList names;
+        foreach (int index, run) {
+            QScopedPointer<Mlt::Filter> filter(m_producer->filter(index));
+            QmlMetadata* meta = MAIN.filterController()->metadataForService(filter.data());
+            names << (meta? meta->name() : QString::fromUtf8(filter->get("mlt_service")));
+        }
+        fused->set(kFusedCaptionProperty, names.join(", ").toUtf8().constData());
+        m_event->block();
+        m_producer->attach(*fused);
+        m_producer->move_filter(m_producer->filter_count() - 1, run.first());
+        for (int j = run.size() - 1; j >= 0; j--) {
+            QScopedPointer<Mlt::Filter> filter(m_producer->filter(run[j] + 1));
+            m_producer->detach(*filter);
+        }
+        m_event->unblock();
+        count++;
+    }
+    QApplication::restoreOverrideCursor();
+
+    if (count > 0) {
+        reset(m_producer.data());
+        emit addedOrRemoved(m_producer.data());
+        emit changed();
+        MAIN.showStatusMessage(tr("Combined %n group(s) of color filters", 0, count));
+    } else {
+        MAIN.showStatusMessage(error);
+    }
+}
+
+void AttachedFiltersModel::unfuseColorFilters()
+{
+    if (!m_producer || !m_producer->is_valid())
+        return;
+    if (MLT.isSeekable())
+        MLT.pause();
+    bool isChanged = false;
+    m_event->block();
+    for (int i = m_producer->filter_count() - 1; i >= 0; i--) {
+        QScopedPointer<Mlt::Filter> fused(m_producer->filter(i));
+        if (!fused || !ColorFusion::isFused(*fused))
+            continue;
+        QList<Mlt::Filter*> filters = ColorFusion::unfuse(*fused);
+        if (filters.isEmpty()) {
+            LOG_WARNING() << "Failed to restore the fused filters" << fused->get(kFusedCaptionProperty);
+            continue;
+        }
+        for (int j = 0; j < filters.size(); j++) {
+            m_producer->attach(*filters[j]);
+            m_producer->move_filter(m_producer->filter_count() - 1, i + j);
+        }
+        m_producer->detach(*fused);
+        qDeleteAll(filters);
+        isChanged = true;
+    }
+    m_event->unblock();
+
+    if (isChanged) {
+        reset(m_producer.data());
+        emit addedOrRemoved(m_producer.data());
+        emit changed();
+    }
+}
+
 void AttachedFiltersModel::reset(Mlt::Producer* producer)
 {
     beginResetModel();
@@ -365,29 +460,12 @@ void AttachedFiltersModel::reset(Mlt::Producer* producer)
         m_producer.reset();
     m_metaList.clear();
     m_mltIndexMap.clear();
+    m_filterList.clear();
 
     if (m_producer && m_producer->is_valid()) {
         Mlt::Event* event = m_producer->listen("service-changed", this, (mlt_listener)AttachedFiltersModel::producerChanged);
         m_event.reset(event);
-        int count = m_producer->filter_count();
-        for (int i = 0; i < count; i++) {
-            Mlt::Filter* filter = m_producer->filter(i);
-            if (filter && filter->is_valid() && !filter->get_int("_loader")) {
-                QmlMetadata* newMeta = MAIN.filterController()->metadataForService(filter);
-                int newIndex = m_metaList.count();
-                for (int j = newIndex - 1; j >= 0; j--) {
-                    const QmlMetadata* prevMeta = m_metaList[j];
-                    if (sortIsLess(prevMeta, newMeta)) {
-                        newIndex = j;
-                    } else {
-                        break;
-                    }
-                }
-                m_metaList.insert(newIndex, newMeta);
-                m_mltIndexMap.insert(newIndex, i);
-            }
-            delete filter;
-        }
+        collectFilters(m_filterList, m_metaList, m_mltIndexMap);
     }
 
     endResetModel();
@@ -395,7 +473,99 @@ void AttachedFiltersModel::reset(Mlt::Producer* producer)
     emit isProducerSelectedChanged();
 }
 
+void AttachedFiltersModel::refresh()
+{
+    if (!m_producer || !m_producer->is_valid())
+        return;
+
+    FilterList filters;
+    MetadataList metaList;
+    IndexMap indexMap;
+    collectFilters(filters, metaList, indexMap);
+
+    // Most changes, such as keyframe drags, only change filter properties.
+    if (isSameOrder(filters, m_filterList)) {
+        m_mltIndexMap = indexMap;
+        return;
+    }
+
+    // Remove the rows of filters that were detached if the others kept
+    // their order.
+    int j = 0;
+    for (int i = 0; i < m_filterList.count() && j < filters.count(); i++) {
+        if (m_filterList[i]->get_filter() == filters[j]->get_filter())
+            j++;
+    }
+    if (j < filters.count()) {
+        // Filters were added or reordered outside of this model.
+        reset(m_producer.data());
+        return;
+    }
+    // Point the surviving rows at their new MLT indices first so that the
+    // model stays consistent between the row removals.
+    for (int i = 0; i < m_filterList.count(); i++) {
+        int row = indexOf(filters, m_filterList[i]->get_filter());
+        m_mltIndexMap[i] = row >= 0? indexMap[row] : -1;
+    }
+    for (int i = m_filterList.count() - 1; i >= 0; i--) {
+        if (m_mltIndexMap[i] < 0) {
+            beginRemoveRows(QModelIndex(), i, i);
+            m_filterList.removeAt(i);
+            m_metaList.removeAt(i);
+            m_mltIndexMap.removeAt(i);
+            endRemoveRows();
+        }
+    }
+    emit addedOrRemoved(m_producer.data());
+}
+
+void AttachedFiltersModel::collectFilters(FilterList& filters, MetadataList& metaList, IndexMap& indexMap) const
+{
+    int count = m_producer->filter_count();
+    for (int i = 0; i < count; i++) {
+        QSharedPointer<Mlt::Filter> filter(m_producer->filter(i));
+        if (filter && filter->is_valid() && !filter->get_int("_loader")) {
+            // Reuse the metadata of filters already in the model.
+            int row = indexOf(m_filterList, filter->get_filter());
+            QmlMetadata* newMeta = row >= 0? m_metaList[row]
+                                           : MAIN.filterController()->metadataForService(filter.data());
+            int newIndex = metaList.count();
+            for (int j = newIndex - 1; j >= 0; j--) {
+                const QmlMetadata* prevMeta = metaList[j];
+                if (sortIsLess(prevMeta, newMeta)) {
+                    newIndex = j;
+                } else {
+                    break;
+                }
+            }
+            metaList.insert(newIndex, newMeta);
+            indexMap.insert(newIndex, i);
+            filters.insert(newIndex, filter);
+        }
+    }
+}
+
+int AttachedFiltersModel::indexOf(const FilterList& filters, mlt_filter filter)
+{
+    for (int i = 0; i < filters.count(); i++) {
+        if (filters[i]->get_filter() == filter)
+            return i;
+    }
+    return -1;
+}
+
+bool AttachedFiltersModel::isSameOrder(const FilterList& a, const FilterList& b)
+{
+    if (a.count() != b.count())
+        return false;
+    for (int i = 0; i < a.count(); i++) {
+        if (a[i]->get_filter() != b[i]->get_filter())
+            return false;
+    }
+    return true;
+}
+
 void AttachedFiltersModel::producerChanged(mlt_properties, AttachedFiltersModel* model)
 {
-    model->reset(model->m_producer.data());
+    model->refresh();
 }
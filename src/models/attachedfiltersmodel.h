@@ -19,6 +19,7 @@
 #define ATTACHEDFILTERSMODEL_H
 
 #include <QAbstractListModel>
+#include <QSharedPointer>
 #include <MltFilter.h>
 #include <MltProducer.h>
 #include <MltEvent.h>
@@ -66,19 +67,30 @@ public slots:
     void add(QmlMetadata* meta);
     void remove(int row);
     bool move(int fromRow, int toRow);
+    void fuseColorFilters();
+    void unfuseColorFilters();
 
 private:
+    typedef QList<QmlMetadata*> MetadataList;
+    typedef QList<int> IndexMap;
+    // Each entry holds a reference, so a detached filter cannot be freed and
+    // its address reused by a new filter while the model still compares it.
+    typedef QList<QSharedPointer<Mlt::Filter>> FilterList;
+
     static void producerChanged(mlt_properties owner, AttachedFiltersModel* model);
     void reset(Mlt::Producer *producer = 0);
+    void refresh();
+    void collectFilters(FilterList& filters, MetadataList& metaList, IndexMap& indexMap) const;
+    static int indexOf(const FilterList& filters, mlt_filter filter);
+    static bool isSameOrder(const FilterList& a, const FilterList& b);
 
     int m_dropRow;
     int m_removeRow;
     QScopedPointer<Mlt::Producer> m_producer;
     QScopedPointer<Mlt::Event> m_event;
-    typedef QList<QmlMetadata*> MetadataList;
     MetadataList m_metaList;
-    typedef QList<int> IndexMap;
     IndexMap m_mltIndexMap;
+    FilterList m_filterList;
 };
 
 #endif // ATTACHEDFILTERSMODEL_H
@@ -20,6 +20,7 @@
 #include "mltcontroller.h"
 #include "shotcut_mlt_properties.h"
 #include "settings.h"
+#include "playbackgovernor.h"
 #include <QString>
 #include <QVariantList>
 #include <QImage>
@@ -85,6 +86,18 @@ void AudioLevelsTask::start(Mlt::Producer& producer, QObject* object, const QMod
     }
 }
 
+bool AudioLevelsTask::isPending(Mlt::Producer& producer)
+{
+    QMutexLocker locker(&tasksListMutex);
+    foreach (AudioLevelsTask* t, tasksList) {
+        Mlt::Producer* p = t->m_producers.first().first;
+        if (p && p->is_valid() && !qstrcmp(p->get("resource"), producer.get("resource"))
+                && p->get_int("audio_index") == producer.get_int("audio_index"))
+            return true;
+    }
+    return false;
+}
+
 void AudioLevelsTask::closeAll()
 {
     // Tell all of the audio levels tasks to stop.
@@ -182,6 +195,7 @@ void AudioLevelsTask::run()
         // for each frame
         int n = tempProducer()->get_playtime();
         for (int i = 0; i < n && !m_isCanceled; i++) {
+            PlaybackGovernor::yieldIfThrottled();
             Mlt::Frame* frame = tempProducer()->get_frame();
             if (frame && frame->is_valid() && !frame->get_int("test_audio")) {
                 mlt_audio_format format = mlt_audio_s16;
@@ -205,6 +219,7 @@ void AudioLevelsTask::run()
                 foreach (ProducerAndIndex p, m_producers) {
                     QVariantList* levelsCopy = new QVariantList(levels);
                     p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
+                    p.first->set(kAudioLevelsCompleteProperty, 0);
                     if (-1 != m_object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
                         QMetaObject::invokeMethod(m_object, "audioLevelsReady", Q_ARG(const QModelIndex&, p.second));
                 }
@@ -266,6 +281,7 @@ void AudioLevelsTask::run()
         foreach (ProducerAndIndex p, m_producers) {
             QVariantList* levelsCopy = new QVariantList(levels);
             p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
+            p.first->set(kAudioLevelsCompleteProperty, 1);
             if (-1 != m_object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
                 QMetaObject::invokeMethod(m_object, "audioLevelsReady", Q_ARG(const QModelIndex&, p.second));
         }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2018 Meltytech, LLC
+ * Copyright (c) 2013-2020 Meltytech, LLC
  * Author: Dan Dennedy <dan@dennedy.org>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -33,6 +33,7 @@ public:
     virtual ~AudioLevelsTask();
     static void start(Mlt::Producer& producer, QObject* object, const QModelIndex& index, bool force = false);
     static void closeAll();
+    static bool isPending(Mlt::Producer& producer);
     bool operator==(AudioLevelsTask& b);
 
 protected:
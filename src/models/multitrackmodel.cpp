@@ -42,9 +42,18 @@ MultitrackModel::MultitrackModel(QObject *parent)
     , m_tractor(0)
     , m_isMakingTransition(false)
 {
-    connect(this, SIGNAL(modified()), SLOT(adjustBackgroundDuration()));
-    connect(this, SIGNAL(modified()), SLOT(adjustTrackFilters()));
+    connect(this, SIGNAL(modified()), SLOT(maintainInvariants()));
     connect(this, SIGNAL(reloadRequested()), SLOT(reload()), Qt::QueuedConnection);
+    connect(this, SIGNAL(rowsInserted(QModelIndex, int, int)), SLOT(updateClipCounts(QModelIndex)));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex, int, int)), SLOT(updateClipCounts(QModelIndex)));
+    connect(this, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)),
+            SLOT(onRowsMoved(QModelIndex, int, int, QModelIndex, int)));
+    connect(this, SIGNAL(modelReset()), SLOT(updateClipCounts()));
+    connect(this, SIGNAL(rowsInserted(QModelIndex, int, int)), SLOT(onRowsInserted(QModelIndex, int, int)));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex, int, int)), SLOT(onRowsRemoved(QModelIndex, int, int)));
+    connect(this, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)),
+            SLOT(onDataChanged(QModelIndex, QModelIndex)));
+    connect(this, SIGNAL(modelReset()), SLOT(resetInvariants()));
 }
 
 MultitrackModel::~MultitrackModel()
@@ -2298,7 +2307,12 @@ void MultitrackModel::moveClipInBlank(Mlt::Playlist& playlist, int trackIndex, i
 
 void MultitrackModel::consolidateBlanks(Mlt::Playlist &playlist, int trackIndex)
 {
-    for (int i = 1; i < playlist.count(); i++) {
+    // Only the rows changed since the last time can be adjacent blanks.
+    int first = 0;
+    int last = -1;
+    if (m_invariants.dirtyRows(trackIndex, &first, &last))
+        last = qMin(last, playlist.count() - 2);
+    for (int i = qMax(1, first); i <= last + 1 && i < playlist.count(); i++) {
         if (playlist.is_blank(i - 1) && playlist.is_blank(i)) {
             int out = playlist.clip_length(i - 1) + playlist.clip_length(i) - 1;
             playlist.resize_clip(i - 1, 0, out);
@@ -2309,6 +2323,7 @@ void MultitrackModel::consolidateBlanks(Mlt::Playlist &playlist, int trackIndex)
             beginRemoveRows(index(trackIndex), i, i);
             playlist.remove(i--);
             endRemoveRows();
+            --last;
         }
     }
     if (playlist.count() > 0) {
@@ -2324,6 +2339,7 @@ void MultitrackModel::consolidateBlanks(Mlt::Playlist &playlist, int trackIndex)
         playlist.blank(0);
         endInsertRows();
     }
+    m_invariants.setConsolidated(trackIndex);
 }
 
 void MultitrackModel::consolidateBlanksAllTracks()
@@ -2377,10 +2393,9 @@ void MultitrackModel::addBackgroundTrack()
     m_tractor->set_track(playlist, m_tractor->count());
 }
 
-void MultitrackModel::adjustBackgroundDuration()
+void MultitrackModel::adjustBackgroundDuration(int duration)
 {
     if (!m_tractor) return;
-    int duration = getDuration();
     Mlt::Producer* track = m_tractor->track(0);
     if (track) {
         Mlt::Playlist playlist(*track);
@@ -2422,10 +2437,9 @@ void MultitrackModel::adjustServiceFilterDurations(Mlt::Service& service, int du
     service.set(kFilterOutProperty, duration - 1);
 }
 
-void MultitrackModel::adjustTrackFilters()
+void MultitrackModel::adjustTrackFilters(int duration)
 {
     if (!m_tractor) return;
-    int duration = getDuration();
 
     // Adjust filters on the tractor.
     adjustServiceFilterDurations(*m_tractor, duration);
@@ -3011,12 +3025,18 @@ int MultitrackModel::getDuration()
 
 void MultitrackModel::load()
 {
+    // A new project replaces every track, so the old ones are removed and
+    // the new ones inserted. Unlike a model reset, this also tells views
+    // that they do not need to rebuild anything in between.
     if (m_tractor) {
-        beginResetModel();
+        int count = m_trackList.count();
+        if (count > 0)
+            beginRemoveRows(QModelIndex(), 0, count - 1);
         delete m_tractor;
         m_tractor = 0;
         m_trackList.clear();
-        endResetModel();
+        if (count > 0)
+            endRemoveRows();
     }
     // In some versions of MLT, the resource property is the XML filename,
     // but the Mlt::Tractor(Service&) constructor will fail unless it detects
@@ -3037,9 +3057,11 @@ void MultitrackModel::load()
     MLT.updateAvformatCaching(m_tractor->count());
     refreshTrackList();
     convertOldDoc();
+    m_invariants.reset(m_trackList.count());
     consolidateBlanksAllTracks();
-    adjustBackgroundDuration();
-    adjustTrackFilters();
+    int duration = getDuration();
+    adjustBackgroundDuration(duration);
+    adjustTrackFilters(duration);
     if (m_trackList.count() > 0) {
         beginInsertRows(QModelIndex(), 0, m_trackList.count() - 1);
         endInsertRows();
@@ -3063,6 +3085,162 @@ void MultitrackModel::reload(bool asynchronous)
     }
 }
 
+// Brings the views up to date after edits that announced their own
+// changes, which only leaves the waveforms to be shown again. It falls
+// back to reload() when the rows no longer match what the views were told.
+void MultitrackModel::refresh()
+{
+    if (!m_tractor)
+        return;
+    if (rowsMatch()) {
+        getAudioLevels(true);
+        emit filteredChanged();
+    } else {
+        reload();
+    }
+}
+
+// Returns false if the rows no longer match what the views were told, in
+// which case only a model reset brings them up to date.
+bool MultitrackModel::rowsMatch()
+{
+    if (m_clipCounts.size() != m_trackList.size())
+        return false;
+    for (int trackIndex = 0; trackIndex < m_trackList.size(); ++trackIndex) {
+        if (rowCount(index(trackIndex)) != m_clipCounts[trackIndex]) {
+            LOG_DEBUG() << "track" << trackIndex << "changed without notification";
+            return false;
+        }
+    }
+    return true;
+}
+
+void MultitrackModel::updateClipCounts(const QModelIndex& parent)
+{
+    if (parent.isValid() && parent.row() < m_clipCounts.size() && m_clipCounts.size() == m_trackList.size()) {
+        m_clipCounts[parent.row()] = rowCount(parent);
+    } else {
+        m_clipCounts.resize(m_trackList.size());
+        for (int i = 0; i < m_trackList.size(); ++i)
+            m_clipCounts[i] = rowCount(index(i));
+    }
+}
+
+void MultitrackModel::onRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row)
+{
+    updateClipCounts(parent);
+    if (destination != parent)
+        updateClipCounts(destination);
+    if (parent.isValid() && parent == destination) {
+        m_invariants.rowsRemoved(parent.row(), start, end);
+        int first = (row > end)? row - (end - start + 1) : row;
+        m_invariants.rowsInserted(parent.row(), first, first + end - start);
+    } else {
+        resetInvariants();
+    }
+}
+
+void MultitrackModel::onRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+        m_invariants.rowsInserted(parent.row(), first, last);
+    else
+        resetInvariants();
+}
+
+void MultitrackModel::onRowsRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+        m_invariants.rowsRemoved(parent.row(), first, last);
+    else
+        resetInvariants();
+}
+
+void MultitrackModel::onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    // Track rows only change track properties.
+    if (topLeft.parent().isValid())
+        m_invariants.rowsChanged(topLeft.parent().row(), topLeft.row(), bottomRight.row());
+}
+
+void MultitrackModel::resetInvariants()
+{
+    m_invariants.reset(m_trackList.count());
+}
+
+void MultitrackModel::maintainInvariants()
+{
+    if (!m_tractor) return;
+    applyInvariants();
+    if (TimelineInvariants::isVerifying() && !verifyInvariants()) {
+        // Repair with a full recompute.
+        resetInvariants();
+        applyInvariants();
+    }
+}
+
+void MultitrackModel::applyInvariants()
+{
+    foreach (int i, m_invariants.takeChangedTracks()) {
+        if (i < m_trackList.count()) {
+            QScopedPointer<Mlt::Producer> track(m_tractor->track(m_trackList.at(i).mlt_index));
+            m_invariants.setTrackLength(i, (track && track->is_valid())? track->get_length() : 0);
+        }
+    }
+    if (m_invariants.takeDurationChange()) {
+        int duration = m_invariants.duration();
+        adjustBackgroundDuration(duration);
+        adjustTrackFilters(duration);
+    }
+}
+
+// Compares the incremental state with a full recompute and logs any
+// mismatch.
+bool MultitrackModel::verifyInvariants()
+{
+    bool result = true;
+    int duration = getDuration();
+    if (duration != m_invariants.duration()) {
+        LOG_WARNING() << "timeline duration" << m_invariants.duration() << "expected" << duration;
+        result = false;
+    }
+    QScopedPointer<Mlt::Producer> background(m_tractor->track(0));
+    if (background && background->is_valid()) {
+        Mlt::Playlist playlist(*background);
+        QScopedPointer<Mlt::Producer> clip(playlist.get_clip(0));
+        if (clip && clip->is_valid() && duration > 0 && clip->parent().get_length() != duration) {
+            LOG_WARNING() << "background duration" << clip->parent().get_length() << "expected" << duration;
+            result = false;
+        }
+    }
+    if (m_tractor->get(kFilterOutProperty) && m_tractor->get_int(kFilterOutProperty) != duration - 1) {
+        LOG_WARNING() << "timeline filters end at" << m_tractor->get_int(kFilterOutProperty) << "expected" << duration - 1;
+        result = false;
+    }
+    for (int i = 0; i < m_trackList.count(); ++i) {
+        QScopedPointer<Mlt::Producer> track(m_tractor->track(m_trackList.at(i).mlt_index));
+        if (!track || !track->is_valid())
+            continue;
+        if (track->get(kFilterOutProperty) && track->get_int(kFilterOutProperty) != duration - 1) {
+            LOG_WARNING() << "track" << i << "filters end at" << track->get_int(kFilterOutProperty) << "expected" << duration - 1;
+            result = false;
+        }
+        // Tracks with rows left to consolidate may still have adjacent blanks.
+        int first, last;
+        if (m_invariants.dirtyRows(i, &first, &last))
+            continue;
+        Mlt::Playlist playlist(*track);
+        for (int j = 1; j < playlist.count(); ++j) {
+            if (playlist.is_blank(j - 1) && playlist.is_blank(j)) {
+                LOG_WARNING() << "track" << i << "has adjacent blanks at" << j;
+                result = false;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
 void MultitrackModel::replace(int trackIndex, int clipIndex, Mlt::Producer& clip, bool copyFilters)
 {
     int i = m_trackList.at(trackIndex).mlt_index;
@@ -3228,17 +3406,33 @@ void MultitrackModel::refreshTrackList()
     }
 }
 
-void MultitrackModel::getAudioLevels()
+void MultitrackModel::getAudioLevels(bool notifyComplete)
 {
+    QVector<int> roles;
+    roles << AudioLevelsRole;
     for (int trackIx = 0; trackIx < m_trackList.size(); trackIx++) {
         int i = m_trackList.at(trackIx).mlt_index;
         QScopedPointer<Mlt::Producer> track(m_tractor->track(i));
         Mlt::Playlist playlist(*track);
-        for (int clipIx = 0; clipIx < playlist.count(); clipIx++) {
-            QScopedPointer<Mlt::Producer> clip(playlist.get_clip(clipIx));
+        // Runs of clips whose complete levels only need to be shown again.
+        int first = -1;
+        for (int clipIx = 0; clipIx <= playlist.count(); clipIx++) {
+            QScopedPointer<Mlt::Producer> clip(clipIx < playlist.count()? playlist.get_clip(clipIx) : nullptr);
+            bool isComplete = false;
             if (clip && clip->is_valid() && !clip->is_blank() && clip->get_int("audio_index") > -1) {
-                QModelIndex index = createIndex(clipIx, 0, trackIx);
-                AudioLevelsTask::start(clip->parent(), this, index);
+                Mlt::Producer parent = clip->parent();
+                // A pending task still needs the current index to notify the
+                // right clip, and a canceled one left only partial levels.
+                isComplete = parent.get_int(kAudioLevelsCompleteProperty) && !AudioLevelsTask::isPending(parent);
+                if (!isComplete)
+                    AudioLevelsTask::start(parent, this, createIndex(clipIx, 0, trackIx));
+            }
+            if (isComplete && first < 0) {
+                first = clipIx;
+            } else if (!isComplete && first >= 0) {
+                if (notifyComplete)
+                    emit dataChanged(createIndex(first, 0, trackIx), createIndex(clipIx - 1, 0, trackIx), roles);
+                first = -1;
             }
         }
     }
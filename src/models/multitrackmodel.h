@@ -21,6 +21,7 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include <QString>
+#include "timelineinvariants.h"
 #include <MltTractor.h>
 #include <MltPlaylist.h>
 
@@ -110,6 +111,7 @@ public:
     bool mergeClipWithNext(int trackIndex, int clipIndex, bool dryrun);
     void adjustClipFilters(Mlt::Producer& producer, int in, int out, int inDelta, int outDelta);
     Mlt::ClipInfo *findClipByUuid(const QUuid& uuid, int& trackIndex, int& clipIndex);
+    bool verifyInvariants();
 
 signals:
     void created();
@@ -169,18 +171,22 @@ public slots:
     void filterAddedOrRemoved(Mlt::Producer *producer);
     void onFilterChanged(Mlt::Filter* filter);
     void reload(bool asynchronous = false);
+    void refresh();
     void replace(int trackIndex, int clipIndex, Mlt::Producer& clip, bool copyFilters = true);
 
 private:
     Mlt::Tractor* m_tractor;
     TrackList m_trackList;
     bool m_isMakingTransition;
+    QVector<int> m_clipCounts; // rows per track as last announced to views
+    TimelineInvariants m_invariants;
 
     void moveClipToEnd(Mlt::Playlist& playlist, int trackIndex, int clipIndex, int position, bool ripple, bool rippleAllTracks);
     void moveClipInBlank(Mlt::Playlist& playlist, int trackIndex, int clipIndex, int position, bool ripple, bool rippleAllTracks, int duration = 0);
     void consolidateBlanks(Mlt::Playlist& playlist, int trackIndex);
     void consolidateBlanksAllTracks();
-    void getAudioLevels();
+    void getAudioLevels(bool notifyComplete = false);
+    bool rowsMatch();
     void addBlackTrackIfNeeded();
     void convertOldDoc();
     Mlt::Transition* getTransition(const QString& name, int trackIndex) const;
@@ -193,13 +199,21 @@ private:
     void clearMixReferences(int trackIndex, int clipIndex);
     bool isFiltered(Mlt::Producer* producer = 0) const;
     int getDuration();
+    void adjustBackgroundDuration(int duration);
+    void adjustTrackFilters(int duration);
     void adjustServiceFilterDurations(Mlt::Service& service, int duration);
+    void applyInvariants();
 
     friend class UndoHelper;
 
 private slots:
-    void adjustBackgroundDuration();
-    void adjustTrackFilters();
+    void maintainInvariants();
+    void resetInvariants();
+    void updateClipCounts(const QModelIndex& parent = QModelIndex());
+    void onRowsInserted(const QModelIndex& parent, int first, int last);
+    void onRowsRemoved(const QModelIndex& parent, int first, int last);
+    void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+    void onRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
 };
 
 #endif // MULTITRACKMODEL_H
@@ -35,6 +35,7 @@
 #include "database.h"
 #include "mainwindow.h"
 #include "proxymanager.h"
+#include "seekindex.h"
 
 static void deleteQImage(QImage* image)
 {
@@ -86,6 +87,9 @@ public:
                 m_tempProducer->attach(scaler);
                 m_tempProducer->attach(padder);
                 m_tempProducer->attach(converter);
+                // The out point is often in the same group as the in point.
+                if (SeekIndex::isIndexable(m_producer))
+                    SeekIndex::attach(*m_tempProducer, SeekIndex::find(QString(m_producer.get(kShotcutHashProperty))));
             }
         }
         return m_tempProducer;
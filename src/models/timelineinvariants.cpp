@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timelineinvariants.h"
+#include <QtGlobal>
+#include <limits>
+
+static const int kAllRows = std::numeric_limits<int>::max();
+
+TimelineInvariants::TimelineInvariants()
+    : m_appliedDuration(-1)
+{
+}
+
+void TimelineInvariants::reset(int trackCount)
+{
+    m_dirtyRows.clear();
+    m_changedTracks.clear();
+    for (int i = 0; i < trackCount; ++i) {
+        markRows(i, 0, kAllRows);
+        m_changedTracks << i;
+    }
+    m_trackLengths.fill(0, trackCount);
+    m_appliedDuration = -1;
+}
+
+void TimelineInvariants::rowsInserted(int trackIndex, int first, int last)
+{
+    int count = last - first + 1;
+    if (m_dirtyRows.contains(trackIndex)) {
+        Rows& rows = m_dirtyRows[trackIndex];
+        if (rows.first >= first)
+            rows.first += count;
+        if (rows.last >= first && rows.last != kAllRows)
+            rows.last += count;
+    }
+    // A new row can touch a blank on either side.
+    markRows(trackIndex, first - 1, last + 1);
+}
+
+void TimelineInvariants::rowsRemoved(int trackIndex, int first, int last)
+{
+    int count = last - first + 1;
+    if (m_dirtyRows.contains(trackIndex)) {
+        Rows& rows = m_dirtyRows[trackIndex];
+        if (rows.first > last)
+            rows.first -= count;
+        else if (rows.first > first)
+            rows.first = first;
+        if (rows.last != kAllRows) {
+            if (rows.last > last)
+                rows.last -= count;
+            else if (rows.last >= first)
+                rows.last = first;
+        }
+    }
+    // The rows on both sides of the gap are now neighbors.
+    markRows(trackIndex, first - 1, first);
+}
+
+void TimelineInvariants::rowsChanged(int trackIndex, int first, int last)
+{
+    markRows(trackIndex, first - 1, last + 1);
+}
+
+bool TimelineInvariants::dirtyRows(int trackIndex, int* first, int* last) const
+{
+    if (!m_dirtyRows.contains(trackIndex))
+        return false;
+    const Rows& rows = m_dirtyRows[trackIndex];
+    *first = rows.first;
+    *last = rows.last;
+    return true;
+}
+
+void TimelineInvariants::setConsolidated(int trackIndex)
+{
+    m_dirtyRows.remove(trackIndex);
+}
+
+QList<int> TimelineInvariants::takeChangedTracks()
+{
+    QList<int> result = m_changedTracks.toList();
+    m_changedTracks.clear();
+    return result;
+}
+
+void TimelineInvariants::setTrackLength(int trackIndex, int length)
+{
+    if (trackIndex >= m_trackLengths.size())
+        m_trackLengths.resize(trackIndex + 1);
+    m_trackLengths[trackIndex] = length;
+}
+
+int TimelineInvariants::duration() const
+{
+    int result = 0;
+    foreach (int length, m_trackLengths)
+        result = qMax(result, length);
+    return result;
+}
+
+bool TimelineInvariants::takeDurationChange()
+{
+    int value = duration();
+    if (value == m_appliedDuration)
+        return false;
+    m_appliedDuration = value;
+    return true;
+}
+
+bool TimelineInvariants::isVerifying()
+{
+    static bool result = !qgetenv("VERIFY_TIMELINE").isEmpty();
+    return result;
+}
+
+void TimelineInvariants::markRows(int trackIndex, int first, int last)
+{
+    first = qMax(0, first);
+    if (m_dirtyRows.contains(trackIndex)) {
+        Rows& rows = m_dirtyRows[trackIndex];
+        rows.first = qMin(rows.first, first);
+        rows.last = qMax(rows.last, last);
+    } else {
+        Rows rows = {first, last};
+        m_dirtyRows.insert(trackIndex, rows);
+    }
+    m_changedTracks << trackIndex;
+}
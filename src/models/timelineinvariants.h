@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMELINEINVARIANTS_H
+#define TIMELINEINVARIANTS_H
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QVector>
+
+/*!
+  \class TimelineInvariants
+  \brief Tracks what an edit changed so the timeline is kept consistent
+  without scanning the whole project.
+
+  MultitrackModel reports the rows it inserts, removes and changes on each
+  track. Only the changed rows of a track can end up as adjacent blanks,
+  only the changed tracks need their lengths read again, and the
+  background and track filters only need adjusting when the longest track
+  changes. MultitrackModel::verifyInvariants() compares the result against
+  a full recompute; setting the VERIFY_TIMELINE environment variable runs it
+  after every edit.
+*/
+
+class TimelineInvariants
+{
+public:
+    TimelineInvariants();
+
+    // Forgets everything, for example when tracks are added or removed.
+    void reset(int trackCount);
+    void rowsInserted(int trackIndex, int first, int last);
+    void rowsRemoved(int trackIndex, int first, int last);
+    void rowsChanged(int trackIndex, int first, int last);
+
+    // Returns false when the track has no rows to consolidate.
+    bool dirtyRows(int trackIndex, int* first, int* last) const;
+    void setConsolidated(int trackIndex);
+
+    QList<int> takeChangedTracks();
+    void setTrackLength(int trackIndex, int length);
+    int duration() const;
+    // Returns whether the duration changed since the last call.
+    bool takeDurationChange();
+
+    static bool isVerifying();
+
+private:
+    struct Rows {
+        int first;
+        int last;
+    };
+
+    void markRows(int trackIndex, int first, int last);
+
+    QHash<int, Rows> m_dirtyRows;
+    QSet<int> m_changedTracks;
+    QVector<int> m_trackLengths;
+    int m_appliedDuration;
+};
+
+#endif // TIMELINEINVARIANTS_H
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "motionstore.h"
+#include "mltcontroller.h"
+#include "settings.h"
+#include "util.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <MltFilter.h>
+#include <MltProducer.h>
+#include <Logger.h>
+#include <climits>
+
+typedef QMap<int, QByteArray> FrameMap;
+
+static const char* kHeader = "VID.STAB 1\n";
+// Options of the vidstab filter that change the motion it detects
+static const char* kAnalysisProperties[] = {
+    "shakiness", "accuracy", "stepsize", "mincontrast", "tripod", 0
+};
+
+namespace {
+
+// Reads the "Frame <number> (...)" lines of a vid.stab results file.
+bool readFrames(const QString& path, FrameMap& frames)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    if (!file.readLine().startsWith("VID.STAB"))
+        return false;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (!line.startsWith("Frame "))
+            continue;
+        int space = line.indexOf(' ', 6);
+        bool ok = false;
+        int number = line.mid(6, space - 6).toInt(&ok);
+        if (!ok || space < 0 || number < 1)
+            return false;
+        frames.insert(number, line.mid(space));
+    }
+    return true;
+}
+
+bool writeFrames(const QString& path, const FrameMap& frames, int first, int last, int offset)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(kHeader);
+    FrameMap::const_iterator i = frames.lowerBound(first);
+    for (; i != frames.constEnd() && i.key() <= last; ++i)
+        file.write("Frame " + QByteArray::number(i.key() - offset) + i.value());
+    return file.commit();
+}
+
+} // namespace
+
+QString MotionStore::path(Mlt::Producer& producer, Mlt::Filter& filter)
+{
+    QString mediaHash = Util::getHash(producer);
+    if (mediaHash.isEmpty())
+        return QString();
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(mediaHash.toLatin1());
+    // A timewarp clip shares the hash of its media but numbers its frames by speed.
+    hash.addData(producer.get("mlt_service"));
+    hash.addData(producer.get("warp_speed"));
+    hash.addData(QString("%1x%2 %3/%4").arg(MLT.profile().width()).arg(MLT.profile().height())
+                 .arg(MLT.profile().frame_rate_num()).arg(MLT.profile().frame_rate_den()).toLatin1());
+    for (int i = 0; kAnalysisProperties[i]; ++i) {
+        hash.addData(kAnalysisProperties[i]);
+        hash.addData(filter.get(kAnalysisProperties[i]));
+    }
+    // Filters before Stabilize change the pictures that are analyzed.
+    for (int i = 0; i < producer.filter_count(); ++i) {
+        QScopedPointer<Mlt::Filter> other(producer.filter(i));
+        if (!other || other->get_filter() == filter.get_filter())
+            break;
+        if (!other->is_valid() || other->get_int("_loader") || other->get_int("disable"))
+            continue;
+        for (int j = 0; j < other->count(); ++j) {
+            const char* name = other->get_name(j);
+            if (name && name[0] != '_' && qstrcmp(name, "in") && qstrcmp(name, "out")) {
+                hash.addData(name);
+                hash.addData(other->get(j));
+            }
+        }
+    }
+
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd("motion")) {
+        dir.mkdir("motion");
+        dir.cd("motion");
+    }
+    return dir.filePath(QString(hash.result().toHex()) + ".trf");
+}
+
+QList<MotionStore::Range> MotionStore::missing(const QString& storePath, int in, int out)
+{
+    QList<Range> result;
+    FrameMap frames;
+    readFrames(storePath, frames);
+    int first = -1;
+    // Frames are numbered from 1 in the file.
+    for (int i = in; i <= out; ++i) {
+        bool stored = frames.contains(i + 1);
+        if (!stored && first < 0)
+            first = i;
+        if (stored && first >= 0) {
+            result << Range(first, i - 1);
+            first = -1;
+        }
+    }
+    if (first >= 0)
+        result << Range(first, out);
+    return result;
+}
+
+bool MotionStore::merge(const QString& storePath, const QString& resultsPath, int first, int skip)
+{
+    FrameMap analyzed;
+    if (!readFrames(resultsPath, analyzed) || analyzed.isEmpty())
+        return false;
+    FrameMap frames;
+    readFrames(storePath, frames);
+    int count = 0;
+    for (FrameMap::const_iterator i = analyzed.constBegin(); i != analyzed.constEnd(); ++i) {
+        if (i.key() > skip) {
+            frames.insert(first + i.key(), i.value());
+            ++count;
+        }
+    }
+    LOG_INFO() << "stored the motion of" << count << "frames from" << first + skip << "in" << storePath;
+    return writeFrames(storePath, frames, 1, INT_MAX, 0);
+}
+
+bool MotionStore::extract(const QString& storePath, int in, int out, const QString& resultsPath)
+{
+    FrameMap frames;
+    if (!readFrames(storePath, frames))
+        return false;
+    return writeFrames(resultsPath, frames, in + 1, out + 1, in);
+}
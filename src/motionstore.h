@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MOTIONSTORE_H
+#define MOTIONSTORE_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+
+namespace Mlt {
+    class Filter;
+    class Producer;
+}
+
+/*!
+  \class MotionStore
+  \brief Keeps the camera motion found by Stabilize analysis for reuse.
+
+  The vidstab filter stores the motion it detects in a file with one line
+  per frame, numbered from the first frame of the filter, and only the
+  later transform step uses the smoothing and zoom options. This keeps
+  every analyzed frame in one file per media file, keyed by the content
+  hash of the media, the producer service and speed, the analysis options,
+  the video mode and the filters that run before Stabilize, and numbered
+  by source frame. path() returns an empty string for media without a hash,
+  which is then analyzed without the store. Analysis then
+  only runs over the frames that are not stored yet, and a trimmed clip or
+  a copy of it gets its results file written from the store without
+  decoding the video again.
+*/
+
+class MotionStore
+{
+public:
+    typedef QPair<int, int> Range; // first and last source frame
+
+    static QString path(Mlt::Producer& producer, Mlt::Filter& filter);
+    static QList<Range> missing(const QString& storePath, int in, int out);
+
+    /*!
+      Adds the frames of a results file written by analysis that started at
+      source frame \a first. The first \a skip frames are not stored because
+      the motion of the first analyzed frame is unknown.
+    */
+    static bool merge(const QString& storePath, const QString& resultsPath, int first, int skip);
+
+    // Writes a results file for a filter covering the source frames in to out.
+    static bool extract(const QString& storePath, int in, int out, const QString& resultsPath);
+};
+
+#endif // MOTIONSTORE_H
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "multicamdecoder.h"
+#include "mltcontroller.h"
+#include "util.h"
+#include <QMutexLocker>
+#include <MltProfile.h>
+#include <MltProducer.h>
+#include <MltFrame.h>
+#include <Logger.h>
+
+MulticamDecoder::MulticamDecoder(int index, const QString& xml, int width, QObject* parent)
+    : QThread(parent)
+    , m_index(index)
+    , m_xml(xml)
+    , m_width(width)
+    , m_requested(-1)
+    , m_stopped(false)
+{
+    setObjectName(QString("multicam %1").arg(index));
+}
+
+MulticamDecoder::~MulticamDecoder()
+{
+    stop();
+    wait();
+}
+
+void MulticamDecoder::requestPosition(int position)
+{
+    QMutexLocker locker(&m_mutex);
+    m_requested = position;
+    m_condition.wakeOne();
+}
+
+void MulticamDecoder::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stopped = true;
+    m_condition.wakeOne();
+}
+
+void MulticamDecoder::run()
+{
+    // A private profile scaled down to the grid cell keeps the decoding and
+    // scaling cost proportional to what is shown.
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    if (profile.width() > m_width) {
+        int height = Util::coerceMultiple(m_width * profile.height() / profile.width());
+        profile.set_width(Util::coerceMultiple(m_width));
+        profile.set_height(height);
+    }
+    Mlt::Producer producer(profile, "xml-string", m_xml.toUtf8().constData());
+    if (!producer.is_valid()) {
+        LOG_WARNING() << "failed to load multicam angle" << m_index;
+        return;
+    }
+    int width = profile.width();
+    int height = profile.height();
+    int last = -1;
+
+    forever {
+        int position;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopped && (m_requested < 0 || m_requested == last))
+                m_condition.wait(&m_mutex);
+            if (m_stopped)
+                break;
+            position = m_requested;
+        }
+        // Sequential requests during playback let avformat keep decoding
+        // forward without a real seek.
+        producer.seek(position);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        last = position;
+        if (!frame || !frame->is_valid())
+            continue;
+        frame->set("rescale.interp", "bilinear");
+        frame->set("consumer_deinterlace", 1);
+        mlt_image_format format = mlt_image_rgb24;
+        int w = width;
+        int h = height;
+        const uchar* data = frame->get_image(format, w, h);
+        if (!data || w <= 0 || h <= 0)
+            continue;
+        QImage image(data, w, h, 3 * w, QImage::Format_RGB888);
+        emit frameReady(m_index, image.copy());
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MULTICAMDECODER_H
+#define MULTICAMDECODER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QString>
+
+/*!
+  \class MulticamDecoder
+  \brief Decodes one multicam angle at a reduced size on its own thread.
+
+  Only the most recently requested position is decoded, so a decoder that
+  falls behind skips frames instead of queueing them. Audio is never read.
+*/
+
+class MulticamDecoder : public QThread
+{
+    Q_OBJECT
+public:
+    MulticamDecoder(int index, const QString& xml, int width, QObject* parent = nullptr);
+    ~MulticamDecoder();
+
+    int index() const { return m_index; }
+    QString xml() const { return m_xml; }
+    void requestPosition(int position);
+    void stop();
+
+signals:
+    void frameReady(int index, const QImage& image);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    int m_index;
+    QString m_xml;
+    int m_width;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    int m_requested;
+    bool m_stopped;
+};
+
+#endif // MULTICAMDECODER_H
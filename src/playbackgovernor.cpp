@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "playbackgovernor.h"
+#include "jobqueue.h"
+#include "settings.h"
+#include "sharedframe.h"
+#include <QThread>
+#include <QThreadPool>
+#include <Logger.h>
+
+static const int kYieldMs = 20;
+static const int kMaxDropGap = 30;
+static const int kThrottledThreads = 1;
+
+QAtomicInt PlaybackGovernor::m_throttled;
+
+PlaybackGovernor::PlaybackGovernor(QObject* parent)
+    : QObject(parent)
+    , m_savedThreadCount(0)
+    , m_speed(0.0)
+    , m_lastPosition(-1)
+    , m_framesPlayed(0)
+    , m_framesDropped(0)
+{
+}
+
+PlaybackGovernor& PlaybackGovernor::singleton(QObject* parent)
+{
+    static PlaybackGovernor* instance = 0;
+    if (!instance)
+        instance = new PlaybackGovernor(parent);
+    return *instance;
+}
+
+bool PlaybackGovernor::isThrottled()
+{
+    return m_throttled.load();
+}
+
+void PlaybackGovernor::yieldIfThrottled()
+{
+    if (m_throttled.load())
+        QThread::msleep(kYieldMs);
+}
+
+void PlaybackGovernor::onPlayed(double speed)
+{
+    if (m_speed == 0.0) {
+        m_lastPosition = -1;
+        m_framesPlayed = 0;
+        m_framesDropped = 0;
+    }
+    m_speed = speed;
+    if (!m_throttled.load() && Settings.playerThrottleBackground())
+        throttle();
+}
+
+void PlaybackGovernor::onPaused()
+{
+    if (m_speed != 0.0 && m_framesPlayed > 0) {
+        LOG_INFO() << "played" << m_framesPlayed << "frames, dropped" << m_framesDropped
+                   << "throttled" << isThrottled();
+        if (m_framesDropped > 0)
+            emit showStatusMessage(tr("Dropped %1 of %2 frames during playback")
+                                   .arg(m_framesDropped).arg(m_framesPlayed + m_framesDropped));
+    }
+    m_speed = 0.0;
+    if (m_throttled.load())
+        restore();
+}
+
+void PlaybackGovernor::onFrameDisplayed(const SharedFrame& frame)
+{
+    if (m_speed != 1.0)
+        return;
+    int position = frame.get_position();
+    if (m_lastPosition >= 0) {
+        int delta = position - m_lastPosition;
+        // Larger jumps are seeks or loops rather than dropped frames.
+        if (delta > 1 && delta <= kMaxDropGap)
+            m_framesDropped += delta - 1;
+        if (delta > 0)
+            ++m_framesPlayed;
+    }
+    m_lastPosition = position;
+}
+
+void PlaybackGovernor::throttle()
+{
+    m_throttled.store(1);
+    QThreadPool* pool = QThreadPool::globalInstance();
+    m_savedThreadCount = pool->maxThreadCount();
+    pool->setMaxThreadCount(qBound(1, kThrottledThreads, m_savedThreadCount));
+    foreach (AbstractJob* job, JOBS.jobs()) {
+        if (job->jobState() == QProcess::Running)
+            job->setThrottled(true);
+    }
+    LOG_DEBUG() << "throttled background work to" << pool->maxThreadCount() << "threads";
+}
+
+void PlaybackGovernor::restore()
+{
+    m_throttled.store(0);
+    if (m_savedThreadCount > 0)
+        QThreadPool::globalInstance()->setMaxThreadCount(m_savedThreadCount);
+    foreach (AbstractJob* job, JOBS.jobs()) {
+        if (job->jobState() == QProcess::Running)
+            job->setThrottled(false);
+    }
+    LOG_DEBUG() << "restored background work";
+}
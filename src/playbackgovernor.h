@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PLAYBACKGOVERNOR_H
+#define PLAYBACKGOVERNOR_H
+
+#include <QObject>
+#include <QAtomicInt>
+
+class SharedFrame;
+
+/*!
+  \class PlaybackGovernor
+  \brief Holds back background work while the player is playing.
+
+  When playback starts, the child processes of running jobs get a lower CPU
+  and I/O priority, in-process jobs yield between units of work, and the
+  global thread pool used by thumbnail and audio level workers is limited.
+  In-process jobs have a pool of their own so that they do not hold its
+  threads. Everything is restored when playback pauses or stops. Dropped
+  frames are counted during normal speed playback and reported afterwards.
+*/
+
+class PlaybackGovernor : public QObject
+{
+    Q_OBJECT
+protected:
+    explicit PlaybackGovernor(QObject* parent);
+
+public:
+    static PlaybackGovernor& singleton(QObject* parent = 0);
+    static bool isThrottled();
+    // Workers call this between units of work to slow down during playback.
+    static void yieldIfThrottled();
+
+    int framesPlayed() const { return m_framesPlayed; }
+    int framesDropped() const { return m_framesDropped; }
+
+signals:
+    void showStatusMessage(QString);
+
+public slots:
+    void onPlayed(double speed);
+    void onPaused();
+    void onFrameDisplayed(const SharedFrame& frame);
+
+private:
+    void throttle();
+    void restore();
+
+    static QAtomicInt m_throttled;
+    int m_savedThreadCount;
+    double m_speed;
+    int m_lastPosition;
+    int m_framesPlayed;
+    int m_framesDropped;
+};
+
+#endif // PLAYBACKGOVERNOR_H
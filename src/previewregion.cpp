@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "previewregion.h"
+#include "sharedframe.h"
+#include <QScopedPointer>
+#include <QSet>
+#include <QString>
+#include <MltFilter.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+static const double kAspectTolerance = 0.01;
+static const char* kRegionProperty = "region";
+static const char* kFrameXProperty = "_shotcut:region.x";
+static const char* kFrameYProperty = "_shotcut:region.y";
+static const char* kFrameWidthProperty = "_shotcut:region.width";
+static const char* kFrameHeightProperty = "_shotcut:region.height";
+
+namespace {
+
+// Producers that set the media size on the frame for the crop normalizer.
+const QSet<QString> croppableProducers = QSet<QString>()
+    << "avformat" << "avformat-novalidate" << "qimage" << "pixbuf";
+
+// Filters whose output pixel depends only on the same input pixel or that
+// only change the audio.
+const QSet<QString> pointServices = QSet<QString>()
+    << "brightness" << "lift_gamma_gain" << "sepia" << "invert" << "tcolor"
+    << "frei0r.saturat0r" << "frei0r.colgate" << "frei0r.coloradj_RGB"
+    << "avfilter.hue" << "avfilter.lut3d" << "shotcut.lut3d"
+    << "volume" << "panner" << "mono" << "channelcopy" << "audiochannels" << "audioconvert";
+
+bool isCroppable(mlt_filter filter, mlt_properties frameProperties)
+{
+    int width = mlt_properties_get_int(frameProperties, "meta.media.width");
+    int height = mlt_properties_get_int(frameProperties, "meta.media.height");
+    // Something else already crops this frame.
+    if (width <= 0 || height <= 0 || mlt_properties_get(frameProperties, "crop.original_width"))
+        return false;
+    double sar = 1.0;
+    if (mlt_properties_get_int(frameProperties, "meta.media.sample_aspect_den") > 0)
+        sar = mlt_properties_get_double(frameProperties, "meta.media.sample_aspect_num")
+            / mlt_properties_get_double(frameProperties, "meta.media.sample_aspect_den");
+    if (sar <= 0.0)
+        sar = 1.0;
+    // The region is relative to the frame, which only matches the media
+    // when the media fills the frame without padding.
+    mlt_profile profile = mlt_service_profile(MLT_FILTER_SERVICE(filter));
+    double aspect = width * sar / height;
+    return profile && qAbs(aspect / mlt_profile_dar(profile) - 1.0) < kAspectTolerance;
+}
+
+// Sets the frame properties the same way as a non-active crop filter does
+// for the active crop normalizer of the clip.
+void crop(mlt_properties frameProperties, const mlt_rect& region)
+{
+    int width = mlt_properties_get_int(frameProperties, "meta.media.width");
+    int height = mlt_properties_get_int(frameProperties, "meta.media.height");
+    // Keep even offsets for chroma subsampling and field order.
+    int left = qBound(0, qRound(region.x * width), width - 2) & ~1;
+    int top = qBound(0, qRound(region.y * height), height - 2) & ~1;
+    int right = qMax(0, width - left - qMax(2, qRound(region.w * width) & ~1));
+    int bottom = qMax(0, height - top - qMax(2, qRound(region.h * height) & ~1));
+    mlt_properties_set_int(frameProperties, "crop.left", left);
+    mlt_properties_set_int(frameProperties, "crop.right", right);
+    mlt_properties_set_int(frameProperties, "crop.top", top);
+    mlt_properties_set_int(frameProperties, "crop.bottom", bottom);
+    mlt_properties_set_int(frameProperties, "crop.original_width", width);
+    mlt_properties_set_int(frameProperties, "crop.original_height", height);
+    mlt_properties_set_int(frameProperties, "meta.media.width", width - left - right);
+    mlt_properties_set_int(frameProperties, "meta.media.height", height - top - bottom);
+    // Tell the display which part of the frame the image shows after rounding.
+    mlt_properties_set_double(frameProperties, kFrameXProperty, double(left) / width);
+    mlt_properties_set_double(frameProperties, kFrameYProperty, double(top) / height);
+    mlt_properties_set_double(frameProperties, kFrameWidthProperty, double(width - left - right) / width);
+    mlt_properties_set_double(frameProperties, kFrameHeightProperty, double(height - top - bottom) / height);
+}
+
+mlt_frame process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties frameProperties = MLT_FRAME_PROPERTIES(frame);
+    mlt_properties_lock(properties);
+    mlt_rect region = mlt_properties_get_rect(properties, kRegionProperty);
+    mlt_properties_unlock(properties);
+
+    if (region.w > 0.0 && region.h > 0.0 && isCroppable(filter, frameProperties))
+        crop(frameProperties, region);
+    return frame;
+}
+
+} // namespace
+
+Mlt::Filter* PreviewRegion::createFilter(Mlt::Profile& profile)
+{
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return 0;
+    filter->process = process;
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_properties_set_data(properties, "_profile", profile.get_profile(), 0, NULL, NULL);
+    // Loader filters are not saved in the project or shown as clip filters.
+    mlt_properties_set_int(properties, "_loader", 1);
+    Mlt::Filter* result = new Mlt::Filter(filter);
+    mlt_filter_close(filter);
+    return result;
+}
+
+bool PreviewRegion::isSupported(Mlt::Producer& producer)
+{
+    if (!producer.is_valid() || !croppableProducers.contains(producer.get("mlt_service")))
+        return false;
+    for (int i = 0; i < producer.filter_count(); ++i) {
+        QScopedPointer<Mlt::Filter> filter(producer.filter(i));
+        if (!filter || !filter->is_valid() || filter->get_int("_loader") || filter->get_int("disable"))
+            continue;
+        if (!pointServices.contains(filter->get("mlt_service")))
+            return false;
+    }
+    return true;
+}
+
+void PreviewRegion::setRegion(Mlt::Filter& filter, const QRectF& region)
+{
+    mlt_rect rect = {region.x(), region.y(), region.width(), region.height(), 1.0};
+    filter.lock();
+    filter.set(kRegionProperty, rect);
+    filter.unlock();
+}
+
+QRectF PreviewRegion::frameRegion(const SharedFrame& frame)
+{
+    double width = frame.get_double(kFrameWidthProperty);
+    double height = frame.get_double(kFrameHeightProperty);
+    if (width <= 0.0 || height <= 0.0)
+        return QRectF();
+    return QRectF(frame.get_double(kFrameXProperty), frame.get_double(kFrameYProperty), width, height);
+}
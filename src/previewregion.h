@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PREVIEWREGION_H
+#define PREVIEWREGION_H
+
+#include <QRectF>
+
+namespace Mlt {
+    class Filter;
+    class Producer;
+    class Profile;
+}
+class SharedFrame;
+
+/*!
+  \class PreviewRegion
+  \brief Renders only the part of a clip that is visible in the zoomed player.
+
+  A hidden filter attached to the player consumer asks the crop normalizer
+  of the clip to cut the region out of the decoded image, so that scaling,
+  the clip filters and the upload to the display only handle the visible
+  pixels. The region is given in fractions of the frame and always has the
+  aspect ratio of the profile. Frames that cannot be cropped, for example
+  because the media has a different aspect ratio, are rendered whole and
+  carry no region.
+*/
+
+class PreviewRegion
+{
+public:
+    static Mlt::Filter* createFilter(Mlt::Profile& profile);
+
+    // Whether the clip and all of its filters work on a cropped image.
+    static bool isSupported(Mlt::Producer& producer);
+
+    // A null region renders the whole frame.
+    static void setRegion(Mlt::Filter& filter, const QRectF& region);
+
+    // Returns the region a frame was rendered for, or a null region.
+    static QRectF frameRegion(const SharedFrame& frame);
+};
+
+#endif // PREVIEWREGION_H
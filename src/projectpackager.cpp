@@ -0,0 +1,672 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projectpackager.h"
+#include "mltcontroller.h"
+#include "seekindex.h"
+#include "shotcut_mlt_properties.h"
+#include "util.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QFutureSynchronizer>
+#include <QProcess>
+#include <QSaveFile>
+#include <QSet>
+#include <QThreadPool>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QtConcurrent/QtConcurrentRun>
+#include <Logger.h>
+#include <atomic>
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static const int kMaxParallelFiles = 2;
+static const qint64 kCopyBufferSize = 1024 * 1024;
+static const double kTrimHandleSeconds = 1.0;
+static const char* kMediaFolder = "media";
+
+namespace {
+
+bool isResourceProperty(const QString& name)
+{
+    return name == "resource" || name == "src" || name == "filename"
+            || name == "luma" || name == "luma.resource" || name == "composite.luma"
+            || name == "producer.resource" || name == "av.file" || name == "warp_resource";
+}
+
+// Returns the "plain:" or timewarp speed prefix of a resource, if any.
+QString prefixOf(const QString& name, const QString& value)
+{
+    if (name != "resource")
+        return QString();
+    if (value.startsWith("plain:"))
+        return "plain:";
+    int length = value.indexOf(':');
+    if (length <= 0)
+        return QString();
+    for (int i = 0; i < length; i++) {
+        if (!value[i].isDigit() && value[i] != '.' && value[i] != ',')
+            return QString();
+    }
+    return value.left(length + 1);
+}
+
+// Returns the absolute path of the file that a property refers to, if any.
+QString fileOf(const QString& name, const QString& value, QString* prefix = nullptr)
+{
+    if (!isResourceProperty(name) || value.isEmpty())
+        return QString();
+    QString p = prefixOf(name, value);
+    QFileInfo info(value.mid(p.size()));
+    if (!info.isAbsolute() || !info.isFile())
+        return QString();
+    if (prefix)
+        *prefix = p;
+    return info.absoluteFilePath();
+}
+
+bool isTrimmableService(const QString& service)
+{
+    return service == "avformat" || service == "avformat-novalidate";
+}
+
+bool runProcess(QProcess& process, const std::function<bool()>& isCanceled)
+{
+    if (!process.waitForStarted())
+        return false;
+    while (process.state() != QProcess::NotRunning && !process.waitForFinished(100)) {
+        if (isCanceled()) {
+            process.kill();
+            process.waitForFinished();
+            return false;
+        }
+    }
+    return process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+}
+
+} // namespace
+
+ProjectPackager::ProjectPackager(const QString& xml, const QString& folder, const QString& projectName, bool trim)
+    : m_xml(xml)
+    , m_folder(folder)
+    , m_projectName(projectName)
+    , m_isTrimEnabled(trim)
+    , m_fps(0.0)
+    , m_duplicates(0)
+{
+}
+
+bool ProjectPackager::analyze(const std::function<bool()>& isCanceled)
+{
+    struct Service {
+        QString element;
+        QString id;
+        QString service;
+        QString resource;
+        QStringList files;
+    };
+    QList<Service> services;
+    QXmlStreamReader xml(m_xml);
+
+    while (!xml.atEnd()) {
+        switch (xml.readNext()) {
+        case QXmlStreamReader::StartElement: {
+            const QString element = xml.name().toString();
+            const QXmlStreamAttributes attributes = xml.attributes();
+            if (element == "profile") {
+                int den = attributes.value("frame_rate_den").toInt();
+                if (den > 0)
+                    m_fps = attributes.value("frame_rate_num").toDouble() / den;
+            } else if (element == "producer" || element == "chain"
+                       || element == "filter" || element == "transition") {
+                Service service;
+                service.element = element;
+                service.id = attributes.value("id").toString();
+                services << service;
+            } else if (element == "property" && !services.isEmpty()) {
+                const QString name = attributes.value("name").toString();
+                const QString value = xml.readElementText();
+                if (name == "mlt_service") {
+                    services.last().service = value;
+                } else {
+                    QString path = fileOf(name, value);
+                    if (!path.isEmpty()) {
+                        services.last().files << path;
+                        if (name == "resource")
+                            services.last().resource = path;
+                    }
+                }
+            } else if (element == "entry" || element == "track") {
+                const QString id = attributes.value("producer").toString();
+                if (m_producers.contains(id)) {
+                    Producer& producer = m_producers[id];
+                    int in = attributes.hasAttribute("in")? frames(attributes.value("in").toString()) : -1;
+                    int out = attributes.hasAttribute("out")? frames(attributes.value("out").toString()) : -1;
+                    if (element == "track" || in < 0 || out < in) {
+                        producer.isWhole = true;
+                    } else if (producer.in < 0) {
+                        producer.in = in;
+                        producer.out = out;
+                    } else {
+                        producer.in = qMin(producer.in, in);
+                        producer.out = qMax(producer.out, out);
+                    }
+                }
+            }
+            break;
+        }
+        case QXmlStreamReader::EndElement: {
+            const QString element = xml.name().toString();
+            if (services.isEmpty() || services.last().element != element)
+                break;
+            Service service = services.takeLast();
+            if (element == "producer" || element == "chain") {
+                Producer producer = {service.service, service.resource, service.files, false, -1, -1};
+                m_producers[service.id] = producer;
+            } else if (!services.isEmpty()) {
+                // A filter belongs to the producer that it is nested in.
+                services.last().files << service.files;
+            } else if (!service.files.isEmpty()) {
+                if (!m_producers.contains(QString())) {
+                    Producer others = {QString(), QString(), QStringList(), true, -1, -1};
+                    m_producers[QString()] = others;
+                }
+                m_producers[QString()].files << service.files;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (xml.hasError()) {
+        m_errorString = tr("Failed to read the project: %1").arg(xml.errorString());
+        return false;
+    }
+    if (m_fps <= 0.0)
+        m_fps = MLT.profile().fps();
+
+    // Hash the files in parallel to find the ones with the same content.
+    QSet<QString> paths;
+    foreach (const Producer& producer, m_producers)
+        paths.unite(producer.files.toSet());
+    QThreadPool pool;
+    pool.setMaxThreadCount(kMaxParallelFiles);
+    QHash<QString, QFuture<QString>> hashes;
+    foreach (const QString& path, paths)
+        hashes[path] = QtConcurrent::run(&pool, [path]() { return Util::getFileHash(path); });
+
+    QHash<QString, QString> targets; // lower case target to media key
+    foreach (const QString& path, paths) {
+        QString hash = hashes[path].result();
+        qint64 size = QFileInfo(path).size();
+        // The hash only samples the ends of large files, so include the size
+        // and compare the whole files before dropping one.
+        QString key = hash.isEmpty()? path : QString("%1:%2").arg(hash).arg(size);
+        for (int n = 1; m_media.contains(key); ++n) {
+            if (isSameContent(path, m_media[key].path, isCanceled))
+                break;
+            if (isCanceled())
+                return false;
+            LOG_INFO() << path << "only has the same hash and size as" << m_media[key].path;
+            key = QString("%1:%2:%3").arg(hash).arg(size).arg(n);
+        }
+        m_keys[path] = key;
+        if (m_media.contains(key)) {
+            LOG_INFO() << path << "is the same as" << m_media[key].path;
+            ++m_duplicates;
+            continue;
+        }
+        QFileInfo info(path);
+        QString target = QString("%1/%2").arg(QString(kMediaFolder)).arg(info.fileName());
+        if (targets.contains(target.toLower())) {
+            target = QString("%1/%2 (%3)").arg(QString(kMediaFolder)).arg(info.completeBaseName()).arg(hash.left(8));
+            if (!info.suffix().isEmpty())
+                target += "." + info.suffix();
+        }
+        targets[target.toLower()] = key;
+        Media media = {path, hash, size, target, true, -1, -1, 0, 0, false, false, -1};
+        m_media[key] = media;
+    }
+
+    for (auto i = m_producers.constBegin(); i != m_producers.constEnd(); ++i) {
+        const Producer& producer = i.value();
+        bool isWhole = producer.isWhole || producer.in < 0 || !isTrimmableService(producer.service);
+        foreach (const QString& path, producer.files) {
+            Media& media = m_media[m_keys[path]];
+            if (isWhole || path != producer.resource) {
+                media.isTrimmable = false;
+            } else if (media.usedIn < 0) {
+                media.usedIn = producer.in;
+                media.usedOut = producer.out;
+            } else {
+                media.usedIn = qMin(media.usedIn, producer.in);
+                media.usedOut = qMax(media.usedOut, producer.out);
+            }
+        }
+    }
+    if (m_isTrimEnabled) {
+        for (auto i = m_media.begin(); i != m_media.end() && !isCanceled(); ++i)
+            planTrim(i.value(), isCanceled);
+    }
+    if (isCanceled())
+        return false;
+    LOG_INFO() << "collecting" << m_media.size() << "files with" << m_duplicates << "duplicates";
+    return true;
+}
+
+void ProjectPackager::planTrim(Media& media, const std::function<bool()>& isCanceled)
+{
+    if (!media.isTrimmable || media.usedIn < 0 || m_fps <= 0.0)
+        return;
+    // Media that was never opened in the player has no index yet.
+    QSharedPointer<SeekIndex> index = SeekIndex::findOrBuild(media.hash, media.path, isCanceled);
+    if (!index)
+        return;
+
+    // Keep some handles so the clips can still be adjusted a little.
+    int handles = qRound(kTrimHandleSeconds * m_fps);
+    int in = qMax(0, media.usedIn - handles);
+    int out = media.usedOut + handles;
+    int keyframe = index->keyframeAtOrBefore(in, m_fps);
+    if (keyframe < 0)
+        return;
+
+    // The used bytes run from the keyframe before the in point to the one
+    // after the out point.
+    qint64 start = -1;
+    qint64 end = media.size;
+    foreach (const SeekIndex::Keyframe& k, index->keyframes()) {
+        int frame = qRound(k.time * m_fps);
+        if (frame <= keyframe) {
+            start = k.offset;
+        } else if (frame > out) {
+            end = k.offset;
+            break;
+        }
+    }
+    if (start < 0 || end <= start)
+        return;
+    LOG_DEBUG() << media.path << "uses frames" << media.usedIn << "to" << media.usedOut
+                << "in bytes" << start << "to" << end << "of" << media.size;
+    if (2 * (end - start) >= media.size)
+        return;
+    media.usedBytes = end - start;
+    media.shift = keyframe;
+    media.length = out - keyframe + 1;
+    media.isTrimmed = true;
+}
+
+bool ProjectPackager::collect(const std::function<void(int)>& progress, const std::function<bool()>& isCanceled)
+{
+    QDir dir(m_folder);
+    if (!dir.mkpath(kMediaFolder)) {
+        m_errorString = tr("Failed to create the folder %1").arg(dir.filePath(kMediaFolder));
+        return false;
+    }
+    qint64 total = 0;
+    foreach (const Media& media, m_media)
+        total += media.isTrimmed? media.usedBytes : media.size;
+
+    // The workers report the progress as they go.
+    std::atomic<qint64> done(0);
+    std::atomic<int> percent(-1);
+    auto addBytes = [&](qint64 bytes) {
+        done += bytes;
+        int p = (total > 0)? qBound(0, int(100 * done / total), 99) : 0;
+        if (percent.exchange(p) != p)
+            progress(p);
+    };
+    QThreadPool pool;
+    pool.setMaxThreadCount(kMaxParallelFiles);
+    QFutureSynchronizer<bool> synchronizer;
+    for (auto i = m_media.begin(); i != m_media.end(); ++i) {
+        Media* media = &i.value();
+        synchronizer.addFuture(QtConcurrent::run(&pool, [=]() {
+            return collectOne(*media, addBytes, isCanceled);
+        }));
+    }
+    synchronizer.waitForFinished();
+    bool ok = true;
+    foreach (const QFuture<bool>& future, synchronizer.futures())
+        ok = ok && future.result();
+    return ok && !isCanceled();
+}
+
+bool ProjectPackager::collectOne(Media& media, const std::function<void(qint64)>& addBytes,
+                                 const std::function<bool()>& isCanceled)
+{
+    QString targetPath = QDir(m_folder).filePath(media.target);
+    if (QFileInfo(targetPath).canonicalFilePath() == QFileInfo(media.path).canonicalFilePath()) {
+        // Collecting into the same folder again.
+        addBytes(media.isTrimmed? media.usedBytes : media.size);
+        media.isTrimmed = false;
+        media.shift = 0;
+        return true;
+    }
+    if (QFile::exists(targetPath))
+        QFile::remove(targetPath);
+    if (media.isTrimmed) {
+        if (trim(media, targetPath, isCanceled)) {
+            addBytes(media.usedBytes);
+            return true;
+        }
+        if (isCanceled())
+            return false;
+        LOG_WARNING() << "failed to trim" << media.path << "so copying it whole";
+        media.isTrimmed = false;
+        media.shift = 0;
+        QFile::remove(targetPath);
+    }
+    if (link(media.path, targetPath)) {
+        media.isLinked = true;
+        addBytes(media.size);
+        return true;
+    }
+    if (!copy(media.path, targetPath, addBytes, isCanceled)) {
+        if (!isCanceled())
+            LOG_WARNING() << "failed to copy" << media.path << "to" << targetPath;
+        return false;
+    }
+    return true;
+}
+
+bool ProjectPackager::trim(const Media& media, const QString& targetPath, const std::function<bool()>& isCanceled)
+{
+    // The seek index counts from the first video packet, but ffmpeg seeks
+    // from the start of the container.
+    QProcess ffprobe;
+    QFileInfo ffprobePath(qApp->applicationDirPath(), "ffprobe");
+    QStringList args;
+    args << "-v" << "error" << "-select_streams" << "v:0"
+         << "-show_entries" << "stream=start_time:format=start_time"
+         << "-of" << "default=noprint_wrappers=1:nokey=1" << media.path;
+    ffprobe.start(ffprobePath.absoluteFilePath(), args);
+    if (!runProcess(ffprobe, isCanceled))
+        return false;
+    QList<QByteArray> lines = ffprobe.readAllStandardOutput().trimmed().split('\n');
+    if (lines.size() < 2)
+        return false;
+    double videoStart = lines.first().trimmed().toDouble();
+    double formatStart = lines.last().trimmed().toDouble();
+
+    // Aim a little after the keyframe so that the stream copy starts on it.
+    double start = media.shift / m_fps + videoStart - formatStart + 0.25 / m_fps;
+    QProcess ffmpeg;
+    QFileInfo ffmpegPath(qApp->applicationDirPath(), "ffmpeg");
+    args.clear();
+    args << "-v" << "error" << "-ss" << QString::number(qMax(0.0, start), 'f', 6)
+         << "-i" << media.path << "-map" << "0" << "-c" << "copy" << "-ignore_unknown"
+         << "-map_metadata" << "0" << "-t" << QString::number(media.length / m_fps, 'f', 6)
+         << "-y" << targetPath;
+    ffmpeg.start(ffmpegPath.absoluteFilePath(), args);
+    if (!runProcess(ffmpeg, isCanceled)) {
+        LOG_WARNING() << ffmpeg.readAllStandardError();
+        return false;
+    }
+    LOG_INFO() << "trimmed" << media.path << "from frame" << media.shift << "for" << media.length << "frames";
+    return true;
+}
+
+bool ProjectPackager::isSameContent(const QString& a, const QString& b, const std::function<bool()>& isCanceled) const
+{
+    QFile fileA(a);
+    QFile fileB(b);
+    if (!fileA.open(QIODevice::ReadOnly) || !fileB.open(QIODevice::ReadOnly) || fileA.size() != fileB.size())
+        return false;
+    QByteArray bufferA(kCopyBufferSize, Qt::Uninitialized);
+    QByteArray bufferB(kCopyBufferSize, Qt::Uninitialized);
+    while (!fileA.atEnd()) {
+        if (isCanceled())
+            return false;
+        qint64 n = fileA.read(bufferA.data(), bufferA.size());
+        if (n <= 0 || fileB.read(bufferB.data(), n) != n || memcmp(bufferA.constData(), bufferB.constData(), n))
+            return false;
+    }
+    return true;
+}
+
+bool ProjectPackager::link(const QString& source, const QString& targetPath)
+{
+#ifdef Q_OS_WIN
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(targetPath).utf16()),
+                           reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(source).utf16()), nullptr);
+#else
+    return ::link(QFile::encodeName(source).constData(), QFile::encodeName(targetPath).constData()) == 0;
+#endif
+}
+
+bool ProjectPackager::copy(const QString& source, const QString& targetPath,
+                           const std::function<void(qint64)>& addBytes, const std::function<bool()>& isCanceled)
+{
+    QFile in(source);
+    QSaveFile out(targetPath);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly))
+        return false;
+    QByteArray buffer(kCopyBufferSize, Qt::Uninitialized);
+    while (!in.atEnd()) {
+        if (isCanceled()) {
+            out.cancelWriting();
+            return false;
+        }
+        qint64 n = in.read(buffer.data(), buffer.size());
+        if (n < 0 || out.write(buffer.constData(), n) != n) {
+            out.cancelWriting();
+            return false;
+        }
+        addBytes(n);
+    }
+    return out.commit();
+}
+
+bool ProjectPackager::writeProject()
+{
+    QSaveFile file(projectPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_errorString = tr("Failed to write %1").arg(projectPath());
+        return false;
+    }
+    QXmlStreamReader xml(m_xml);
+    QXmlStreamWriter newXml(&file);
+    newXml.setAutoFormatting(true);
+    newXml.setAutoFormattingIndent(1);
+    // The frames that the producers, entries and services being written
+    // move by, and the last frame of the trimmed media they refer to.
+    struct Span {
+        int shift;
+        int last;
+        bool isClip;
+    };
+    QList<Span> spans;
+    QString producerId;
+
+    while (!xml.atEnd()) {
+        switch (xml.readNext()) {
+        case QXmlStreamReader::StartDocument:
+            newXml.writeStartDocument(xml.documentVersion().toString(), xml.isStandaloneDocument());
+            break;
+        case QXmlStreamReader::EndDocument:
+            newXml.writeEndDocument();
+            break;
+        case QXmlStreamReader::Comment:
+            newXml.writeComment(xml.text().toString());
+            break;
+        case QXmlStreamReader::Characters:
+            if (!xml.isWhitespace())
+                newXml.writeCharacters(xml.text().toString());
+            break;
+        case QXmlStreamReader::StartElement: {
+            const QString element = xml.name().toString();
+            const QXmlStreamAttributes attributes = xml.attributes();
+            if (element == "property") {
+                const QString name = attributes.value("name").toString();
+                QString value = xml.readElementText();
+                bool isTrimmedClip = !spans.isEmpty() && spans.last().isClip && spans.last().shift > 0;
+                QString prefix;
+                const Media* media = mediaOf(fileOf(name, value, &prefix));
+                if (media) {
+                    value = prefix + media->target;
+                } else if (isTrimmedClip && name == kShotcutHashProperty) {
+                    // The trimmed file has different content.
+                    break;
+                } else if (isTrimmedClip && name == "length" && spans.size() == 1) {
+                    const Media* trimmed = mediaOf(m_producers.value(producerId).resource);
+                    if (trimmed)
+                        value = QString::number(trimmed->length);
+                }
+                newXml.writeStartElement(xml.namespaceUri().toString(), element);
+                newXml.writeAttributes(attributes);
+                newXml.writeCharacters(value);
+                newXml.writeEndElement();
+                break;
+            }
+            // The frames of a trimmed producer, its entries and the filters
+            // on them move, since clip filters use the frames of the source.
+            // Transitions and the filters of tracks keep theirs.
+            Span span = {0, 0, false};
+            if (element == "producer" || element == "chain" || element == "entry") {
+                QString id = attributes.value("producer").toString();
+                if (element != "entry")
+                    id = producerId = attributes.value("id").toString();
+                span.shift = shiftOf(id);
+                if (span.shift > 0)
+                    span.last = mediaOf(m_producers.value(id).resource)->length - 1;
+                span.isClip = true;
+                spans << span;
+            } else if (element == "filter") {
+                if (!spans.isEmpty() && spans.last().isClip) {
+                    span = spans.last();
+                    span.isClip = false;
+                }
+                spans << span;
+            } else if (element == "transition") {
+                spans << span;
+            }
+            const int shift = span.shift;
+            const int last = span.last;
+            newXml.writeStartElement(xml.namespaceUri().toString(), element);
+            foreach (const QXmlStreamAttribute& a, attributes) {
+                if (element == "mlt" && a.name() == "root") {
+                    // Without a root the paths are relative to the project file.
+                    continue;
+                } else if (shift > 0 && (a.name() == "in" || a.name() == "out")) {
+                    newXml.writeAttribute(a.name().toString(),
+                        QString::number(qBound(0, frames(a.value().toString()) - shift, last)));
+                } else {
+                    newXml.writeAttribute(a);
+                }
+            }
+            break;
+        }
+        case QXmlStreamReader::EndElement: {
+            const QString element = xml.name().toString();
+            if (element == "producer" || element == "chain" || element == "entry"
+                    || element == "filter" || element == "transition")
+                spans.removeLast();
+            newXml.writeEndElement();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (xml.hasError()) {
+        file.cancelWriting();
+        m_errorString = tr("Failed to read the project: %1").arg(xml.errorString());
+        return false;
+    }
+    if (!file.commit()) {
+        m_errorString = tr("Failed to write %1").arg(projectPath());
+        return false;
+    }
+    return true;
+}
+
+QString ProjectPackager::projectPath() const
+{
+    return QDir(m_folder).filePath(m_projectName + ".mlt");
+}
+
+QString ProjectPackager::report() const
+{
+    int linked = 0;
+    int trimmed = 0;
+    qint64 copied = 0;
+    qint64 saved = 0;
+    foreach (const Media& media, m_media) {
+        if (media.isLinked) {
+            ++linked;
+        } else if (media.isTrimmed) {
+            ++trimmed;
+            copied += media.usedBytes;
+            saved += media.size - media.usedBytes;
+        } else {
+            copied += media.size;
+        }
+    }
+    QString s = tr("Collected %n file(s) into %1\n", nullptr, m_media.size()).arg(m_folder);
+    if (m_duplicates > 0)
+        s += tr("Skipped %n duplicate file(s)\n", nullptr, m_duplicates);
+    if (linked > 0)
+        s += tr("Linked %n file(s)\n", nullptr, linked);
+    if (trimmed > 0)
+        s += tr("Trimmed %n file(s) to save %1 MiB\n", nullptr, trimmed).arg(saved / 1024 / 1024);
+    s += tr("Copied %1 MiB\n").arg(copied / 1024 / 1024);
+    return s;
+}
+
+int ProjectPackager::frames(const QString& time) const
+{
+    bool ok = false;
+    int result = time.toInt(&ok);
+    if (ok)
+        return result;
+    // Clock values look like "00:00:04.160" and SMPTE like "00:00:04:04".
+    QStringList parts = time.split(':');
+    if (parts.size() < 3)
+        return -1;
+    double seconds = parts[0].toInt() * 3600 + parts[1].toInt() * 60 + parts[2].toDouble();
+    if (parts.size() > 3)
+        return qRound(seconds * m_fps) + parts[3].toInt();
+    return qRound(seconds * m_fps);
+}
+
+int ProjectPackager::shiftOf(const QString& producerId) const
+{
+    if (producerId.isEmpty() || !m_producers.contains(producerId))
+        return 0;
+    const Producer& producer = m_producers[producerId];
+    if (!isTrimmableService(producer.service))
+        return 0;
+    const Media* media = mediaOf(producer.resource);
+    return (media && media->isTrimmed)? media->shift : 0;
+}
+
+const ProjectPackager::Media* ProjectPackager::mediaOf(const QString& path) const
+{
+    if (path.isEmpty() || !m_keys.contains(path))
+        return nullptr;
+    auto i = m_media.constFind(m_keys[path]);
+    return (i == m_media.constEnd())? nullptr : &i.value();
+}
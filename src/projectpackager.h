@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROJECTPACKAGER_H
+#define PROJECTPACKAGER_H
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+/*!
+  \class ProjectPackager
+  \brief Collects a project and the files it uses into one folder.
+
+  The saved project XML is read once to find every file that a producer,
+  filter or transition refers to, and the frames of each producer that
+  the playlists and tracks use. Files are hashed in parallel, and those
+  with the same hash and size are compared byte for byte so that files
+  with the same content are collected once. They are hard linked into the
+  media folder of the package when it is on the same volume and copied
+  otherwise, a few at a time so that the disks are not overwhelmed.
+
+  A long video that is only partly used can be trimmed to the used span
+  plus handles with a stream copy, which needs its SeekIndex so that the
+  copy starts on a keyframe at a known frame. The index is built while
+  analyzing when the media does not have one yet. The project is then
+  written to the package in a single pass with the paths made relative
+  and the in and out points of the trimmed producers, their entries and
+  their filters shifted. Transitions and track filters keep theirs.
+*/
+
+class ProjectPackager
+{
+    Q_DECLARE_TR_FUNCTIONS(ProjectPackager)
+
+public:
+    ProjectPackager(const QString& xml, const QString& folder, const QString& projectName, bool trim);
+
+    bool analyze(const std::function<bool()>& isCanceled);
+    bool collect(const std::function<void(int)>& progress, const std::function<bool()>& isCanceled);
+    bool writeProject();
+
+    QString projectPath() const;
+    QString errorString() const { return m_errorString; }
+    QString report() const;
+
+private:
+    struct Media {
+        QString path;           // absolute path of the source file
+        QString hash;
+        qint64 size;
+        QString target;         // path relative to the package folder
+        bool isTrimmable;       // only used by plain avformat producers
+        int usedIn;             // first and last used frame, -1 when unknown
+        int usedOut;
+        int shift;              // frames cut from the start when trimmed
+        int length;             // frames in the trimmed file
+        bool isTrimmed;
+        bool isLinked;
+        qint64 usedBytes;       // from the seek index, -1 when unknown
+    };
+
+    struct Producer {
+        QString service;
+        QString resource;       // the file of the resource property
+        QStringList files;      // all files, including those of its filters
+        bool isWhole;           // used as a whole, such as by a track
+        int in;
+        int out;
+    };
+
+    void planTrim(Media& media, const std::function<bool()>& isCanceled);
+    bool isSameContent(const QString& a, const QString& b, const std::function<bool()>& isCanceled) const;
+    bool collectOne(Media& media, const std::function<void(qint64)>& addBytes,
+                    const std::function<bool()>& isCanceled);
+    bool trim(const Media& media, const QString& targetPath, const std::function<bool()>& isCanceled);
+    bool link(const QString& source, const QString& targetPath);
+    bool copy(const QString& source, const QString& targetPath, const std::function<void(qint64)>& addBytes,
+              const std::function<bool()>& isCanceled);
+    int frames(const QString& time) const;
+    int shiftOf(const QString& producerId) const;
+    const Media* mediaOf(const QString& path) const;
+
+    QString m_xml;
+    QString m_folder;
+    QString m_projectName;
+    bool m_isTrimEnabled;
+    double m_fps;
+    QHash<QString, Producer> m_producers;  // by producer id
+    QHash<QString, QString> m_keys;        // source path to media key
+    QHash<QString, Media> m_media;         // by content hash and size
+    QString m_errorString;
+    int m_duplicates;
+};
+
+#endif // PROJECTPACKAGER_H
@@ -412,30 +412,37 @@ bool ProxyManager::filePending(Mlt::Producer& producer)
     return (projectDir.cd("proxies") && projectDir.exists(fileName)) || proxyDir.exists(fileName);
 }
 
+// Points the producer at its proxy file, which must exist
+bool ProxyManager::useProxy(Mlt::Producer& producer)
+{
+    QDir proxyDir(Settings.proxyFolder());
+    QDir projectDir(MLT.projectFolder());
+    QString service = QString::fromLatin1(producer.get("mlt_service"));
+    QString fileName;
+    if (service.startsWith("avformat")) {
+        fileName = Util::getHash(producer) + kProxyVideoExtension;
+    } else if (isValidImage(producer)) {
+        fileName = Util::getHash(producer) + kProxyImageExtension;
+    } else {
+        return false;
+    }
+    producer.set(kIsProxyProperty, 1);
+    producer.set(kOriginalResourceProperty, producer.get("resource"));
+    if (projectDir.exists(fileName)) {
+        producer.set("resource", projectDir.filePath(fileName).toUtf8().constData());
+    } else {
+        producer.set("resource", proxyDir.filePath(fileName).toUtf8().constData());
+    }
+    return true;
+}
+
 // Returns true if the producer exists and was updated with proxy info
 bool ProxyManager::generateIfNotExists(Mlt::Producer& producer, bool replace)
 {
     if (Settings.proxyEnabled() && producer.is_valid() && !producer.get_int(kDisableProxyProperty) && !producer.get_int(kIsProxyProperty)) {
         QString service = QString::fromLatin1(producer.get("mlt_service"));
         if (ProxyManager::fileExists(producer)) {
-            QDir proxyDir(Settings.proxyFolder());
-            QDir projectDir(MLT.projectFolder());
-            QString fileName;
-            if (service.startsWith("avformat")) {
-                fileName = Util::getHash(producer) + kProxyVideoExtension;
-            } else if (isValidImage(producer)) {
-                fileName = Util::getHash(producer) + kProxyImageExtension;
-            } else {
-                return false;
-            }
-            producer.set(kIsProxyProperty, 1);
-            producer.set(kOriginalResourceProperty, producer.get("resource"));
-            if (projectDir.exists(fileName)) {
-                producer.set("resource", projectDir.filePath(fileName).toUtf8().constData());
-            } else {
-                producer.set("resource", proxyDir.filePath(fileName).toUtf8().constData());
-            }
-            return true;
+            return ProxyManager::useProxy(producer);
         } else if (!filePending(producer)) {
             if (service.startsWith("avformat")) {
                 // Tag this producer so we do not try to generate proxy again in this session
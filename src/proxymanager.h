@@ -49,6 +49,7 @@ public:
     static bool fileExists(Mlt::Producer& producer);
     static bool filePending(Mlt::Producer& producer);
     static bool generateIfNotExists(Mlt::Producer& producer, bool replace = true);
+    static bool useProxy(Mlt::Producer& producer);
     static const char* videoFilenameExtension();
     static const char* pendingVideoExtension();
     static const char* imageFilenameExtension();
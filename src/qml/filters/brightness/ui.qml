@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018 Meltytech, LLC
+ * Copyright (c) 2016-2020 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -28,7 +28,17 @@ Item {
     property double middleValue: 1.0
     property double endValue: 1.0
 
-    Component.onCompleted: {
+    Component.onCompleted: loadFilter()
+
+    // Called when this panel is reused for another filter.
+    function rebind() {
+        filter.loadPresets()
+        startValue = middleValue = endValue = 1.0
+        loadFilter()
+        brightnessKeyframesButton.checked = filter.animateIn <= 0 && filter.animateOut <= 0 && filter.keyframeCount('level') > 0
+    }
+
+    function loadFilter() {
         if (filter.isNew) {
             // Set default parameter values
             filter.set('level', 1.0)
@@ -28,7 +28,18 @@ Item {
     width: 620
     height: 350
 
-    Component.onCompleted: {
+    Component.onCompleted: loadFilter()
+
+    // Called when this panel is reused for another filter.
+    function rebind() {
+        filter.loadPresets()
+        loadFilter()
+        liftKeyframesButton.checked = filter.keyframeCount('lift_r') > 0
+        gammaKeyframesButton.checked = filter.keyframeCount('gamma_r') > 0
+        gainKeyframesButton.checked = filter.keyframeCount('gain_r') > 0
+    }
+
+    function loadFilter() {
         if (filter.isNew) {
             // Set default parameter values
             filter.set("lift_r", 0.0);
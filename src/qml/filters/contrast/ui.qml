@@ -31,7 +31,17 @@ Item {
     width: 200
     height: 50
     
-    Component.onCompleted: {
+    Component.onCompleted: loadFilter()
+
+    // Called when this panel is reused for another filter.
+    function rebind() {
+        filter.loadPresets()
+        startValue = middleValue = endValue = 0.5
+        loadFilter()
+        keyframesButton.checked = filter.animateIn <= 0 && filter.animateOut <= 0 && filter.keyframeCount('gain_r') > 0
+    }
+
+    function loadFilter() {
         if (filter.isNew) {
             // Set default parameter values
             filter.set("gamma_r", 1.0);
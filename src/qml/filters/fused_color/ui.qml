@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+import QtQuick 2.1
+import QtQuick.Controls 1.1
+import QtQuick.Layouts 1.0
+import org.shotcut.qml 1.0 as Shotcut
+
+Item {
+    width: 350
+    height: 100
+
+    SystemPalette { id: activePalette; colorGroup: SystemPalette.Active }
+    Shotcut.File { id: lutFile }
+
+    Component.onCompleted: {
+        lutFile.url = filter.get('av.file')
+        if (!lutFile.exists()) {
+            statusLabel.text = qsTr('The combined color table is missing. Split the filters to restore them.')
+            statusLabel.color = 'red'
+        }
+    }
+
+    ColumnLayout {
+        anchors.fill: parent
+        anchors.margins: 8
+
+        Label {
+            text: qsTr('Combined: %1').arg(filter.get('shotcut:fusedCaption'))
+            wrapMode: Text.WordWrap
+            Layout.fillWidth: true
+        }
+        Label {
+            id: statusLabel
+            wrapMode: Text.WordWrap
+            Layout.fillWidth: true
+        }
+        Button {
+            text: qsTr('Split')
+            tooltip: qsTr('Replace the combined filter with the filters it was made from')
+            onClicked: attachedfiltersmodel.unfuseColorFilters()
+        }
+        Item {
+            Layout.fillHeight: true
+        }
+    }
+}
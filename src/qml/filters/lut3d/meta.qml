@@ -21,6 +21,6 @@ import org.shotcut.qml 1.0
 Metadata {
     type: Metadata.Filter
     name: qsTr("LUT (3D)")
-    mlt_service: 'avfilter.lut3d'
+    mlt_service: 'shotcut.lut3d'
     qml: 'ui.qml'
 }
@@ -83,6 +83,9 @@ Item {
             filter.set("reload", 1);
             setStatus(false)
         }
+        // Stored motion makes analyzing a trimmed clip again quick.
+        onInChanged: analyzeValueChanged()
+        onOutChanged: analyzeValueChanged()
     }
     
     FileDialog {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014-2019 Meltytech, LLC
+ * Copyright (c) 2014-2020 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -27,17 +27,25 @@ Rectangle {
     
     function clearCurrentFilter() {
         if (filterConfig.item) {
-            filterConfig.item.width = 1
-            filterConfig.item.height = 1
+            var item = filterConfig.item
+            filterConfig.item = null
+            item.width = 1
+            item.height = 1
+            panelPool.release(item)
         }
-        filterConfig.source = ""
     }
     
     function setCurrentFilter(index) {
         clearCurrentFilter()
         attachedFilters.setCurrentFilter(index)
         selectedIndex = index
-        filterConfig.source = metadata ? metadata.qmlFilePath : ""
+        if (metadata) {
+            filterConfig.item = panelPool.acquire(metadata.qmlFilePath, filter, metadata, filterConfig)
+            if (filterConfig.item) {
+                filterConfig.minimumWidth = filterConfig.item.width
+                filterConfigScrollView.expandWidth()
+            }
+        }
     }
 
     function openFilterMenu() {
@@ -96,7 +104,7 @@ Rectangle {
 
     GridLayout {
         id: attachedContainer
-        columns: 6
+        columns: 7
         anchors {
             top: titleBackground.bottom
             left: parent.left
@@ -108,7 +116,7 @@ Rectangle {
 
         AttachedFilters {
             id: attachedFilters
-            Layout.columnSpan: 6
+            Layout.columnSpan: 7
             Layout.fillWidth: true
             Layout.fillHeight: true
             onFilterClicked: {
@@ -167,6 +175,16 @@ Rectangle {
             tooltip: qsTr('Paste filters')
             onClicked: application.pasteFilters()
         }
+        Button {
+            id: combineButton
+            Layout.minimumWidth: height
+            enabled: attachedfiltersmodel.isProducerSelected
+            opacity: enabled ? 1.0 : 0.5
+            iconName: 'merge'
+            iconSource: 'qrc:///icons/oxygen/32x32/actions/merge.png'
+            tooltip: qsTr('Combine adjacent color filters into one for faster playback')
+            onClicked: attachedfiltersmodel.fuseColorFilters()
+        }
         Item {
             Layout.fillWidth: true
         }
@@ -182,14 +200,13 @@ Rectangle {
             }
         }
         onWidthChanged: expandWidth()
-        Loader {
+        Item {
             id: filterConfig
             enabled: !filterMenu.visible
             property int minimumWidth: 0
-            onLoaded: {
-                minimumWidth = item.width
-                filterConfigScrollView.expandWidth()
-            }
+            property Item item: null
+            width: item ? item.width : 0
+            height: item ? item.height : 0
         }
     }
         
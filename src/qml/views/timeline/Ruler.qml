@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2019 Meltytech, LLC
+ * Copyright (c) 2013-2020 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -49,6 +49,18 @@ Rectangle {
         }
     }
 
+    // Frames outside broadcast limits found by the broadcast QC job.
+    Repeater {
+        model: timeline.qcRegions
+        Rectangle {
+            anchors.top: rulerTop.top
+            height: 4
+            width: Math.max(1, (modelData.end - modelData.start + 1) * timeScale)
+            x: modelData.start * timeScale
+            color: modelData.video ? 'red' : 'orange'
+        }
+    }
+
     Connections {
         target: profile
         onProfileChanged: {
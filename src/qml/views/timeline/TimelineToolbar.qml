@@ -176,19 +176,19 @@ ToolBar {
 
     Action {
         id: copyAction
-        tooltip: qsTr('Copy - Copy the current clip to the Source player (C)')
+        tooltip: qsTr('Copy - Copy the current clip to the Source player (C)\nor several selected clips for pasting with Ctrl+V')
         iconName: 'edit-copy'
         iconSource: 'qrc:///icons/oxygen/32x32/actions/edit-copy.png'
         enabled: timeline.selection.length
-        onTriggered: timeline.copyClip(timeline.selection[0].y, timeline.selection[0].x)
+        onTriggered: timeline.copySelection()
     }
 
     Action {
         id: insertAction
-        tooltip: qsTr('Paste - Insert clip into the current track\nshifting following clips to the right (V)')
+        tooltip: qsTr('Paste - Insert clip into the current track\nshifting following clips to the right (V)\nor the copied clips at the playhead (Ctrl+V)')
         iconName: 'edit-paste'
         iconSource: 'qrc:///icons/oxygen/32x32/actions/edit-paste.png'
-        onTriggered: timeline.insert(currentTrack)
+        onTriggered: timeline.pasteClipboard(currentTrack)
     }
 
     Action {
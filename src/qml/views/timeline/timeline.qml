@@ -483,6 +483,24 @@ Rectangle {
             shortcut: 'Ctrl+Alt+C'
             onTriggered: timeline.copyToSource()
         }
+        MenuItem {
+            enabled: timeline.selection.length > 1
+            text: qsTr('Synchronize Selected Clips by Audio')
+            onTriggered: timeline.syncSelectionByAudio()
+        }
+        MenuItem {
+            text: qsTr('Measure Program Loudness')
+            onTriggered: timeline.measureLoudness()
+        }
+        MenuItem {
+            text: qsTr('Analyze Broadcast Safety')
+            onTriggered: timeline.analyzeBroadcastSafety()
+        }
+        MenuItem {
+            visible: timeline.qcRegions.length > 0
+            text: qsTr('Clear Broadcast Safety Marks')
+            onTriggered: timeline.clearQcRegions()
+        }
         MenuSeparator {}
         MenuItem {
             enabled: multitrack.trackHeight > 10
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "filterpanelpool.h"
+#include "qmlfilter.h"
+#include "qmlmetadata.h"
+#include "qmlproducer.h"
+#include <QQmlComponent>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <Logger.h>
+
+// Keep at most this many released panels.
+static const int kMaxIdlePanels = 8;
+
+FilterPanelPool::FilterPanelPool(QQmlContext* context, QObject* producer, QObject* parent)
+    : QObject(parent)
+    , m_context(context)
+    , m_producer(producer)
+    , m_idleFilter(new QmlFilter)
+    , m_idleMetadata(new QmlMetadata)
+    , m_idleProducer(new QmlProducer)
+{
+}
+
+FilterPanelPool::~FilterPanelPool()
+{
+    clear();
+}
+
+QQuickItem* FilterPanelPool::acquire(const QUrl& url, QObject* filter, QObject* metadata, QQuickItem* parent)
+{
+    Panel panel = {0, 0, url, QSizeF()};
+    bool isReused = false;
+    for (int i = 0; i < m_idle.size(); ++i) {
+        if (m_idle[i].url == url) {
+            panel = m_idle.takeAt(i);
+            isReused = true;
+            break;
+        }
+    }
+
+    if (isReused) {
+        setContextProperties(panel, filter, metadata, m_producer);
+        // Restore the size from before the view stretched it.
+        panel.item->setSize(panel.size);
+        panel.item->setParentItem(parent);
+        panel.item->setVisible(true);
+        QMetaObject::invokeMethod(panel.item, "rebind");
+    } else {
+        panel.context = new QQmlContext(m_context, this);
+        setContextProperties(panel, filter, metadata, m_producer);
+        if (!create(url, panel)) {
+            delete panel.context;
+            return 0;
+        }
+        panel.item->setParentItem(parent);
+    }
+    m_active << panel;
+    return panel.item;
+}
+
+void FilterPanelPool::release(QQuickItem* item)
+{
+    for (int i = 0; i < m_active.size(); ++i) {
+        if (m_active[i].item == item) {
+            Panel panel = m_active.takeAt(i);
+            if (isPoolable(item)) {
+                // Detach the panel from the filter and player while it waits.
+                // Null would make its live bindings throw TypeErrors.
+                item->setVisible(false);
+                item->setParentItem(0);
+                setContextProperties(panel, m_idleFilter.data(), m_idleMetadata.data(), m_idleProducer.data());
+                if (m_idle.size() >= kMaxIdlePanels) {
+                    destroy(m_idle.first());
+                    m_idle.removeFirst();
+                }
+                m_idle << panel;
+            } else {
+                destroy(panel);
+            }
+            return;
+        }
+    }
+}
+
+bool FilterPanelPool::isPoolable(QQuickItem* item)
+{
+    return item && item->metaObject()->indexOfMethod("rebind()") >= 0;
+}
+
+void FilterPanelPool::preload(const QUrl& url)
+{
+    if (!url.isEmpty() && !m_components.contains(url)) {
+        LOG_DEBUG() << "compiling" << url.toLocalFile();
+        m_components.insert(url, new QQmlComponent(m_context->engine(), url, QQmlComponent::Asynchronous, this));
+    }
+}
+
+void FilterPanelPool::clear()
+{
+    for (int i = 0; i < m_active.size(); ++i)
+        destroy(m_active[i]);
+    for (int i = 0; i < m_idle.size(); ++i)
+        destroy(m_idle[i]);
+    m_active.clear();
+    m_idle.clear();
+}
+
+QQmlComponent* FilterPanelPool::component(const QUrl& url)
+{
+    QQmlComponent* result = m_components.value(url);
+    if (result && result->isLoading()) {
+        // Still compiling in the background, but it is needed now.
+        result->deleteLater();
+        result = 0;
+    }
+    if (!result) {
+        result = new QQmlComponent(m_context->engine(), url, QQmlComponent::PreferSynchronous, this);
+        m_components.insert(url, result);
+    }
+    return result;
+}
+
+bool FilterPanelPool::create(const QUrl& url, Panel& panel)
+{
+    QQmlComponent* component = this->component(url);
+    if (!component->isReady()) {
+        LOG_WARNING() << component->errorString();
+        return false;
+    }
+    QObject* object = component->beginCreate(panel.context);
+    panel.item = qobject_cast<QQuickItem*>(object);
+    if (!panel.item) {
+        delete object;
+        return false;
+    }
+    // The view must not garbage collect a panel that is kept in the pool.
+    QQmlEngine::setObjectOwnership(panel.item, QQmlEngine::CppOwnership);
+    component->completeCreate();
+    panel.size = panel.item->size();
+    return true;
+}
+
+void FilterPanelPool::setContextProperties(Panel& panel, QObject* filter, QObject* metadata, QObject* producer)
+{
+    panel.context->setContextProperty("filter", filter);
+    panel.context->setContextProperty("metadata", metadata);
+    panel.context->setContextProperty("producer", producer);
+}
+
+void FilterPanelPool::destroy(Panel& panel)
+{
+    // Delete the item now, while its filter still exists, and before the
+    // context that its bindings use.
+    panel.item->setParentItem(0);
+    delete panel.item;
+    delete panel.context;
+    panel.item = 0;
+    panel.context = 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILTERPANELPOOL_H
+#define FILTERPANELPOOL_H
+
+#include <QObject>
+#include <QHash>
+#include <QScopedPointer>
+#include <QList>
+#include <QSizeF>
+#include <QUrl>
+
+class QQmlComponent;
+class QQmlContext;
+class QQuickItem;
+class QmlFilter;
+class QmlMetadata;
+class QmlProducer;
+
+/*!
+  \class FilterPanelPool
+  \brief Caches the compiled filter panels and keeps released panels for reuse.
+
+  Panels are created from a QQmlComponent that is compiled once per ui.qml
+  file and get their own context with the filter, metadata and producer
+  properties. A released panel that declares a rebind() function is kept
+  instead of destroyed, and the next request for the same file sets the new
+  filter on its context and calls rebind() to load its controls again.
+
+  Only panels with rebind() are pooled; any other panel is destroyed as
+  soon as it is released, before its filter goes away. A kept panel's
+  bindings stay live, so while it waits its context points at an inert
+  filter, metadata and producer instead of null.
+*/
+
+class FilterPanelPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    FilterPanelPool(QQmlContext* context, QObject* producer, QObject* parent = 0);
+    ~FilterPanelPool();
+
+    Q_INVOKABLE QQuickItem* acquire(const QUrl& url, QObject* filter, QObject* metadata, QQuickItem* parent);
+    Q_INVOKABLE void release(QQuickItem* item);
+    //! Starts compiling a panel in the background if it is not cached.
+    void preload(const QUrl& url);
+    //! Destroys all of the panels but keeps the compiled components.
+    void clear();
+    static bool isPoolable(QQuickItem* item);
+
+private:
+    struct Panel {
+        QQuickItem* item;
+        QQmlContext* context;
+        QUrl url;
+        QSizeF size;
+    };
+
+    QQmlComponent* component(const QUrl& url);
+    bool create(const QUrl& url, Panel& panel);
+    void setContextProperties(Panel& panel, QObject* filter, QObject* metadata, QObject* producer);
+    void destroy(Panel& panel);
+
+    QQmlContext* m_context;
+    QObject* m_producer;
+    QHash<QUrl, QQmlComponent*> m_components;
+    QList<Panel> m_active;
+    QList<Panel> m_idle;
+    QScopedPointer<QmlFilter> m_idleFilter;
+    QScopedPointer<QmlMetadata> m_idleMetadata;
+    QScopedPointer<QmlProducer> m_idleProducer;
+};
+
+#endif // FILTERPANELPOOL_H
@@ -25,6 +25,7 @@
 #include "settings.h"
 #include "util.h"
 #include "proxymanager.h"
+#include "motionstore.h"
 #include <Logger.h>
 
 #include <QDir>
@@ -322,6 +323,15 @@ void QmlFilter::deletePreset(const QString &name)
 
 void QmlFilter::analyze(bool isAudio)
 {
+    if (!isAudio && !qstrcmp(m_filter.get("mlt_service"), "vidstab")
+            && m_filter.get_data("service")) {
+        Mlt::Producer producer(mlt_producer(m_filter.get_data("service")));
+        QString storePath = MotionStore::path(producer, m_filter);
+        if (!storePath.isEmpty()) {
+            analyzeMotion(producer, storePath);
+            return;
+        }
+    }
     Mlt::Service service(mlt_service(m_filter.get_data("service")));
 
     // get temp filename for input xml
@@ -386,6 +396,100 @@ void QmlFilter::analyze(bool isAudio)
     }
 }
 
+void QmlFilter::analyzeMotion(Mlt::Producer& producer, const QString& storePath)
+{
+    QString filename(m_filter.get("filename"));
+    int filterIn = in();
+    int filterOut = out();
+    QList<MotionStore::Range> ranges = MotionStore::missing(storePath, filterIn, filterOut);
+
+    AnalyzeDelegate* delegate = new AnalyzeDelegate(m_filter);
+    connect(delegate, &AnalyzeDelegate::motionAnalyzed, this, &QmlFilter::analyzeFinished);
+    delegate->setMotionStore(storePath, filterIn, filterOut, filename);
+    if (ranges.isEmpty()) {
+        LOG_INFO() << "reusing the stored motion of frames" << filterIn << "to" << filterOut;
+        delegate->finishMotion();
+        return;
+    }
+
+    QScopedPointer<QTemporaryFile> tmp(Util::writableTemporaryFile(filename));
+    tmp->open();
+    tmp->close();
+    m_filter.set("results", nullptr, 0);
+    int disable = m_filter.get_int("disable");
+    m_filter.set("disable", 0);
+    m_filter.set("analyze", 1);
+    MLT.saveXML(tmp->fileName(), &producer, false /* without relative paths */, false /* without verify */);
+    m_filter.set("analyze", 0);
+    m_filter.set("disable", disable);
+    QFile f1(tmp->fileName());
+    f1.open(QIODevice::ReadOnly);
+    QDomDocument source(tmp->fileName());
+    source.setContent(&f1);
+    f1.close();
+
+    foreach (const MotionStore::Range& range, ranges) {
+        // Start a frame early because the first frame analyzed has no motion.
+        int first = qMax(0, range.first - 1);
+        QScopedPointer<QTemporaryFile> results(Util::writableTemporaryFile(filename, "shotcut-XXXXXX.trf"));
+        results->open();
+        results->close();
+        results->setAutoRemove(false);
+        QScopedPointer<QTemporaryFile> tmpTarget(Util::writableTemporaryFile(filename));
+        tmpTarget->open();
+        tmpTarget->close();
+
+        // Analyze only the range by trimming the producer and the filter.
+        QDomDocument dom = source.cloneNode(true).toDocument();
+        QDomNodeList producers = dom.elementsByTagName("producer");
+        for (int i = 0; i < producers.size(); i++) {
+            producers.at(i).toElement().setAttribute("in", first);
+            producers.at(i).toElement().setAttribute("out", range.second);
+        }
+        QDomNodeList filters = dom.elementsByTagName("filter");
+        for (int i = 0; i < filters.size(); i++) {
+            QDomElement filterNode = filters.at(i).toElement();
+            QDomNodeList properties = filterNode.elementsByTagName("property");
+            QDomElement filenameNode;
+            bool found = false;
+            for (int j = 0; j < properties.size(); j++) {
+                QDomElement propertyNode = properties.at(j).toElement();
+                QString name = propertyNode.attribute("name");
+                if (name == "mlt_service" && propertyNode.text() == "vidstab")
+                    found = true;
+                else if (name == "filename")
+                    filenameNode = propertyNode;
+            }
+            if (found && !filenameNode.isNull()) {
+                filterNode.setAttribute("in", first);
+                filterNode.setAttribute("out", range.second);
+                while (filenameNode.hasChildNodes())
+                    filenameNode.removeChild(filenameNode.firstChild());
+                filenameNode.appendChild(dom.createTextNode(results->fileName()));
+            }
+        }
+        QDomElement consumerNode = dom.createElement("consumer");
+        QDomNodeList profiles = dom.elementsByTagName("profile");
+        if (profiles.isEmpty())
+            dom.documentElement().insertAfter(consumerNode, dom.documentElement());
+        else
+            dom.documentElement().insertAfter(consumerNode, profiles.at(profiles.length() - 1));
+        consumerNode.setAttribute("mlt_service", "xml");
+        consumerNode.setAttribute("all", 1);
+        consumerNode.setAttribute("audio_off", 1);
+        consumerNode.setAttribute("no_meta", 1);
+        consumerNode.setAttribute("resource", tmpTarget->fileName());
+
+        AbstractJob* job = new MeltJob(tmpTarget->fileName(), dom.toString(2),
+            MLT.profile().frame_rate_num(), MLT.profile().frame_rate_den());
+        job->setLabel(tr("Analyze %1 (%2 - %3)").arg(Util::baseName(ProxyManager::resource(producer)))
+                      .arg(QString(producer.frames_to_time(first, mlt_time_clock)))
+                      .arg(QString(producer.frames_to_time(range.second, mlt_time_clock))));
+        delegate->addMotionJob(job, first, range.first - first, results->fileName());
+        JOBS.add(job);
+    }
+}
+
 int QmlFilter::framesFromTime(const QString &time)
 {
     if (MLT.producer()) {
@@ -639,6 +743,9 @@ AnalyzeDelegate::AnalyzeDelegate(Mlt::Filter& filter)
     : QObject(0)
     , m_uuid(QUuid::createUuid())
     , m_serviceName(filter.get("mlt_service"))
+    , m_in(0)
+    , m_out(-1)
+    , m_isMotionFailed(false)
 {
     filter.set(kShotcutHashProperty, m_uuid.toByteArray().data());
 }
@@ -740,38 +847,8 @@ void AnalyzeDelegate::onAnalyzeFinished(AbstractJob *job, bool isSuccess)
 
     if (isSuccess) {
         QString results = resultsFromXml(fileName, m_serviceName);
-        if (!results.isEmpty()) {
-            // look for filters by UUID in each pending export job.
-            foreach (AbstractJob* job, JOBS.jobs()) {
-                if (!job->ran() && typeid(*job) == typeid(EncodeJob)) {
-                    updateJob(dynamic_cast<EncodeJob*>(job), results);
-                }
-            }
-    
-            // Locate filters in memory by UUID.
-            FindFilterParser graphParser(m_uuid);
-            if (MAIN.isMultitrackValid()) {
-                graphParser.start(*MAIN.multitrack());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            if (MAIN.playlist() && MAIN.playlist()->count() > 0) {
-                graphParser.start(*MAIN.playlist());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            if (MLT.producer() && MLT.producer()->is_valid()) {
-                graphParser.start(*MLT.producer());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            if (MLT.savedProducer() && MLT.savedProducer()->is_valid()) {
-                graphParser.start(*MLT.savedProducer());
-                foreach (Mlt::Filter filter, graphParser.filters())
-                    updateFilter(filter, results);
-            }
-            emit MAIN.filterController()->attachedModel()->changed();
-        }
+        if (!results.isEmpty())
+            updateResults(results);
     } else if (!job->property("filename").isNull()) {
         QFile file(job->property("filename").toString());
         if (file.exists() && file.size() == 0)
@@ -781,6 +858,78 @@ void AnalyzeDelegate::onAnalyzeFinished(AbstractJob *job, bool isSuccess)
     deleteLater();
 }
 
+void AnalyzeDelegate::setMotionStore(const QString& storePath, int in, int out, const QString& resultsPath)
+{
+    m_storePath = storePath;
+    m_in = in;
+    m_out = out;
+    m_resultsPath = resultsPath;
+}
+
+void AnalyzeDelegate::addMotionJob(AbstractJob* job, int first, int skip, const QString& resultsPath)
+{
+    MotionJob motionJob = {first, skip, resultsPath};
+    m_motionJobs.insert(job, motionJob);
+    connect(job, &AbstractJob::finished, this, &AnalyzeDelegate::onMotionAnalyzeFinished);
+}
+
+void AnalyzeDelegate::finishMotion()
+{
+    bool isSuccess = !m_isMotionFailed
+            && MotionStore::extract(m_storePath, m_in, m_out, m_resultsPath);
+    if (isSuccess)
+        updateResults(m_resultsPath);
+    else
+        LOG_WARNING() << "failed to write the motion of frames" << m_in << "to" << m_out << "to" << m_resultsPath;
+    emit motionAnalyzed(isSuccess);
+    deleteLater();
+}
+
+void AnalyzeDelegate::onMotionAnalyzeFinished(AbstractJob* job, bool isSuccess)
+{
+    MotionJob motionJob = m_motionJobs.take(job);
+    if (!isSuccess || !MotionStore::merge(m_storePath, motionJob.resultsPath, motionJob.first, motionJob.skip))
+        m_isMotionFailed = true;
+    QFile::remove(motionJob.resultsPath);
+    QFile::remove(job->objectName());
+    if (m_motionJobs.isEmpty())
+        finishMotion();
+}
+
+void AnalyzeDelegate::updateResults(const QString& results)
+{
+    // look for filters by UUID in each pending export job.
+    foreach (AbstractJob* job, JOBS.jobs()) {
+        if (!job->ran() && typeid(*job) == typeid(EncodeJob)) {
+            updateJob(dynamic_cast<EncodeJob*>(job), results);
+        }
+    }
+
+    // Locate filters in memory by UUID.
+    FindFilterParser graphParser(m_uuid);
+    if (MAIN.isMultitrackValid()) {
+        graphParser.start(*MAIN.multitrack());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+    if (MAIN.playlist() && MAIN.playlist()->count() > 0) {
+        graphParser.start(*MAIN.playlist());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+    if (MLT.producer() && MLT.producer()->is_valid()) {
+        graphParser.start(*MLT.producer());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+    if (MLT.savedProducer() && MLT.savedProducer()->is_valid()) {
+        graphParser.start(*MLT.savedProducer());
+        foreach (Mlt::Filter filter, graphParser.filters())
+            updateFilter(filter, results);
+    }
+    emit MAIN.filterController()->attachedModel()->changed();
+}
+
 QString AnalyzeDelegate::resultsFromXml(const QString& fileName, const QString& serviceName)
 {
     // parse the xml
@@ -23,6 +23,7 @@
 #include <QVariant>
 #include <QRectF>
 #include <QUuid>
+#include <QMap>
 #include <MltFilter.h>
 #include <MltProducer.h>
 #include <MltAnimation.h>
@@ -133,6 +134,7 @@ private:
     
     QString objectNameOrService();
     int keyframeIndex(Mlt::Animation& animation, int position);
+    void analyzeMotion(Mlt::Producer& producer, const QString& storePath);
 };
 
 class AnalyzeDelegate : public QObject
@@ -140,11 +142,25 @@ class AnalyzeDelegate : public QObject
     Q_OBJECT
 public:
     explicit AnalyzeDelegate(Mlt::Filter& filter);
+    void setMotionStore(const QString& storePath, int in, int out, const QString& resultsPath);
+    void addMotionJob(AbstractJob* job, int first, int skip, const QString& resultsPath);
+    void finishMotion();
+
+signals:
+    void motionAnalyzed(bool isSuccess);
 
 public slots:
     void onAnalyzeFinished(AbstractJob *job, bool isSuccess);
+    void onMotionAnalyzeFinished(AbstractJob *job, bool isSuccess);
 
 private:
+    struct MotionJob {
+        int first;
+        int skip;
+        QString resultsPath;
+    };
+
+    void updateResults(const QString& results);
     QString resultsFromXml(const QString& fileName, const QString& serviceName);
     void updateFilter(Mlt::Filter& filter, const QString& results);
 #if LIBMLT_VERSION_INT >= MLT_VERSION_CPP_UPDATED
@@ -155,6 +171,12 @@ private:
 #else
     Mlt::Filter m_filter;
 #endif
+    QString m_storePath;
+    QString m_resultsPath;
+    int m_in;
+    int m_out;
+    QMap<AbstractJob*, MotionJob> m_motionJobs;
+    bool m_isMotionFailed;
 };
 
 #endif // FILTER_H
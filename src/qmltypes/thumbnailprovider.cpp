@@ -18,18 +18,31 @@
 #include "thumbnailprovider.h"
 #include <QQuickImageProvider>
 #include <QCryptographicHash>
+#include <QFileInfo>
+#include <QMutexLocker>
 #include "mltcontroller.h"
 #include "models/playlistmodel.h"
 #include "database.h"
+#include "seekindex.h"
 
 #include <Logger.h>
 
+// Keeping a few producers open lets the next thumbnail of the same media
+// decode forward from the last one instead of opening and seeking again.
+static const int kMaxProducers = 4;
+
 ThumbnailProvider::ThumbnailProvider()
     : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
     , m_profile("atsc_720p_60")
 {
 }
 
+ThumbnailProvider::~ThumbnailProvider()
+{
+    for (int i = 0; i < m_producers.size(); ++i)
+        delete m_producers[i].second;
+}
+
 QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
     QImage result;
@@ -62,10 +75,11 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
                 service = "avformat";
             else if (service.startsWith("xml"))
                 service = "xml-nogl";
-            Mlt::Producer producer(m_profile, service.toUtf8().constData(), resource.toUtf8().constData());
-            if (producer.is_valid()) {
-                result = makeThumbnail(producer, frameNumber, requestedSize);
+            Mlt::Producer* producer = takeProducer(service, resource, hash);
+            if (producer) {
+                result = makeThumbnail(*producer, frameNumber, requestedSize);
                 DB.putThumbnail(key, result);
+                keepProducer(service, resource, producer);
             }
         }
     }
@@ -102,9 +116,6 @@ QString ThumbnailProvider::cacheKey(Mlt::Properties& properties, const QString&
 
 QImage ThumbnailProvider::makeThumbnail(Mlt::Producer &producer, int frameNumber, const QSize& requestedSize)
 {
-    Mlt::Filter scaler(m_profile, "swscale");
-    Mlt::Filter padder(m_profile, "resize");
-    Mlt::Filter converter(m_profile, "avcolor_space");
     int height = PlaylistModel::THUMBNAIL_HEIGHT * 2;
     int width = PlaylistModel::THUMBNAIL_WIDTH * 2;
 
@@ -113,8 +124,41 @@ QImage ThumbnailProvider::makeThumbnail(Mlt::Producer &producer, int frameNumber
         height = requestedSize.height();
     }
 
-    producer.attach(scaler);
-    producer.attach(padder);
-    producer.attach(converter);
     return MLT.image(producer, frameNumber, width, height);
 }
+
+Mlt::Producer* ThumbnailProvider::takeProducer(const QString& service, const QString& resource, const QString& hash)
+{
+    QString key = service + '/' + resource;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int i = m_producers.size() - 1; i >= 0; --i) {
+            if (m_producers[i].first == key)
+                return m_producers.takeAt(i).second;
+        }
+    }
+    Mlt::Producer* producer = new Mlt::Producer(m_profile, service.toUtf8().constData(), resource.toUtf8().constData());
+    if (!producer->is_valid()) {
+        delete producer;
+        return 0;
+    }
+    Mlt::Filter scaler(m_profile, "swscale");
+    Mlt::Filter padder(m_profile, "resize");
+    Mlt::Filter converter(m_profile, "avcolor_space");
+    producer->attach(scaler);
+    producer->attach(padder);
+    producer->attach(converter);
+    // Proxies are named after the hash of their original, whose index does
+    // not describe them.
+    if (SeekIndex::isIndexable(*producer) && QFileInfo(resource).baseName() != hash)
+        SeekIndex::attach(*producer, SeekIndex::find(hash));
+    return producer;
+}
+
+void ThumbnailProvider::keepProducer(const QString& service, const QString& resource, Mlt::Producer* producer)
+{
+    QMutexLocker locker(&m_mutex);
+    m_producers.append(qMakePair(service + '/' + resource, producer));
+    while (m_producers.size() > kMaxProducers)
+        delete m_producers.takeFirst().second;
+}
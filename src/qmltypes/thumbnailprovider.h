@@ -20,6 +20,9 @@
 #define THUMBNAILPROVIDER_H
 
 #include <QQuickImageProvider>
+#include <QList>
+#include <QMutex>
+#include <QPair>
 #include <MltProducer.h>
 #include <MltProfile.h>
 
@@ -27,13 +30,19 @@ class ThumbnailProvider : public QQuickImageProvider
 {
 public:
     explicit ThumbnailProvider();
+    ~ThumbnailProvider();
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize);
 
 private:
     QString cacheKey(Mlt::Properties& properties, const QString& service,
                      const QString& resource, const QString& hash, int frameNumber);
     QImage makeThumbnail(Mlt::Producer&, int frameNumber, const QSize& requestedSize);
+    Mlt::Producer* takeProducer(const QString& service, const QString& resource, const QString& hash);
+    void keepProducer(const QString& service, const QString& resource, Mlt::Producer* producer);
     Mlt::Profile m_profile;
+    QMutex m_mutex;
+    // The most recently used producers, last, keyed by service and resource
+    QList<QPair<QString, Mlt::Producer*>> m_producers;
 };
 
 #endif // THUMBNAILPROVIDER_H
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "rendercache.h"
+#include "util.h"
+#include <QByteArray>
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDomDocument>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QString>
+#include <MltPlaylist.h>
+#include <MltTractor.h>
+#include <MltFilter.h>
+#include <string.h>
+
+static const int kMaxCacheKiB = 256 * 1024;
+static const char* kAttachedProperty = "_shotcut:renderCache";
+static const char* kCutProperty = "_shotcut:renderCacheCut";
+static const char* kKeyProperty = "_shotcut:renderCacheKey";
+
+namespace {
+
+struct CachedImage
+{
+    QByteArray image;
+    QByteArray alpha;
+    mlt_image_format format;
+    int width;
+    int height;
+};
+
+QCache<QByteArray, CachedImage> imageCache(kMaxCacheKiB);
+QMutex imageCacheMutex;
+// Whether each title document seen is animated, by its hash.
+QHash<QByteArray, bool> titleAnimation;
+QMutex titleAnimationMutex;
+
+// Services whose image does not depend on the frame position.
+const QSet<QString> staticProducers = QSet<QString>()
+    << "color" << "colour" << "qtext" << "kdenlivetitle";
+const QSet<QString> staticFilters = QSet<QString>()
+    << "dynamictext" << "qtext" << "affine" << "brightness" << "crop" << "qtcrop"
+    << "lift_gamma_gain" << "mask_start" << "mask_apply" << "qtblend" << "sepia"
+    << "invert" << "charcoal" << "frei0r.alpha0ps" << "frei0r.IIRblur" << "frei0r.sharpness"
+    << "frei0r.saturat0r" << "frei0r.coloradj_RGB" << "frei0r.letterb0xed"
+    << "frei0r.pixeliz0r" << "frei0r.contrast0r" << "frei0r.cairoblend"
+    << "frei0r.select0r" << "frei0r.colorize" << "frei0r.squareblur";
+// Audio filters do not change the image, so they are ignored.
+const QSet<QString> audioFilters = QSet<QString>()
+    << "volume" << "panner" << "channelcopy" << "mono" << "audiolevel";
+
+bool isAnimatedTitle(Mlt::Producer& producer)
+{
+    QByteArray xml = producer.get("xmldata");
+    QByteArray key = QCryptographicHash::hash(xml, QCryptographicHash::Md5);
+    QMutexLocker locker(&titleAnimationMutex);
+    auto i = titleAnimation.constFind(key);
+    if (i != titleAnimation.constEnd())
+        return i.value();
+    bool animated = RenderCache::isAnimatedTitle(QString::fromUtf8(xml));
+    titleAnimation.insert(key, animated);
+    return animated;
+}
+
+bool hashProperties(QCryptographicHash& hash, Mlt::Properties& properties)
+{
+    for (int i = 0; i < properties.count(); ++i) {
+        const char* name = properties.get_name(i);
+        if (!name || name[0] == '_')
+            continue;
+        const char* value = properties.get(i);
+        if (Util::isKeyframed(value))
+            return false;
+        // Text keywords such as #timecode# change with the position.
+        if ((!strcmp(name, "argument") || !strcmp(name, "text") || !strcmp(name, "html"))
+                && value && strchr(value, '#'))
+            return false;
+        hash.addData(name);
+        hash.addData("=", 1);
+        if (value)
+            hash.addData(value);
+        hash.addData("\n", 1);
+    }
+    return true;
+}
+
+// Returns an empty key if the image of the cut may change between frames.
+QByteArray stateKey(mlt_producer cut)
+{
+    mlt_producer parentProducer = mlt_producer_cut_parent(cut);
+    if (!parentProducer)
+        return QByteArray();
+    Mlt::Producer parent(parentProducer);
+    QString service = QString::fromLatin1(parent.get("mlt_service"));
+    if (service == "webvfx") {
+        // Only plain HTML; WebVfx pages are told the time to render.
+        if (!QString::fromUtf8(parent.get("resource")).startsWith("plain:"))
+            return QByteArray();
+    } else if (!staticProducers.contains(service)) {
+        return QByteArray();
+    } else if (service == "kdenlivetitle" && isAnimatedTitle(parent)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (!hashProperties(hash, parent))
+        return QByteArray();
+    int in = mlt_producer_get_in(cut);
+    int out = mlt_producer_get_out(cut);
+    int n = parent.filter_count();
+    for (int i = 0; i < n; ++i) {
+        QScopedPointer<Mlt::Filter> filter(parent.filter(i));
+        if (!filter || !filter->is_valid() || filter->get_int("_loader"))
+            continue;
+        QString filterService = QString::fromLatin1(filter->get("mlt_service"));
+        if (audioFilters.contains(filterService))
+            continue;
+        if (!staticFilters.contains(filterService))
+            return QByteArray();
+        // A filter that starts or ends within the clip changes it.
+        if (filter->get_out() > 0 && (filter->get_in() > in || filter->get_out() < out))
+            return QByteArray();
+        if (!hashProperties(hash, *filter))
+            return QByteArray();
+    }
+    return hash.result();
+}
+
+void deleteKey(void* key)
+{
+    delete static_cast<QByteArray*>(key);
+}
+
+int getImage(mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height, int writable)
+{
+    QByteArray key = *static_cast<QByteArray*>(mlt_properties_get_data(MLT_FRAME_PROPERTIES(frame), kKeyProperty, NULL));
+    key += QByteArray::number(*format) + ' ' + QByteArray::number(*width) + 'x' + QByteArray::number(*height)
+        + ' ' + mlt_properties_get(MLT_FRAME_PROPERTIES(frame), "rescale.interp");
+
+    CachedImage cached;
+    bool found = false;
+    {
+        QMutexLocker locker(&imageCacheMutex);
+        if (CachedImage* entry = imageCache.object(key)) {
+            // Copying only references the image data.
+            cached = *entry;
+            found = true;
+        }
+    }
+    if (found) {
+        uint8_t* copy = (uint8_t*) mlt_pool_alloc(cached.image.size());
+        memcpy(copy, cached.image.constData(), cached.image.size());
+        mlt_frame_set_image(frame, copy, cached.image.size(), mlt_pool_release);
+        if (!cached.alpha.isEmpty()) {
+            uint8_t* alpha = (uint8_t*) mlt_pool_alloc(cached.alpha.size());
+            memcpy(alpha, cached.alpha.constData(), cached.alpha.size());
+            mlt_frame_set_alpha(frame, alpha, cached.alpha.size(), mlt_pool_release);
+        }
+        *image = copy;
+        *format = cached.format;
+        *width = cached.width;
+        *height = cached.height;
+        return 0;
+    }
+
+    int error = mlt_frame_get_image(frame, image, format, width, height, writable);
+    if (!error && *image) {
+        CachedImage* entry = new CachedImage;
+        int size = mlt_image_format_size(*format, *width, *height, NULL);
+        entry->image = QByteArray((const char*) *image, size);
+        uint8_t* alpha = mlt_frame_get_alpha(frame);
+        if (alpha)
+            entry->alpha = QByteArray((const char*) alpha, *width * *height);
+        entry->format = *format;
+        entry->width = *width;
+        entry->height = *height;
+        QMutexLocker locker(&imageCacheMutex);
+        imageCache.insert(key, entry, qMax(1, (entry->image.size() + entry->alpha.size()) / 1024));
+    }
+    return error;
+}
+
+mlt_frame process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_producer cut = (mlt_producer) mlt_properties_get_data(MLT_FILTER_PROPERTIES(filter), kCutProperty, NULL);
+    if (cut) {
+        QByteArray key = stateKey(cut);
+        if (!key.isEmpty()) {
+            mlt_properties_set_data(MLT_FRAME_PROPERTIES(frame), kKeyProperty, new QByteArray(key), 0, deleteKey, NULL);
+            mlt_frame_push_get_image(frame, getImage);
+        }
+    }
+    return frame;
+}
+
+void attachToCut(Mlt::Producer& cut)
+{
+    if (cut.get_int(kAttachedProperty))
+        return;
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return;
+    filter->process = process;
+    // Loader filters are not saved in the project or shown as clip filters.
+    mlt_properties_set_int(MLT_FILTER_PROPERTIES(filter), "_loader", 1);
+    // The cut owns the filter, so it outlives this reference.
+    mlt_properties_set_data(MLT_FILTER_PROPERTIES(filter), kCutProperty, cut.get_producer(), 0, NULL, NULL);
+    mlt_service_attach(MLT_PRODUCER_SERVICE(cut.get_producer()), filter);
+    mlt_filter_close(filter);
+    cut.set(kAttachedProperty, 1);
+}
+
+} // namespace
+
+void RenderCache::attach(Mlt::Producer& producer)
+{
+    if (!producer.is_valid())
+        return;
+    if (producer.type() == tractor_type) {
+        Mlt::Tractor tractor(producer);
+        for (int i = 0; i < tractor.count(); ++i) {
+            QScopedPointer<Mlt::Producer> track(tractor.track(i));
+            if (track && track->is_valid())
+                attach(*track);
+        }
+    } else if (producer.type() == playlist_type) {
+        Mlt::Playlist playlist(producer);
+        for (int i = 0; i < playlist.count(); ++i) {
+            if (playlist.is_blank(i))
+                continue;
+            // Filters on the cut run after those of the clip itself.
+            QScopedPointer<Mlt::Producer> clip(playlist.get_clip(i));
+            if (clip && clip->is_valid() && clip->is_cut())
+                attachToCut(*clip);
+        }
+    }
+}
+
+void RenderCache::clear()
+{
+    QMutexLocker locker(&imageCacheMutex);
+    imageCache.clear();
+}
+
+bool RenderCache::isAnimatedTitle(const QString& xml)
+{
+    QDomDocument doc;
+    if (!doc.setContent(xml))
+        return true;
+    // The title pans and zooms when its viewport changes over the clip.
+    QDomElement start = doc.documentElement().firstChildElement("startviewport");
+    QDomElement end = doc.documentElement().firstChildElement("endviewport");
+    if (!start.isNull() && !end.isNull()) {
+        QDomNamedNodeMap attributes = start.attributes();
+        if (attributes.count() != end.attributes().count())
+            return true;
+        for (int i = 0; i < attributes.count(); ++i) {
+            QDomAttr attribute = attributes.item(i).toAttr();
+            if (end.attribute(attribute.name()) != attribute.value())
+                return true;
+        }
+    }
+    // The typewriter effect reveals text a few characters at a time.
+    QDomNodeList contents = doc.elementsByTagName("content");
+    for (int i = 0; i < contents.count(); ++i) {
+        QString typewriter = contents.item(i).toElement().attribute("typewriter");
+        if (!typewriter.isEmpty() && !typewriter.startsWith('0'))
+            return true;
+    }
+    return false;
+}
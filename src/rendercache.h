@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+class QString;
+
+namespace Mlt {
+    class Producer;
+}
+
+/*!
+  \class RenderCache
+  \brief Reuses the images of clips that look the same on every frame.
+
+  Titles, colors and plain HTML pages are rendered again for every frame
+  they cover although nothing about them changes. A hidden filter attached
+  to each such clip in the playlist and timeline computes a key from the
+  properties of the clip and its filters. The image rendered for the first
+  frame is kept under that key plus the requested image size and format,
+  and the following frames are copied from it without running the producer
+  or its filters. A clip with keyframes, position dependent text, a title
+  that scrolls or types, or a filter not known to be static is always
+  rendered, and changing any property changes the key, so nothing needs to
+  be invalidated explicitly.
+*/
+
+class RenderCache
+{
+public:
+    // Attaches the cache to the suitable clips of a playlist or multitrack.
+    static void attach(Mlt::Producer& producer);
+    static void clear();
+    //! Returns whether a kdenlivetitle document moves or reveals anything over time.
+    static bool isAnimatedTitle(const QString& xml);
+};
+
+#endif // RENDERCACHE_H
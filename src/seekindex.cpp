@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "seekindex.h"
+#include "settings.h"
+#include "shotcut_mlt_properties.h"
+#include "util.h"
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QSet>
+#include <QTextStream>
+#include <QThreadPool>
+#include <MltPlaylist.h>
+#include <MltProducer.h>
+#include <MltTractor.h>
+#include <Logger.h>
+#include <algorithm>
+
+static const char* kHeader = "# shotcut seek index 1";
+static const char* kAttachedProperty = "_shotcut:seekindex";
+static const char* kIndexProperty = "index";
+static const char* kProducerProperty = "producer";
+static const char* kLastProperty = "_last";
+// avformat decodes forward by itself for shorter jumps.
+static const int kSeekThreshold = 12;
+static const int kCancelInterval = 100; // ms
+
+namespace {
+
+class IndexTask;
+
+QMutex g_mutex;
+QHash<QString, QSharedPointer<SeekIndex>> g_indexes;
+QSet<QString> g_missing;
+QHash<QString, IndexTask*> g_pending;
+
+// ffprobe reads the whole file, so indexing one at a time keeps it from
+// competing with the player and the other jobs for the disk.
+QThreadPool& indexPool()
+{
+    static QThreadPool* pool = 0;
+    if (!pool) {
+        pool = new QThreadPool(qApp);
+        pool->setMaxThreadCount(1);
+    }
+    return *pool;
+}
+
+class IndexTask : public QRunnable
+{
+public:
+    IndexTask(const QString& hash, const QString& resource, const QString& path)
+        : m_hash(hash)
+        , m_resource(resource)
+        , m_path(path)
+    {}
+
+    void cancel()
+    {
+        m_canceled.store(1);
+    }
+
+    void run()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QSharedPointer<SeekIndex> index;
+        if (SeekIndex::build(m_resource, m_path, [this]() { return m_canceled.load() != 0; })) {
+            LOG_INFO() << "indexed the keyframes of" << m_resource << "in" << timer.elapsed() << "ms";
+            index = SeekIndex::load(m_path);
+        }
+        QMutexLocker locker(&g_mutex);
+        // A canceled task was already removed.
+        if (g_pending.value(m_hash) == this)
+            g_pending.remove(m_hash);
+        if (index) {
+            g_missing.remove(m_hash);
+            g_indexes.insert(m_hash, index);
+        }
+    }
+
+private:
+    QString m_hash;
+    QString m_resource;
+    QString m_path;
+    QAtomicInt m_canceled;
+};
+
+bool keyframeLessThan(const SeekIndex::Keyframe& a, const SeekIndex::Keyframe& b)
+{
+    return a.time < b.time;
+}
+
+void deleteIndex(void* index)
+{
+    delete static_cast<QSharedPointer<SeekIndex>*>(index);
+}
+
+// Decodes the frames between the last one of this producer and the
+// requested one when avformat would otherwise seek back to the keyframe of
+// their group. The producer's own get_frame is called directly because it
+// holds the service lock while its filters run, and the skipped frames do
+// not need the filters anyway.
+mlt_frame process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    mlt_producer producer = (mlt_producer) mlt_properties_get_data(properties, kProducerProperty, NULL);
+    if (!producer || !producer->get_frame)
+        return frame;
+    mlt_position position = mlt_frame_get_position(frame);
+    mlt_position last = mlt_properties_get_position(properties, kLastProperty);
+    mlt_properties_set_position(properties, kLastProperty, position);
+    QSharedPointer<SeekIndex>* index = static_cast<QSharedPointer<SeekIndex>*>(
+        mlt_properties_get_data(properties, kIndexProperty, NULL));
+    if (!index || last < 0 || position - last <= kSeekThreshold
+            || !(*index)->isSameGroup(last, position, mlt_producer_get_fps(producer)))
+        return frame;
+
+    mlt_position saved = mlt_producer_position(producer);
+    for (mlt_position i = last + 1; i < position; ++i) {
+        mlt_frame skipped = NULL;
+        mlt_producer_seek(producer, i);
+        if (producer->get_frame(producer, &skipped, 0) || !skipped)
+            break;
+        // The native format and size avoid any conversion.
+        mlt_image_format format = mlt_image_none;
+        uint8_t* image = NULL;
+        int width = 0;
+        int height = 0;
+        mlt_frame_get_image(skipped, &image, &format, &width, &height, 0);
+        mlt_frame_close(skipped);
+    }
+    mlt_producer_seek(producer, saved);
+    return frame;
+}
+
+} // namespace
+
+QSharedPointer<SeekIndex> SeekIndex::find(Mlt::Producer& producer)
+{
+    if (!isIndexable(producer))
+        return QSharedPointer<SeekIndex>();
+    return find(Util::getHash(producer));
+}
+
+QSharedPointer<SeekIndex> SeekIndex::find(const QString& hash)
+{
+    if (hash.isEmpty())
+        return QSharedPointer<SeekIndex>();
+    {
+        QMutexLocker locker(&g_mutex);
+        if (g_indexes.contains(hash))
+            return g_indexes.value(hash);
+        if (g_pending.contains(hash) || g_missing.contains(hash))
+            return QSharedPointer<SeekIndex>();
+    }
+    QSharedPointer<SeekIndex> index = load(indexPath(hash));
+    QMutexLocker locker(&g_mutex);
+    if (index)
+        g_indexes.insert(hash, index);
+    else
+        g_missing.insert(hash);
+    return index;
+}
+
+QSharedPointer<SeekIndex> SeekIndex::findOrBuild(const QString& hash, const QString& resource,
+                                                 const std::function<bool()>& isCanceled)
+{
+    QSharedPointer<SeekIndex> index = find(hash);
+    if (index || hash.isEmpty())
+        return index;
+    // A request for the same media may be indexing it in the background,
+    // but the file is replaced atomically, so both can write it.
+    QString path = indexPath(hash);
+    if (!path.isEmpty() && build(resource, path, isCanceled))
+        index = load(path);
+    if (index) {
+        QMutexLocker locker(&g_mutex);
+        g_missing.remove(hash);
+        g_indexes.insert(hash, index);
+    }
+    return index;
+}
+
+void SeekIndex::request(Mlt::Producer& producer)
+{
+    if (!isIndexable(producer))
+        return;
+    QString hash = Util::getHash(producer);
+    QString path = indexPath(hash);
+    if (hash.isEmpty() || path.isEmpty() || QFile::exists(path))
+        return;
+    QMutexLocker locker(&g_mutex);
+    if (g_pending.contains(hash))
+        return;
+    IndexTask* task = new IndexTask(hash, QString::fromUtf8(producer.get("resource")), path);
+    g_pending.insert(hash, task);
+    indexPool().start(task);
+}
+
+void SeekIndex::cancelAll()
+{
+    QMutexLocker locker(&g_mutex);
+    foreach (IndexTask* task, g_pending) {
+        if (indexPool().tryTake(task))
+            delete task;
+        else
+            task->cancel();
+    }
+    g_pending.clear();
+}
+
+void SeekIndex::attach(Mlt::Producer& producer)
+{
+    if (!producer.is_valid())
+        return;
+    if (producer.type() == tractor_type) {
+        Mlt::Tractor tractor(producer);
+        for (int i = 0; i < tractor.count(); ++i) {
+            QScopedPointer<Mlt::Producer> track(tractor.track(i));
+            if (track && track->is_valid())
+                attach(*track);
+        }
+    } else if (producer.type() == playlist_type) {
+        Mlt::Playlist playlist(producer);
+        for (int i = 0; i < playlist.count(); ++i) {
+            QScopedPointer<Mlt::Producer> clip(playlist.get_clip(i));
+            if (clip && clip->is_valid() && !clip->is_blank())
+                attach(*clip);
+        }
+    } else {
+        Mlt::Producer parent = producer.is_cut()? producer.parent() : producer;
+        // Only an existing hash is used here because hashing reads the file.
+        if (!parent.get_int(kAttachedProperty) && parent.get(kShotcutHashProperty) && isIndexable(parent))
+            attach(parent, find(parent.get(kShotcutHashProperty)));
+    }
+}
+
+void SeekIndex::attach(Mlt::Producer& producer, QSharedPointer<SeekIndex> index)
+{
+    if (!index || !producer.is_valid() || producer.get_int(kAttachedProperty))
+        return;
+    mlt_filter filter = mlt_filter_new();
+    if (!filter)
+        return;
+    filter->process = process;
+    mlt_properties properties = MLT_FILTER_PROPERTIES(filter);
+    // Loader filters are not saved in the project or shown as clip filters.
+    mlt_properties_set_int(properties, "_loader", 1);
+    mlt_properties_set_position(properties, kLastProperty, -1);
+    // The producer owns the filter, so it outlives this reference.
+    mlt_properties_set_data(properties, kProducerProperty, producer.get_producer(), 0, NULL, NULL);
+    mlt_properties_set_data(properties, kIndexProperty, new QSharedPointer<SeekIndex>(index), 0, deleteIndex, NULL);
+    mlt_service_attach(MLT_PRODUCER_SERVICE(producer.get_producer()), filter);
+    mlt_filter_close(filter);
+    producer.set(kAttachedProperty, 1);
+}
+
+bool SeekIndex::isIndexable(Mlt::Producer& producer)
+{
+    // Proxies are encoded with short groups and are not what the hash names.
+    return producer.is_valid() && QString(producer.get("mlt_service")).startsWith("avformat")
+            && !producer.get_int(kIsProxyProperty) && producer.get_int("video_index") >= 0;
+}
+
+int SeekIndex::keyframeAtOrBefore(int frame, double fps) const
+{
+    if (m_keyframes.isEmpty() || fps <= 0.0)
+        return -1;
+    Keyframe key = {(frame + 0.5) / fps, -1};
+    QVector<Keyframe>::const_iterator i = std::upper_bound(m_keyframes.constBegin(),
+        m_keyframes.constEnd(), key, keyframeLessThan);
+    if (i == m_keyframes.constBegin())
+        return -1;
+    --i;
+    return qRound(i->time * fps);
+}
+
+bool SeekIndex::isSameGroup(int from, int to, double fps) const
+{
+    if (from < 0 || to <= from)
+        return false;
+    int keyframe = keyframeAtOrBefore(to, fps);
+    return keyframe >= 0 && keyframe <= from;
+}
+
+QString SeekIndex::indexPath(const QString& hash)
+{
+    if (hash.isEmpty())
+        return QString();
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd("seekindex")) {
+        dir.mkdir("seekindex");
+        dir.cd("seekindex");
+    }
+    return dir.filePath(hash + ".idx");
+}
+
+QSharedPointer<SeekIndex> SeekIndex::load(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QSharedPointer<SeekIndex>();
+    QTextStream stream(&file);
+    if (stream.readLine() != kHeader) {
+        LOG_WARNING() << "ignoring seek index with an unknown format" << path;
+        return QSharedPointer<SeekIndex>();
+    }
+    QSharedPointer<SeekIndex> index(new SeekIndex);
+    while (!stream.atEnd()) {
+        QStringList fields = stream.readLine().split(' ');
+        if (fields.size() != 2)
+            continue;
+        Keyframe keyframe = {fields[0].toDouble(), fields[1].toLongLong()};
+        index->m_keyframes << keyframe;
+    }
+    if (index->m_keyframes.isEmpty())
+        return QSharedPointer<SeekIndex>();
+    return index;
+}
+
+bool SeekIndex::build(const QString& resource, const QString& path, const std::function<bool()>& isCanceled)
+{
+    QProcess process;
+    QFileInfo ffprobePath(qApp->applicationDirPath(), "ffprobe");
+    QStringList args;
+    args << "-v" << "error" << "-select_streams" << "v:0"
+         << "-show_entries" << "packet=pts_time,pos,flags"
+         << "-of" << "csv=print_section=0" << resource;
+    process.start(ffprobePath.absoluteFilePath(), args);
+    while (!process.waitForFinished(kCancelInterval) && process.state() != QProcess::NotRunning) {
+        if (isCanceled && isCanceled()) {
+            process.kill();
+            process.waitForFinished();
+            return false;
+        }
+    }
+    if (process.error() == QProcess::FailedToStart || process.exitStatus() != QProcess::NormalExit
+            || process.exitCode() != 0) {
+        LOG_WARNING() << "failed to index the keyframes of" << resource << process.readAllStandardError();
+        return false;
+    }
+
+    // Packets are listed in decoding order, and the producer counts frames
+    // from the earliest presentation time of any of them.
+    QVector<Keyframe> keyframes;
+    double start = -1.0;
+    foreach (QByteArray line, process.readAllStandardOutput().split('\n')) {
+        QList<QByteArray> fields = line.trimmed().split(',');
+        if (fields.size() < 3)
+            continue;
+        bool ok = false;
+        double time = fields[0].toDouble(&ok);
+        if (!ok)
+            continue;
+        if (start < 0.0 || time < start)
+            start = time;
+        if (fields[2].contains('K')) {
+            Keyframe keyframe = {time, fields[1].toLongLong(&ok)};
+            if (!ok)
+                keyframe.offset = -1;
+            keyframes << keyframe;
+        }
+    }
+    if (keyframes.isEmpty())
+        return false;
+    std::sort(keyframes.begin(), keyframes.end(), keyframeLessThan);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    stream << kHeader << '\n';
+    foreach (const Keyframe& keyframe, keyframes)
+        stream << QString::number(keyframe.time - start, 'f', 6) << ' ' << keyframe.offset << '\n';
+    stream.flush();
+    return file.commit();
+}
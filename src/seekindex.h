@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEEKINDEX_H
+#define SEEKINDEX_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+namespace Mlt {
+    class Producer;
+}
+
+/*!
+  \class SeekIndex
+  \brief Records where the keyframes of a media file are.
+
+  The keyframe times and byte offsets of the first video stream are read
+  once with ffprobe on a thread of its own and kept in the application data
+  folder, keyed by the content hash of the media. A decoder that already
+  sits on a frame can then tell whether a later frame is in the same group
+  of pictures, in which case decoding forward to it is cheaper than letting
+  avformat seek back to the keyframe and decode the group again. This
+  matters most for long-GOP camera and screen recordings.
+
+  attach() adds a hidden filter that does this for the producers of the
+  player, the thumbnails and the frame export.
+*/
+
+class SeekIndex
+{
+public:
+    struct Keyframe {
+        double time;   // seconds from the first video packet
+        qint64 offset; // byte position in the file, -1 when unknown
+    };
+
+    // Returns the index of the producer's media if it was built, else null.
+    static QSharedPointer<SeekIndex> find(Mlt::Producer& producer);
+    static QSharedPointer<SeekIndex> find(const QString& hash);
+    // Returns the index of the media, building it first if needed.
+    static QSharedPointer<SeekIndex> findOrBuild(const QString& hash, const QString& resource,
+                                                 const std::function<bool()>& isCanceled);
+
+    // Starts building the index in the background when it does not exist.
+    static void request(Mlt::Producer& producer);
+    // Drops the waiting requests and stops the one in progress.
+    static void cancelAll();
+
+    /*!
+      Makes the media of \a producer, or of each clip when it is a playlist
+      or tractor, decode forward to a later frame in the same group of
+      pictures instead of seeking. Media without an index are left alone.
+    */
+    static void attach(Mlt::Producer& producer);
+    static void attach(Mlt::Producer& producer, QSharedPointer<SeekIndex> index);
+
+    static bool isIndexable(Mlt::Producer& producer);
+    static QSharedPointer<SeekIndex> load(const QString& path);
+    // Runs ffprobe on the media and saves the index to path.
+    static bool build(const QString& resource, const QString& path,
+                      const std::function<bool()>& isCanceled = nullptr);
+
+    const QVector<Keyframe>& keyframes() const { return m_keyframes; }
+
+    // Returns the frame of the last keyframe at or before frame, or -1.
+    int keyframeAtOrBefore(int frame, double fps) const;
+
+    /*!
+      Returns whether frame \a to follows \a from without a keyframe in
+      between, so that decoding forward from \a from reaches it exactly.
+    */
+    bool isSameGroup(int from, int to, double fps) const;
+
+private:
+    static QString indexPath(const QString& hash);
+
+    QVector<Keyframe> m_keyframes;
+};
+
+#endif // SEEKINDEX_H
@@ -297,6 +297,19 @@ void ShotcutSettings::setEncodeParallelProcessing(bool b)
     settings.setValue("encode/parallelProcessing", b);
 }
 
+QStringList ShotcutSettings::encodeTuning(const QString& codec) const
+{
+    return settings.value("encode/tuning/" + codec).toStringList();
+}
+
+void ShotcutSettings::setEncodeTuning(const QString& codec, const QStringList& ls)
+{
+    if (ls.isEmpty())
+        settings.remove("encode/tuning/" + codec);
+    else
+        settings.setValue("encode/tuning/" + codec, ls);
+}
+
 int ShotcutSettings::playerAudioChannels() const
 {
     return settings.value("player/audioChannels", 2).toInt();
@@ -430,6 +443,16 @@ void ShotcutSettings::setPlayerRealtime(bool b)
     settings.setValue("player/realtime", b);
 }
 
+bool ShotcutSettings::playerThrottleBackground() const
+{
+    return settings.value("player/throttleBackground", true).toBool();
+}
+
+void ShotcutSettings::setPlayerThrottleBackground(bool b)
+{
+    settings.setValue("player/throttleBackground", b);
+}
+
 bool ShotcutSettings::playerScrubAudio() const
 {
     return settings.value("player/scrubAudio", true).toBool();
@@ -652,6 +675,66 @@ void ShotcutSettings::setLoudnessScopeShowMeter(const QString& meter, bool b)
     settings.setValue("scope/loudness/" + meter, b);
 }
 
+double ShotcutSettings::qcMaxTruePeak() const
+{
+    return settings.value("qc/maxTruePeak", -1.0).toDouble();
+}
+
+void ShotcutSettings::setQcMaxTruePeak(double dBTP)
+{
+    settings.setValue("qc/maxTruePeak", dBTP);
+}
+
+double ShotcutSettings::qcMaxShortTermLoudness() const
+{
+    return settings.value("qc/maxShortTermLoudness", -18.0).toDouble();
+}
+
+void ShotcutSettings::setQcMaxShortTermLoudness(double lufs)
+{
+    settings.setValue("qc/maxShortTermLoudness", lufs);
+}
+
+double ShotcutSettings::qcProgramLoudness() const
+{
+    return settings.value("qc/programLoudness", -23.0).toDouble();
+}
+
+void ShotcutSettings::setQcProgramLoudness(double lufs)
+{
+    settings.setValue("qc/programLoudness", lufs);
+}
+
+double ShotcutSettings::qcProgramTolerance() const
+{
+    return settings.value("qc/programTolerance", 0.5).toDouble();
+}
+
+void ShotcutSettings::setQcProgramTolerance(double lu)
+{
+    settings.setValue("qc/programTolerance", lu);
+}
+
+int ShotcutSettings::audioSpectrumWindowSize() const
+{
+    return settings.value("scope/spectrum/windowSize", 8192).toInt();
+}
+
+void ShotcutSettings::setAudioSpectrumWindowSize(int size)
+{
+    settings.setValue("scope/spectrum/windowSize", size);
+}
+
+bool ShotcutSettings::audioSpectrumShowWaterfall() const
+{
+    return settings.value("scope/spectrum/waterfall", true).toBool();
+}
+
+void ShotcutSettings::setAudioSpectrumShowWaterfall(bool b)
+{
+    settings.setValue("scope/spectrum/waterfall", b);
+}
+
 int ShotcutSettings::drawMethod() const
 {
 #ifdef Q_OS_WIN
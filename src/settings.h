@@ -96,6 +96,8 @@ public:
     void setShowConvertClipDialog(bool);
     bool encodeParallelProcessing() const;
     void setEncodeParallelProcessing(bool);
+    QStringList encodeTuning(const QString& codec) const;
+    void setEncodeTuning(const QString& codec, const QStringList&);
 
     int playerAudioChannels() const;
     void setPlayerAudioChannels(int);
@@ -122,6 +124,8 @@ public:
     void setPlayerProgressive(bool);
     bool playerRealtime() const;
     void setPlayerRealtime(bool);
+    bool playerThrottleBackground() const;
+    void setPlayerThrottleBackground(bool);
     bool playerScrubAudio() const;
     void setPlayerScrubAudio(bool);
     int playerVolume() const;
@@ -173,6 +177,18 @@ public:
 
     bool loudnessScopeShowMeter(const QString& meter) const;
     void setLoudnessScopeShowMeter(const QString& meter, bool b);
+    double qcMaxTruePeak() const;
+    void setQcMaxTruePeak(double);
+    double qcMaxShortTermLoudness() const;
+    void setQcMaxShortTermLoudness(double);
+    double qcProgramLoudness() const;
+    void setQcProgramLoudness(double);
+    double qcProgramTolerance() const;
+    void setQcProgramTolerance(double);
+    int audioSpectrumWindowSize() const;
+    void setAudioSpectrumWindowSize(int size);
+    bool audioSpectrumShowWaterfall() const;
+    void setAudioSpectrumShowWaterfall(bool b);
 
     int drawMethod() const;
     void setDrawMethod(int);
@@ -55,6 +55,8 @@
 #define kOriginalInProperty "shotcut:originalIn"
 #define kOriginalOutProperty "shotcut:originalOut"
 #define kDisableProxyProperty "shotcut:disableProxy"
+#define kFusedFiltersProperty "shotcut:fusedFilters"
+#define kFusedCaptionProperty "shotcut:fusedCaption"
 
 /* Project specific properties */
 #define kShotcutProjectAudioChannels "shotcut:projectAudioChannels"
@@ -76,6 +78,7 @@
 /* Internal only */
 
 #define kAudioLevelsProperty "_shotcut:audio-levels"
+#define kAudioLevelsCompleteProperty "_shotcut:audio-levels-complete"
 #define kBackgroundCaptureProperty "_shotcut:bgcapture"
 #define kPlaylistIndexProperty "_shotcut:playlistIndex"
 #define kPlaylistStartProperty "_shotcut:playlistStart"
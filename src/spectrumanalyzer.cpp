@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "spectrumanalyzer.h"
+#include <Logger.h>
+#include <cmath>
+#include <cstring>
+
+// Spend at most this much of the scope thread on transforms per frame.
+static const double kBudgetMs = 4.0;
+// A band is read from the shortest window that has this many bins in it.
+static const int kMinBinsPerBand = 2;
+// The number of progressively shorter windows analyzed with the selected one.
+static const int kResolutionCount = 4;
+static const int kOverlap = 4;
+static const float kSilence = -1000.0f;
+
+SpectrumAnalyzer::SpectrumAnalyzer(const QVector<Band>& bands, int historySize)
+    : m_bands(bands)
+    , m_sinceAnalysis(0)
+    , m_windowSize(8192)
+    , m_frequency(0)
+    , m_lastPosition(-1)
+    , m_history(qMax(1, historySize))
+    , m_historyNext(0)
+    , m_averageCost(0.0)
+    , m_analysisCost(0.0)
+{
+    for (int i = 0; i < m_history.size(); ++i)
+        m_history[i].position = -1;
+}
+
+void SpectrumAnalyzer::setWindowSize(int windowSize)
+{
+    int size = kMinWindowSize;
+    while (size < windowSize && size < kMaxWindowSize)
+        size <<= 1;
+    if (size != m_windowSize) {
+        m_windowSize = size;
+        // Rebuild the tables for the next frame.
+        m_frequency = 0;
+        m_analysisCost = 0.0;
+    }
+}
+
+QVector<float> SpectrumAnalyzer::process(int position, const int16_t* samples, int sampleCount,
+                                         int channels, int frequency)
+{
+    if (frequency != m_frequency)
+        buildTables(frequency);
+
+    bool isContiguous = position == m_lastPosition + 1;
+    if (position == m_lastPosition || (!isContiguous && contains(position))) {
+        // Repeated or scrubbed back to an analyzed frame. The FIFO no longer
+        // holds the audio before the next frame, so start it over.
+        m_lastPosition = position;
+        m_sinceAnalysis = 0;
+        m_fifo.fill(0.0f);
+        return levels(position);
+    }
+    if (!isContiguous) {
+        m_sinceAnalysis = 0;
+        m_fifo.fill(0.0f);
+    }
+    m_lastPosition = position;
+
+    const int hop = m_windowSize / kOverlap;
+    int pending = (m_sinceAnalysis + sampleCount) / hop;
+    int allowed = pending;
+    if (m_analysisCost > 0.0)
+        allowed = qBound(1, int(kBudgetMs / m_analysisCost), pending);
+    int skip = pending - allowed;
+
+    QVector<float> levels(m_bands.size(), 0.0f);
+    int analyses = 0;
+    m_timer.start();
+    float* fifo = m_fifo.data();
+    const int fifoSize = m_fifo.size();
+    for (int offset = 0; offset < sampleCount;) {
+        int count = qMin(hop - m_sinceAnalysis, sampleCount - offset);
+        // Shift the FIFO and append the new samples mixed down to mono.
+        memmove(fifo, fifo + count, (fifoSize - count) * sizeof(float));
+        float* out = fifo + fifoSize - count;
+        const int16_t* in = samples + offset * channels;
+        for (int i = 0; i < count; ++i) {
+            float sum = 0.0f;
+            for (int c = 0; c < channels; ++c)
+                sum += *in++;
+            out[i] = sum / (32768.0f * channels);
+        }
+        m_sinceAnalysis += count;
+        offset += count;
+        if (m_sinceAnalysis >= hop) {
+            m_sinceAnalysis = 0;
+            // Skip the oldest windows when they do not fit in the budget.
+            if (skip > 0) {
+                --skip;
+            } else {
+                analyze(levels);
+                ++analyses;
+            }
+        }
+    }
+
+    if (analyses > 0) {
+        double cost = m_timer.nsecsElapsed() / 1000000.0;
+        m_analysisCost = m_analysisCost > 0.0? 0.9 * m_analysisCost + 0.1 * cost / analyses : cost / analyses;
+        m_averageCost = 0.9 * m_averageCost + 0.1 * cost;
+        for (int i = 0; i < levels.size(); ++i)
+            levels[i] = levels[i] > 0.0f? 20.0f * std::log10(levels[i]) : kSilence;
+        m_lastLevels = levels;
+    } else {
+        m_averageCost *= 0.9;
+        if (m_lastLevels.size() != levels.size())
+            m_lastLevels.fill(kSilence, levels.size());
+        levels = m_lastLevels;
+    }
+    if (pending > allowed)
+        LOG_DEBUG() << "skipped" << pending - allowed << "of" << pending << "spectrum windows";
+    store(position, levels);
+    return levels;
+}
+
+QVector<float> SpectrumAnalyzer::levels(int position) const
+{
+    int slot = m_index.value(position, -1);
+    return slot >= 0? m_history[slot].levels : QVector<float>();
+}
+
+void SpectrumAnalyzer::clear()
+{
+    m_index.clear();
+    for (int i = 0; i < m_history.size(); ++i) {
+        m_history[i].position = -1;
+        m_history[i].levels.clear();
+    }
+    m_historyNext = 0;
+    m_lastPosition = -1;
+    m_lastLevels.clear();
+}
+
+void SpectrumAnalyzer::buildTables(int frequency)
+{
+    m_frequency = frequency;
+    m_resolutions.clear();
+    for (int size = m_windowSize; size >= kMinWindowSize && m_resolutions.size() < kResolutionCount; size >>= 1) {
+        Resolution r;
+        r.size = size;
+        r.used = false;
+        r.window.resize(size);
+        for (int i = 0; i < size; ++i)
+            r.window[i] = 0.5f - 0.5f * std::cos(2.0 * M_PI * i / size);
+        r.reverse.resize(size);
+        for (int i = 0, j = 0; i < size; ++i) {
+            r.reverse[i] = j;
+            int bit = size >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+        }
+        r.twiddles.resize(size / 2);
+        for (int k = 0; k < size / 2; ++k)
+            r.twiddles[k] = std::polar(1.0f, float(-2.0 * M_PI * k / size));
+        r.buffer.resize(size);
+        r.magnitudes.resize(size / 2 + 1);
+        m_resolutions << r;
+    }
+
+    // Map every band to a bin range once instead of scanning all bins.
+    m_bandBins.resize(m_bands.size());
+    for (int b = 0; b < m_bands.size(); ++b) {
+        BandBins& bins = m_bandBins[b];
+        bins.resolution = -1;
+        for (int r = m_resolutions.size() - 1; r >= 0; --r) {
+            const int size = m_resolutions[r].size;
+            double binWidth = double(frequency) / size;
+            int first = int(std::ceil(m_bands[b].low / binWidth));
+            int last = qMin(size / 2, int(std::floor(m_bands[b].high / binWidth)));
+            if (last - first + 1 >= kMinBinsPerBand) {
+                bins.resolution = r;
+                bins.first = first;
+                bins.last = last;
+                break;
+            }
+        }
+        if (bins.resolution < 0) {
+            // Even the longest window cannot split this band, so use the
+            // bin nearest to its center.
+            const int size = m_resolutions.first().size;
+            int bin = int(std::sqrt(m_bands[b].low * m_bands[b].high) * size / frequency + 0.5);
+            bins.resolution = 0;
+            bins.first = bins.last = qBound(0, bin, size / 2);
+        }
+        m_resolutions[bins.resolution].used = true;
+    }
+
+    m_fifo.fill(0.0f, m_windowSize);
+    m_sinceAnalysis = 0;
+    m_lastLevels.clear();
+    LOG_DEBUG() << "window" << m_windowSize << "resolutions" << m_resolutions.size() << "frequency" << frequency;
+}
+
+void SpectrumAnalyzer::analyze(QVector<float>& levels)
+{
+    for (int r = 0; r < m_resolutions.size(); ++r) {
+        if (m_resolutions[r].used)
+            transform(m_resolutions[r]);
+    }
+    for (int b = 0; b < m_bandBins.size(); ++b) {
+        const BandBins& bins = m_bandBins[b];
+        const float* magnitudes = m_resolutions[bins.resolution].magnitudes.constData();
+        float peak = levels[b];
+        // Pick the highest bin level within this band to represent the
+        // whole band.
+        for (int i = bins.first; i <= bins.last; ++i)
+            peak = qMax(peak, magnitudes[i]);
+        levels[b] = peak;
+    }
+}
+
+// Windowed in-place radix-2 FFT of the newest samples in the FIFO.
+void SpectrumAnalyzer::transform(Resolution& r)
+{
+    const int n = r.size;
+    const float* samples = m_fifo.constData() + m_fifo.size() - n;
+    const float* window = r.window.constData();
+    const int* reverse = r.reverse.constData();
+    Complex* data = r.buffer.data();
+    for (int i = 0; i < n; ++i)
+        data[reverse[i]] = Complex(samples[i] * window[i], 0.0f);
+
+    const Complex* twiddles = r.twiddles.constData();
+    for (int length = 2; length <= n; length <<= 1) {
+        int half = length / 2;
+        int step = n / length;
+        for (int i = 0; i < n; i += length) {
+            for (int j = 0; j < half; ++j) {
+                Complex u = data[i + j];
+                Complex v = data[i + j + half] * twiddles[j * step];
+                data[i + j] = u + v;
+                data[i + j + half] = u - v;
+            }
+        }
+    }
+
+    // Scale so that a full scale sine reads 1.0 (0 dB) through the Hann window.
+    const float scale = 4.0f / n;
+    float* magnitudes = r.magnitudes.data();
+    for (int k = 0; k <= n / 2; ++k)
+        magnitudes[k] = std::abs(data[k]) * scale;
+}
+
+void SpectrumAnalyzer::store(int position, const QVector<float>& levels)
+{
+    int slot = m_index.value(position, -1);
+    if (slot < 0) {
+        slot = m_historyNext;
+        m_historyNext = (m_historyNext + 1) % m_history.size();
+        if (m_history[slot].position >= 0)
+            m_index.remove(m_history[slot].position);
+        m_index.insert(position, slot);
+    }
+    m_history[slot].position = position;
+    m_history[slot].levels = levels;
+}
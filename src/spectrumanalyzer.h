@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QVector>
+#include <QHash>
+#include <QElapsedTimer>
+#include <complex>
+#include <stdint.h>
+
+/*!
+  \class SpectrumAnalyzer
+  \brief Computes per-frame band levels for the audio spectrum scope.
+
+  Audio is accumulated in a sample FIFO and analyzed with overlapping
+  Hann windows. Every analysis transforms the newest samples at several
+  window sizes, from the selected size down by powers of two, and each
+  band reads the shortest window that still resolves it. Low bands get
+  the frequency resolution of the long window while high bands keep the
+  time resolution of a short one.
+
+  The band levels of each frame are kept in a ring buffer keyed by frame
+  position so that the waterfall history is drawn again without any new
+  analysis when scrubbing back. The time spent transforming is measured
+  and capped per frame; windows that do not fit in the budget are skipped.
+*/
+
+class SpectrumAnalyzer
+{
+public:
+    struct Band {
+        double low;  // Hz
+        double high; // Hz
+    };
+
+    SpectrumAnalyzer(const QVector<Band>& bands, int historySize);
+
+    void setWindowSize(int windowSize);
+    int windowSize() const { return m_windowSize; }
+    //! Returns the band levels in dB of a frame and adds them to the history.
+    QVector<float> process(int position, const int16_t* samples, int sampleCount,
+                           int channels, int frequency);
+    //! Returns the cached band levels of a frame or an empty vector.
+    QVector<float> levels(int position) const;
+    bool contains(int position) const { return m_index.contains(position); }
+    int bandCount() const { return m_bands.size(); }
+    //! Returns the moving average of the analysis time per frame in ms.
+    double averageCost() const { return m_averageCost; }
+    void clear();
+
+    static const int kMinWindowSize = 1024;
+    static const int kMaxWindowSize = 16384;
+
+private:
+    typedef std::complex<float> Complex;
+
+    struct Resolution {
+        int size;
+        bool used;
+        QVector<float> window;
+        QVector<int> reverse;
+        QVector<Complex> twiddles;
+        QVector<Complex> buffer;
+        QVector<float> magnitudes;
+    };
+
+    struct BandBins {
+        int resolution;
+        int first;
+        int last;
+    };
+
+    struct Row {
+        int position;
+        QVector<float> levels;
+    };
+
+    void buildTables(int frequency);
+    void analyze(QVector<float>& levels);
+    void transform(Resolution& resolution);
+    void store(int position, const QVector<float>& levels);
+
+    QVector<Band> m_bands;
+    QVector<Resolution> m_resolutions;
+    QVector<BandBins> m_bandBins;
+    QVector<float> m_fifo;
+    QVector<float> m_lastLevels;
+    int m_sinceAnalysis;
+    int m_windowSize;
+    int m_frequency;
+    int m_lastPosition;
+    QVector<Row> m_history;
+    QHash<int, int> m_index; // position -> history slot
+    int m_historyNext;
+    double m_averageCost;
+    double m_analysisCost; // ms per analysis
+    QElapsedTimer m_timer;
+};
+
+#endif // SPECTRUMANALYZER_H
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "startuptrace.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <Logger.h>
+
+namespace {
+
+QElapsedTimer g_timer;
+QList<QPair<QString, qint64>> g_costs;
+// The time spent in the scopes nested in each open scope.
+QVector<qint64> g_nestedCosts;
+bool g_isFirstPaintDone = false;
+
+} // namespace
+
+StartupTrace::Scope::Scope(const QString& name)
+    : m_name(name)
+    , m_start(g_timer.isValid()? g_timer.elapsed() : 0)
+{
+    g_nestedCosts << 0;
+}
+
+StartupTrace::Scope::~Scope()
+{
+    qint64 nested = g_nestedCosts.takeLast();
+    if (!g_timer.isValid())
+        return;
+    qint64 total = g_timer.elapsed() - m_start;
+    if (!g_nestedCosts.isEmpty())
+        g_nestedCosts.last() += total;
+    qint64 cost = total - nested;
+    if (g_isFirstPaintDone)
+        LOG_INFO() << "startup: initialized" << m_name << "after first paint in" << cost << "ms";
+    else
+        g_costs << qMakePair(m_name, cost);
+}
+
+void StartupTrace::start()
+{
+    g_timer.start();
+}
+
+bool StartupTrace::firstPaint()
+{
+    if (g_isFirstPaintDone || !g_timer.isValid())
+        return false;
+    g_isFirstPaintDone = true;
+    LOG_INFO() << "startup: first paint after" << g_timer.elapsed() << "ms";
+    for (const auto& cost : g_costs)
+        LOG_INFO() << "startup:" << cost.first << cost.second << "ms";
+    g_costs.clear();
+    return true;
+}
+
+bool StartupTrace::isFirstPaintDone()
+{
+    return g_isFirstPaintDone;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+
+/*!
+  \class StartupTrace
+  \brief Measures how long it takes until the main window first paints.
+
+  main() starts the clock, and the expensive steps of building the main
+  window, mostly the docks, are timed with a Scope. The time to first
+  paint is logged with the cost of each step. A Scope inside another one
+  is only counted once: the outer one reports the time spent outside of
+  it, so the costs add up. Steps that run later, such as docks initialized
+  on first show or when idle, are logged as they finish.
+*/
+
+class StartupTrace
+{
+public:
+    class Scope
+    {
+    public:
+        explicit Scope(const QString& name);
+        ~Scope();
+
+    private:
+        QString m_name;
+        qint64 m_start;
+    };
+
+    static void start();
+    // Returns false if the first paint was already reported.
+    static bool firstPaint();
+    static bool isFirstPaintDone();
+};
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "timelineclipboard.h"
+#include "mltcontroller.h"
+#include "models/multitrackmodel.h"
+#include "shotcut_mlt_properties.h"
+
+#include <QHash>
+#include <QScopedPointer>
+#include <climits>
+
+void TimelineClipboard::setItems(const QList<Item>& items)
+{
+    m_items = items;
+    m_trackCount = 0;
+    foreach (const Item& item, m_items)
+        m_trackCount = qMax(m_trackCount, item.trackOffset + 1);
+}
+
+// Replaces the contents with the selected clips, given as (clip, track)
+// points, and returns how many were copied. Blanks and transitions are
+// skipped.
+int TimelineClipboard::copy(MultitrackModel& model, const QList<QPoint>& selection)
+{
+    // Serialize each producer once even when several of its cuts are selected.
+    // The selected clips hold their producers, so the pointers stay unique.
+    QHash<mlt_producer, QString> xmlByProducer;
+    int firstTrack = INT_MAX;
+    int firstPosition = INT_MAX;
+    QList<Item> items;
+    foreach (const QPoint& point, selection) {
+        if (point.y() < 0 || point.y() >= model.trackList().size())
+            continue;
+        QScopedPointer<Mlt::Producer> track(model.tractor()->track(model.trackList().at(point.y()).mlt_index));
+        if (!track)
+            continue;
+        Mlt::Playlist playlist(*track);
+        QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(point.x()));
+        if (!info || !info->producer || !info->producer->is_valid() || info->producer->is_blank()
+                || info->producer->get(kShotcutTransitionProperty))
+            continue;
+        QString& xml = xmlByProducer[info->producer->get_producer()];
+        if (xml.isEmpty())
+            xml = MLT.XML(info->producer);
+        Item item = {xml, point.y(), info->start, info->frame_in, info->frame_out};
+        items << item;
+        firstTrack = qMin(firstTrack, point.y());
+        firstPosition = qMin(firstPosition, info->start);
+    }
+    for (int i = 0; i < items.size(); ++i) {
+        items[i].trackOffset -= firstTrack;
+        items[i].position -= firstPosition;
+    }
+    setItems(items);
+    return items.size();
+}
+
+Mlt::Producer TimelineClipboard::materialize(const Item& item)
+{
+    Mlt::Producer clip(MLT.profile(), "xml-string", item.xml.toUtf8().constData());
+    if (clip.is_valid())
+        clip.set_in_and_out(item.in, item.out);
+    return clip;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMELINECLIPBOARD_H
+#define TIMELINECLIPBOARD_H
+
+#include <QList>
+#include <QPoint>
+#include <QString>
+#include <MltProducer.h>
+
+class MultitrackModel;
+
+/*!
+  \class TimelineClipboard
+  \brief Holds a multi-track selection of timeline clips for pasting.
+
+  Copying takes a snapshot of each clip's producer and its filters as XML
+  along with its in and out points and its place relative to the rest of
+  the selection. Later edits to the timeline do not change what gets
+  pasted, and each paste makes new, independent producers.
+*/
+
+class TimelineClipboard
+{
+public:
+    struct Item {
+        QString xml;     // the clip's parent producer, not a cut
+        int trackOffset; // tracks below the first selected track
+        int position;    // frames after the earliest selected clip
+        int in;
+        int out;
+    };
+
+    TimelineClipboard() : m_trackCount(0) {}
+    void clear() { m_items.clear(); m_trackCount = 0; }
+    bool isEmpty() const { return m_items.isEmpty(); }
+    int count() const { return m_items.size(); }
+    int trackCount() const { return m_trackCount; }
+    const QList<Item>& items() const { return m_items; }
+    void setItems(const QList<Item>& items);
+    int copy(MultitrackModel& model, const QList<QPoint>& selection);
+
+    static Mlt::Producer materialize(const Item& item);
+
+private:
+    QList<Item> m_items;
+    int m_trackCount;
+};
+
+#endif // TIMELINECLIPBOARD_H
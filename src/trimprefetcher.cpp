@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trimprefetcher.h"
+#include "mltcontroller.h"
+#include "seekindex.h"
+#include "util.h"
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <MltProfile.h>
+#include <MltProducer.h>
+#include <MltFrame.h>
+#include <Logger.h>
+
+// Frames kept decoded on each side of the requested frame.
+static const int kWindow = 12;
+
+TrimPrefetcher::TrimPrefetcher(int side, const QString& xml, int width, QObject* parent)
+    : QThread(parent)
+    , m_side(side)
+    , m_xml(xml)
+    , m_width(width)
+    , m_requested(-1)
+    , m_length(0)
+    , m_stopped(false)
+{
+    setObjectName(QString("trim prefetch %1").arg(side));
+}
+
+TrimPrefetcher::~TrimPrefetcher()
+{
+    stop();
+    wait();
+}
+
+QImage TrimPrefetcher::image(int frame)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_images.value(frame);
+}
+
+void TrimPrefetcher::requestFrame(int frame)
+{
+    QMutexLocker locker(&m_mutex);
+    m_requested = frame;
+    // Forget the frames that moved out of reach.
+    QMap<int, QImage>::iterator i = m_images.begin();
+    while (i != m_images.end()) {
+        if (qAbs(i.key() - frame) > 2 * kWindow)
+            i = m_images.erase(i);
+        else
+            ++i;
+    }
+    m_condition.wakeOne();
+}
+
+void TrimPrefetcher::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stopped = true;
+    m_condition.wakeOne();
+}
+
+// Returns the next frame to decode, or -1 when the window is complete. The
+// requested frame comes first, then the frames after it, and then the frames
+// before it from the start of the window, so that each run is decoded
+// forward after a single seek. Call with the mutex locked.
+int TrimPrefetcher::nextFrame(int last) const
+{
+    if (m_requested < 0)
+        return -1;
+    int first = qMax(0, m_requested - kWindow);
+    int end = m_requested + kWindow;
+    if (m_length > 0)
+        end = qMin(end, m_length - 1);
+    if (!m_images.contains(m_requested))
+        return m_requested;
+    // Continue a forward run when possible.
+    if (last >= first && last < end && !m_images.contains(last + 1))
+        return last + 1;
+    for (int i = m_requested + 1; i <= end; ++i)
+        if (!m_images.contains(i))
+            return i;
+    for (int i = first; i < m_requested; ++i)
+        if (!m_images.contains(i))
+            return i;
+    return -1;
+}
+
+void TrimPrefetcher::run()
+{
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+    if (profile.width() > m_width) {
+        int height = Util::coerceMultiple(m_width * profile.height() / profile.width());
+        profile.set_width(Util::coerceMultiple(m_width));
+        profile.set_height(height);
+    }
+    Mlt::Producer producer(profile, "xml-string", m_xml.toUtf8().constData());
+    if (!producer.is_valid()) {
+        LOG_WARNING() << "failed to load the clip to prefetch for side" << m_side;
+        return;
+    }
+    int width = profile.width();
+    int height = profile.height();
+    double fps = profile.fps();
+    QSharedPointer<SeekIndex> index = SeekIndex::find(producer);
+    int last = -1;
+    int decoded = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_length = producer.get_length();
+    }
+
+    forever {
+        int position;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopped && (position = nextFrame(last)) < 0)
+                m_condition.wait(&m_mutex);
+            if (m_stopped)
+                break;
+        }
+        // Within the same group of pictures, decoding forward one frame at a
+        // time is cheaper than the seek back to its keyframe that avformat
+        // makes for longer jumps.
+        if (index && position > last + 1 && index->isSameGroup(last, position, fps))
+            position = last + 1;
+        // Consecutive frames continue decoding without a real seek.
+        producer.seek(position);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        last = position;
+        QImage image;
+        if (frame && frame->is_valid()) {
+            frame->set("rescale.interp", "bilinear");
+            frame->set("consumer_deinterlace", 1);
+            mlt_image_format format = mlt_image_rgb24;
+            int w = width;
+            int h = height;
+            const uchar* data = frame->get_image(format, w, h);
+            if (data && w > 0 && h > 0)
+                image = QImage(data, w, h, 3 * w, QImage::Format_RGB888).copy();
+        }
+        if (image.isNull()) {
+            // Keep a placeholder so the frame is not tried again.
+            image = QImage(1, 1, QImage::Format_RGB888);
+            image.fill(Qt::black);
+        }
+        bool isRequested;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (qAbs(position - m_requested) <= 2 * kWindow)
+                m_images.insert(position, image);
+            isRequested = position == m_requested;
+        }
+        ++decoded;
+        if (isRequested)
+            emit frameReady(m_side, position, image);
+    }
+    LOG_DEBUG() << "trim side" << m_side << "decoded" << decoded << "frames";
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRIMPREFETCHER_H
+#define TRIMPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QMap>
+#include <QString>
+
+/*!
+  \class TrimPrefetcher
+  \brief Keeps a small window of decoded frames around an edit point.
+
+  The frames of one clip are decoded at a reduced size on their own thread.
+  The requested frame is decoded first, then the frames around it in
+  order, so that moving a trim handle by a few frames finds them already
+  decoded instead of seeking again. Frames far from the request are
+  dropped. Audio is never read. When the media has a SeekIndex, longer
+  jumps inside a group of pictures are decoded forward instead of seeking.
+*/
+
+class TrimPrefetcher : public QThread
+{
+    Q_OBJECT
+public:
+    TrimPrefetcher(int side, const QString& xml, int width, QObject* parent = nullptr);
+    ~TrimPrefetcher();
+
+    int side() const { return m_side; }
+    // Returns a null image when the frame is not decoded yet.
+    QImage image(int frame);
+    void requestFrame(int frame);
+    void stop();
+
+signals:
+    void frameReady(int side, int frame, const QImage& image);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    int nextFrame(int last) const;
+
+    int m_side;
+    QString m_xml;
+    int m_width;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QMap<int, QImage> m_images;
+    int m_requested;
+    int m_length;
+    bool m_stopped;
+};
+
+#endif // TRIMPREFETCHER_H
@@ -37,6 +37,7 @@
 #include "shotcut_mlt_properties.h"
 #include "qmltypes/qmlapplication.h"
 #include "proxymanager.h"
+#include "mltcontroller.h"
 
 QString Util::baseName(const QString &filePath)
 {
@@ -420,3 +421,26 @@ QString Util::getHash(Mlt::Properties& properties)
     }
     return hash;
 }
+
+bool Util::isKeyframed(const char* value)
+{
+    // Keyframes look like "0=value;..." or "00:00:01.000=value;..."
+    if (!value || !*value)
+        return false;
+    const char* s = value;
+    while (*s && strchr("0123456789:.-~|!", *s))
+        ++s;
+    return s != value && *s == '=';
+}
+
+QString Util::lut3dService()
+{
+    // Without the Shotcut MLT module LUTs fall back to FFmpeg's filter.
+    static QString service;
+    if (service.isEmpty()) {
+        QScopedPointer<Mlt::Properties> mltFilters(MLT.repository()->filters());
+        service = mltFilters->get_data("shotcut.lut3d")? "shotcut.lut3d" : "avfilter.lut3d";
+        LOG_INFO() << "using" << service << "for 3D LUTs";
+    }
+    return service;
+}
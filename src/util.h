@@ -54,6 +54,8 @@ public:
     static void applyCustomProperties(Mlt::Producer& destination, Mlt::Producer& source, int in, int out);
     static QString getFileHash(const QString& path);
     static QString getHash(Mlt::Properties& properties);
+    static bool isKeyframed(const char* value);
+    static QString lut3dService();
 };
 
 #endif // UTIL_H
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videoqualitymeter.h"
+#include "mltcontroller.h"
+#include "dataqueue.h"
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QQueue>
+#include <QtConcurrent/QtConcurrentRun>
+#include <Logger.h>
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const int kQueueSize = 4;
+static const int kSsimWindow = 8;
+static const double kMaxPsnr = 100.0;
+
+namespace {
+
+struct DecodedFrame
+{
+    Mlt::Frame* frame;
+    const uint8_t* image;
+    int width;
+    int height;
+};
+
+typedef DataQueue<DecodedFrame> FrameQueue;
+
+void decode(Mlt::Producer* producer, int count, int width, int height,
+            FrameQueue* queue, std::function<bool()> isCanceled)
+{
+    for (int i = 0; i < count && !isCanceled(); ++i) {
+        DecodedFrame decoded = {producer->get_frame(), nullptr, width, height};
+        if (decoded.frame && decoded.frame->is_valid()) {
+            mlt_image_format format = mlt_image_yuv420p;
+            decoded.frame->set("consumer_deinterlace", 1);
+            decoded.frame->set("rescale.interp", "bilinear");
+            decoded.image = decoded.frame->get_image(format, decoded.width, decoded.height);
+            if (format != mlt_image_yuv420p)
+                decoded.image = nullptr;
+        }
+        if (!decoded.frame)
+            break;
+        queue->push(decoded);
+    }
+    // An empty frame signals the end of the stream.
+    queue->push(DecodedFrame {nullptr, nullptr, 0, 0});
+}
+
+VideoQualityMeter::FrameResult compare(int position, DecodedFrame a, DecodedFrame b)
+{
+    VideoQualityMeter::FrameResult result;
+    result.position = position;
+    for (int i = 0; i < VideoQualityMeter::PlaneCount; ++i) {
+        result.psnr[i] = 0.0;
+        result.ssim[i] = 0.0;
+    }
+    if (a.image && b.image && a.width == b.width && a.height == b.height) {
+        const uint8_t* planeA = a.image;
+        const uint8_t* planeB = b.image;
+        int width = a.width;
+        int height = a.height;
+        for (int i = 0; i < VideoQualityMeter::PlaneCount; ++i) {
+            if (i == VideoQualityMeter::PlaneCb) {
+                planeA += width * height;
+                planeB += width * height;
+                width /= 2;
+                height /= 2;
+            } else if (i == VideoQualityMeter::PlaneCr) {
+                planeA += width * height;
+                planeB += width * height;
+            }
+            uint64_t sse = VideoQualityMeter::sumSquaredError(planeA, planeB, width, height, width);
+            result.psnr[i] = VideoQualityMeter::psnr(sse, width, height);
+            result.ssim[i] = VideoQualityMeter::ssim(planeA, planeB, width, height, width);
+        }
+    }
+    delete a.frame;
+    delete b.frame;
+    return result;
+}
+
+#if defined(__SSE2__)
+inline int horizontalSum(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+#endif
+
+} // namespace
+
+VideoQualityMeter::VideoQualityMeter(const QString& reference, const QString& encoded)
+    : m_reference(reference)
+    , m_encoded(encoded)
+{
+}
+
+bool VideoQualityMeter::measure(std::function<void(int)> progress, std::function<bool()> isCanceled)
+{
+    m_results.clear();
+    m_error.clear();
+
+    // Use a private profile so that loading the reference does not change the project.
+    Mlt::Profile profile;
+    MLT.copyProfile(profile);
+
+    Mlt::Producer reference(profile, m_reference.toUtf8().constData());
+    Mlt::Producer encoded(profile, m_encoded.toUtf8().constData());
+    if (!reference.is_valid() || !encoded.is_valid()) {
+        m_error = tr("Failed to open %1")
+                .arg(reference.is_valid()? m_encoded : m_reference);
+        return false;
+    }
+    reference.set("audio_index", -1);
+    encoded.set("audio_index", -1);
+    int count = qMin(reference.get_playtime(), encoded.get_playtime());
+    if (count <= 0) {
+        m_error = tr("There are no frames to compare.");
+        return false;
+    }
+    LOG_DEBUG() << "measuring" << count << "frames of" << m_encoded << "against" << m_reference;
+
+    // Each file is decoded on its own thread while frame pairs are compared
+    // on the remaining cores.
+    QThreadPool decodePool;
+    decodePool.setMaxThreadCount(2);
+    QThreadPool comparePool;
+    comparePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    FrameQueue referenceQueue(kQueueSize, FrameQueue::OverflowModeWait);
+    FrameQueue encodedQueue(kQueueSize, FrameQueue::OverflowModeWait);
+    int width = profile.width();
+    int height = profile.height();
+    QtConcurrent::run(&decodePool, [&]() {
+        decode(&reference, count, width, height, &referenceQueue, isCanceled);
+    });
+    QtConcurrent::run(&decodePool, [&]() {
+        decode(&encoded, count, width, height, &encodedQueue, isCanceled);
+    });
+
+    QQueue<QFuture<FrameResult>> pending;
+    bool referenceDone = false;
+    bool encodedDone = false;
+    int position = 0;
+    int previousPercent = -1;
+    m_results.reserve(count);
+    while (!referenceDone && !encodedDone) {
+        DecodedFrame a = referenceQueue.pop();
+        DecodedFrame b = encodedQueue.pop();
+        referenceDone = !a.frame;
+        encodedDone = !b.frame;
+        if (referenceDone || encodedDone || isCanceled()) {
+            delete a.frame;
+            delete b.frame;
+            continue;
+        }
+        pending.enqueue(QtConcurrent::run(&comparePool, compare, position++, a, b));
+        while (pending.size() > comparePool.maxThreadCount()
+               || (!pending.isEmpty() && pending.head().isFinished())) {
+            m_results.append(pending.dequeue().result());
+        }
+        int percent = m_results.size() * 100 / count;
+        if (percent != previousPercent) {
+            progress(percent);
+            previousPercent = percent;
+        }
+    }
+    // Drain whichever decoder is still running so that it can exit.
+    while (!referenceDone) {
+        DecodedFrame a = referenceQueue.pop();
+        referenceDone = !a.frame;
+        delete a.frame;
+    }
+    while (!encodedDone) {
+        DecodedFrame b = encodedQueue.pop();
+        encodedDone = !b.frame;
+        delete b.frame;
+    }
+    while (!pending.isEmpty())
+        m_results.append(pending.dequeue().result());
+    decodePool.waitForDone();
+
+    if (isCanceled())
+        return false;
+    if (m_results.size() < count)
+        LOG_WARNING() << "only measured" << m_results.size() << "of" << count << "frames";
+    return !m_results.isEmpty();
+}
+
+bool VideoQualityMeter::writeReport(const QString& path, double fps) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    double psnr[PlaneCount] = {0.0, 0.0, 0.0};
+    double ssim[PlaneCount] = {0.0, 0.0, 0.0};
+    stream << "frame|time|Y PSNR|Y SSIM|Cb PSNR|Cb SSIM|Cr PSNR|Cr SSIM\n";
+    foreach (const FrameResult& r, m_results) {
+        stream << QString("%1|%2").arg(r.position, 5, 10, QChar('0')).arg(r.position / fps, 0, 'f', 3);
+        for (int i = 0; i < PlaneCount; ++i) {
+            stream << QString("|%1|%2").arg(r.psnr[i], 0, 'f', 2).arg(r.ssim[i], 0, 'f', 4);
+            psnr[i] += r.psnr[i];
+            ssim[i] += r.ssim[i];
+        }
+        stream << "\n";
+    }
+    if (!m_results.isEmpty()) {
+        stream << "average||";
+        for (int i = 0; i < PlaneCount; ++i) {
+            stream << QString("%1|%2").arg(psnr[i] / m_results.size(), 0, 'f', 2)
+                                      .arg(ssim[i] / m_results.size(), 0, 'f', 4);
+            stream << (i + 1 < PlaneCount? "|" : "\n");
+        }
+    }
+    return stream.status() == QTextStream::Ok;
+}
+
+bool VideoQualityMeter::writeCsv(const QString& path, double fps) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    stream << "frame,time,psnr_y,ssim_y,psnr_cb,ssim_cb,psnr_cr,ssim_cr\n";
+    foreach (const FrameResult& r, m_results) {
+        stream << r.position << ',' << QString::number(r.position / fps, 'f', 3);
+        for (int i = 0; i < PlaneCount; ++i)
+            stream << ',' << QString::number(r.psnr[i], 'f', 3) << ',' << QString::number(r.ssim[i], 'f', 5);
+        stream << "\n";
+    }
+    return stream.status() == QTextStream::Ok;
+}
+
+QVector<VideoQualityMeter::FrameResult> VideoQualityMeter::readCsv(const QString& path)
+{
+    QVector<FrameResult> results;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&file);
+        // Skip the header.
+        stream.readLine();
+        while (!stream.atEnd()) {
+            QStringList fields = stream.readLine().split(',');
+            if (fields.size() < 2 + 2 * PlaneCount)
+                continue;
+            FrameResult r;
+            r.position = fields[0].toInt();
+            for (int i = 0; i < PlaneCount; ++i) {
+                r.psnr[i] = fields[2 + 2 * i].toDouble();
+                r.ssim[i] = fields[3 + 2 * i].toDouble();
+            }
+            results.append(r);
+        }
+    }
+    return results;
+}
+
+QVector<VideoQualityMeter::Segment> VideoQualityMeter::worstSegments(
+        const QVector<FrameResult>& results, int windowFrames, int count)
+{
+    QVector<Segment> segments;
+    int n = results.size();
+    windowFrames = qBound(1, windowFrames, qMax(1, n));
+    if (n == 0 || count <= 0)
+        return segments;
+
+    // Mean luma SSIM and PSNR over every window using prefix sums.
+    QVector<double> ssimSum(n + 1, 0.0);
+    QVector<double> psnrSum(n + 1, 0.0);
+    for (int i = 0; i < n; ++i) {
+        ssimSum[i + 1] = ssimSum[i] + results[i].ssim[PlaneY];
+        psnrSum[i + 1] = psnrSum[i] + results[i].psnr[PlaneY];
+    }
+    QVector<Segment> windows;
+    windows.reserve(n - windowFrames + 1);
+    for (int i = 0; i + windowFrames <= n; ++i) {
+        Segment s;
+        s.start = i;
+        s.end = i + windowFrames - 1;
+        s.ssim = (ssimSum[i + windowFrames] - ssimSum[i]) / windowFrames;
+        s.psnr = (psnrSum[i + windowFrames] - psnrSum[i]) / windowFrames;
+        windows.append(s);
+    }
+    std::sort(windows.begin(), windows.end(), [](const Segment& a, const Segment& b) {
+        return a.ssim < b.ssim;
+    });
+
+    // Pick the lowest scoring windows that do not overlap.
+    foreach (const Segment& w, windows) {
+        bool overlaps = false;
+        foreach (const Segment& s, segments) {
+            if (w.start <= s.end && w.end >= s.start) {
+                overlaps = true;
+                break;
+            }
+        }
+        if (!overlaps) {
+            Segment s = w;
+            s.start = results[w.start].position;
+            s.end = results[w.end].position;
+            segments.append(s);
+            if (segments.size() == count)
+                break;
+        }
+    }
+    return segments;
+}
+
+uint64_t VideoQualityMeter::sumSquaredError(const uint8_t* a, const uint8_t* b,
+                                            int width, int height, int stride)
+{
+    uint64_t sum = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* pa = a + y * stride;
+        const uint8_t* pb = b + y * stride;
+        int x = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + x));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + x));
+            __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, lo));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, hi));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        sum += uint64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; x < width; ++x) {
+            int d = pa[x] - pb[x];
+            sum += d * d;
+        }
+    }
+    return sum;
+}
+
+double VideoQualityMeter::psnr(uint64_t sse, int width, int height)
+{
+    if (sse == 0 || width <= 0 || height <= 0)
+        return kMaxPsnr;
+    double mse = double(sse) / (double(width) * height);
+    return qMin(kMaxPsnr, 10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+double VideoQualityMeter::ssim(const uint8_t* a, const uint8_t* b,
+                               int width, int height, int stride)
+{
+    static const double c1 = (0.01 * 255) * (0.01 * 255);
+    static const double c2 = (0.03 * 255) * (0.03 * 255);
+    static const double n = kSsimWindow * kSsimWindow;
+    int windowsX = width / kSsimWindow;
+    int windowsY = height / kSsimWindow;
+    if (windowsX == 0 || windowsY == 0)
+        return 1.0;
+
+    double total = 0.0;
+    for (int wy = 0; wy < windowsY; ++wy) {
+        for (int wx = 0; wx < windowsX; ++wx) {
+            const uint8_t* pa = a + wy * kSsimWindow * stride + wx * kSsimWindow;
+            const uint8_t* pb = b + wy * kSsimWindow * stride + wx * kSsimWindow;
+            int sumA = 0, sumB = 0, sumAA = 0, sumBB = 0, sumAB = 0;
+#if defined(__SSE2__)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i ones = _mm_set1_epi16(1);
+            __m128i sa = zero, sb = zero, saa = zero, sbb = zero, sab = zero;
+            for (int y = 0; y < kSsimWindow; ++y) {
+                __m128i va = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pa + y * stride)), zero);
+                __m128i vb = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pb + y * stride)), zero);
+                sa = _mm_add_epi32(sa, _mm_madd_epi16(va, ones));
+                sb = _mm_add_epi32(sb, _mm_madd_epi16(vb, ones));
+                saa = _mm_add_epi32(saa, _mm_madd_epi16(va, va));
+                sbb = _mm_add_epi32(sbb, _mm_madd_epi16(vb, vb));
+                sab = _mm_add_epi32(sab, _mm_madd_epi16(va, vb));
+            }
+            sumA = horizontalSum(sa);
+            sumB = horizontalSum(sb);
+            sumAA = horizontalSum(saa);
+            sumBB = horizontalSum(sbb);
+            sumAB = horizontalSum(sab);
+#else
+            for (int y = 0; y < kSsimWindow; ++y) {
+                for (int x = 0; x < kSsimWindow; ++x) {
+                    int va = pa[y * stride + x];
+                    int vb = pb[y * stride + x];
+                    sumA += va;
+                    sumB += vb;
+                    sumAA += va * va;
+                    sumBB += vb * vb;
+                    sumAB += va * vb;
+                }
+            }
+#endif
+            double meanA = sumA / n;
+            double meanB = sumB / n;
+            double varA = sumAA / n - meanA * meanA;
+            double varB = sumBB / n - meanB * meanB;
+            double covariance = sumAB / n - meanA * meanB;
+            total += ((2.0 * meanA * meanB + c1) * (2.0 * covariance + c2))
+                   / ((meanA * meanA + meanB * meanB + c1) * (varA + varB + c2));
+        }
+    }
+    return total / (windowsX * windowsY);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOQUALITYMETER_H
+#define VIDEOQUALITYMETER_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <stdint.h>
+
+/*!
+  \class VideoQualityMeter
+  \brief Computes per-frame PSNR and SSIM between two media files.
+
+  The reference and encoded files are decoded concurrently on their own
+  threads into bounded queues, and each pair of frames is compared on a
+  thread pool. The luma and chroma planes of a planar YUV 4:2:0 image are
+  measured separately using SIMD kernels where available.
+*/
+
+class VideoQualityMeter
+{
+    Q_DECLARE_TR_FUNCTIONS(VideoQualityMeter)
+
+public:
+    enum Plane {
+        PlaneY,
+        PlaneCb,
+        PlaneCr,
+        PlaneCount
+    };
+
+    struct FrameResult {
+        int position;
+        double psnr[PlaneCount];
+        double ssim[PlaneCount];
+    };
+
+    struct Segment {
+        int start;
+        int end;
+        double ssim;
+        double psnr;
+    };
+
+    VideoQualityMeter(const QString& reference, const QString& encoded);
+
+    /*!
+      Measures every frame and returns true when all frames were measured.
+      \a progress receives a percentage, and \a isCanceled is polled between
+      frames.
+    */
+    bool measure(std::function<void(int)> progress, std::function<bool()> isCanceled);
+
+    const QVector<FrameResult>& results() const { return m_results; }
+    QString errorString() const { return m_error; }
+    bool writeReport(const QString& path, double fps) const;
+    bool writeCsv(const QString& path, double fps) const;
+
+    static QVector<FrameResult> readCsv(const QString& path);
+    static QVector<Segment> worstSegments(const QVector<FrameResult>& results,
+                                          int windowFrames, int count);
+
+    // Kernels, exposed for reuse by other analyses.
+    static uint64_t sumSquaredError(const uint8_t* a, const uint8_t* b,
+                                    int width, int height, int stride);
+    static double ssim(const uint8_t* a, const uint8_t* b,
+                       int width, int height, int stride);
+    static double psnr(uint64_t sse, int width, int height);
+
+private:
+    QString m_reference;
+    QString m_encoded;
+    QVector<FrameResult> m_results;
+    QString m_error;
+};
+
+#endif // VIDEOQUALITYMETER_H
@@ -26,6 +26,8 @@
 #include "jobs/ffmpegjob.h"
 #include "jobs/meltjob.h"
 #include "jobs/postjobaction.h"
+#include "jobs/qcjob.h"
+#include "jobs/analysisjob.h"
 #include "settings.h"
 #include "mainwindow.h"
 #include "Logger.h"
@@ -87,6 +89,7 @@ AvformatProducerWidget::AvformatProducerWidget(QWidget *parent)
     , ui(new Ui::AvformatProducerWidget)
     , m_defaultDuration(-1)
     , m_recalcDuration(true)
+    , m_askToConvert(false)
     , m_userDefinedCaption(false)
 {
     ui->setupUi(this);
@@ -474,6 +477,16 @@ void AvformatProducerWidget::onFrameDecoded()
     ui->aspectDenSpinBox->setValue(dar_denominator);
     ui->aspectDenSpinBox->blockSignals(false);
 
+    // Offer to conform jittered media with an earlier frame rate analysis.
+    if (m_producer->get_int("video_index") >= 0) {
+        FrameTiming::Result timing;
+        if (FrameTiming::load(FrameTiming::request(*m_producer).cachePath, timing)
+                && FrameTiming::differs(*m_producer, timing)) {
+            offerAnalysis(tr("Detected %1. Click here to conform it.").arg(FrameTiming::toString(timing)),
+                          [=]() { applyFrameTiming(timing, false); });
+        }
+    }
+
     double fps = m_producer->get_double("meta.media.frame_rate_num");
     if (m_producer->get_double("meta.media.frame_rate_den") > 0)
         fps /= m_producer->get_double("meta.media.frame_rate_den");
@@ -485,6 +498,17 @@ void AvformatProducerWidget::onFrameDecoded()
                                       .arg(isVariableFrameRate? tr("(variable)") : "")));
     }
 
+    // Offer an earlier scan mode detection unless the user chose one.
+    if (m_producer->get_int("video_index") >= 0 && !m_producer->get("force_progressive")
+            && !m_producer->get("force_tff")) {
+        FieldDetection::Result detected;
+        if (FieldDetection::load(FieldDetection::request(*m_producer).cachePath, detected)
+                && FieldDetection::differs(*m_producer, detected)) {
+            offerAnalysis(tr("Detected %1. Click here to apply it.").arg(FieldDetection::toString(detected)),
+                          [=]() { applyScanDetection(detected, true); });
+        }
+    }
+
     int progressive = m_producer->get_int("meta.media.progressive");
     if (m_producer->get("force_progressive"))
         progressive = m_producer->get_int("force_progressive");
@@ -521,17 +545,10 @@ void AvformatProducerWidget::onFrameDecoded()
             && !m_producer->get(kMultitrackItemProperty)) {
         m_producer->set(kShotcutSkipConvertProperty, true);
         if (isVariableFrameRate) {
-            MLT.pause();
             LOG_INFO() << resource << "is variable frame rate";
-            TranscodeDialog dialog(tr("This file is variable frame rate, which is not reliable for editing. "
-                                      "Do you want to convert it to an edit-friendly format?\n\n"
-                                      "If yes, choose a format below and then click OK to choose a file name. "
-                                      "After choosing a file name, a job is created. "
-                                      "When it is done, double-click the job to open it.\n"),
-                                   ui->scanComboBox->currentIndex(), this);
-            dialog.setWindowModality(QmlApplication::dialogModality());
-            dialog.showCheckBox();
-            convert(dialog);
+            // Most of these only have jittered timestamps, so find out
+            // before asking to convert.
+            analyzeFrameTiming(true);
         }
         if (QFile::exists(resource) && !MLT.isSeekable(m_producer.data())) {
             MLT.pause();
@@ -695,6 +712,11 @@ void AvformatProducerWidget::on_menuButton_clicked()
     menu.addAction(ui->actionCopyFullFilePath);
     menu.addAction(ui->actionFFmpegInfo);
     menu.addAction(ui->actionFFmpegIntegrityCheck);
+    if (m_producer->get_int("video_index") >= 0) {
+        menu.addAction(ui->actionBroadcastQc);
+        menu.addAction(ui->actionDetectScan);
+        menu.addAction(ui->actionAnalyzeFrameRate);
+    }
     menu.addAction(ui->actionFFmpegConvert);
     menu.addAction(ui->actionExtractSubclip);
     menu.addAction(ui->actionSetFileDate);
@@ -753,6 +775,151 @@ void AvformatProducerWidget::on_actionFFmpegIntegrityCheck_triggered()
     JOBS.add(new FfmpegJob(resource, args));
 }
 
+void AvformatProducerWidget::on_actionBroadcastQc_triggered()
+{
+    QString resource = GetFilenameFromProducer(producer());
+    JOBS.add(new QcJob(resource, MLT.XML(producer()), false,
+                       MLT.profile().frame_rate_num(), MLT.profile().frame_rate_den()));
+}
+
+void AvformatProducerWidget::on_actionDetectScan_triggered()
+{
+    FieldDetection::Request request = FieldDetection::request(*m_producer);
+    FieldDetection::Result result;
+    if (FieldDetection::load(request.cachePath, result)) {
+        applyScanDetection(result, true);
+        return;
+    }
+    AnalysisJob<FieldDetection>* job = new AnalysisJob<FieldDetection>(request.resource, request);
+    connect(job, SIGNAL(finished(AbstractJob*,bool,QString)), this, SLOT(onScanDetectionFinished(AbstractJob*,bool)));
+    JOBS.add(job);
+}
+
+void AvformatProducerWidget::onScanDetectionFinished(AbstractJob* job, bool isSuccess)
+{
+    AnalysisJob<FieldDetection>* detectionJob = dynamic_cast<AnalysisJob<FieldDetection>*>(job);
+    if (isSuccess && detectionJob && m_producer
+            && FieldDetection::request(*m_producer).resource == detectionJob->request().resource
+            && m_producer->get_int("video_index") == detectionJob->request().videoIndex)
+        applyScanDetection(detectionJob->result(), true);
+}
+
+void AvformatProducerWidget::applyScanDetection(const FieldDetection::Result& result, bool overrideUser)
+{
+    MAIN.showStatusMessage(FieldDetection::toString(result));
+    if (FieldDetection::apply(*m_producer, result, overrideUser)) {
+        int progressive = m_producer->get_int("force_progressive");
+        ui->scanComboBox->setCurrentIndex(progressive);
+        if (m_producer->get("force_tff"))
+            ui->fieldOrderComboBox->setCurrentIndex(m_producer->get_int("force_tff"));
+        ui->fieldOrderComboBox->setEnabled(!progressive);
+        emit producerChanged(producer());
+        if (Settings.playerGPU())
+            connect(MLT.videoWidget(), SIGNAL(frameDisplayed(const SharedFrame&)), this, SLOT(onFrameDisplayed(const SharedFrame&)));
+    }
+}
+
+void AvformatProducerWidget::on_actionAnalyzeFrameRate_triggered()
+{
+    analyzeFrameTiming(false);
+}
+
+void AvformatProducerWidget::analyzeFrameTiming(bool askToConvert)
+{
+    FrameTiming::Request request = FrameTiming::request(*m_producer);
+    FrameTiming::Result result;
+    if (FrameTiming::load(request.cachePath, result)) {
+        applyFrameTiming(result, askToConvert);
+        return;
+    }
+    AnalysisJob<FrameTiming>* job = new AnalysisJob<FrameTiming>(request.resource, request);
+    m_askToConvert = askToConvert;
+    connect(job, SIGNAL(finished(AbstractJob*,bool,QString)), this, SLOT(onFrameTimingFinished(AbstractJob*,bool)));
+    JOBS.add(job);
+}
+
+void AvformatProducerWidget::onFrameTimingFinished(AbstractJob* job, bool isSuccess)
+{
+    AnalysisJob<FrameTiming>* timingJob = dynamic_cast<AnalysisJob<FrameTiming>*>(job);
+    if (isSuccess && timingJob && m_producer
+            && FrameTiming::request(*m_producer).resource == timingJob->request().resource
+            && m_producer->get_int("video_index") == timingJob->request().videoIndex)
+        applyFrameTiming(timingJob->result(), m_askToConvert);
+}
+
+// When the analysis ran because the file was opened, only offer to change
+// the clip; otherwise the user asked for it.
+void AvformatProducerWidget::applyFrameTiming(const FrameTiming::Result& result, bool askToConvert)
+{
+    if (askToConvert && FrameTiming::differs(*m_producer, result)) {
+        offerAnalysis(tr("Detected %1. Click here to conform it.").arg(FrameTiming::toString(result)),
+                      [=]() { applyFrameTiming(result, false); });
+        return;
+    }
+    MAIN.showStatusMessage(FrameTiming::toString(result));
+    if (!askToConvert && FrameTiming::apply(*m_producer, result)) {
+        double fps = double(result.rateNum) / result.rateDen;
+        ui->videoTableWidget->setItem(2, 1, new QTableWidgetItem(QString("%L1").arg(fps, 0, 'f', 6)));
+        emit producerChanged(producer());
+    } else if (result.timing == FrameTiming::Variable && (!askToConvert || Settings.showConvertClipDialog())) {
+        askToConvertVariableFrameRate(result);
+    }
+}
+
+void AvformatProducerWidget::askToConvertVariableFrameRate(const FrameTiming::Result& result)
+{
+    MLT.pause();
+    QMessageBox dialog(QMessageBox::Question, qApp->applicationName(),
+                       tr("This file is variable frame rate, which is not reliable for editing.\n\n"
+                          "Shotcut can follow its timestamps to show it at a constant %L1 fps "
+                          "without converting it, in a new clip that refers to this file. "
+                          "Do you want to do that?\n\n"
+                          "Click No to convert it to an edit-friendly format instead.")
+                       .arg(double(result.rateNum) / result.rateDen, 0, 'f', 3),
+                       QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel, this);
+    dialog.setWindowModality(QmlApplication::dialogModality());
+    dialog.setDefaultButton(QMessageBox::Yes);
+    dialog.setEscapeButton(QMessageBox::Cancel);
+    int button = dialog.exec();
+    if (button == QMessageBox::Yes) {
+        QString resource = ProxyManager::resource(*m_producer);
+        QString path = QString("%1/%2 - %3.mlt").arg(Settings.savePath())
+                       .arg(QFileInfo(resource).completeBaseName()).arg(tr("Conformed"));
+        QString filename = QFileDialog::getSaveFileName(this, dialog.windowTitle(), path,
+                                                        tr("MLT XML (*.mlt);;All Files (*)"));
+        if (filename.isEmpty())
+            return;
+        if (!filename.endsWith(".mlt"))
+            filename += ".mlt";
+        if (FrameTiming::conform(*m_producer, result, filename))
+            MAIN.open(filename);
+        else
+            MAIN.showStatusMessage(tr("Failed to write %1").arg(filename));
+    } else if (button == QMessageBox::No) {
+        TranscodeDialog transcodeDialog(tr("Choose an edit-friendly format below and then click OK to choose a file name. "
+                                           "After choosing a file name, a job is created. "
+                                           "When it is done, double-click the job to open it.\n"),
+                                        ui->scanComboBox->currentIndex(), this);
+        transcodeDialog.setWindowModality(QmlApplication::dialogModality());
+        transcodeDialog.showCheckBox();
+        convert(transcodeDialog);
+    }
+}
+
+// Offers to apply an earlier analysis of this media in the status bar, as
+// long as the same media is still shown.
+void AvformatProducerWidget::offerAnalysis(const QString& message, const std::function<void()>& apply)
+{
+    QString hash = Util::getHash(*m_producer);
+    int videoIndex = m_producer->get_int("video_index");
+    QAction* action = new QAction(message, 0);
+    connect(action, &QAction::triggered, this, [=]() {
+        if (m_producer && Util::getHash(*m_producer) == hash && m_producer->get_int("video_index") == videoIndex)
+            apply();
+    });
+    MAIN.showStatusMessage(action, 15);
+}
+
 void AvformatProducerWidget::on_actionFFmpegConvert_triggered()
 {
     TranscodeDialog dialog(tr("Choose an edit-friendly format below and then click OK to choose a file name. "
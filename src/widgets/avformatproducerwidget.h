@@ -23,10 +23,13 @@
 #include "abstractproducerwidget.h"
 #include "sharedframe.h"
 #include "dialogs/transcodedialog.h"
+#include "fielddetection.h"
+#include "frametiming.h"
 
 namespace Ui {
     class AvformatProducerWidget;
 }
+class AbstractJob;
 
 class AvformatProducerWidget : public QWidget, public AbstractProducerWidget
 {
@@ -92,6 +95,15 @@ private slots:
     void on_actionFFmpegInfo_triggered();
 
     void on_actionFFmpegIntegrityCheck_triggered();
+    void on_actionBroadcastQc_triggered();
+
+    void on_actionDetectScan_triggered();
+
+    void onScanDetectionFinished(AbstractJob* job, bool isSuccess);
+
+    void on_actionAnalyzeFrameRate_triggered();
+
+    void onFrameTimingFinished(AbstractJob* job, bool isSuccess);
 
     void on_actionFFmpegConvert_triggered();
 
@@ -126,6 +138,11 @@ private:
     void recreateProducer();
     void convert(TranscodeDialog& dialog);
     bool revertToOriginalResource();
+    void applyScanDetection(const FieldDetection::Result& result, bool overrideUser);
+    void analyzeFrameTiming(bool askToConvert);
+    void applyFrameTiming(const FrameTiming::Result& result, bool askToConvert);
+    void askToConvertVariableFrameRate(const FrameTiming::Result& result);
+    void offerAnalysis(const QString& message, const std::function<void()>& apply);
 };
 
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "multicamwidget.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QKeyEvent>
+#include <cmath>
+
+static const int kSpacing = 2;
+
+MulticamWidget::MulticamWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_active(-1)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setMinimumSize(160, 90);
+}
+
+void MulticamWidget::setAngles(const QStringList& names)
+{
+    m_names = names;
+    m_images.clear();
+    m_images.resize(names.size());
+    if (m_active >= names.size())
+        m_active = -1;
+    update();
+}
+
+void MulticamWidget::setImage(int index, const QImage& image)
+{
+    if (index >= 0 && index < m_images.size()) {
+        m_images[index] = image;
+        update(cellRect(index));
+    }
+}
+
+void MulticamWidget::setActiveAngle(int index)
+{
+    if (index != m_active) {
+        m_active = index;
+        update();
+    }
+}
+
+QRect MulticamWidget::cellRect(int index) const
+{
+    int columns = qMax(1, int(std::ceil(std::sqrt(double(m_names.size())))));
+    int rows = qMax(1, (m_names.size() + columns - 1) / columns);
+    int w = width() / columns;
+    int h = height() / rows;
+    return QRect((index % columns) * w, (index / columns) * h, w, h);
+}
+
+void MulticamWidget::paintEvent(QPaintEvent*)
+{
+    QPainter p(this);
+    p.fillRect(rect(), Qt::black);
+    if (m_names.isEmpty()) {
+        p.setPen(palette().color(QPalette::Text));
+        p.drawText(rect(), Qt::AlignCenter | Qt::TextWordWrap,
+                   tr("Add the camera angles as video tracks, synchronize them, and choose the program track."));
+        return;
+    }
+    for (int i = 0; i < m_names.size(); ++i) {
+        QRect cell = cellRect(i).adjusted(kSpacing, kSpacing, -kSpacing, -kSpacing);
+        const QImage& image = m_images[i];
+        if (!image.isNull()) {
+            QSize size = image.size().scaled(cell.size(), Qt::KeepAspectRatio);
+            QRect target(QPoint(0, 0), size);
+            target.moveCenter(cell.center());
+            p.drawImage(target, image);
+        }
+        QString label = QString("%1: %2").arg(i + 1).arg(m_names[i]);
+        QRect textRect = p.fontMetrics().boundingRect(label).adjusted(-4, -2, 4, 2);
+        textRect.moveTopLeft(cell.topLeft());
+        p.fillRect(textRect, QColor(0, 0, 0, 160));
+        p.setPen(Qt::white);
+        p.drawText(textRect, Qt::AlignCenter, label);
+        if (i == m_active) {
+            p.setPen(QPen(palette().color(QPalette::Highlight), 2 * kSpacing));
+            p.setBrush(Qt::NoBrush);
+            p.drawRect(cell.adjusted(-kSpacing / 2, -kSpacing / 2, kSpacing / 2, kSpacing / 2));
+        }
+    }
+}
+
+void MulticamWidget::mousePressEvent(QMouseEvent* event)
+{
+    for (int i = 0; i < m_names.size(); ++i) {
+        if (cellRect(i).contains(event->pos())) {
+            emit angleClicked(i);
+            return;
+        }
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void MulticamWidget::keyPressEvent(QKeyEvent* event)
+{
+    int index = event->key() - Qt::Key_1;
+    if (event->modifiers() == Qt::NoModifier && index >= 0 && index < qMin(9, m_names.size())) {
+        emit angleClicked(index);
+        event->accept();
+    } else {
+        QWidget::keyPressEvent(event);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MULTICAMWIDGET_H
+#define MULTICAMWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QStringList>
+#include <QVector>
+
+class MulticamWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MulticamWidget(QWidget *parent = 0);
+    void setAngles(const QStringList& names);
+    int count() const { return m_names.size(); }
+    int activeAngle() const { return m_active; }
+
+public slots:
+    void setImage(int index, const QImage& image);
+    void setActiveAngle(int index);
+
+signals:
+    void angleClicked(int index);
+
+protected:
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+    void mousePressEvent(QMouseEvent* event) Q_DECL_OVERRIDE;
+    void keyPressEvent(QKeyEvent* event) Q_DECL_OVERRIDE;
+
+private:
+    QRect cellRect(int index) const;
+
+    QStringList m_names;
+    QVector<QImage> m_images;
+    int m_active;
+};
+
+#endif // MULTICAMWIDGET_H
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2016 Meltytech, LLC
+ * Copyright (c) 2015-2020 Meltytech, LLC
  * Author: Brian Matherly <code@brianmatherly.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -18,14 +18,18 @@
 
 #include "audiospectrumscopewidget.h"
 #include "widgets/audiometerwidget.h"
+#include "spectrumanalyzer.h"
+#include "settings.h"
 #include <Logger.h>
+#include <QAction>
+#include <QActionGroup>
 #include <QPainter>
 #include <QtAlgorithms>
 #include <QVBoxLayout>
-#include <MltProfile.h>
 #include <cmath>
 
-static const int WINDOW_SIZE = 8000; // 6 Hz FFT bins at 48kHz
+static const int HISTORY_SIZE = 256; // frames of waterfall history
+static const double WATERFALL_MIN_DB = -70.0;
 
 struct band
 {
@@ -98,10 +102,49 @@ AudioSpectrumScopeWidget::AudioSpectrumScopeWidget()
     // Setup this widget
     qRegisterMetaType< QVector<double> >("QVector<double>");
 
-    // Create the FFT filter
-    Mlt::Profile profile;
-    m_filter = new Mlt::Filter(profile, "fft");
-    m_filter->set("window_size", WINDOW_SIZE);
+    // Create the spectrum analyzer
+    QVector<SpectrumAnalyzer::Band> bands;
+    for (int i = FIRST_AUDIBLE_BAND_INDEX; i <= LAST_AUDIBLE_BAND_INDEX; i++) {
+        SpectrumAnalyzer::Band band = {BAND_TAB[i].low, BAND_TAB[i].high};
+        bands << band;
+    }
+    m_analyzer = new SpectrumAnalyzer(bands, HISTORY_SIZE);
+    m_windowSize = Settings.audioSpectrumWindowSize();
+    m_showWaterfall = Settings.audioSpectrumShowWaterfall();
+
+    // Waterfall colors from black through blue, green and yellow to red.
+    QLinearGradient gradient(0, 0, 255, 0);
+    gradient.setColorAt(0.0, Qt::black);
+    gradient.setColorAt(0.25, Qt::darkBlue);
+    gradient.setColorAt(0.5, Qt::darkGreen);
+    gradient.setColorAt(0.75, Qt::yellow);
+    gradient.setColorAt(1.0, Qt::red);
+    QImage ramp(256, 1, QImage::Format_RGB32);
+    QPainter rampPainter(&ramp);
+    rampPainter.fillRect(ramp.rect(), gradient);
+    rampPainter.end();
+    for (int i = 0; i < 256; i++)
+        m_colors << ramp.pixel(i, 0);
+
+    // Add the configuration actions to the context menu.
+    setContextMenuPolicy(Qt::ActionsContextMenu);
+    QActionGroup* group = new QActionGroup(this);
+    for (int size = 2048; size <= SpectrumAnalyzer::kMaxWindowSize; size *= 2) {
+        QAction* action = group->addAction(tr("Window Size %1").arg(size));
+        action->setData(size);
+        action->setCheckable(true);
+        action->setChecked(size == m_windowSize);
+    }
+    connect(group, SIGNAL(triggered(QAction*)), this, SLOT(onWindowSizeTriggered(QAction*)));
+    addActions(group->actions());
+    QAction* separator = new QAction(this);
+    separator->setSeparator(true);
+    addAction(separator);
+    QAction* action = new QAction(tr("Waterfall"), this);
+    action->setCheckable(true);
+    action->setChecked(m_showWaterfall);
+    connect(action, SIGNAL(toggled(bool)), this, SLOT(onWaterfallToggled(bool)));
+    addAction(action);
 
     // Add the audio signal widget
     QVBoxLayout *vlayout = new QVBoxLayout(this);
@@ -117,7 +160,13 @@ AudioSpectrumScopeWidget::AudioSpectrumScopeWidget()
     }
     m_audioMeter->setChannelLabels(freqLabels);
     m_audioMeter->setChannelLabelUnits("Hz");
-    vlayout->addWidget(m_audioMeter);
+    vlayout->addWidget(m_audioMeter, 1);
+
+    // The waterfall is painted by this widget in the area of a placeholder.
+    m_waterfall = new QWidget(this);
+    m_waterfall->setMinimumHeight(40);
+    m_waterfall->setVisible(m_showWaterfall);
+    vlayout->addWidget(m_waterfall, 1);
 
     // Config the size.
     m_audioMeter->setOrientation(Qt::Vertical);
@@ -131,82 +180,87 @@ AudioSpectrumScopeWidget::AudioSpectrumScopeWidget()
 
 AudioSpectrumScopeWidget::~AudioSpectrumScopeWidget()
 {
-    delete m_filter;
+    delete m_analyzer;
 }
 
-void AudioSpectrumScopeWidget::processSpectrum()
+void AudioSpectrumScopeWidget::renderWaterfall(int position)
 {
-    QVector<double> bands(AUDIBLE_BAND_COUNT);
-    float* bins = (float*)m_filter->get_data("bins");
-    int bin_count = m_filter->get_int("bin_count");
-    double bin_width = m_filter->get_double("bin_width");
-
-    int band = 0;
-    bool firstBandFound = false;
-    for (int bin = 0; bin < bin_count; bin++) {
-        // Loop through all the FFT bins and align bin frequencies with
-        // band frequencies.
-        double F = bin_width * (double)bin;
-
-        if (!firstBandFound) {
-            // Skip bins that come before the first band.
-            if (BAND_TAB[band + FIRST_AUDIBLE_BAND_INDEX].low > F) {
-                continue;
-            } else {
-                firstBandFound = true;
-                bands[band] = bins[bin];
-            }
-        } else if (BAND_TAB[band + FIRST_AUDIBLE_BAND_INDEX].high < F) {
-            // This bin is outside of this band - move to the next band.
-            band++;
-            if ((band + FIRST_AUDIBLE_BAND_INDEX) > LAST_AUDIBLE_BAND_INDEX) {
-                // Skip bins that come after the last band.
-                break;
-            }
-            bands[band] = bins[bin];
-        } else if (bands[band] < bins[bin] ) {
-            // Pick the highest bin level within this band to represent the
-            // whole band.
-            bands[band] = bins[bin];
-        }
-    }
+    int bandCount = m_analyzer->bandCount();
+    if (m_renderWaterfall.width() != bandCount || m_renderWaterfall.height() != HISTORY_SIZE)
+        m_renderWaterfall = QImage(bandCount, HISTORY_SIZE, QImage::Format_RGB32);
 
-    // At this point, bands contains the magnitude of the signal for each
-    // band. Convert to dB.
-    for (band = 0; band < bands.size(); band++) {
-        double mag = bands[band];
-        double dB = mag > 0.0 ? 20 * log10( mag ) : -1000.0;
-        bands[band] = dB;
+    // Draw the history ending at the current position, newest on top, from
+    // the cached band levels.
+    for (int row = 0; row < HISTORY_SIZE; row++) {
+        QRgb* line = reinterpret_cast<QRgb*>(m_renderWaterfall.scanLine(row));
+        QVector<float> levels = m_analyzer->levels(position - row);
+        if (levels.size() != bandCount) {
+            std::fill(line, line + bandCount, m_colors.first());
+            continue;
+        }
+        for (int band = 0; band < bandCount; band++) {
+            double value = (levels[band] - WATERFALL_MIN_DB) / -WATERFALL_MIN_DB;
+            line[band] = m_colors[qBound(0, int(value * 255.0), 255)];
+        }
     }
 
-    // Update the audio signal widget
-    QMetaObject::invokeMethod(m_audioMeter, "showAudio", Qt::QueuedConnection, Q_ARG(const QVector<double>&, bands));
+    m_mutex.lock();
+    m_displayWaterfall.swap(m_renderWaterfall);
+    m_mutex.unlock();
 }
 
 void AudioSpectrumScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
 {
-    bool refresh = false;
     SharedFrame sFrame;
+    QVector<float> levels;
+    int position = -1;
 
+    m_analyzer->setWindowSize(m_windowSize);
     while (m_queue.count() > 0) {
         sFrame = m_queue.pop();
         if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio( format, frequency, channels, samples );
-            refresh = true;
+            position = sFrame.get_position();
+            levels = m_analyzer->process(position, sFrame.get_audio(), sFrame.get_audio_samples(),
+                                         sFrame.get_audio_channels(), sFrame.get_audio_frequency());
         }
     }
 
-    if (refresh) {
-        processSpectrum();
+    if (position >= 0) {
+        // Update the audio signal widget
+        QVector<double> bands(levels.size());
+        for (int band = 0; band < levels.size(); band++)
+            bands[band] = levels[band];
+        QMetaObject::invokeMethod(m_audioMeter, "showAudio", Qt::QueuedConnection, Q_ARG(const QVector<double>&, bands));
+        if (m_showWaterfall)
+            renderWaterfall(position);
     }
 }
 
+void AudioSpectrumScopeWidget::paintEvent(QPaintEvent*)
+{
+    if (!isVisible() || !m_waterfall->isVisible())
+        return;
+
+    QPainter p(this);
+    m_mutex.lock();
+    p.drawImage(m_waterfall->geometry(), m_displayWaterfall, m_displayWaterfall.rect());
+    m_mutex.unlock();
+    p.end();
+}
+
+void AudioSpectrumScopeWidget::onWindowSizeTriggered(QAction* action)
+{
+    m_windowSize = action->data().toInt();
+    Settings.setAudioSpectrumWindowSize(m_windowSize);
+}
+
+void AudioSpectrumScopeWidget::onWaterfallToggled(bool checked)
+{
+    m_showWaterfall = checked;
+    m_waterfall->setVisible(checked);
+    Settings.setAudioSpectrumShowWaterfall(checked);
+}
+
 QString AudioSpectrumScopeWidget::getTitle()
 {
    return tr("Audio Spectrum");
@@ -21,9 +21,13 @@
 
 
 #include "scopewidget.h"
-#include <MltFilter.h>
+#include <QAtomicInt>
+#include <QImage>
+#include <QMutex>
+#include <QVector>
 
 class AudioMeterWidget;
+class SpectrumAnalyzer;
 
 class AudioSpectrumScopeWidget Q_DECL_FINAL : public ScopeWidget
 {
@@ -34,16 +38,32 @@ public:
     ~AudioSpectrumScopeWidget();
     QString getTitle() Q_DECL_OVERRIDE;
 
+protected:
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+
+private slots:
+    void onWindowSizeTriggered(QAction* action);
+    void onWaterfallToggled(bool checked);
+
 private:
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
-    void processSpectrum();
+    void renderWaterfall(int position);
 
     // Members accessed by scope thread.
-    Mlt::Filter* m_filter;
+    SpectrumAnalyzer* m_analyzer;
+    QVector<QRgb> m_colors;
+    QImage m_renderWaterfall;
+
+    // Members accessed in multiple threads (mutex protected).
+    QMutex m_mutex;
+    QImage m_displayWaterfall;
+    QAtomicInt m_windowSize;
+    QAtomicInt m_showWaterfall;
 
     // Members accessed only in the GUI thread
     AudioMeterWidget* m_audioMeter;
+    QWidget* m_waterfall;
 };
 
 #endif // AUDIOSPECTRUMSCOPEWIDGET_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trimmonitorwidget.h"
+#include <QPainter>
+
+static const int kSpacing = 2;
+
+TrimMonitorWidget::TrimMonitorWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setMinimumSize(320, 90);
+}
+
+void TrimMonitorWidget::setLabel(int side, const QString& label)
+{
+    if (side == OutgoingSide || side == IncomingSide) {
+        m_labels[side] = label;
+        update(sideRect(side));
+    }
+}
+
+void TrimMonitorWidget::setImage(int side, const QImage& image)
+{
+    if (side == OutgoingSide || side == IncomingSide) {
+        m_images[side] = image;
+        update(sideRect(side));
+    }
+}
+
+void TrimMonitorWidget::clear()
+{
+    for (int i = OutgoingSide; i <= IncomingSide; ++i) {
+        m_images[i] = QImage();
+        m_labels[i].clear();
+    }
+    update();
+}
+
+QRect TrimMonitorWidget::sideRect(int side) const
+{
+    int w = width() / 2;
+    return QRect(side * w, 0, w, height());
+}
+
+void TrimMonitorWidget::paintEvent(QPaintEvent*)
+{
+    QPainter p(this);
+    p.fillRect(rect(), Qt::black);
+    if (m_labels[OutgoingSide].isEmpty() && m_labels[IncomingSide].isEmpty()) {
+        p.setPen(palette().color(QPalette::Text));
+        p.drawText(rect(), Qt::AlignCenter | Qt::TextWordWrap,
+                   tr("Drag the edge of a clip in the timeline to see the frames on both sides of the edit."));
+        return;
+    }
+    for (int i = OutgoingSide; i <= IncomingSide; ++i) {
+        QRect cell = sideRect(i).adjusted(kSpacing, kSpacing, -kSpacing, -kSpacing);
+        const QImage& image = m_images[i];
+        if (!image.isNull() && !m_labels[i].isEmpty()) {
+            QSize size = image.size().scaled(cell.size(), Qt::KeepAspectRatio);
+            QRect target(QPoint(0, 0), size);
+            target.moveCenter(cell.center());
+            p.drawImage(target, image);
+        }
+        if (m_labels[i].isEmpty())
+            continue;
+        QRect textRect = p.fontMetrics().boundingRect(m_labels[i]).adjusted(-4, -2, 4, 2);
+        textRect.moveBottomLeft(cell.bottomLeft());
+        p.fillRect(textRect, QColor(0, 0, 0, 160));
+        p.setPen(Qt::white);
+        p.drawText(textRect, Qt::AlignCenter, m_labels[i]);
+    }
+}
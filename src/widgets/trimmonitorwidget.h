@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRIMMONITORWIDGET_H
+#define TRIMMONITORWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QString>
+
+class TrimMonitorWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    enum Side {
+        OutgoingSide,
+        IncomingSide
+    };
+
+    explicit TrimMonitorWidget(QWidget *parent = 0);
+    void setLabel(int side, const QString& label);
+    void clear();
+
+public slots:
+    void setImage(int side, const QImage& image);
+
+protected:
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+
+private:
+    QRect sideRect(int side) const;
+
+    QImage m_images[2];
+    QString m_labels[2];
+};
+
+#endif // TRIMMONITORWIDGET_H
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videoqualitygraph.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QMouseEvent>
+#include <QToolTip>
+
+static const int MARGIN = 4;
+static const QColor SSIM_COLOR(86, 199, 255);
+static const QColor PSNR_COLOR(255, 190, 60);
+static const QColor SEGMENT_COLOR(255, 40, 40, 60);
+
+VideoQualityGraph::VideoQualityGraph(QWidget *parent)
+    : QWidget(parent)
+    , m_highlighted(-1)
+    , m_minSsim(0.0)
+    , m_minPsnr(0.0)
+    , m_maxPsnr(100.0)
+{
+    setMouseTracking(true);
+    setMinimumHeight(150);
+}
+
+void VideoQualityGraph::setResults(const QVector<VideoQualityMeter::FrameResult>& results)
+{
+    m_results = results;
+    m_minSsim = 1.0;
+    m_minPsnr = 100.0;
+    m_maxPsnr = 0.0;
+    foreach (const VideoQualityMeter::FrameResult& r, m_results) {
+        m_minSsim = qMin(m_minSsim, r.ssim[VideoQualityMeter::PlaneY]);
+        m_minPsnr = qMin(m_minPsnr, r.psnr[VideoQualityMeter::PlaneY]);
+        m_maxPsnr = qMax(m_maxPsnr, r.psnr[VideoQualityMeter::PlaneY]);
+    }
+    if (m_maxPsnr <= m_minPsnr)
+        m_maxPsnr = m_minPsnr + 1.0;
+    if (m_minSsim >= 1.0)
+        m_minSsim = 0.99;
+    update();
+}
+
+void VideoQualityGraph::setSegments(const QVector<VideoQualityMeter::Segment>& segments)
+{
+    m_segments = segments;
+    m_highlighted = -1;
+    update();
+}
+
+void VideoQualityGraph::setHighlightedSegment(int index)
+{
+    m_highlighted = index;
+    update();
+}
+
+QRectF VideoQualityGraph::graphRect() const
+{
+    return QRectF(rect()).adjusted(MARGIN, MARGIN, -MARGIN, -MARGIN);
+}
+
+double VideoQualityGraph::xForPosition(int position) const
+{
+    QRectF r = graphRect();
+    if (m_results.size() < 2)
+        return r.left();
+    int first = m_results.first().position;
+    int last = m_results.last().position;
+    return r.left() + r.width() * (position - first) / qMax(1, last - first);
+}
+
+int VideoQualityGraph::indexAt(double x) const
+{
+    QRectF r = graphRect();
+    if (m_results.isEmpty() || r.width() <= 0)
+        return -1;
+    int index = qRound((x - r.left()) / r.width() * (m_results.size() - 1));
+    return qBound(0, index, m_results.size() - 1);
+}
+
+void VideoQualityGraph::paintEvent(QPaintEvent*)
+{
+    QPainter p(this);
+    QRectF r = graphRect();
+    p.fillRect(rect(), palette().base());
+    if (m_results.isEmpty()) {
+        p.setPen(palette().text().color());
+        p.drawText(rect(), Qt::AlignCenter, tr("No results"));
+        return;
+    }
+
+    // Worst segments.
+    for (int i = 0; i < m_segments.size(); ++i) {
+        double x1 = xForPosition(m_segments[i].start);
+        double x2 = xForPosition(m_segments[i].end);
+        QColor color = SEGMENT_COLOR;
+        if (i == m_highlighted)
+            color.setAlpha(140);
+        p.fillRect(QRectF(x1, r.top(), qMax(1.0, x2 - x1), r.height()), color);
+    }
+
+    // Reduce to at most one point per pixel column using the minimum.
+    int columns = qMax(1, int(r.width()));
+    QPainterPath ssimPath;
+    QPainterPath psnrPath;
+    double step = double(m_results.size()) / columns;
+    for (int c = 0; c < columns && c * step < m_results.size(); ++c) {
+        int begin = int(c * step);
+        int end = qMin(m_results.size(), qMax(begin + 1, int((c + 1) * step)));
+        double ssim = 1.0;
+        double psnr = m_maxPsnr;
+        for (int i = begin; i < end; ++i) {
+            ssim = qMin(ssim, m_results[i].ssim[VideoQualityMeter::PlaneY]);
+            psnr = qMin(psnr, m_results[i].psnr[VideoQualityMeter::PlaneY]);
+        }
+        double x = r.left() + r.width() * c / columns;
+        double ySsim = r.bottom() - r.height() * (ssim - m_minSsim) / (1.0 - m_minSsim);
+        double yPsnr = r.bottom() - r.height() * (psnr - m_minPsnr) / (m_maxPsnr - m_minPsnr);
+        if (c == 0) {
+            ssimPath.moveTo(x, ySsim);
+            psnrPath.moveTo(x, yPsnr);
+        } else {
+            ssimPath.lineTo(x, ySsim);
+            psnrPath.lineTo(x, yPsnr);
+        }
+    }
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(QPen(PSNR_COLOR, 1.0));
+    p.drawPath(psnrPath);
+    p.setPen(QPen(SSIM_COLOR, 1.5));
+    p.drawPath(ssimPath);
+
+    // Legend.
+    p.setPen(SSIM_COLOR);
+    p.drawText(r, Qt::AlignLeft | Qt::AlignTop, tr("Y SSIM (%1 - 1.0)").arg(m_minSsim, 0, 'f', 3));
+    p.setPen(PSNR_COLOR);
+    p.drawText(r, Qt::AlignRight | Qt::AlignTop, tr("Y PSNR (%1 - %2 dB)")
+               .arg(m_minPsnr, 0, 'f', 1).arg(m_maxPsnr, 0, 'f', 1));
+}
+
+void VideoQualityGraph::mouseMoveEvent(QMouseEvent* event)
+{
+    int index = indexAt(event->pos().x());
+    if (index >= 0) {
+        const VideoQualityMeter::FrameResult& r = m_results[index];
+        QToolTip::showText(event->globalPos(), tr("Frame %1\nY SSIM %2\nY PSNR %3 dB")
+                           .arg(r.position)
+                           .arg(r.ssim[VideoQualityMeter::PlaneY], 0, 'f', 4)
+                           .arg(r.psnr[VideoQualityMeter::PlaneY], 0, 'f', 2), this);
+    }
+}
+
+void VideoQualityGraph::mousePressEvent(QMouseEvent* event)
+{
+    int index = indexAt(event->pos().x());
+    if (index >= 0)
+        emit positionClicked(m_results[index].position);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOQUALITYGRAPH_H
+#define VIDEOQUALITYGRAPH_H
+
+#include <QWidget>
+#include <QVector>
+#include "videoqualitymeter.h"
+
+class VideoQualityGraph : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit VideoQualityGraph(QWidget *parent = 0);
+    void setResults(const QVector<VideoQualityMeter::FrameResult>& results);
+    void setSegments(const QVector<VideoQualityMeter::Segment>& segments);
+    void setHighlightedSegment(int index);
+
+signals:
+    void positionClicked(int position);
+
+protected:
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+    void mouseMoveEvent(QMouseEvent*) Q_DECL_OVERRIDE;
+    void mousePressEvent(QMouseEvent*) Q_DECL_OVERRIDE;
+
+private:
+    QRectF graphRect() const;
+    int indexAt(double x) const;
+    double xForPosition(int position) const;
+
+    QVector<VideoQualityMeter::FrameResult> m_results;
+    QVector<VideoQualityMeter::Segment> m_segments;
+    int m_highlighted;
+    double m_minSsim;
+    double m_minPsnr;
+    double m_maxPsnr;
+};
+
+#endif // VIDEOQUALITYGRAPH_H
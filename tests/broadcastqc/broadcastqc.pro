@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_broadcastqc
+SOURCES += tst_broadcastqc.cpp
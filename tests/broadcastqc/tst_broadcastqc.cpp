@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QStandardPaths>
+
+#include "broadcastqc.h"
+#include "mltcontroller.h"
+#include <MltProducer.h>
+#include <MltRepository.h>
+#include <cmath>
+#include <cstring>
+
+static const int kFrames = 250; // 10 seconds at 25 fps
+static const double kToneLevel = -23.0; // dBFS, which is also its loudness in LUFS
+
+class TestBroadcastQc : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Returns frames of silent black video with the given loudness.
+    static QVector<BroadcastQc::FrameStats> frames(int count, double loudness)
+    {
+        QVector<BroadcastQc::FrameStats> result;
+        for (int i = 0; i < count; ++i) {
+            BroadcastQc::FrameStats stats;
+            memset(&stats, 0, sizeof(stats));
+            stats.position = i;
+            stats.lumaMin = stats.lumaMax = stats.lumaMean = 16;
+            stats.momentary = stats.shortTerm = qint16(qRound(loudness * 10.0));
+            stats.truePeak = qint16(qRound((loudness + 3.0) * 10.0));
+            result << stats;
+        }
+        return result;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+        MLT.profile().set_width(320);
+        MLT.profile().set_height(180);
+        MLT.profile().set_sample_aspect(1, 1);
+        MLT.profile().set_display_aspect(16, 9);
+        MLT.profile().set_frame_rate(25, 1);
+        MLT.profile().set_progressive(1);
+    }
+
+    void defaultLimitsFollowR128()
+    {
+        BroadcastQc::Limits limits = BroadcastQc::defaultLimits();
+        QCOMPARE(limits.truePeak, -1.0);
+        QCOMPARE(limits.shortTerm, -18.0);
+        QCOMPARE(limits.programLoudness, -23.0);
+
+        BroadcastQc::FrameStats stats = frames(1, -23.0).first();
+        QCOMPARE(BroadcastQc::violations(stats, limits), int(BroadcastQc::NoViolation));
+        stats.shortTerm = -170;
+        QCOMPARE(BroadcastQc::violations(stats, limits), int(BroadcastQc::LoudnessViolation));
+        stats.shortTerm = -180;
+        stats.truePeak = -5;
+        QCOMPARE(BroadcastQc::violations(stats, limits), int(BroadcastQc::AudioViolation));
+    }
+
+    void flagsRegionsAboveLoudnessLimit()
+    {
+        QVector<BroadcastQc::FrameStats> list = frames(100, -24.0);
+        for (int i = 40; i < 60; ++i)
+            list[i].shortTerm = -150;
+        QVector<BroadcastQc::Region> regions = BroadcastQc::regions(list, BroadcastQc::defaultLimits());
+        QCOMPARE(regions.size(), 1);
+        QCOMPARE(regions.first().start, 40);
+        QCOMPARE(regions.first().end, 59);
+        QCOMPARE(regions.first().violations, int(BroadcastQc::LoudnessViolation));
+
+        // A stricter limit flags the whole program.
+        BroadcastQc::Limits limits = BroadcastQc::defaultLimits();
+        limits.shortTerm = -25.0;
+        regions = BroadcastQc::regions(list, limits);
+        QCOMPARE(regions.size(), 1);
+        QCOMPARE(regions.first().start, 0);
+        QCOMPARE(regions.first().end, 99);
+    }
+
+    void gatesProgramLoudness()
+    {
+        QVector<BroadcastQc::FrameStats> list = frames(100, -23.0);
+        QVERIFY(qAbs(BroadcastQc::programLoudness(list) - -23.0) < 0.1);
+
+        // Quiet passages below the relative gate do not lower the program loudness.
+        list += frames(100, -40.0);
+        QVERIFY(qAbs(BroadcastQc::programLoudness(list) - -23.0) < 0.1);
+        QVERIFY(!std::isfinite(BroadcastQc::programLoudness(frames(10, -100.0))));
+    }
+
+    void measuresToneLoudness()
+    {
+        QScopedPointer<Mlt::Properties> filters(MLT.repository()->filters());
+        if (!filters->get_data("loudness_meter"))
+            QSKIP("loudness_meter is not available");
+        Mlt::Producer tone(MLT.profile(), "tone");
+        if (!tone.is_valid())
+            QSKIP("tone is not available");
+        tone.set("level", kToneLevel);
+        tone.set("length", kFrames);
+        tone.set_in_and_out(0, kFrames - 1);
+
+        BroadcastQc::Limits limits = BroadcastQc::defaultLimits();
+        limits.shortTerm = kToneLevel - 2.0;
+        BroadcastQc qc(MLT.XML(&tone), limits);
+        QVERIFY(qc.analyze([](int) {}, []() { return false; }));
+        QCOMPARE(qc.frames().size(), kFrames);
+        const BroadcastQc::FrameStats& last = qc.frames().last();
+        QVERIFY(qAbs(last.shortTerm / 10.0 - kToneLevel) < 1.0);
+        QVERIFY(qAbs(BroadcastQc::programLoudness(qc.frames()) - kToneLevel) < 1.0);
+
+        // The tone stays above the lowered limit once the window is full.
+        QVector<BroadcastQc::Region> regions = BroadcastQc::regions(qc.frames(), limits);
+        QVERIFY(!regions.isEmpty());
+        QCOMPARE(regions.last().end, kFrames - 1);
+        QVERIFY(regions.last().violations & BroadcastQc::LoudnessViolation);
+        QVERIFY(!(regions.last().violations & BroadcastQc::AudioViolation));
+        foreach (const BroadcastQc::Region& r, BroadcastQc::regions(qc.frames(), BroadcastQc::defaultLimits()))
+            QVERIFY(!(r.violations & (BroadcastQc::LoudnessViolation | BroadcastQc::AudioViolation)));
+    }
+};
+
+QTEST_MAIN(TestBroadcastQc)
+
+#include "tst_broadcastqc.moc"
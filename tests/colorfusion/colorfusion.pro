@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_colorfusion
+SOURCES += tst_colorfusion.cpp
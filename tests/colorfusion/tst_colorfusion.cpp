@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "colorfusion.h"
+#include "mltcontroller.h"
+#include <MltFilter.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+static const int kBenchmarkWidth = 3840;
+static const int kBenchmarkHeight = 2160;
+
+class TestColorFusion : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_folder;
+
+    // A clip with two brightness filters and a lift, gamma and gain.
+    Mlt::Producer* createClip(Mlt::Profile& profile)
+    {
+        Mlt::Producer* producer = new Mlt::Producer(profile, "color", "#ff80604f");
+        producer->set("length", 100);
+        Mlt::Filter darken(profile, "brightness");
+        darken.set("level", 0.8);
+        producer->attach(darken);
+        Mlt::Filter grade(profile, "lift_gamma_gain");
+        grade.set("gamma_r", 1.2);
+        grade.set("gamma_g", 1.0);
+        grade.set("gamma_b", 0.9);
+        producer->attach(grade);
+        Mlt::Filter brighten(profile, "brightness");
+        brighten.set("level", 1.1);
+        producer->attach(brighten);
+        return producer;
+    }
+
+    void renderFrame(Mlt::Producer& producer)
+    {
+        producer.seek(0);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        mlt_image_format format = mlt_image_rgb24;
+        int width = kBenchmarkWidth;
+        int height = kBenchmarkHeight;
+        QVERIFY(frame->get_image(format, width, height));
+    }
+
+    void setProfileSize(Mlt::Profile& profile, int width, int height)
+    {
+        profile.set_width(width);
+        profile.set_height(height);
+        profile.set_sample_aspect(1, 1);
+        profile.set_display_aspect(width, height);
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+        QVERIFY(m_folder.isValid());
+    }
+
+    void findsRun()
+    {
+        QScopedPointer<Mlt::Producer> clip(createClip(MLT.profile()));
+        QList<ColorFusion::Run> runs = ColorFusion::findRuns(*clip);
+        QCOMPARE(runs.size(), 1);
+        QCOMPARE(runs.first(), ColorFusion::Run() << 0 << 1 << 2);
+    }
+
+    void fuseWritesTableToFolder()
+    {
+        QScopedPointer<Mlt::Producer> clip(createClip(MLT.profile()));
+        QString error;
+        QScopedPointer<Mlt::Filter> fused(ColorFusion::fuse(*clip, ColorFusion::findRuns(*clip).first(),
+                                                            m_folder.path(), &error));
+        QVERIFY2(fused, qPrintable(error));
+        QVERIFY(ColorFusion::isFused(*fused));
+        QFileInfo table(QString::fromUtf8(fused->get("av.file")));
+        QVERIFY(table.exists());
+        QCOMPARE(table.absolutePath(), QDir(m_folder.path()).absolutePath());
+    }
+
+    void unfuseRestoresFilters()
+    {
+        QScopedPointer<Mlt::Producer> clip(createClip(MLT.profile()));
+        QScopedPointer<Mlt::Filter> fused(ColorFusion::fuse(*clip, ColorFusion::findRuns(*clip).first(),
+                                                            m_folder.path()));
+        QVERIFY(fused);
+        QList<Mlt::Filter*> filters = ColorFusion::unfuse(*fused);
+        QCOMPARE(filters.size(), 3);
+        QCOMPARE(QString(filters[1]->get("mlt_service")), QString("lift_gamma_gain"));
+        QCOMPARE(filters[2]->get_double("level"), 1.1);
+        qDeleteAll(filters);
+    }
+
+    void lutFolderIsNextToProject()
+    {
+        QCOMPARE(ColorFusion::lutFolder("/videos/project.mlt"), QString("/videos/luts"));
+    }
+
+    void benchmarkFilters()
+    {
+        Mlt::Profile profile;
+        setProfileSize(profile, kBenchmarkWidth, kBenchmarkHeight);
+        QScopedPointer<Mlt::Producer> clip(createClip(profile));
+        QBENCHMARK {
+            renderFrame(*clip);
+        }
+    }
+
+    void benchmarkFused()
+    {
+        Mlt::Profile profile;
+        setProfileSize(profile, kBenchmarkWidth, kBenchmarkHeight);
+        QScopedPointer<Mlt::Producer> clip(createClip(profile));
+        ColorFusion::Run run = ColorFusion::findRuns(*clip).first();
+        QScopedPointer<Mlt::Filter> fused(ColorFusion::fuse(*clip, run, m_folder.path()));
+        QVERIFY(fused);
+        for (int i = run.size() - 1; i >= 0; --i) {
+            QScopedPointer<Mlt::Filter> filter(clip->filter(run[i]));
+            clip->detach(*filter);
+        }
+        clip->attach(*fused);
+        QBENCHMARK {
+            renderFrame(*clip);
+        }
+    }
+};
+
+QTEST_MAIN(TestColorFusion)
+
+#include "tst_colorfusion.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_filterpanelpool
+SOURCES += tst_filterpanelpool.cpp
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QPointer>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QTemporaryDir>
+
+#include "qmltypes/filterpanelpool.h"
+
+// Stands in for a ui.qml panel. Its bindings read all three context
+// properties, as the real panels do.
+static const char* kPanelQml =
+    "import QtQuick 2.1\n"
+    "Item {\n"
+    "    width: 200; height: 50\n"
+    "    property int rebinds: 0\n"
+    "    property string filterName: filter.objectName\n"
+    "    property string metadataName: metadata.objectName\n"
+    "    property string producerName: producer.objectName\n"
+    "%1"
+    "}\n";
+static const char* kRebind = "    function rebind() { rebinds++ }\n";
+
+class TestFilterPanelPool : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QQmlEngine* m_engine;
+    QObject m_producer;
+    QObject m_filter;
+    QObject m_metadata;
+    QUrl m_pooled;
+    QUrl m_unpooled;
+    int m_warnings;
+
+    QUrl writePanel(const QString& name, bool hasRebind)
+    {
+        QFile file(m_dir.filePath(name));
+        if (!file.open(QIODevice::WriteOnly))
+            return QUrl();
+        file.write(QString(kPanelQml).arg(hasRebind? kRebind : "").toUtf8());
+        return QUrl::fromLocalFile(file.fileName());
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+        m_pooled = writePanel("pooled.qml", true);
+        m_unpooled = writePanel("unpooled.qml", false);
+        m_producer.setObjectName("producer");
+        m_filter.setObjectName("filter");
+        m_metadata.setObjectName("metadata");
+    }
+
+    void init()
+    {
+        m_engine = new QQmlEngine;
+        m_warnings = 0;
+        connect(m_engine, &QQmlEngine::warnings, this, [this](const QList<QQmlError>& errors) {
+            m_warnings += errors.size();
+        });
+    }
+
+    void cleanup()
+    {
+        delete m_engine;
+        m_engine = nullptr;
+    }
+
+    void reusesPanelsWithRebind()
+    {
+        FilterPanelPool pool(m_engine->rootContext(), &m_producer);
+        QQuickItem parent;
+        QQuickItem* item = pool.acquire(m_pooled, &m_filter, &m_metadata, &parent);
+        QVERIFY(item);
+        QCOMPARE(item->property("filterName").toString(), QString("filter"));
+        pool.release(item);
+
+        QObject otherFilter;
+        otherFilter.setObjectName("other");
+        QQuickItem* reused = pool.acquire(m_pooled, &otherFilter, &m_metadata, &parent);
+        QCOMPARE(reused, item);
+        QCOMPARE(reused->property("rebinds").toInt(), 1);
+        QCOMPARE(reused->property("filterName").toString(), QString("other"));
+        QCOMPARE(reused->property("producerName").toString(), QString("producer"));
+        pool.release(reused);
+        QCOMPARE(m_warnings, 0);
+    }
+
+    void destroysPanelsWithoutRebind()
+    {
+        FilterPanelPool pool(m_engine->rootContext(), &m_producer);
+        QQuickItem parent;
+        QPointer<QQuickItem> item = pool.acquire(m_unpooled, &m_filter, &m_metadata, &parent);
+        QVERIFY(item);
+        QVERIFY(!FilterPanelPool::isPoolable(item));
+        pool.release(item);
+        // Gone before the filter can be deleted, not at the next event loop.
+        QVERIFY(item.isNull());
+        QCOMPARE(m_warnings, 0);
+    }
+
+    void parkedPanelOutlivesItsFilter()
+    {
+        FilterPanelPool pool(m_engine->rootContext(), &m_producer);
+        QQuickItem parent;
+        QObject* filter = new QObject;
+        QQuickItem* item = pool.acquire(m_pooled, filter, &m_metadata, &parent);
+        QVERIFY(item);
+        pool.release(item);
+        delete filter;
+        QCoreApplication::processEvents();
+        QVERIFY(item->property("filterName").toString() != QString("filter"));
+        QCOMPARE(m_warnings, 0);
+    }
+
+    void benchmarkCreate()
+    {
+        FilterPanelPool pool(m_engine->rootContext(), &m_producer);
+        QQuickItem parent;
+        QBENCHMARK {
+            pool.release(pool.acquire(m_unpooled, &m_filter, &m_metadata, &parent));
+        }
+    }
+
+    void benchmarkReuse()
+    {
+        FilterPanelPool pool(m_engine->rootContext(), &m_producer);
+        QQuickItem parent;
+        pool.release(pool.acquire(m_pooled, &m_filter, &m_metadata, &parent));
+        QBENCHMARK {
+            pool.release(pool.acquire(m_pooled, &m_filter, &m_metadata, &parent));
+        }
+    }
+};
+
+QTEST_MAIN(TestFilterPanelPool)
+
+#include "tst_filterpanelpool.moc"
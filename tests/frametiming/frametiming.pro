@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_frametiming
+SOURCES += tst_frametiming.cpp
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "frametiming.h"
+
+static const double kRate = 30000.0 / 1001.0;
+
+class TestFrameTiming : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    // Moves every fifth frame by jitter frames.
+    static QVector<double> grid(int count, double jitter = 0.0)
+    {
+        QVector<double> timestamps;
+        for (int i = 0; i < count; ++i)
+            timestamps << (i + (i % 5 == 2? jitter : 0.0)) / kRate;
+        return timestamps;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        QVERIFY(m_dir.isValid());
+    }
+
+    void constant()
+    {
+        FrameTiming::Result result = FrameTiming::classify(grid(300));
+        QCOMPARE(result.timing, FrameTiming::Constant);
+        QCOMPARE(result.rateNum, 30000);
+        QCOMPARE(result.rateDen, 1001);
+        QVERIFY(result.frameSlots.isEmpty());
+    }
+
+    void jittered()
+    {
+        FrameTiming::Result result = FrameTiming::classify(grid(300, 0.3));
+        QCOMPARE(result.timing, FrameTiming::Jittered);
+        QCOMPARE(result.rateNum, 30000);
+        QCOMPARE(result.duplicates, 0);
+        QCOMPARE(result.gaps, 0);
+    }
+
+    void variableMap()
+    {
+        // Drop the frame in slot 10 and add one right after slot 20.
+        QVector<double> timestamps = grid(300);
+        timestamps.remove(10);
+        timestamps.insert(20, timestamps[19] + 0.1 / kRate);
+        FrameTiming::Result result = FrameTiming::classify(timestamps);
+        QCOMPARE(result.timing, FrameTiming::Variable);
+        QCOMPARE(result.gaps, 1);
+        QCOMPARE(result.duplicates, 1);
+        QCOMPARE(result.frameSlots.size(), timestamps.size());
+
+        QVector<int> map = FrameTiming::gridMap(result.frameSlots);
+        QCOMPARE(map.size(), 300);
+        QCOMPARE(map[9], 9);
+        QCOMPARE(map[10], 9);
+        QCOMPARE(map[11], 11);
+        for (int slot = 12; slot < map.size(); ++slot)
+            QCOMPARE(map[slot], slot);
+    }
+
+    void unknown()
+    {
+        QCOMPARE(FrameTiming::classify(grid(2)).timing, FrameTiming::Unknown);
+        QVERIFY(!FrameTiming::isValid(FrameTiming::classify(grid(2))));
+    }
+
+    void cacheRoundTrip()
+    {
+        QVector<double> timestamps = grid(100);
+        timestamps.remove(50);
+        FrameTiming::Result result = FrameTiming::classify(timestamps);
+        QString path = m_dir.filePath("media.timing");
+        QVERIFY(FrameTiming::save(path, result));
+
+        FrameTiming::Result loaded;
+        QVERIFY(FrameTiming::load(path, loaded));
+        QCOMPARE(loaded.timing, result.timing);
+        QCOMPARE(loaded.rateNum, result.rateNum);
+        QCOMPARE(loaded.rateDen, result.rateDen);
+        QCOMPARE(loaded.gaps, result.gaps);
+        QCOMPARE(loaded.frameSlots, result.frameSlots);
+        QVERIFY(!FrameTiming::load(QString(), loaded));
+    }
+};
+
+QTEST_MAIN(TestFrameTiming)
+
+#include "tst_frametiming.moc"
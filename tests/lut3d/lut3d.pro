@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_lut3d
+INCLUDEPATH += $$PWD/../../mltmodule
+SOURCES += tst_lut3d.cpp \
+    ../../mltmodule/lutregistry.cpp
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QImage>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cmath>
+
+#include "lutregistry.h"
+#include "mltcontroller.h"
+#include <MltFilter.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+static const int kLutSize = 17;
+static const int kWidth = 1920;
+static const int kHeight = 1080;
+
+class TestLut3d : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QString m_lutPath;
+    QString m_imagePath;
+    Mlt::Profile m_profile;
+
+    // A curve on each channel that interpolation cannot follow exactly.
+    bool writeCube(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+            return false;
+        QTextStream stream(&file);
+        stream << "LUT_3D_SIZE " << kLutSize << "\n";
+        for (int b = 0; b < kLutSize; ++b)
+            for (int g = 0; g < kLutSize; ++g)
+                for (int r = 0; r < kLutSize; ++r) {
+                    double x = r / double(kLutSize - 1);
+                    double y = g / double(kLutSize - 1);
+                    double z = b / double(kLutSize - 1);
+                    stream << std::pow(x, 0.6) << " " << (0.8 * y + 0.2 * x * z) << " " << std::pow(z, 1.8) << "\n";
+                }
+        return true;
+    }
+
+    QByteArray render(const QList<Mlt::Filter*>& filters)
+    {
+        Mlt::Producer producer(m_profile, m_imagePath.toUtf8().constData());
+        foreach (Mlt::Filter* filter, filters)
+            producer.attach(*filter);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        mlt_image_format format = mlt_image_rgb24;
+        int width = kWidth;
+        int height = kHeight;
+        const uint8_t* image = frame->get_image(format, width, height);
+        QByteArray result;
+        if (image && format == mlt_image_rgb24)
+            result = QByteArray((const char*) image, width * height * 3);
+        foreach (Mlt::Filter* filter, filters)
+            producer.detach(*filter);
+        return result;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+        m_profile.set_width(kWidth);
+        m_profile.set_height(kHeight);
+        m_profile.set_sample_aspect(1, 1);
+        m_profile.set_display_aspect(kWidth, kHeight);
+        m_profile.set_progressive(1);
+        QVERIFY(m_dir.isValid());
+        m_lutPath = m_dir.filePath("curve.cube");
+        QVERIFY(writeCube(m_lutPath));
+
+        // Random colors in 4x2 blocks that survive conversion to 4:2:2.
+        QImage image(kWidth, kHeight, QImage::Format_RGB32);
+        qsrand(1);
+        for (int y = 0; y < kHeight; y += 2)
+            for (int x = 0; x < kWidth; x += 4) {
+                QRgb color = qRgb(qrand() & 0xff, qrand() & 0xff, qrand() & 0xff);
+                for (int i = 0; i < 8; ++i)
+                    image.setPixel(x + i % 4, y + i / 4, color);
+            }
+        m_imagePath = m_dir.filePath("colors.png");
+        QVERIFY(image.save(m_imagePath));
+    }
+
+    void matchesFFmpeg_data()
+    {
+        QTest::addColumn<QString>("interpolation");
+        QTest::newRow("nearest") << "nearest";
+        QTest::newRow("trilinear") << "trilinear";
+        QTest::newRow("tetrahedral") << "tetrahedral";
+    }
+
+    void matchesFFmpeg()
+    {
+        QFETCH(QString, interpolation);
+        Mlt::Filter ffmpeg(m_profile, "avfilter.lut3d");
+        if (!ffmpeg.is_valid())
+            QSKIP("avfilter.lut3d is not available");
+        ffmpeg.set("av.file", m_lutPath.toUtf8().constData());
+        ffmpeg.set("av.interp", interpolation.toLatin1().constData());
+        QByteArray expected = render(QList<Mlt::Filter*>() << &ffmpeg);
+        QByteArray actual = render(QList<Mlt::Filter*>());
+        QVERIFY(!expected.isEmpty());
+        QCOMPARE(actual.size(), expected.size());
+
+        LutRegistry::Pointer lut = LutRegistry::acquire(m_lutPath);
+        QVERIFY(lut);
+        LutRegistry::apply(*lut, (uint8_t*) actual.data(), kWidth * kHeight, 3,
+                           LutRegistry::interpolation(interpolation.toLatin1().constData()));
+        int maxError = 0;
+        for (int i = 0; i < expected.size(); ++i)
+            maxError = qMax(maxError, qAbs(int(uint8_t(expected[i])) - int(uint8_t(actual[i]))));
+        // The arithmetic is FFmpeg's; only a compiler that fuses multiply
+        // and add differently can move a value across a rounding boundary.
+        QVERIFY2(maxError <= 1, qPrintable(QString("max error %1").arg(maxError)));
+    }
+
+    void sharesTables()
+    {
+        QString copyPath = m_dir.filePath("copy.cube");
+        QVERIFY(QFile::copy(m_lutPath, copyPath));
+        LutRegistry::Pointer lut = LutRegistry::acquire(m_lutPath);
+        QVERIFY(lut);
+        QCOMPARE(LutRegistry::acquire(m_lutPath).data(), lut.data());
+        QCOMPARE(LutRegistry::acquire(copyPath).data(), lut.data());
+    }
+
+    void leavesShapersToFFmpeg()
+    {
+        QString path = m_dir.filePath("shaper.cube");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("LUT_1D_SIZE 2\n0 0 0\n1 1 1\nLUT_3D_SIZE 2\n");
+        file.close();
+        QVERIFY(!LutRegistry::acquire(path));
+    }
+
+    void benchmarkAcquire()
+    {
+        // What 500 clips sharing a show LUT cost after the first parse
+        LutRegistry::Pointer lut = LutRegistry::acquire(m_lutPath);
+        QBENCHMARK {
+            for (int i = 0; i < 500; ++i)
+                LutRegistry::acquire(m_lutPath);
+        }
+    }
+
+    void benchmarkApply()
+    {
+        LutRegistry::Pointer lut = LutRegistry::acquire(m_lutPath);
+        QByteArray image = render(QList<Mlt::Filter*>());
+        QBENCHMARK {
+            LutRegistry::apply(*lut, (uint8_t*) image.data(), kWidth * kHeight, 3, LutRegistry::Tetrahedral);
+        }
+    }
+
+    void benchmarkFFmpeg()
+    {
+        Mlt::Filter ffmpeg(m_profile, "avfilter.lut3d");
+        if (!ffmpeg.is_valid())
+            QSKIP("avfilter.lut3d is not available");
+        ffmpeg.set("av.file", m_lutPath.toUtf8().constData());
+        QBENCHMARK {
+            render(QList<Mlt::Filter*>() << &ffmpeg);
+        }
+    }
+};
+
+QTEST_MAIN(TestLut3d)
+
+#include "tst_lut3d.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_multitrackmodel
+SOURCES += tst_multitrackmodel.cpp
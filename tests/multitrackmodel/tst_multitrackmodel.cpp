@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QQmlComponent>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QSignalSpy>
+#include <QStandardPaths>
+
+#include "testtimeline.h"
+#include "shotcut_mlt_properties.h"
+
+static const char* kTimelineXml =
+    "<mlt>"
+    "<producer id=\"black\" in=\"0\" out=\"199\">"
+    "<property name=\"mlt_service\">color</property>"
+    "<property name=\"resource\">black</property>"
+    "</producer>"
+    "<playlist id=\"background\"><entry producer=\"black\" in=\"0\" out=\"199\"/></playlist>"
+    "<producer id=\"clip0\" in=\"0\" out=\"24\"><property name=\"mlt_service\">color</property><property name=\"resource\">red</property></producer>"
+    "<producer id=\"clip1\" in=\"0\" out=\"24\"><property name=\"mlt_service\">color</property><property name=\"resource\">green</property></producer>"
+    "<producer id=\"clip2\" in=\"0\" out=\"24\"><property name=\"mlt_service\">color</property><property name=\"resource\">blue</property></producer>"
+    "<producer id=\"clip3\" in=\"0\" out=\"24\"><property name=\"mlt_service\">color</property><property name=\"resource\">white</property></producer>"
+    "<playlist id=\"playlist0\">"
+    "<property name=\"shotcut:video\">1</property>"
+    "<entry producer=\"clip0\" in=\"0\" out=\"24\"/>"
+    "<entry producer=\"clip1\" in=\"0\" out=\"24\"/>"
+    "<blank length=\"10\"/>"
+    "<entry producer=\"clip2\" in=\"0\" out=\"24\"/>"
+    "<entry producer=\"clip3\" in=\"0\" out=\"24\"/>"
+    "</playlist>"
+    "<tractor id=\"tractor0\">"
+    "<property name=\"shotcut\">1</property>"
+    "<track producer=\"background\"/>"
+    "<track producer=\"playlist0\"/>"
+    "</tractor>"
+    "</mlt>";
+
+// Builds a delegate for each track and clip the way the timeline does and
+// counts how many were created.
+static const char* kTimelineQml =
+    "import QtQuick 2.0\n"
+    "import QtQml.Models 2.1\n"
+    "Item {\n"
+    "    id: root\n"
+    "    property int created: 0\n"
+    "    Repeater {\n"
+    "        model: DelegateModel {\n"
+    "            id: trackDelegateModel\n"
+    "            model: multitrack\n"
+    "            Item {\n"
+    "                Component.onCompleted: root.created++\n"
+    "                Repeater {\n"
+    "                    model: DelegateModel {\n"
+    "                        model: multitrack\n"
+    "                        rootIndex: trackDelegateModel.modelIndex(index)\n"
+    "                        Item { Component.onCompleted: root.created++ }\n"
+    "                    }\n"
+    "                }\n"
+    "            }\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+class TestMultitrackModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    MultitrackModel* m_model;
+    QQmlEngine* m_engine;
+    QObject* m_view;
+
+    static void deleteLevels(void* levels)
+    {
+        delete static_cast<QVariantList*>(levels);
+    }
+
+    void load()
+    {
+        QVERIFY(TestTimeline::load(*m_model, kTimelineXml));
+        QCOMPARE(m_model->trackList().size(), 1);
+        QCOMPARE(m_model->rowCount(m_model->index(0)), 5);
+    }
+
+    // Marks the levels of a clip as if an audio levels task had finished or
+    // been canceled part way.
+    void setLevels(int clipIndex, bool isComplete)
+    {
+        QScopedPointer<Mlt::Producer> track(m_model->tractor()->track(m_model->trackList().at(0).mlt_index));
+        Mlt::Playlist playlist(*track);
+        QScopedPointer<Mlt::Producer> clip(playlist.get_clip(clipIndex));
+        Mlt::Producer parent = clip->parent();
+        parent.set(kAudioLevelsProperty, new QVariantList(QVariantList() << 0 << 0), 0,
+                   (mlt_destructor) deleteLevels);
+        parent.set(kAudioLevelsCompleteProperty, isComplete);
+    }
+
+    // Returns the number of delegates the view created since the last call.
+    int delegatesCreated()
+    {
+        int created = m_view->property("created").toInt();
+        m_view->setProperty("created", 0);
+        return created;
+    }
+
+    Mlt::Producer* colorClip()
+    {
+        Mlt::Producer* clip = new Mlt::Producer(MLT.profile(), "color", "yellow");
+        clip->set("length", 25);
+        clip->set_in_and_out(0, 24);
+        return clip;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        qRegisterMetaType<QVector<int>>();
+        MLT.profile().set_explicit(true);
+    }
+
+    void init()
+    {
+        m_model = new MultitrackModel;
+        load();
+        m_engine = new QQmlEngine;
+        m_engine->rootContext()->setContextProperty("multitrack", m_model);
+        QQmlComponent component(m_engine);
+        component.setData(kTimelineQml, QUrl());
+        m_view = component.create();
+        QVERIFY2(m_view, qPrintable(component.errorString()));
+        // The background track is hidden, so one track and its clips.
+        QCOMPARE(delegatesCreated(), 1 + 5);
+    }
+
+    void cleanup()
+    {
+        delete m_view;
+        m_view = nullptr;
+        delete m_engine;
+        m_engine = nullptr;
+        delete m_model;
+        m_model = nullptr;
+    }
+
+    void structuralEdits_data()
+    {
+        QTest::addColumn<QString>("edit");
+        QTest::addColumn<int>("inserted");
+        QTest::addColumn<int>("removed");
+        QTest::addColumn<int>("created");
+        QTest::addColumn<int>("clips");
+        QTest::newRow("append") << "append" << 1 << 0 << 1 << 6;
+        QTest::newRow("remove") << "remove" << 0 << 1 << 0 << 4;
+        // The lifted clip becomes a blank that merges with the next one.
+        QTest::newRow("lift") << "lift" << 0 << 1 << 0 << 4;
+        // A new audio track starts with a blank.
+        QTest::newRow("audio track") << "audio track" << 1 << 0 << 2 << 5;
+    }
+
+    // Each edit only announces the rows it touched, and the view only
+    // creates delegates for the new ones.
+    void structuralEdits()
+    {
+        QFETCH(QString, edit);
+        QFETCH(int, inserted);
+        QFETCH(int, removed);
+        QFETCH(int, created);
+        QFETCH(int, clips);
+        QSignalSpy rowsInserted(m_model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+        QSignalSpy rowsRemoved(m_model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+        QSignalSpy modelReset(m_model, SIGNAL(modelReset()));
+
+        if (edit == "append") {
+            QScopedPointer<Mlt::Producer> clip(colorClip());
+            QCOMPARE(m_model->appendClip(0, *clip), 5);
+        } else if (edit == "remove") {
+            m_model->removeClip(0, 0, false);
+        } else if (edit == "lift") {
+            m_model->liftClip(0, 1);
+        } else if (edit == "audio track") {
+            QCOMPARE(m_model->addAudioTrack(), 1);
+        }
+
+        QCOMPARE(modelReset.count(), 0);
+        QCOMPARE(rowsInserted.count(), inserted);
+        QCOMPARE(rowsRemoved.count(), removed);
+        QCOMPARE(delegatesCreated(), created);
+        QCOMPARE(m_model->rowCount(m_model->index(0)), clips);
+    }
+
+    void loadReplacesTracksWithoutReset()
+    {
+        QSignalSpy rowsInserted(m_model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+        QSignalSpy rowsRemoved(m_model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+        QSignalSpy modelReset(m_model, SIGNAL(modelReset()));
+
+        load();
+
+        QCOMPARE(modelReset.count(), 0);
+        QCOMPARE(rowsRemoved.count(), 1);
+        QVERIFY(!rowsRemoved.at(0).at(0).toModelIndex().isValid());
+        QCOMPARE(rowsInserted.count(), 1);
+        QVERIFY(!rowsInserted.at(0).at(0).toModelIndex().isValid());
+        QCOMPARE(delegatesCreated(), 1 + 5);
+    }
+
+    void reloadAlwaysResets()
+    {
+        QSignalSpy modelReset(m_model, SIGNAL(modelReset()));
+
+        m_model->reload();
+
+        QCOMPARE(modelReset.count(), 1);
+        QCOMPARE(delegatesCreated(), 1 + 5);
+    }
+
+    void refreshNotifiesOnlyAudioLevels()
+    {
+        setLevels(0, true);
+        setLevels(1, true);
+        setLevels(3, true);
+        setLevels(4, true);
+        QSignalSpy dataChanged(m_model, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)));
+        QSignalSpy modelReset(m_model, SIGNAL(modelReset()));
+
+        m_model->refresh();
+
+        QCOMPARE(modelReset.count(), 0);
+        QCOMPARE(delegatesCreated(), 0);
+        // One run on each side of the blank.
+        QCOMPARE(dataChanged.count(), 2);
+        QVector<int> roles;
+        roles << MultitrackModel::AudioLevelsRole;
+        for (int i = 0; i < dataChanged.count(); ++i)
+            QCOMPARE(dataChanged.at(i).at(2).value<QVector<int>>(), roles);
+        QCOMPARE(dataChanged.at(0).at(0).toModelIndex().row(), 0);
+        QCOMPARE(dataChanged.at(0).at(1).toModelIndex().row(), 1);
+        QCOMPARE(dataChanged.at(1).at(0).toModelIndex().row(), 3);
+        QCOMPARE(dataChanged.at(1).at(1).toModelIndex().row(), 4);
+    }
+
+    void refreshSkipsPartialLevels()
+    {
+        setLevels(0, true);
+        setLevels(1, false);
+        setLevels(3, false);
+        setLevels(4, true);
+        QSignalSpy dataChanged(m_model, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)));
+
+        m_model->refresh();
+
+        QCOMPARE(dataChanged.count(), 2);
+        QCOMPARE(dataChanged.at(0).at(0).toModelIndex().row(), 0);
+        QCOMPARE(dataChanged.at(0).at(1).toModelIndex().row(), 0);
+        QCOMPARE(dataChanged.at(1).at(0).toModelIndex().row(), 4);
+        QCOMPARE(dataChanged.at(1).at(1).toModelIndex().row(), 4);
+    }
+
+    void refreshResetsUnannouncedRows()
+    {
+        QScopedPointer<Mlt::Producer> track(m_model->tractor()->track(m_model->trackList().at(0).mlt_index));
+        Mlt::Playlist playlist(*track);
+        playlist.remove(4);
+        QSignalSpy dataChanged(m_model, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)));
+        QSignalSpy modelReset(m_model, SIGNAL(modelReset()));
+
+        m_model->refresh();
+
+        QCOMPARE(modelReset.count(), 1);
+        QCOMPARE(dataChanged.count(), 0);
+    }
+};
+
+QTEST_MAIN(TestMultitrackModel)
+
+#include "tst_multitrackmodel.moc"
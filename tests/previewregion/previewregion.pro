@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_previewregion
+SOURCES += tst_previewregion.cpp
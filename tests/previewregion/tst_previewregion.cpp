@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QImage>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "mltcontroller.h"
+#include "previewregion.h"
+#include "sharedframe.h"
+#include <MltFilter.h>
+#include <MltPlaylist.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+static const int kMediaWidth = 3840;
+static const int kMediaHeight = 2160;
+// The visible part of the frame at 400% zoom
+static const QRectF kRegion(0.5, 0.5, 0.25, 0.25);
+
+class TestPreviewRegion : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QString m_imagePath;
+    Mlt::Profile m_profile;
+
+    // Plays the image through the region filter like the player does.
+    Mlt::Playlist* createPlayer(Mlt::Filter& regionFilter)
+    {
+        Mlt::Producer image(m_profile, m_imagePath.toUtf8().constData());
+        Mlt::Filter brightness(m_profile, "brightness");
+        brightness.set("level", 0.9);
+        image.attach(brightness);
+        Mlt::Playlist* playlist = new Mlt::Playlist(m_profile);
+        playlist->append(image);
+        playlist->attach(regionFilter);
+        return playlist;
+    }
+
+    QImage render(Mlt::Producer& producer, int width, int height, QRectF* region = 0)
+    {
+        producer.seek(0);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        mlt_image_format format = mlt_image_rgb24a;
+        const uchar* image = frame->get_image(format, width, height);
+        if (region)
+            *region = PreviewRegion::frameRegion(SharedFrame(*frame));
+        if (!image || format != mlt_image_rgb24a)
+            return QImage();
+        return QImage(image, width, height, QImage::Format_RGBA8888).copy();
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+        m_profile.set_width(1920);
+        m_profile.set_height(1080);
+        m_profile.set_sample_aspect(1, 1);
+        m_profile.set_display_aspect(16, 9);
+        m_profile.set_progressive(1);
+        QVERIFY(m_dir.isValid());
+
+        // Each quadrant has its own color.
+        QImage image(kMediaWidth, kMediaHeight, QImage::Format_RGB32);
+        QPainter painter(&image);
+        painter.fillRect(0, 0, kMediaWidth / 2, kMediaHeight / 2, Qt::red);
+        painter.fillRect(kMediaWidth / 2, 0, kMediaWidth / 2, kMediaHeight / 2, Qt::green);
+        painter.fillRect(0, kMediaHeight / 2, kMediaWidth / 2, kMediaHeight / 2, Qt::blue);
+        painter.fillRect(kMediaWidth / 2, kMediaHeight / 2, kMediaWidth / 2, kMediaHeight / 2, Qt::white);
+        painter.end();
+        m_imagePath = m_dir.filePath("quadrants.png");
+        QVERIFY(image.save(m_imagePath));
+    }
+
+    void supportsPointFilters()
+    {
+        Mlt::Producer image(m_profile, m_imagePath.toUtf8().constData());
+        QVERIFY(PreviewRegion::isSupported(image));
+        Mlt::Filter brightness(m_profile, "brightness");
+        image.attach(brightness);
+        QVERIFY(PreviewRegion::isSupported(image));
+        Mlt::Filter affine(m_profile, "affine");
+        image.attach(affine);
+        QVERIFY(!PreviewRegion::isSupported(image));
+    }
+
+    void rendersOnlyTheRegion()
+    {
+        QScopedPointer<Mlt::Filter> filter(PreviewRegion::createFilter(m_profile));
+        QScopedPointer<Mlt::Playlist> player(createPlayer(*filter));
+        PreviewRegion::setRegion(*filter, kRegion);
+        QRectF region;
+        QImage image = render(*player, 480, 270, &region);
+        QVERIFY(!image.isNull());
+        QVERIFY(qAbs(region.x() - kRegion.x()) < 0.01);
+        QVERIFY(qAbs(region.width() - kRegion.width()) < 0.01);
+        // The region lies within the white quadrant.
+        QColor center = image.pixelColor(image.width() / 2, image.height() / 2);
+        QVERIFY(center.red() > 200 && center.green() > 200 && center.blue() > 200);
+    }
+
+    void rendersWholeFrameWithoutRegion()
+    {
+        QScopedPointer<Mlt::Filter> filter(PreviewRegion::createFilter(m_profile));
+        QScopedPointer<Mlt::Playlist> player(createPlayer(*filter));
+        PreviewRegion::setRegion(*filter, QRectF());
+        QRectF region;
+        QImage image = render(*player, 1920, 1080, &region);
+        QVERIFY(!image.isNull());
+        QVERIFY(region.isNull());
+        QVERIFY(image.pixelColor(100, 100).red() > 200);
+    }
+
+    void benchmarkWholeFrame()
+    {
+        QScopedPointer<Mlt::Filter> filter(PreviewRegion::createFilter(m_profile));
+        QScopedPointer<Mlt::Playlist> player(createPlayer(*filter));
+        PreviewRegion::setRegion(*filter, QRectF());
+        QBENCHMARK {
+            render(*player, 1920, 1080);
+        }
+    }
+
+    void benchmarkRegion()
+    {
+        QScopedPointer<Mlt::Filter> filter(PreviewRegion::createFilter(m_profile));
+        QScopedPointer<Mlt::Playlist> player(createPlayer(*filter));
+        PreviewRegion::setRegion(*filter, kRegion);
+        QBENCHMARK {
+            render(*player, 480, 270);
+        }
+    }
+};
+
+QTEST_MAIN(TestPreviewRegion)
+
+#include "tst_previewregion.moc"
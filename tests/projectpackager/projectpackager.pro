@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_projectpackager
+SOURCES += tst_projectpackager.cpp
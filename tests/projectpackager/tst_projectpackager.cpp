@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+
+#include "mltcontroller.h"
+#include "projectpackager.h"
+#include <MltConsumer.h>
+#include <MltFrame.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+static const int kFrames = 300;
+static const int kGroupLength = 50;
+static const int kUsedIn = 200;
+static const int kUsedOut = 224;
+static const int kFadeOut = 212;
+// The used frames plus a second of handles start in the group at frame 150
+// and end at frame 249.
+static const int kShift = 150;
+static const int kTrimmedLength = 100;
+static const int kSampledFileSize = 3 * 1000 * 1000;
+
+class TestProjectPackager : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_folder;
+    Mlt::Profile m_profile;
+    QString m_mediaPath;
+
+    // A clip that uses a short span of the media, with a filter on the
+    // whole producer and one on the first half of the clip, which use the
+    // frames of the source like the ones Shotcut adds, and a track filter.
+    QString project() const
+    {
+        return QString(
+            "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+            "<mlt LC_NUMERIC=\"C\" root=\"%1\">\n"
+            " <profile width=\"320\" height=\"180\" progressive=\"1\" sample_aspect_num=\"1\" sample_aspect_den=\"1\""
+            " display_aspect_num=\"16\" display_aspect_den=\"9\" frame_rate_num=\"25\" frame_rate_den=\"1\"/>\n"
+            " <producer id=\"producer0\" in=\"0\" out=\"%3\">\n"
+            "  <property name=\"length\">%4</property>\n"
+            "  <property name=\"resource\">%2</property>\n"
+            "  <property name=\"mlt_service\">avformat</property>\n"
+            "  <filter id=\"filter0\" in=\"0\" out=\"%3\">\n"
+            "   <property name=\"mlt_service\">greyscale</property>\n"
+            "  </filter>\n"
+            " </producer>\n"
+            " <playlist id=\"playlist0\">\n"
+            "  <entry producer=\"producer0\" in=\"%5\" out=\"%6\">\n"
+            "   <filter id=\"filter1\" in=\"%5\" out=\"%8\">\n"
+            "    <property name=\"mlt_service\">brightness</property>\n"
+            "    <property name=\"level\">0.5</property>\n"
+            "   </filter>\n"
+            "  </entry>\n"
+            " </playlist>\n"
+            " <tractor id=\"tractor0\" in=\"0\" out=\"%7\">\n"
+            "  <track producer=\"playlist0\"/>\n"
+            "  <filter id=\"filter2\" in=\"0\" out=\"%7\">\n"
+            "   <property name=\"mlt_service\">brightness</property>\n"
+            "   <property name=\"level\">0.8</property>\n"
+            "  </filter>\n"
+            " </tractor>\n"
+            "</mlt>\n")
+            .arg(m_folder.path()).arg(m_mediaPath)
+            .arg(kFrames - 1).arg(kFrames)
+            .arg(kUsedIn).arg(kUsedOut).arg(kUsedOut - kUsedIn).arg(kFadeOut);
+    }
+
+    bool package(const QString& xml, const QString& folder, bool trim)
+    {
+        ProjectPackager packager(xml, folder, "packaged", trim);
+        auto isCanceled = []() { return false; };
+        return packager.analyze(isCanceled)
+            && packager.collect([](int) {}, isCanceled)
+            && packager.writeProject();
+    }
+
+    // Returns the in and out points of each element by id, or by element
+    // name for those without one.
+    QHash<QString, QPair<int, int>> inAndOut(const QString& path) const
+    {
+        QHash<QString, QPair<int, int>> result;
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return result;
+        QXmlStreamReader xml(&file);
+        while (!xml.atEnd()) {
+            if (xml.readNext() != QXmlStreamReader::StartElement)
+                continue;
+            const QXmlStreamAttributes attributes = xml.attributes();
+            if (!attributes.hasAttribute("in"))
+                continue;
+            QString id = attributes.value("id").toString();
+            if (id.isEmpty())
+                id = xml.name().toString();
+            result[id] = qMakePair(attributes.value("in").toInt(), attributes.value("out").toInt());
+        }
+        return result;
+    }
+
+    QStringList resources(const QString& path) const
+    {
+        QStringList result;
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return result;
+        QXmlStreamReader xml(&file);
+        while (!xml.atEnd()) {
+            if (xml.readNext() == QXmlStreamReader::StartElement && xml.name() == QLatin1String("property")
+                    && xml.attributes().value("name") == QLatin1String("resource"))
+                result << xml.readElementText();
+        }
+        return result;
+    }
+
+    QImage render(Mlt::Producer& producer, int position)
+    {
+        producer.seek(position);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        mlt_image_format format = mlt_image_rgb24;
+        int width = m_profile.width();
+        int height = m_profile.height();
+        const uchar* image = frame->get_image(format, width, height);
+        if (!image)
+            return QImage();
+        return QImage(image, width, height, 3 * width, QImage::Format_RGB888).copy();
+    }
+
+    void compareFrames(const QString& originalPath, const QString& packagedPath)
+    {
+        Mlt::Producer original(m_profile, "xml", originalPath.toUtf8().constData());
+        Mlt::Producer packaged(m_profile, "xml", packagedPath.toUtf8().constData());
+        QVERIFY(original.is_valid());
+        QVERIFY(packaged.is_valid());
+        QCOMPARE(packaged.get_playtime(), original.get_playtime());
+        for (int position = 0; position < original.get_playtime(); position += 6) {
+            QImage expected = render(original, position);
+            QVERIFY(!expected.isNull());
+            QCOMPARE(render(packaged, position), expected);
+        }
+    }
+
+    bool writeFile(const QString& path, const QByteArray& data) const
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+        QVERIFY(m_folder.isValid());
+        m_profile.set_width(320);
+        m_profile.set_height(180);
+        m_profile.set_sample_aspect(1, 1);
+        m_profile.set_display_aspect(16, 9);
+        m_profile.set_frame_rate(25, 1);
+        m_profile.set_progressive(1);
+
+        // Encode long groups of pictures with a fixed length.
+        Mlt::Producer noise(m_profile, "noise");
+        noise.set("length", kFrames);
+        noise.set_in_and_out(0, kFrames - 1);
+        QString path = m_folder.filePath("groups.mp4");
+        Mlt::Consumer consumer(m_profile, "avformat", path.toUtf8().constData());
+        consumer.set("vcodec", "libx264");
+        consumer.set("preset", "ultrafast");
+        consumer.set("g", kGroupLength);
+        consumer.set("keyint_min", kGroupLength);
+        consumer.set("sc_threshold", 0);
+        consumer.set("an", 1);
+        consumer.set("real_time", -1);
+        consumer.set("terminate_on_pause", 1);
+        consumer.connect(noise);
+        consumer.run();
+        if (QFileInfo(path).size() > 0)
+            m_mediaPath = path;
+    }
+
+    void keepsFramesWhole()
+    {
+        if (m_mediaPath.isEmpty())
+            QSKIP("libx264 is not available to encode the test media");
+        QString originalPath = m_folder.filePath("whole.mlt");
+        QVERIFY(writeFile(originalPath, project().toUtf8()));
+        QString folder = m_folder.filePath("whole");
+        QVERIFY(QDir().mkpath(folder));
+        QVERIFY(package(project(), folder, false));
+        QString packagedPath = QDir(folder).filePath("packaged.mlt");
+
+        QHash<QString, QPair<int, int>> points = inAndOut(packagedPath);
+        QCOMPARE(points["entry"], qMakePair(kUsedIn, kUsedOut));
+        QCOMPARE(points["filter0"], qMakePair(0, kFrames - 1));
+        QCOMPARE(points["filter1"], qMakePair(kUsedIn, kFadeOut));
+        QCOMPARE(points["filter2"], qMakePair(0, kUsedOut - kUsedIn));
+        QCOMPARE(resources(packagedPath), QStringList() << "media/groups.mp4");
+        compareFrames(originalPath, packagedPath);
+    }
+
+    void shiftsTrimmedClipAndFilters()
+    {
+        if (m_mediaPath.isEmpty())
+            QSKIP("libx264 is not available to encode the test media");
+        QString originalPath = m_folder.filePath("trim.mlt");
+        QVERIFY(writeFile(originalPath, project().toUtf8()));
+        QString folder = m_folder.filePath("trim");
+        QVERIFY(QDir().mkpath(folder));
+        QVERIFY(package(project(), folder, true));
+        QString packagedPath = QDir(folder).filePath("packaged.mlt");
+
+        QHash<QString, QPair<int, int>> points = inAndOut(packagedPath);
+        if (points["entry"].first == kUsedIn)
+            QSKIP("ffmpeg and ffprobe are not available next to the test");
+        QCOMPARE(points["entry"], qMakePair(kUsedIn - kShift, kUsedOut - kShift));
+        QCOMPARE(points["producer0"], qMakePair(0, kTrimmedLength - 1));
+        // The clip filters move with the clip and stay inside the media.
+        QCOMPARE(points["filter0"], qMakePair(0, kTrimmedLength - 1));
+        QCOMPARE(points["filter1"], qMakePair(kUsedIn - kShift, kFadeOut - kShift));
+        QCOMPARE(points["filter2"], qMakePair(0, kUsedOut - kUsedIn));
+        compareFrames(originalPath, packagedPath);
+    }
+
+    void comparesSampledDuplicates()
+    {
+        // The hash only samples the first and last megabytes of these, so
+        // "a" and "b" only differ in the middle, and "c" is a copy of "a".
+        QByteArray data(kSampledFileSize, 'a');
+        QVERIFY(writeFile(m_folder.filePath("a.bin"), data));
+        QVERIFY(writeFile(m_folder.filePath("c.bin"), data));
+        data[kSampledFileSize / 2] = 'b';
+        QVERIFY(writeFile(m_folder.filePath("b.bin"), data));
+
+        QString producers;
+        QString entries;
+        foreach (const QString& name, QStringList() << "a" << "b" << "c") {
+            producers += QString(
+                " <producer id=\"%1\" in=\"0\" out=\"0\">\n"
+                "  <property name=\"resource\">%2</property>\n"
+                "  <property name=\"mlt_service\">avformat</property>\n"
+                " </producer>\n").arg(name).arg(m_folder.filePath(name + ".bin"));
+            entries += QString("  <entry producer=\"%1\" in=\"0\" out=\"0\"/>\n").arg(name);
+        }
+        QString xml = QString(
+            "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+            "<mlt LC_NUMERIC=\"C\">\n%1"
+            " <playlist id=\"playlist0\">\n%2 </playlist>\n"
+            "</mlt>\n").arg(producers).arg(entries);
+        QString folder = m_folder.filePath("duplicates");
+        QVERIFY(QDir().mkpath(folder));
+        QVERIFY(package(xml, folder, false));
+
+        QStringList files = QDir(QDir(folder).filePath("media")).entryList(QDir::Files);
+        QCOMPARE(files.size(), 2);
+        QVERIFY(files.contains("b.bin"));
+        QStringList packaged = resources(QDir(folder).filePath("packaged.mlt"));
+        QCOMPARE(packaged.size(), 3);
+        QCOMPARE(packaged[0], packaged[2]);
+        QVERIFY(packaged[0] != packaged[1]);
+    }
+};
+
+QTEST_MAIN(TestProjectPackager)
+
+#include "tst_projectpackager.moc"
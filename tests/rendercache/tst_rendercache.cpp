@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QStandardPaths>
+
+#include "mltcontroller.h"
+#include "rendercache.h"
+#include <MltFilter.h>
+#include <MltPlaylist.h>
+
+static const int kFrames = 250;
+
+class TestRenderCache : public QObject
+{
+    Q_OBJECT
+
+private:
+    // A color clip with a static filter, which the cache accepts.
+    Mlt::Playlist* createPlaylist()
+    {
+        Mlt::Producer color(MLT.profile(), "color", "#ff336699");
+        color.set("length", kFrames);
+        Mlt::Filter filter(MLT.profile(), "brightness");
+        filter.set("level", 0.5);
+        color.attach(filter);
+        Mlt::Playlist* playlist = new Mlt::Playlist(MLT.profile());
+        playlist->append(color, 0, kFrames - 1);
+        return playlist;
+    }
+
+    QByteArray render(Mlt::Producer& producer, int position)
+    {
+        producer.seek(position);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        mlt_image_format format = mlt_image_yuv422;
+        int width = MLT.profile().width();
+        int height = MLT.profile().height();
+        const uint8_t* image = frame->get_image(format, width, height);
+        if (!image)
+            return QByteArray();
+        return QByteArray((const char*) image, mlt_image_format_size(format, width, height, NULL));
+    }
+
+    QString title(const QString& start, const QString& end, const QString& typewriter)
+    {
+        return QString("<kdenlivetitle width=\"1920\" height=\"1080\">"
+                       "<item type=\"QGraphicsTextItem\" z-index=\"0\">"
+                       "<position x=\"100\" y=\"100\"/>"
+                       "<content font=\"Sans\" typewriter=\"%3\">Title</content>"
+                       "</item>"
+                       "<startviewport rect=\"%1\"/>"
+                       "<endviewport rect=\"%2\"/>"
+                       "<background color=\"0,0,0,0\"/>"
+                       "</kdenlivetitle>").arg(start, end, typewriter);
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+    }
+
+    void init()
+    {
+        RenderCache::clear();
+    }
+
+    void cachedImageMatchesRendered()
+    {
+        QScopedPointer<Mlt::Playlist> rendered(createPlaylist());
+        QScopedPointer<Mlt::Playlist> cached(createPlaylist());
+        RenderCache::attach(*cached);
+        QByteArray expected = render(*rendered, 10);
+        QVERIFY(!expected.isEmpty());
+        // The first frame fills the cache and the next one reads it.
+        QCOMPARE(render(*cached, 10), expected);
+        QCOMPARE(render(*cached, 20), expected);
+    }
+
+    void staticTitleIsNotAnimated()
+    {
+        QVERIFY(!RenderCache::isAnimatedTitle(title("0,0,1920,1080", "0,0,1920,1080", "0;2;1;0;0")));
+    }
+
+    void scrollingTitleIsAnimated()
+    {
+        QVERIFY(RenderCache::isAnimatedTitle(title("0,0,1920,1080", "0,-1080,1920,1080", "0;2;1;0;0")));
+    }
+
+    void typewriterTitleIsAnimated()
+    {
+        QVERIFY(RenderCache::isAnimatedTitle(title("0,0,1920,1080", "0,0,1920,1080", "1;2;1;0;0")));
+    }
+
+    void benchmarkRender()
+    {
+        QScopedPointer<Mlt::Playlist> playlist(createPlaylist());
+        QBENCHMARK {
+            for (int i = 0; i < kFrames; ++i)
+                render(*playlist, i);
+        }
+    }
+
+    void benchmarkRenderCached()
+    {
+        QScopedPointer<Mlt::Playlist> playlist(createPlaylist());
+        RenderCache::attach(*playlist);
+        QBENCHMARK {
+            for (int i = 0; i < kFrames; ++i)
+                render(*playlist, i);
+        }
+    }
+};
+
+QTEST_MAIN(TestRenderCache)
+
+#include "tst_rendercache.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_seekindex
+SOURCES += tst_seekindex.cpp
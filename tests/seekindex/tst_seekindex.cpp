@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "mltcontroller.h"
+#include "seekindex.h"
+#include <MltConsumer.h>
+#include <MltFrame.h>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+static const int kFrames = 300;
+static const int kGroupLength = 50;
+
+class TestSeekIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_folder;
+    Mlt::Profile m_profile;
+    QString m_mediaPath;
+    QSharedPointer<SeekIndex> m_index;
+
+    // Writes an index with a keyframe every kGroupLength frames, which is
+    // how the test media is encoded.
+    QSharedPointer<SeekIndex> createIndex()
+    {
+        QString path = m_folder.filePath("groups.idx");
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+            return QSharedPointer<SeekIndex>();
+        QTextStream stream(&file);
+        stream << "# shotcut seek index 1\n";
+        for (int frame = 0; frame < kFrames; frame += kGroupLength)
+            stream << QString::number(frame / m_profile.fps(), 'f', 6) << " -1\n";
+        file.close();
+        return SeekIndex::load(path);
+    }
+
+    QImage render(Mlt::Producer& producer, int position)
+    {
+        producer.seek(position);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        mlt_image_format format = mlt_image_rgb24;
+        int width = m_profile.width();
+        int height = m_profile.height();
+        const uchar* image = frame->get_image(format, width, height);
+        if (!image)
+            return QImage();
+        return QImage(image, width, height, 3 * width, QImage::Format_RGB888).copy();
+    }
+
+    // Jumps forward inside each group by more than avformat decodes forward
+    // without seeking.
+    QList<QPair<int, int>> jumps() const
+    {
+        QList<QPair<int, int>> result;
+        for (int group = 0; group < kFrames; group += kGroupLength)
+            result << qMakePair(group + 20, group + kGroupLength - 2);
+        return result;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+        QVERIFY(m_folder.isValid());
+        m_profile.set_width(320);
+        m_profile.set_height(180);
+        m_profile.set_sample_aspect(1, 1);
+        m_profile.set_display_aspect(16, 9);
+        m_profile.set_frame_rate(25, 1);
+        m_profile.set_progressive(1);
+        m_index = createIndex();
+        QVERIFY(m_index);
+
+        // Encode long groups of pictures with a fixed length.
+        Mlt::Producer noise(m_profile, "noise");
+        noise.set("length", kFrames);
+        noise.set_in_and_out(0, kFrames - 1);
+        QString path = m_folder.filePath("groups.mp4");
+        Mlt::Consumer consumer(m_profile, "avformat", path.toUtf8().constData());
+        consumer.set("vcodec", "libx264");
+        consumer.set("preset", "ultrafast");
+        consumer.set("g", kGroupLength);
+        consumer.set("keyint_min", kGroupLength);
+        consumer.set("sc_threshold", 0);
+        consumer.set("an", 1);
+        consumer.set("real_time", -1);
+        consumer.set("terminate_on_pause", 1);
+        consumer.connect(noise);
+        consumer.run();
+        if (QFileInfo(path).size() > 0)
+            m_mediaPath = path;
+    }
+
+    void findsKeyframes()
+    {
+        double fps = m_profile.fps();
+        QCOMPARE(m_index->keyframes().size(), kFrames / kGroupLength);
+        QCOMPARE(m_index->keyframeAtOrBefore(0, fps), 0);
+        QCOMPARE(m_index->keyframeAtOrBefore(kGroupLength - 1, fps), 0);
+        QCOMPARE(m_index->keyframeAtOrBefore(kGroupLength, fps), kGroupLength);
+        QCOMPARE(m_index->keyframeAtOrBefore(2 * kGroupLength + 20, fps), 2 * kGroupLength);
+        QVERIFY(m_index->isSameGroup(10, 40, fps));
+        QVERIFY(!m_index->isSameGroup(40, kGroupLength + 10, fps));
+        QVERIFY(!m_index->isSameGroup(40, 10, fps));
+    }
+
+    void rejectsUnknownFormat()
+    {
+        QString path = m_folder.filePath("unknown.idx");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        file.write("# shotcut seek index 0\n0.000000 -1\n");
+        file.close();
+        QVERIFY(!SeekIndex::load(path));
+    }
+
+    void buildsFromMedia()
+    {
+        if (m_mediaPath.isEmpty())
+            QSKIP("libx264 is not available to encode the test media");
+        QString path = m_folder.filePath("built.idx");
+        if (!SeekIndex::build(m_mediaPath, path))
+            QSKIP("ffprobe is not available next to the test");
+        QSharedPointer<SeekIndex> index = SeekIndex::load(path);
+        QVERIFY(index);
+        QCOMPARE(index->keyframes().size(), m_index->keyframes().size());
+        for (int i = 0; i < index->keyframes().size(); ++i) {
+            QVERIFY(qAbs(index->keyframes().at(i).time - m_index->keyframes().at(i).time) < 0.001);
+            QVERIFY(index->keyframes().at(i).offset >= 0);
+        }
+    }
+
+    void landsOnExactFrame()
+    {
+        if (m_mediaPath.isEmpty())
+            QSKIP("libx264 is not available to encode the test media");
+        Mlt::Producer indexed(m_profile, "avformat", m_mediaPath.toUtf8().constData());
+        QVERIFY(indexed.is_valid());
+        SeekIndex::attach(indexed, m_index);
+        QList<int> positions;
+        // Forward in a group, across a keyframe, and backward.
+        positions << 5 << 45 << 70 << 30;
+        foreach (int position, positions) {
+            Mlt::Producer reference(m_profile, "avformat", m_mediaPath.toUtf8().constData());
+            QImage expected = render(reference, position);
+            QVERIFY(!expected.isNull());
+            QCOMPARE(render(indexed, position), expected);
+        }
+    }
+
+    void benchmarkSeek_data()
+    {
+        QTest::addColumn<bool>("indexed");
+        QTest::newRow("avformat") << false;
+        QTest::newRow("index") << true;
+    }
+
+    void benchmarkSeek()
+    {
+        QFETCH(bool, indexed);
+        if (m_mediaPath.isEmpty())
+            QSKIP("libx264 is not available to encode the test media");
+        Mlt::Producer producer(m_profile, "avformat", m_mediaPath.toUtf8().constData());
+        QVERIFY(producer.is_valid());
+        if (indexed)
+            SeekIndex::attach(producer, m_index);
+        QList<QPair<int, int>> jumps = this->jumps();
+        QBENCHMARK {
+            for (int i = 0; i < jumps.size(); ++i) {
+                render(producer, jumps[i].first);
+                render(producer, jumps[i].second);
+            }
+        }
+    }
+};
+
+QTEST_MAIN(TestSeekIndex)
+
+#include "tst_seekindex.moc"
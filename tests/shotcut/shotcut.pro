@@ -0,0 +1,6 @@
+# The application sources as a static library for the tests to link.
+include(../../src/src.pri)
+
+TARGET = shotcut
+TEMPLATE = lib
+CONFIG += staticlib
@@ -0,0 +1,30 @@
+# Included by each test project. It takes the dependencies from src.pri
+# and links the static library built by shotcut/shotcut.pro instead of
+# compiling the application sources again.
+include(../src/src.pri)
+
+SOURCES =
+HEADERS =
+FORMS =
+OBJECTIVE_SOURCES =
+RESOURCES =
+VPATH =
+
+TEMPLATE = app
+QT += testlib
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+win32 {
+    CONFIG(debug, debug|release) {
+        SHOTCUT_LIB_DIR = $$shadowed($$PWD)/shotcut/debug
+    } else {
+        SHOTCUT_LIB_DIR = $$shadowed($$PWD)/shotcut/release
+    }
+} else {
+    SHOTCUT_LIB_DIR = $$shadowed($$PWD)/shotcut
+}
+INCLUDEPATH += $$PWD $$shadowed($$PWD)/shotcut
+LIBS = -L$$SHOTCUT_LIB_DIR -lshotcut $$LIBS
+win32-msvc*: PRE_TARGETDEPS += $$SHOTCUT_LIB_DIR/shotcut.lib
+else: PRE_TARGETDEPS += $$SHOTCUT_LIB_DIR/libshotcut.a
@@ -0,0 +1,29 @@
+# Unit tests and benchmarks. They are not built by default; use
+#   qmake CONFIG+=tests && make && make check
+TEMPLATE = subdirs
+SUBDIRS = shotcut \
+    broadcastqc \
+    colorfusion \
+    filterpanelpool \
+    frametiming \
+    lut3d \
+    multitrackmodel \
+    previewregion \
+    projectpackager \
+    rendercache \
+    seekindex \
+    timelineclipboard \
+    timelineinvariants
+
+broadcastqc.depends = shotcut
+colorfusion.depends = shotcut
+filterpanelpool.depends = shotcut
+frametiming.depends = shotcut
+lut3d.depends = shotcut
+multitrackmodel.depends = shotcut
+previewregion.depends = shotcut
+projectpackager.depends = shotcut
+rendercache.depends = shotcut
+seekindex.depends = shotcut
+timelineclipboard.depends = shotcut
+timelineinvariants.depends = shotcut
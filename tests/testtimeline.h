@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TESTTIMELINE_H
+#define TESTTIMELINE_H
+
+#include <QString>
+#include <QtTest>
+
+#include "mltcontroller.h"
+#include "models/multitrackmodel.h"
+
+namespace TestTimeline {
+
+// Returns a project with a video track for each entry of clipsPerTrack,
+// holding that many color clips of the given length with a brightness filter.
+inline QString colorXml(const QList<int>& clipsPerTrack, int length = 25)
+{
+    QString xml = "<mlt>"
+        "<producer id=\"black\" in=\"0\" out=\"%1\">"
+        "<property name=\"mlt_service\">color</property>"
+        "<property name=\"resource\">black</property>"
+        "</producer>"
+        "<playlist id=\"background\"><entry producer=\"black\" in=\"0\" out=\"%1\"/></playlist>";
+    int longest = 0;
+    foreach (int clips, clipsPerTrack)
+        longest = qMax(longest, clips);
+    xml = xml.arg(longest * length - 1);
+    QString tractor = "<tractor id=\"tractor0\"><property name=\"shotcut\">1</property>"
+        "<track producer=\"background\"/>";
+    for (int t = 0; t < clipsPerTrack.size(); ++t) {
+        QString playlist = QString("<playlist id=\"playlist%1\"><property name=\"shotcut:video\">1</property>").arg(t);
+        for (int c = 0; c < clipsPerTrack.at(t); ++c) {
+            QString id = QString("clip%1_%2").arg(t).arg(c);
+            xml += QString("<producer id=\"%1\" in=\"0\" out=\"%2\">"
+                "<property name=\"mlt_service\">color</property>"
+                "<property name=\"resource\">#ff%3</property>"
+                "<filter><property name=\"mlt_service\">brightness</property>"
+                "<property name=\"level\">0.5</property></filter>"
+                "</producer>").arg(id).arg(length - 1).arg(c % 0x10000, 4, 16, QChar('0'));
+            playlist += QString("<entry producer=\"%1\" in=\"0\" out=\"%2\"/>").arg(id).arg(length - 1);
+        }
+        xml += playlist + "</playlist>";
+        tractor += QString("<track producer=\"playlist%1\"/>").arg(t);
+    }
+    return xml + tractor + "</tractor></mlt>";
+}
+
+// Returns a project with the given number of video tracks of equal length.
+inline QString colorXml(int tracks, int clipsPerTrack, int length = 25)
+{
+    QList<int> counts;
+    for (int t = 0; t < tracks; ++t)
+        counts << clipsPerTrack;
+    return colorXml(counts, length);
+}
+
+// Loads the project XML into the model without starting a preview.
+inline bool load(MultitrackModel& model, const QString& xml)
+{
+    Mlt::Producer* producer = new Mlt::Producer(MLT.profile(), "xml-string", xml.toUtf8().constData());
+    if (!producer->is_valid()) {
+        delete producer;
+        return false;
+    }
+    // Skip the GLWidget override, which would start a preview consumer.
+    if (MLT.Mlt::Controller::setProducer(producer))
+        return false;
+    model.load();
+    return model.tractor() != nullptr;
+}
+
+} // namespace
+
+#endif // TESTTIMELINE_H
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_timelineclipboard
+SOURCES += tst_timelineclipboard.cpp
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QStandardPaths>
+
+#include "testtimeline.h"
+#include "timelineclipboard.h"
+#include "commands/timelinecommands.h"
+
+static const int kTracks = 4;
+static const int kClipsPerTrack = 250;
+
+class TestTimelineClipboard : public QObject
+{
+    Q_OBJECT
+
+private:
+    MultitrackModel* m_model;
+
+    QList<QPoint> selectAll() const
+    {
+        QList<QPoint> selection;
+        for (int t = 0; t < m_model->trackList().size(); ++t)
+            for (int c = 0; c < m_model->rowCount(m_model->index(t)); ++c)
+                selection << QPoint(c, t);
+        return selection;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+    }
+
+    void init()
+    {
+        m_model = new MultitrackModel;
+        QVERIFY(TestTimeline::load(*m_model, TestTimeline::colorXml(kTracks, kClipsPerTrack)));
+        QCOMPARE(m_model->trackList().size(), kTracks);
+    }
+
+    void cleanup()
+    {
+        delete m_model;
+        m_model = nullptr;
+    }
+
+    void copyKeepsLayout()
+    {
+        TimelineClipboard clipboard;
+        QList<QPoint> selection;
+        selection << QPoint(3, 1) << QPoint(4, 2) << QPoint(6, 2);
+        QCOMPARE(clipboard.copy(*m_model, selection), 3);
+        QCOMPARE(clipboard.trackCount(), 2);
+        QCOMPARE(clipboard.items().at(0).trackOffset, 0);
+        QCOMPARE(clipboard.items().at(0).position, 0);
+        QCOMPARE(clipboard.items().at(1).trackOffset, 1);
+        QCOMPARE(clipboard.items().at(1).position, 25);
+        QCOMPARE(clipboard.items().at(2).position, 75);
+    }
+
+    void copyIsASnapshot()
+    {
+        TimelineClipboard clipboard;
+        QList<QPoint> selection;
+        selection << QPoint(0, 0);
+        QCOMPARE(clipboard.copy(*m_model, selection), 1);
+
+        // Edit the source clip after copying.
+        QScopedPointer<Mlt::Producer> track(m_model->tractor()->track(m_model->trackList().at(0).mlt_index));
+        Mlt::Playlist playlist(*track);
+        QScopedPointer<Mlt::Producer> clip(playlist.get_clip(0));
+        Mlt::Producer parent = clip->parent();
+        QString resource = parent.get("resource");
+        parent.set("resource", "#ffffffff");
+        QScopedPointer<Mlt::Filter> filter(parent.filter(0));
+        QVERIFY(filter && filter->is_valid());
+        parent.detach(*filter);
+
+        Mlt::Producer pasted = TimelineClipboard::materialize(clipboard.items().first());
+        QVERIFY(pasted.is_valid());
+        QCOMPARE(QString(pasted.get("resource")), resource);
+        QCOMPARE(pasted.filter_count(), 1);
+    }
+
+    void benchmarkCopy()
+    {
+        TimelineClipboard clipboard;
+        QList<QPoint> selection = selectAll();
+        QCOMPARE(selection.size(), kTracks * kClipsPerTrack);
+        QBENCHMARK {
+            clipboard.copy(*m_model, selection);
+        }
+        QCOMPARE(clipboard.count(), kTracks * kClipsPerTrack);
+    }
+
+    void benchmarkPaste()
+    {
+        TimelineClipboard clipboard;
+        clipboard.copy(*m_model, selectAll());
+        int position = m_model->tractor()->get_length();
+        QBENCHMARK {
+            Timeline::PasteCommand command(*m_model, 0, position, clipboard.items());
+            command.redo();
+            command.undo();
+        }
+        QCOMPARE(m_model->rowCount(m_model->index(0)), kClipsPerTrack);
+    }
+};
+
+QTEST_MAIN(TestTimelineClipboard)
+
+#include "tst_timelineclipboard.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_timelineinvariants
+SOURCES += tst_timelineinvariants.cpp
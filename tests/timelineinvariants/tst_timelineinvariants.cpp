@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2020 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QStandardPaths>
+#include <QUndoStack>
+
+#include "testtimeline.h"
+#include "commands/timelinecommands.h"
+#include "shotcut_mlt_properties.h"
+
+static const int kLength = 25;
+
+class TestTimelineInvariants : public QObject
+{
+    Q_OBJECT
+
+    enum Edit {
+        RemoveLast,
+        LiftLast,
+        LiftMiddle,
+        LiftNeighbors,
+        RemoveFromShortTrack,
+        TrimLast,
+        RippleTrim,
+        Split
+    };
+
+private:
+    MultitrackModel* m_model;
+
+    // Describes everything the invariants maintain: the clips and blanks
+    // of each track, the background length and the filter spans.
+    QStringList snapshot() const
+    {
+        QStringList result;
+        Mlt::Tractor* tractor = m_model->tractor();
+        QScopedPointer<Mlt::Producer> background(tractor->track(0));
+        Mlt::Playlist backgroundPlaylist(*background);
+        QScopedPointer<Mlt::Producer> black(backgroundPlaylist.get_clip(0));
+        result << QString("background %1").arg(black->parent().get_length());
+        result << QString("filters %1").arg(QString(tractor->get(kFilterOutProperty)));
+        for (int t = 0; t < m_model->trackList().size(); ++t) {
+            QScopedPointer<Mlt::Producer> track(tractor->track(m_model->trackList().at(t).mlt_index));
+            Mlt::Playlist playlist(*track);
+            QString line = QString("track %1 filters %2:").arg(t).arg(QString(track->get(kFilterOutProperty)));
+            for (int i = 0; i < playlist.count(); ++i) {
+                QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(i));
+                if (playlist.is_blank(i))
+                    line += QString(" blank %1").arg(info->frame_count);
+                else
+                    line += QString(" %1 %2-%3").arg(QString(info->resource)).arg(info->frame_in).arg(info->frame_out);
+            }
+            result << line;
+        }
+        return result;
+    }
+
+    void push(QUndoStack& stack, Edit edit)
+    {
+        switch (edit) {
+        case RemoveLast:
+            stack.push(new Timeline::RemoveCommand(*m_model, 0, 7));
+            break;
+        case LiftLast:
+            stack.push(new Timeline::LiftCommand(*m_model, 0, 7));
+            break;
+        case LiftMiddle:
+            stack.push(new Timeline::LiftCommand(*m_model, 1, 2));
+            break;
+        case LiftNeighbors:
+            // The second lift leaves two blanks next to each other.
+            stack.beginMacro("lift");
+            stack.push(new Timeline::LiftCommand(*m_model, 1, 2));
+            stack.push(new Timeline::LiftCommand(*m_model, 1, 3));
+            stack.endMacro();
+            break;
+        case RemoveFromShortTrack:
+            stack.push(new Timeline::RemoveCommand(*m_model, 2, 0));
+            break;
+        case TrimLast:
+            stack.push(new Timeline::TrimClipOutCommand(*m_model, 0, 7, 10, false));
+            break;
+        case RippleTrim:
+            stack.push(new Timeline::TrimClipOutCommand(*m_model, 0, 3, 10, true));
+            break;
+        case Split:
+            stack.push(new Timeline::SplitCommand(*m_model, 0, 3, 3 * kLength + 10));
+            break;
+        }
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        MLT.profile().set_explicit(true);
+    }
+
+    void init()
+    {
+        m_model = new MultitrackModel;
+        // Tracks of different lengths so that edits on the first one change
+        // the duration.
+        QList<int> clips;
+        clips << 8 << 6 << 4;
+        QVERIFY(TestTimeline::load(*m_model, TestTimeline::colorXml(clips, kLength)));
+        QCOMPARE(m_model->trackList().size(), 3);
+        QVERIFY(m_model->verifyInvariants());
+    }
+
+    void cleanup()
+    {
+        delete m_model;
+        m_model = nullptr;
+    }
+
+    void undoRedoRoundTrip_data()
+    {
+        QTest::addColumn<int>("edit");
+        QTest::addColumn<bool>("changesDuration");
+        QTest::newRow("remove last clip") << int(RemoveLast) << true;
+        QTest::newRow("lift last clip") << int(LiftLast) << true;
+        QTest::newRow("lift middle clip") << int(LiftMiddle) << false;
+        QTest::newRow("lift neighbors") << int(LiftNeighbors) << false;
+        QTest::newRow("remove from short track") << int(RemoveFromShortTrack) << false;
+        QTest::newRow("trim last clip") << int(TrimLast) << true;
+        QTest::newRow("ripple trim") << int(RippleTrim) << true;
+        QTest::newRow("split") << int(Split) << false;
+    }
+
+    void undoRedoRoundTrip()
+    {
+        QFETCH(int, edit);
+        QFETCH(bool, changesDuration);
+        QUndoStack stack;
+        QStringList before = snapshot();
+
+        push(stack, Edit(edit));
+        QVERIFY(m_model->verifyInvariants());
+        QStringList after = snapshot();
+        QVERIFY(after != before);
+        QCOMPARE(after.first() != before.first(), changesDuration);
+
+        stack.undo();
+        QVERIFY(m_model->verifyInvariants());
+        QCOMPARE(snapshot(), before);
+
+        stack.redo();
+        QVERIFY(m_model->verifyInvariants());
+        QCOMPARE(snapshot(), after);
+
+        stack.undo();
+        QVERIFY(m_model->verifyInvariants());
+        QCOMPARE(snapshot(), before);
+    }
+
+    void liftNeighborsLeavesOneBlank()
+    {
+        QUndoStack stack;
+        push(stack, LiftNeighbors);
+        QScopedPointer<Mlt::Producer> track(m_model->tractor()->track(m_model->trackList().at(1).mlt_index));
+        Mlt::Playlist playlist(*track);
+        QCOMPARE(playlist.count(), 5);
+        QVERIFY(playlist.is_blank(2));
+        QCOMPARE(playlist.clip_length(2), 2 * kLength);
+    }
+
+    void benchmarkRemoveUndo()
+    {
+        QList<int> clips;
+        for (int t = 0; t < 10; ++t)
+            clips << 500;
+        QVERIFY(TestTimeline::load(*m_model, TestTimeline::colorXml(clips, kLength)));
+        QUndoStack stack;
+        QBENCHMARK {
+            stack.push(new Timeline::LiftCommand(*m_model, 5, 250));
+            stack.undo();
+        }
+        QVERIFY(m_model->verifyInvariants());
+    }
+};
+
+QTEST_MAIN(TestTimelineInvariants)
+
+#include "tst_timelineinvariants.moc"